@@ -0,0 +1,830 @@
+#include <b_plus_tree.h>
+
+#include <assert.h>
+#include <math.h> // isnan()
+#include <stddef.h> // NULL
+#include <string.h> // memmove()
+
+#include <memory.h>
+
+// The kinds of BPlusTreeBound: the elements before the bound are those that are not after
+// (score_, object_), below the minimum of range_, not above its maximum, or likewise for
+// lex_range_.
+#define B_PLUS_TREE_NOT_AFTER 0
+#define B_PLUS_TREE_BELOW_MIN 1
+#define B_PLUS_TREE_NOT_ABOVE_MAX 2
+#define B_PLUS_TREE_LEX_BELOW_MIN 3
+#define B_PLUS_TREE_LEX_NOT_ABOVE_MAX 4
+
+// A bound splits the elements into those before it and those that aren't, in this order.
+// Separators are compared the same way: if a separator is before the bound, so are all the
+// elements before it.
+typedef struct BPlusTreeBound
+{
+	int type_;
+	double score_;
+	const NosqlObject *object_;
+	const SkipListRange *range_;
+	const SkipListLexRange *lex_range_;
+} BPlusTreeBound;
+
+// Return whether (object, score) is before the bound.
+// O(1), or O(M) to compare the objects, M being their length.
+static inline __attribute__ ((always_inline)) int BPlusTreeIsBefore(double score,
+        const NosqlObject *object, const BPlusTreeBound *bound)
+{
+	switch(bound->type_)
+	{
+	case B_PLUS_TREE_NOT_AFTER:
+		// The objects are only compared if the scores are equal.
+		return score < bound->score_ ||
+		       (score == bound->score_ && CompareStringObjects(object, bound->object_) <= 0);
+	case B_PLUS_TREE_BELOW_MIN:
+		return !SkipListAboveMin(score, bound->range_);
+	case B_PLUS_TREE_NOT_ABOVE_MAX:
+		return SkipListBelowMax(score, bound->range_);
+	case B_PLUS_TREE_LEX_BELOW_MIN:
+		return !SkipListLexAboveMin(object, bound->lex_range_);
+	default:
+		return SkipListLexBelowMax(object, bound->lex_range_);
+	}
+}
+
+// Return the number of the first count (score, object) pairs that are before the bound.
+// O(logB), B being the capacity of a node.
+static int BPlusTreeCountBefore(const double *scores, NosqlObject *const *objects, int count,
+                                const BPlusTreeBound *bound)
+{
+	int low = 0, high = count;
+	while(low < high)
+	{
+		int middle = (low + high) / 2;
+		if(BPlusTreeIsBefore(scores[middle], objects[middle], bound))
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+	return low;
+}
+
+// Move count (score, object) pairs, which may overlap.
+// O(N)
+static void BPlusTreeMoveKeys(double *to_scores, NosqlObject **to_objects, const double *scores,
+                              NosqlObject *const *objects, int count)
+{
+	memmove(to_scores, scores, CAST(size_t)count * sizeof(double));
+	memmove(to_objects, objects, CAST(size_t)count * sizeof(NosqlObject *));
+}
+
+// Move count children of inner nodes with their sizes, which may overlap.
+// O(N)
+static void BPlusTreeMoveChildren(BPlusTreeNode **to_children, int64_t *to_sizes,
+                                  BPlusTreeNode *const *children, const int64_t *sizes, int count)
+{
+	memmove(to_children, children, CAST(size_t)count * sizeof(BPlusTreeNode *));
+	memmove(to_sizes, sizes, CAST(size_t)count * sizeof(int64_t));
+}
+
+// Return the number of elements under the node.
+// O(B), B being the capacity of a node.
+static int64_t BPlusTreeSize(const BPlusTreeNode *node)
+{
+	if(node->leaf_)
+	{
+		return node->count_;
+	}
+	const BPlusTreeInner *inner = CAST(const BPlusTreeInner *)node;
+	int64_t size = 0;
+	for(int child = 0; child < node->count_; ++child)
+	{
+		size += inner->size_[child];
+	}
+	return size;
+}
+
+// O(1)
+static BPlusTreeLeaf *BPlusTreeCreateLeaf()
+{
+	BPlusTreeLeaf *leaf = Malloc(CAST(int64_t)sizeof(BPlusTreeLeaf));
+	leaf->node_.leaf_ = 1;
+	leaf->node_.count_ = 0;
+	leaf->previous_ = leaf->next_ = NULL;
+	return leaf;
+}
+
+// O(1)
+static BPlusTreeInner *BPlusTreeCreateInner()
+{
+	BPlusTreeInner *inner = Malloc(CAST(int64_t)sizeof(BPlusTreeInner));
+	inner->node_.leaf_ = 0;
+	inner->node_.count_ = 0;
+	return inner;
+}
+
+// O(1)
+BPlusTree *BPlusTreeCreate()
+{
+	BPlusTree *tree = Malloc(CAST(int64_t)sizeof(BPlusTree));
+	BPlusTreeLeaf *leaf = BPlusTreeCreateLeaf();
+	tree->root_ = &leaf->node_;
+	tree->first_ = tree->last_ = leaf;
+	tree->length_ = 0;
+	tree->height_ = 1;
+	return tree;
+}
+
+// Free the node and its descendants, and release their objects and separators.
+// O(N)
+static void BPlusTreeFreeNode(BPlusTreeNode *node)
+{
+	if(node->leaf_)
+	{
+		BPlusTreeLeaf *leaf = CAST(BPlusTreeLeaf *)node;
+		for(int index = 0; index < node->count_; ++index)
+		{
+			DecreaseReferenceCount(leaf->object_[index]);
+		}
+	}
+	else
+	{
+		BPlusTreeInner *inner = CAST(BPlusTreeInner *)node;
+		for(int child = 0; child < node->count_; ++child)
+		{
+			if(child > 0)
+			{
+				DecreaseReferenceCount(inner->object_[child - 1]);
+			}
+			BPlusTreeFreeNode(inner->child_[child]);
+		}
+	}
+	Free(node);
+}
+
+// O(N)
+void BPlusTreeFree(BPlusTree *tree)
+{
+	BPlusTreeFreeNode(tree->root_);
+	Free(tree);
+}
+
+// Go down to the first element that isn't before the bound, store it in *iterator, where
+// index_ may be the count_ of the leaf if it's in the next leaf, and return its rank, the
+// first element being 0. If path isn't NULL, store the inner nodes on the way in path[] and
+// the children taken in slots[].
+// O(logN)
+static int64_t BPlusTreeSeek(BPlusTree *tree, const BPlusTreeBound *bound, BPlusTreeInner **path,
+                             int *slots, BPlusTreeIterator *iterator)
+{
+	BPlusTreeNode *node = tree->root_;
+	int64_t rank = 0;
+	for(int level = 0; !node->leaf_; ++level)
+	{
+		BPlusTreeInner *inner = CAST(BPlusTreeInner *)node;
+		// The children whose next separator is before the bound are before it.
+		int slot = BPlusTreeCountBefore(inner->score_, inner->object_, node->count_ - 1, bound);
+		for(int child = 0; child < slot; ++child)
+		{
+			rank += inner->size_[child];
+		}
+		if(path != NULL)
+		{
+			path[level] = inner;
+			slots[level] = slot;
+		}
+		node = inner->child_[slot];
+	}
+	BPlusTreeLeaf *leaf = CAST(BPlusTreeLeaf *)node;
+	iterator->leaf_ = leaf;
+	iterator->index_ = BPlusTreeCountBefore(leaf->score_, leaf->object_, node->count_, bound);
+	return rank + iterator->index_;
+}
+
+// Go down to the element of rank, the first element being 0, in the same way.
+// O(logN)
+static void BPlusTreeSeekRank(BPlusTree *tree, int64_t rank, BPlusTreeInner **path, int *slots,
+                              BPlusTreeIterator *iterator)
+{
+	BPlusTreeNode *node = tree->root_;
+	for(int level = 0; !node->leaf_; ++level)
+	{
+		BPlusTreeInner *inner = CAST(BPlusTreeInner *)node;
+		int slot = 0;
+		while(slot < node->count_ - 1 && rank >= inner->size_[slot])
+		{
+			rank -= inner->size_[slot++];
+		}
+		if(path != NULL)
+		{
+			path[level] = inner;
+			slots[level] = slot;
+		}
+		node = inner->child_[slot];
+	}
+	iterator->leaf_ = CAST(BPlusTreeLeaf *)node;
+	iterator->index_ = CAST(int)rank;
+}
+
+// Insert (object, score) at index of the leaf, which isn't full.
+// O(B), B being the capacity of a node.
+static void BPlusTreeLeafInsert(BPlusTreeLeaf *leaf, int index, NosqlObject *object, double score)
+{
+	BPlusTreeMoveKeys(leaf->score_ + index + 1, leaf->object_ + index + 1, leaf->score_ + index,
+	                  leaf->object_ + index, leaf->node_.count_ - index);
+	leaf->score_[index] = score;
+	leaf->object_[index] = object;
+	++leaf->node_.count_;
+}
+
+// Insert the child with size elements at slot of the inner node, which isn't full, after the
+// separator (score, object).
+// O(B), B being the capacity of a node.
+static void BPlusTreeInnerInsert(BPlusTreeInner *inner, int slot, double score,
+                                 NosqlObject *object, BPlusTreeNode *child, int64_t size)
+{
+	int count = inner->node_.count_;
+	BPlusTreeMoveKeys(inner->score_ + slot, inner->object_ + slot, inner->score_ + slot - 1,
+	                  inner->object_ + slot - 1, count - slot);
+	BPlusTreeMoveChildren(inner->child_ + slot + 1, inner->size_ + slot + 1, inner->child_ + slot,
+	                      inner->size_ + slot, count - slot);
+	inner->score_[slot - 1] = score;
+	inner->object_[slot - 1] = object;
+	inner->child_[slot] = child;
+	inner->size_[slot] = size;
+	++inner->node_.count_;
+}
+
+// Move the upper half of the full leaf to a new leaf linked after it, and return the new one.
+// O(B), B being the capacity of a node.
+static BPlusTreeLeaf *BPlusTreeSplitLeaf(BPlusTree *tree, BPlusTreeLeaf *leaf)
+{
+	BPlusTreeLeaf *right = BPlusTreeCreateLeaf();
+	int half = B_PLUS_TREE_LEAF_CAPACITY / 2;
+	BPlusTreeMoveKeys(right->score_, right->object_, leaf->score_ + half, leaf->object_ + half,
+	                  B_PLUS_TREE_LEAF_CAPACITY - half);
+	right->node_.count_ = B_PLUS_TREE_LEAF_CAPACITY - half;
+	leaf->node_.count_ = half;
+	right->previous_ = leaf;
+	right->next_ = leaf->next_;
+	if(leaf->next_ != NULL)
+	{
+		leaf->next_->previous_ = right;
+	}
+	else
+	{
+		tree->last_ = right;
+	}
+	leaf->next_ = right;
+	return right;
+}
+
+// Move the upper half of the children of the full inner node to a new one, store the
+// separator between them, which moves up to the parent, in *score and *object, and return the
+// new node.
+// O(B), B being the capacity of a node.
+static BPlusTreeInner *BPlusTreeSplitInner(BPlusTreeInner *inner, double *score,
+        NosqlObject **object)
+{
+	BPlusTreeInner *right = BPlusTreeCreateInner();
+	int half = B_PLUS_TREE_INNER_CAPACITY / 2, count = B_PLUS_TREE_INNER_CAPACITY - half;
+	*score = inner->score_[half - 1];
+	*object = inner->object_[half - 1];
+	BPlusTreeMoveKeys(right->score_, right->object_, inner->score_ + half, inner->object_ + half,
+	                  count - 1);
+	BPlusTreeMoveChildren(right->child_, right->size_, inner->child_ + half, inner->size_ + half,
+	                      count);
+	right->node_.count_ = count;
+	inner->node_.count_ = half;
+	return right;
+}
+
+// Insert the child, which split from the child taken at the lowest level of path[], after it
+// with the separator (score, object) whose reference it takes over. Split the inner nodes on
+// the way that are full, up to the root. The sizes on the way already count the new element.
+// O(logN)
+static void BPlusTreeInsertChild(BPlusTree *tree, BPlusTreeInner **path, int *slots,
+                                 double score, NosqlObject *object, BPlusTreeNode *child)
+{
+	for(int level = tree->height_ - 2; level >= 0; --level)
+	{
+		BPlusTreeInner *inner = path[level];
+		int slot = slots[level];
+		// size_[slot] counts both halves of the split child.
+		int64_t size = BPlusTreeSize(child);
+		inner->size_[slot] -= size;
+		if(inner->node_.count_ < B_PLUS_TREE_INNER_CAPACITY)
+		{
+			BPlusTreeInnerInsert(inner, slot + 1, score, object, child, size);
+			return;
+		}
+		double up_score;
+		NosqlObject *up_object;
+		BPlusTreeInner *right = BPlusTreeSplitInner(inner, &up_score, &up_object);
+		if(slot + 1 <= inner->node_.count_)
+		{
+			BPlusTreeInnerInsert(inner, slot + 1, score, object, child, size);
+		}
+		else
+		{
+			BPlusTreeInnerInsert(right, slot + 1 - inner->node_.count_, score, object, child, size);
+		}
+		score = up_score;
+		object = up_object;
+		child = &right->node_;
+	}
+	// The root split: a new root links both halves.
+	BPlusTreeInner *root = BPlusTreeCreateInner();
+	int64_t size = BPlusTreeSize(child);
+	root->score_[0] = score;
+	root->object_[0] = object;
+	root->child_[0] = tree->root_;
+	root->child_[1] = child;
+	root->size_[0] = tree->length_ - size;
+	root->size_[1] = size;
+	root->node_.count_ = 2;
+	tree->root_ = &root->node_;
+	++tree->height_;
+}
+
+// O(logN)
+void BPlusTreeInsert(BPlusTree *tree, NosqlObject *object, double score)
+{
+	assert(isnan(score) == 0);
+	// 1. Find the position of the object: after all the elements that are not after it.
+	BPlusTreeInner *path[B_PLUS_TREE_MAX_HEIGHT];
+	int slots[B_PLUS_TREE_MAX_HEIGHT];
+	BPlusTreeIterator position;
+	BPlusTreeBound bound = {B_PLUS_TREE_NOT_AFTER, score, object, NULL, NULL};
+	BPlusTreeSeek(tree, &bound, path, slots, &position);
+	for(int level = 0; level < tree->height_ - 1; ++level)
+	{
+		++path[level]->size_[slots[level]];
+	}
+	++tree->length_;
+	// 2. Insert it into its leaf, or split the leaf if it's full.
+	BPlusTreeLeaf *leaf = position.leaf_;
+	if(leaf->node_.count_ < B_PLUS_TREE_LEAF_CAPACITY)
+	{
+		BPlusTreeLeafInsert(leaf, position.index_, object, score);
+		return;
+	}
+	BPlusTreeLeaf *right = BPlusTreeSplitLeaf(tree, leaf);
+	if(position.index_ <= leaf->node_.count_)
+	{
+		BPlusTreeLeafInsert(leaf, position.index_, object, score);
+	}
+	else
+	{
+		BPlusTreeLeafInsert(right, position.index_ - leaf->node_.count_, object, score);
+	}
+	// 3. The first element of the new leaf separates it from the leaf.
+	IncreaseReferenceCount(right->object_[0]);
+	BPlusTreeInsertChild(tree, path, slots, right->score_[0], right->object_[0], &right->node_);
+}
+
+// Merge the child slot + 1 of the parent into the child slot, and free it.
+// O(B), B being the capacity of a node.
+static void BPlusTreeMerge(BPlusTree *tree, BPlusTreeInner *parent, int slot)
+{
+	BPlusTreeNode *left = parent->child_[slot], *right = parent->child_[slot + 1];
+	int left_count = left->count_, right_count = right->count_;
+	if(left->leaf_)
+	{
+		BPlusTreeLeaf *left_leaf = CAST(BPlusTreeLeaf *)left, *right_leaf = CAST(BPlusTreeLeaf *)right;
+		BPlusTreeMoveKeys(left_leaf->score_ + left_count, left_leaf->object_ + left_count,
+		                  right_leaf->score_, right_leaf->object_, right_count);
+		left_leaf->next_ = right_leaf->next_;
+		if(right_leaf->next_ != NULL)
+		{
+			right_leaf->next_->previous_ = left_leaf;
+		}
+		else
+		{
+			tree->last_ = left_leaf;
+		}
+		// The separator between the leaves is gone.
+		DecreaseReferenceCount(parent->object_[slot]);
+	}
+	else
+	{
+		// The separator of the parent comes down between the children of both nodes.
+		BPlusTreeInner *left_inner = CAST(BPlusTreeInner *)left;
+		BPlusTreeInner *right_inner = CAST(BPlusTreeInner *)right;
+		left_inner->score_[left_count - 1] = parent->score_[slot];
+		left_inner->object_[left_count - 1] = parent->object_[slot];
+		BPlusTreeMoveKeys(left_inner->score_ + left_count, left_inner->object_ + left_count,
+		                  right_inner->score_, right_inner->object_, right_count - 1);
+		BPlusTreeMoveChildren(left_inner->child_ + left_count, left_inner->size_ + left_count,
+		                      right_inner->child_, right_inner->size_, right_count);
+	}
+	left->count_ = left_count + right_count;
+	Free(right);
+	// Remove the separator slot and the child slot + 1 from the parent.
+	int count = parent->node_.count_;
+	parent->size_[slot] += parent->size_[slot + 1];
+	BPlusTreeMoveKeys(parent->score_ + slot, parent->object_ + slot, parent->score_ + slot + 1,
+	                  parent->object_ + slot + 1, count - 2 - slot);
+	BPlusTreeMoveChildren(parent->child_ + slot + 1, parent->size_ + slot + 1,
+	                      parent->child_ + slot + 2, parent->size_ + slot + 2, count - 2 - slot);
+	--parent->node_.count_;
+}
+
+// Move count elements, or children, from the start of the child slot + 1 of the parent to the
+// end of the child slot, or, if count is negative, -count ones from the end of the child slot
+// to the start of the child slot + 1.
+// O(B), B being the capacity of a node.
+static void BPlusTreeShift(BPlusTreeInner *parent, int slot, int count)
+{
+	BPlusTreeNode *left = parent->child_[slot], *right = parent->child_[slot + 1];
+	int left_count = left->count_, right_count = right->count_;
+	int64_t moved = 0;
+	if(left->leaf_)
+	{
+		BPlusTreeLeaf *left_leaf = CAST(BPlusTreeLeaf *)left, *right_leaf = CAST(BPlusTreeLeaf *)right;
+		if(count > 0)
+		{
+			BPlusTreeMoveKeys(left_leaf->score_ + left_count, left_leaf->object_ + left_count,
+			                  right_leaf->score_, right_leaf->object_, count);
+			BPlusTreeMoveKeys(right_leaf->score_, right_leaf->object_, right_leaf->score_ + count,
+			                  right_leaf->object_ + count, right_count - count);
+		}
+		else
+		{
+			BPlusTreeMoveKeys(right_leaf->score_ - count, right_leaf->object_ - count,
+			                  right_leaf->score_, right_leaf->object_, right_count);
+			BPlusTreeMoveKeys(right_leaf->score_, right_leaf->object_,
+			                  left_leaf->score_ + left_count + count,
+			                  left_leaf->object_ + left_count + count, -count);
+		}
+		moved = count;
+		// The new first element of the right leaf is the separator.
+		DecreaseReferenceCount(parent->object_[slot]);
+		parent->score_[slot] = right_leaf->score_[0];
+		parent->object_[slot] = right_leaf->object_[0];
+		IncreaseReferenceCount(parent->object_[slot]);
+	}
+	else
+	{
+		// The separator of the parent comes down between the moved children and the others, and
+		// the separator before the moved children goes up.
+		BPlusTreeInner *left_inner = CAST(BPlusTreeInner *)left;
+		BPlusTreeInner *right_inner = CAST(BPlusTreeInner *)right;
+		if(count > 0)
+		{
+			left_inner->score_[left_count - 1] = parent->score_[slot];
+			left_inner->object_[left_count - 1] = parent->object_[slot];
+			BPlusTreeMoveKeys(left_inner->score_ + left_count, left_inner->object_ + left_count,
+			                  right_inner->score_, right_inner->object_, count - 1);
+			BPlusTreeMoveChildren(left_inner->child_ + left_count, left_inner->size_ + left_count,
+			                      right_inner->child_, right_inner->size_, count);
+			for(int child = 0; child < count; ++child)
+			{
+				moved += right_inner->size_[child];
+			}
+			parent->score_[slot] = right_inner->score_[count - 1];
+			parent->object_[slot] = right_inner->object_[count - 1];
+			BPlusTreeMoveKeys(right_inner->score_, right_inner->object_, right_inner->score_ + count,
+			                  right_inner->object_ + count, right_count - 1 - count);
+			BPlusTreeMoveChildren(right_inner->child_, right_inner->size_, right_inner->child_ + count,
+			                      right_inner->size_ + count, right_count - count);
+		}
+		else
+		{
+			int number = -count;
+			BPlusTreeMoveKeys(right_inner->score_ + number, right_inner->object_ + number,
+			                  right_inner->score_, right_inner->object_, right_count - 1);
+			BPlusTreeMoveChildren(right_inner->child_ + number, right_inner->size_ + number,
+			                      right_inner->child_, right_inner->size_, right_count);
+			right_inner->score_[number - 1] = parent->score_[slot];
+			right_inner->object_[number - 1] = parent->object_[slot];
+			BPlusTreeMoveKeys(right_inner->score_, right_inner->object_,
+			                  left_inner->score_ + left_count - number,
+			                  left_inner->object_ + left_count - number, number - 1);
+			BPlusTreeMoveChildren(right_inner->child_, right_inner->size_,
+			                      left_inner->child_ + left_count - number,
+			                      left_inner->size_ + left_count - number, number);
+			parent->score_[slot] = left_inner->score_[left_count - number - 1];
+			parent->object_[slot] = left_inner->object_[left_count - number - 1];
+			for(int child = 0; child < number; ++child)
+			{
+				moved -= right_inner->size_[child];
+			}
+		}
+	}
+	left->count_ = left_count + count;
+	right->count_ = right_count - count;
+	parent->size_[slot] += moved;
+	parent->size_[slot + 1] -= moved;
+}
+
+// Fix the nodes on the way to a leaf, from the leaf up, that have less than their minimum
+// count after deletes: merge a node with a sibling if both fit in one node, or move half of
+// the difference from the larger one to the smaller one. Then drop the roots that have one
+// child.
+// O(logN)
+static void BPlusTreeRebalance(BPlusTree *tree, BPlusTreeInner **path, int *slots)
+{
+	for(int level = tree->height_ - 2; level >= 0; --level)
+	{
+		BPlusTreeInner *parent = path[level];
+		BPlusTreeNode *child = parent->child_[slots[level]];
+		int capacity = child->leaf_ ? B_PLUS_TREE_LEAF_CAPACITY : B_PLUS_TREE_INNER_CAPACITY;
+		int minimum = child->leaf_ ? B_PLUS_TREE_LEAF_MIN : B_PLUS_TREE_INNER_MIN;
+		if(child->count_ >= minimum)
+		{
+			break; // The parent keeps all its children.
+		}
+		// Every inner node has 2 children at least, so the child has a sibling.
+		int slot = slots[level] > 0 ? slots[level] - 1 : slots[level];
+		int left_count = parent->child_[slot]->count_, right_count = parent->child_[slot + 1]->count_;
+		if(left_count + right_count <= capacity)
+		{
+			BPlusTreeMerge(tree, parent, slot);
+		}
+		else
+		{
+			BPlusTreeShift(parent, slot, (right_count - left_count) / 2);
+		}
+	}
+	while(!tree->root_->leaf_ && tree->root_->count_ == 1)
+	{
+		BPlusTreeNode *root = tree->root_;
+		tree->root_ = (CAST(BPlusTreeInner *)root)->child_[0];
+		Free(root);
+		--tree->height_;
+	}
+}
+
+// Delete up to count elements from rank, the first element being 0, as many as its leaf holds
+// from there, release their objects and return their number.
+// O(logN + B), B being the capacity of a node.
+static int BPlusTreeDeleteInLeaf(BPlusTree *tree, int64_t rank, int64_t count,
+                                 BPlusTreeDeleteFunction callback, void *argument)
+{
+	BPlusTreeInner *path[B_PLUS_TREE_MAX_HEIGHT];
+	int slots[B_PLUS_TREE_MAX_HEIGHT];
+	BPlusTreeIterator position;
+	BPlusTreeSeekRank(tree, rank, path, slots, &position);
+	BPlusTreeLeaf *leaf = position.leaf_;
+	int index = position.index_, number = leaf->node_.count_ - index;
+	number = count < number ? CAST(int)count : number;
+	for(int deleted = index; deleted < index + number; ++deleted)
+	{
+		if(callback != NULL)
+		{
+			callback(argument, leaf->object_[deleted], leaf->score_[deleted]);
+		}
+		DecreaseReferenceCount(leaf->object_[deleted]);
+	}
+	BPlusTreeMoveKeys(leaf->score_ + index, leaf->object_ + index, leaf->score_ + index + number,
+	                  leaf->object_ + index + number, leaf->node_.count_ - index - number);
+	leaf->node_.count_ -= number;
+	for(int level = 0; level < tree->height_ - 1; ++level)
+	{
+		path[level]->size_[slots[level]] -= number;
+	}
+	tree->length_ -= number;
+	BPlusTreeRebalance(tree, path, slots);
+	return number;
+}
+
+// O(logN)
+int BPlusTreeDelete(BPlusTree *tree, NosqlObject *object, double score)
+{
+	int64_t rank = BPlusTreeGetRank(tree, object, score);
+	if(rank == 0)
+	{
+		return 0;
+	}
+	BPlusTreeDeleteInLeaf(tree, rank - 1, 1, NULL, NULL);
+	return 1;
+}
+
+// If the element stays between its neighbors in its leaf with the new score, only the score
+// changes; otherwise the element is deleted and inserted again.
+// O(logN)
+void BPlusTreeUpdateScore(BPlusTree *tree, NosqlObject *object, double current_score,
+                          double new_score)
+{
+	assert(isnan(new_score) == 0);
+	BPlusTreeIterator position;
+	BPlusTreeBound bound = {B_PLUS_TREE_NOT_AFTER, current_score, object, NULL, NULL};
+	int64_t rank = BPlusTreeSeek(tree, &bound, NULL, NULL, &position);
+	BPlusTreeLeaf *leaf = position.leaf_;
+	int index = position.index_ - 1, count = leaf->node_.count_;
+	assert(index >= 0 && leaf->score_[index] == current_score &&
+	       CompareStringObjects(leaf->object_[index], object) == 0);
+	// Scores equal to a neighbor's would need comparing the objects. At the ends of the leaf the
+	// separators of the parent only allow moving away from them, unless the leaf is the first or
+	// the last one.
+	if((index > 0 ? leaf->score_[index - 1] < new_score :
+	        leaf->previous_ == NULL || new_score >= current_score) &&
+	        (index < count - 1 ? leaf->score_[index + 1] > new_score :
+	         leaf->next_ == NULL || new_score <= current_score))
+	{
+		leaf->score_[index] = new_score;
+		return;
+	}
+	// The tree keeps a reference of the object while it moves.
+	object = leaf->object_[index];
+	IncreaseReferenceCount(object);
+	BPlusTreeDeleteInLeaf(tree, rank - 1, 1, NULL, NULL);
+	BPlusTreeInsert(tree, object, new_score);
+}
+
+// O(logN)
+int64_t BPlusTreeGetRank(BPlusTree *tree, NosqlObject *object, double score)
+{
+	// The object is the last element that is not after it, in the leaf where the search ends.
+	BPlusTreeIterator position;
+	BPlusTreeBound bound = {B_PLUS_TREE_NOT_AFTER, score, object, NULL, NULL};
+	int64_t rank = BPlusTreeSeek(tree, &bound, NULL, NULL, &position);
+	int index = position.index_ - 1;
+	if(index < 0 || position.leaf_->score_[index] != score ||
+	        CompareStringObjects(position.leaf_->object_[index], object) != 0)
+	{
+		return 0;
+	}
+	return rank;
+}
+
+// O(logN)
+BPlusTreeIterator BPlusTreeGetElementByRank(BPlusTree *tree, int64_t rank)
+{
+	BPlusTreeIterator iterator = {NULL, 0};
+	if(rank >= 1 && rank <= tree->length_)
+	{
+		BPlusTreeSeekRank(tree, rank - 1, NULL, NULL, &iterator);
+	}
+	return iterator;
+}
+
+// Return the first element that isn't before the bound, or none.
+// O(logN)
+static BPlusTreeIterator BPlusTreeFirstAfter(BPlusTree *tree, const BPlusTreeBound *bound)
+{
+	BPlusTreeIterator iterator;
+	BPlusTreeSeek(tree, bound, NULL, NULL, &iterator);
+	if(iterator.index_ == iterator.leaf_->node_.count_)
+	{
+		iterator.leaf_ = iterator.leaf_->next_;
+		iterator.index_ = 0;
+	}
+	return iterator;
+}
+
+// Return the last element that is before the bound, or none.
+// O(logN)
+static BPlusTreeIterator BPlusTreeLastBefore(BPlusTree *tree, const BPlusTreeBound *bound)
+{
+	BPlusTreeIterator iterator;
+	BPlusTreeSeek(tree, bound, NULL, NULL, &iterator);
+	BPlusTreePrevious(&iterator);
+	return iterator;
+}
+
+// O(1)
+int BPlusTreeIsInRange(BPlusTree *tree, const SkipListRange *range)
+{
+	// 1. Check whether the range is empty.
+	if(range->min_ > range->max_ ||
+	        (range->min_ == range->max_ && (range->min_exclusive_ || range->max_exclusive_)))
+	{
+		return 0;
+	}
+	// 2. The last element must be above the minimum and the first element below the maximum.
+	if(tree->length_ == 0 ||
+	        !SkipListAboveMin(tree->last_->score_[tree->last_->node_.count_ - 1], range))
+	{
+		return 0;
+	}
+	return SkipListBelowMax(tree->first_->score_[0], range);
+}
+
+// O(logN)
+BPlusTreeIterator BPlusTreeFirstInRange(BPlusTree *tree, const SkipListRange *range)
+{
+	BPlusTreeIterator iterator = {NULL, 0};
+	if(!BPlusTreeIsInRange(tree, range))
+	{
+		return iterator;
+	}
+	// It exists since the last element is above the minimum, and it is in the range unless it
+	// is above the maximum.
+	BPlusTreeBound bound = {B_PLUS_TREE_BELOW_MIN, 0, NULL, range, NULL};
+	iterator = BPlusTreeFirstAfter(tree, &bound);
+	if(!SkipListBelowMax(iterator.leaf_->score_[iterator.index_], range))
+	{
+		iterator.leaf_ = NULL;
+	}
+	return iterator;
+}
+
+// O(logN)
+BPlusTreeIterator BPlusTreeLastInRange(BPlusTree *tree, const SkipListRange *range)
+{
+	BPlusTreeIterator iterator = {NULL, 0};
+	if(!BPlusTreeIsInRange(tree, range))
+	{
+		return iterator;
+	}
+	// It exists since the first element is below the maximum, and it is in the range unless
+	// it is below the minimum.
+	BPlusTreeBound bound = {B_PLUS_TREE_NOT_ABOVE_MAX, 0, NULL, range, NULL};
+	iterator = BPlusTreeLastBefore(tree, &bound);
+	if(!SkipListAboveMin(iterator.leaf_->score_[iterator.index_], range))
+	{
+		iterator.leaf_ = NULL;
+	}
+	return iterator;
+}
+
+// O(M), M being the length of the objects.
+int BPlusTreeIsInLexRange(BPlusTree *tree, const SkipListLexRange *range)
+{
+	// 1. Check whether the range is empty.
+	if(range->min_ != NULL && range->max_ != NULL)
+	{
+		int result = CompareStringObjects(range->min_, range->max_);
+		if(result > 0 || (result == 0 && (range->min_exclusive_ || range->max_exclusive_)))
+		{
+			return 0;
+		}
+	}
+	// 2. The last element must be above the minimum and the first element below the maximum.
+	if(tree->length_ == 0 ||
+	        !SkipListLexAboveMin(tree->last_->object_[tree->last_->node_.count_ - 1], range))
+	{
+		return 0;
+	}
+	return SkipListLexBelowMax(tree->first_->object_[0], range);
+}
+
+// O(logN * M), M being the length of the objects.
+BPlusTreeIterator BPlusTreeFirstInLexRange(BPlusTree *tree, const SkipListLexRange *range)
+{
+	BPlusTreeIterator iterator = {NULL, 0};
+	if(!BPlusTreeIsInLexRange(tree, range))
+	{
+		return iterator;
+	}
+	BPlusTreeBound bound = {B_PLUS_TREE_LEX_BELOW_MIN, 0, NULL, NULL, range};
+	iterator = BPlusTreeFirstAfter(tree, &bound);
+	if(!SkipListLexBelowMax(iterator.leaf_->object_[iterator.index_], range))
+	{
+		iterator.leaf_ = NULL;
+	}
+	return iterator;
+}
+
+// O(logN * M), M being the length of the objects.
+BPlusTreeIterator BPlusTreeLastInLexRange(BPlusTree *tree, const SkipListLexRange *range)
+{
+	BPlusTreeIterator iterator = {NULL, 0};
+	if(!BPlusTreeIsInLexRange(tree, range))
+	{
+		return iterator;
+	}
+	BPlusTreeBound bound = {B_PLUS_TREE_LEX_NOT_ABOVE_MAX, 0, NULL, NULL, range};
+	iterator = BPlusTreeLastBefore(tree, &bound);
+	if(!SkipListLexAboveMin(iterator.leaf_->object_[iterator.index_], range))
+	{
+		iterator.leaf_ = NULL;
+	}
+	return iterator;
+}
+
+// The elements in the range are those from the first one not below the minimum to the last
+// one not above the maximum, found by their ranks.
+// O(logN + M/B * logN), M being the number of deleted elements and B the capacity of a node.
+int64_t BPlusTreeDeleteRangeByScore(BPlusTree *tree, const SkipListRange *range,
+                                    BPlusTreeDeleteFunction callback, void *argument)
+{
+	BPlusTreeIterator iterator;
+	BPlusTreeBound bound = {B_PLUS_TREE_BELOW_MIN, 0, NULL, range, NULL};
+	int64_t start = BPlusTreeSeek(tree, &bound, NULL, NULL, &iterator);
+	bound.type_ = B_PLUS_TREE_NOT_ABOVE_MAX;
+	int64_t end = BPlusTreeSeek(tree, &bound, NULL, NULL, &iterator);
+	// Ranks start at 1.
+	return start < end ? BPlusTreeDeleteRangeByRank(tree, start + 1, end, callback, argument) : 0;
+}
+
+// Every search deletes the rest of the range in a leaf, so each leaf is found only once.
+// O(logN + M/B * logN), M being the number of deleted elements and B the capacity of a node.
+int64_t BPlusTreeDeleteRangeByRank(BPlusTree *tree, int64_t start, int64_t end,
+                                   BPlusTreeDeleteFunction callback, void *argument)
+{
+	start = start < 1 ? 1 : start;
+	end = end > tree->length_ ? tree->length_ : end;
+	int64_t deleted = 0;
+	while(start + deleted <= end)
+	{
+		// The ranks after the deleted elements move down to start.
+		deleted += BPlusTreeDeleteInLeaf(tree, start - 1, end - start + 1 - deleted, callback,
+		                                 argument);
+	}
+	return deleted;
+}
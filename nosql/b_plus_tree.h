@@ -0,0 +1,146 @@
+#ifndef NOSQL_SRC_B_PLUS_TREE_H_
+#define NOSQL_SRC_B_PLUS_TREE_H_
+
+#ifndef CAST
+#define CAST(type) (type)
+#endif
+
+#include <stddef.h> // NULL
+#include <stdint.h>
+
+#include <nosql.h>
+#include <skip_list.h>
+
+// A B+ tree keeps string objects ordered like a skip list, by score, then by the bytes of the
+// object, with the same rank and range API. A skip list misses the cache on about every node
+// on the way to an element, which are dozens at 10M elements. A B+ tree node holds many
+// elements in arrays of a few cache lines, so a search misses a few times per level, and
+// there are 6 levels at 10M elements. A range is read from consecutive memory.
+//
+// Leaves hold the elements and are linked in order. An inner node holds count_ children and
+// count_ - 1 separators: separator i is after all elements under child i and not after any
+// element under child i + 1. Every inner node also counts the elements under each child
+// (size_), so that the rank of an element is the sum of the sizes of the children before it
+// on the way down. Separators are (score, object) pairs that hold a reference to the object,
+// since they may stay after the element is deleted.
+
+// 32 scores are 4 cache lines, which a binary search reads in 2 or 3 misses, and only the
+// objects of equal scores are compared.
+#define B_PLUS_TREE_LEAF_CAPACITY 32
+#define B_PLUS_TREE_INNER_CAPACITY 32
+// Nodes but the root have at least 1/4 of their capacity, so that alternate inserts and
+// deletes don't split and merge the same node again and again.
+#define B_PLUS_TREE_LEAF_MIN (B_PLUS_TREE_LEAF_CAPACITY / 4)
+#define B_PLUS_TREE_INNER_MIN (B_PLUS_TREE_INNER_CAPACITY / 4)
+#define B_PLUS_TREE_MAX_HEIGHT 24 // Should be enough for 2^64 elements
+
+// The header of leaves and inner nodes.
+typedef struct BPlusTreeNode
+{
+	int leaf_; // Whether the node is a BPlusTreeLeaf or a BPlusTreeInner.
+	int count_; // The number of elements of a leaf, or of children of an inner node.
+} BPlusTreeNode;
+
+typedef struct BPlusTreeLeaf
+{
+	BPlusTreeNode node_;
+	struct BPlusTreeLeaf *previous_, *next_;
+	// Scores and objects are apart, so that searching the scores doesn't read the objects.
+	double score_[B_PLUS_TREE_LEAF_CAPACITY];
+	NosqlObject *object_[B_PLUS_TREE_LEAF_CAPACITY];
+} BPlusTreeLeaf;
+
+typedef struct BPlusTreeInner
+{
+	BPlusTreeNode node_;
+	double score_[B_PLUS_TREE_INNER_CAPACITY - 1]; // Separators.
+	NosqlObject *object_[B_PLUS_TREE_INNER_CAPACITY - 1];
+	BPlusTreeNode *child_[B_PLUS_TREE_INNER_CAPACITY];
+	int64_t size_[B_PLUS_TREE_INNER_CAPACITY]; // The number of elements under every child.
+} BPlusTreeInner;
+
+typedef struct BPlusTree
+{
+	BPlusTreeNode *root_; // An empty leaf if the tree is empty.
+	BPlusTreeLeaf *first_, *last_;
+	int64_t length_; // The number of elements.
+	int height_; // The number of levels, 1 if the root is a leaf.
+} BPlusTree;
+
+// An element of the tree: the index_-th one of leaf_, or none if leaf_ is NULL. It is valid
+// until the tree changes.
+typedef struct BPlusTreeIterator
+{
+	BPlusTreeLeaf *leaf_;
+	int index_;
+} BPlusTreeIterator;
+
+// The callback of BPlusTreeDeleteRangeBy*(), called for every deleted element before the
+// tree releases its object.
+typedef void (*BPlusTreeDeleteFunction) (void *argument, NosqlObject *object, double score);
+
+// Move the iterator to the next element and return whether there is one.
+// O(1)
+static inline __attribute__ ((always_inline)) int BPlusTreeNext(BPlusTreeIterator *iterator)
+{
+	if(++iterator->index_ < iterator->leaf_->node_.count_)
+	{
+		return 1;
+	}
+	iterator->leaf_ = iterator->leaf_->next_;
+	iterator->index_ = 0;
+	return iterator->leaf_ != NULL;
+}
+
+// Move the iterator to the previous element and return whether there is one.
+// O(1)
+static inline __attribute__ ((always_inline)) int BPlusTreePrevious(BPlusTreeIterator *iterator)
+{
+	if(--iterator->index_ >= 0)
+	{
+		return 1;
+	}
+	iterator->leaf_ = iterator->leaf_->previous_;
+	iterator->index_ = iterator->leaf_ == NULL ? 0 : iterator->leaf_->node_.count_ - 1;
+	return iterator->leaf_ != NULL;
+}
+
+// Return a pointer to a new B+ tree.
+BPlusTree *BPlusTreeCreate();
+// Free the B+ tree and release all its objects.
+void BPlusTreeFree(BPlusTree *tree);
+// Insert the object, which must not be in the tree, with the score. The tree takes over the
+// reference of the caller.
+void BPlusTreeInsert(BPlusTree *tree, NosqlObject *object, double score);
+// Delete the object with the score and release it, and return 1, or return 0 if not found.
+int BPlusTreeDelete(BPlusTree *tree, NosqlObject *object, double score);
+// Change the score of the object, which must be in the tree with current_score.
+void BPlusTreeUpdateScore(BPlusTree *tree, NosqlObject *object, double current_score,
+                          double new_score);
+// Return the rank of the object with the score, the first element being 1, or 0 if not found.
+int64_t BPlusTreeGetRank(BPlusTree *tree, NosqlObject *object, double score);
+// Return the element of rank, the first element being 1, or none if out of range.
+BPlusTreeIterator BPlusTreeGetElementByRank(BPlusTree *tree, int64_t rank);
+// Return whether the range overlaps the scores of the tree, from its first element to its
+// last one. If not, no element is in the range; if so, there may still be none between them.
+int BPlusTreeIsInRange(BPlusTree *tree, const SkipListRange *range);
+// Return the first element whose score is in the range, or none.
+BPlusTreeIterator BPlusTreeFirstInRange(BPlusTree *tree, const SkipListRange *range);
+// Return the last element whose score is in the range, or none.
+BPlusTreeIterator BPlusTreeLastInRange(BPlusTree *tree, const SkipListRange *range);
+// Return whether the lexical range overlaps the objects of the tree, in the same way.
+int BPlusTreeIsInLexRange(BPlusTree *tree, const SkipListLexRange *range);
+// Return the first element whose object is in the lexical range, or none.
+BPlusTreeIterator BPlusTreeFirstInLexRange(BPlusTree *tree, const SkipListLexRange *range);
+// Return the last element whose object is in the lexical range, or none.
+BPlusTreeIterator BPlusTreeLastInLexRange(BPlusTree *tree, const SkipListLexRange *range);
+// Delete the elements whose scores are in the range, a leaf at a time, and return their
+// number. If callback isn't NULL, it's called for every deleted element.
+int64_t BPlusTreeDeleteRangeByScore(BPlusTree *tree, const SkipListRange *range,
+                                    BPlusTreeDeleteFunction callback, void *argument);
+// Delete the elements from rank start to rank end, both included and the first element
+// being 1, and return their number, in the same way.
+int64_t BPlusTreeDeleteRangeByRank(BPlusTree *tree, int64_t start, int64_t end,
+                                   BPlusTreeDeleteFunction callback, void *argument);
+
+#endif // NOSQL_SRC_B_PLUS_TREE_H_
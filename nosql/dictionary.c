@@ -1,12 +1,19 @@
+#define _POSIX_C_SOURCE 200809L // clock_gettime()
+
 #include <dictionary.h>
 
 #include <assert.h>
-#include <limits.h>
+#include <string.h> // memset()
+#include <time.h> // clock_gettime()
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
+#include <hash_function.h>
 #include <memory.h>
 
-#define NULL (void*)0
-
 // We can use DictionaryEnableResize() or DictionaryDisableResize() to enable/disable
 // resizing of the hash table. This is important as we use COW and don't want to move
 // too much memory when there is a child performing saving operations.
@@ -19,6 +26,8 @@ static int dictionary_can_resize = 1; // Indicate whether we are allowed to resi
 // The safe threshold for the ratio between elements/bucket. When the actual ratio
 // is over this threshold, we force resize.
 static int dictionary_force_resize_ratio = 5;
+// The state of DictionaryRandom(), 0 until it's seeded.
+static uint64_t dictionary_random_state = 0;
 
 // Enable resizing of the hash table.
 // O(1)
@@ -34,18 +43,296 @@ void DictionaryDisableResize()
 	dictionary_can_resize = 0;
 }
 
+// Return the current time in microseconds of a monotonic clock.
+// O(1)
+static int64_t DictionaryTimeInMicroseconds()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return CAST(int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
 // Reset hash table structure's all data members to zero.
 // O(1)
 void DictionaryResetHashTable(HashTable *hash_table)
 {
 	hash_table->slot_ = NULL;
 	hash_table->size_ = hash_table->size_mask_ = hash_table->element_number_ = 0;
+	hash_table->entry_ = NULL;
+	hash_table->control_ = NULL;
+	hash_table->deleted_number_ = 0;
+	hash_table->hash_ = NULL;
+}
+
+// We use chaining to solve collision(two or more keys hash to the same slot): place all
+// the elements that hash to the same slot into the same linked list. A chained node is
+// allocated with the next_ link after the HashTableNode, which is the first member so that
+// the pointer can be casted both ways.
+typedef struct HashTableChainedNode
+{
+	HashTableNode node_;
+	HashTableNode *next_;
+} HashTableChainedNode;
+
+// A chained node of a dictionary whose type caches hash values is allocated with room
+// for the hash value after the HashTableChainedNode.
+typedef struct HashTableHashedNode
+{
+	HashTableChainedNode chained_node_;
+	uint64_t hash_;
+} HashTableHashedNode;
+
+// The next node in the slot's linked list of a chained node.
+#define DictionaryNodeNext(node) ((CAST(HashTableChainedNode*)(node))->next_)
+#define DictionaryCachesHash(dictionary) ((dictionary)->type_->cache_hash_)
+// The cached hash value of a chained node, only if DictionaryCachesHash().
+#define DictionaryNodeHash(node) ((CAST(HashTableHashedNode*)(node))->hash_)
+// Whether the chained node may store the key whose hash value is hash: KeyCompare() is
+// skipped when the cached hash value doesn't match.
+#define DictionaryNodeHashMatch(dictionary, node, hash) \
+(DictionaryCachesHash(dictionary) == 0 || DictionaryNodeHash(node) == (hash))
+
+// Open addressing layout(Swiss table).
+// The slots are divided into groups of DICTIONARY_GROUP_WIDTH consecutive slots and
+// every slot has a control byte that is either empty, deleted(tombstone), or full, in
+// which case it stores the 7 low bits(H2) of the mixed hash value of the slot's key.
+// A key is looked up by probing groups, starting at the group selected by the other
+// bits of the hash value(H1) and moving by 1, 2, 3, ... groups(triangular probing visits
+// all groups as the number of groups is a power of 2). In each group, the SIMD compare
+// of the 16(SSE2) or 32(AVX2) control bytes with H2 gives the candidate slots at once, so
+// we call KeyCompare() almost only for the matching key. Probing stops at the first group
+// that has an empty slot, since an insert would have used it.
+#if defined(__AVX2__)
+#define DICTIONARY_GROUP_WIDTH 32
+#else
+#define DICTIONARY_GROUP_WIDTH 16
+#endif
+#define DICTIONARY_GROUP_FULL_MASK \
+CAST(uint32_t)((CAST(uint64_t)1 << DICTIONARY_GROUP_WIDTH) - 1)
+#define DICTIONARY_CONTROL_EMPTY (CAST(signed char)-128) // 0b10000000
+#define DICTIONARY_CONTROL_DELETED (CAST(signed char)-2) // 0b11111110
+
+// Return a mask whose bit i is set if the group's i-th control byte is equal to byte.
+// O(1)
+static inline uint32_t DictionaryGroupMatch(const signed char *control, signed char byte)
+{
+#if defined(__AVX2__)
+	__m256i group = _mm256_loadu_si256(CAST(const __m256i*)control);
+	return CAST(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(group, _mm256_set1_epi8(byte)));
+#elif defined(__SSE2__)
+	__m128i group = _mm_loadu_si128(CAST(const __m128i*)control);
+	return CAST(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(byte)));
+#else
+	uint32_t mask = 0;
+	for(int index = 0; index < DICTIONARY_GROUP_WIDTH; ++index)
+	{
+		if(control[index] == byte)
+		{
+			mask |= CAST(uint32_t)1 << index;
+		}
+	}
+	return mask;
+#endif
+}
+
+// Return a mask whose bit i is set if the group's i-th slot is empty or deleted.
+// Both have the high bit set, so it's just the sign bits of the control bytes.
+// O(1)
+static inline uint32_t DictionaryGroupMatchFree(const signed char *control)
+{
+#if defined(__AVX2__)
+	return CAST(uint32_t)_mm256_movemask_epi8(_mm256_loadu_si256(CAST(const __m256i*)control));
+#elif defined(__SSE2__)
+	return CAST(uint32_t)_mm_movemask_epi8(_mm_loadu_si128(CAST(const __m128i*)control));
+#else
+	uint32_t mask = 0;
+	for(int index = 0; index < DICTIONARY_GROUP_WIDTH; ++index)
+	{
+		if(control[index] < 0)
+		{
+			mask |= CAST(uint32_t)1 << index;
+		}
+	}
+	return mask;
+#endif
+}
+
+// Mix the user's hash value so that both H1 and H2 have good distribution even if
+// HashFunction() is weak(e.g., the identity of integer keys). Finalizer of MurmurHash3.
+// O(1)
+static inline uint64_t DictionaryMixHash(uint64_t hash)
+{
+	uint64_t mixed = hash ^ (hash >> 33);
+	mixed *= 0xff51afd7ed558ccdULL;
+	mixed ^= mixed >> 33;
+	mixed *= 0xc4ceb9fe1a85ec53ULL;
+	mixed ^= mixed >> 33;
+	return mixed;
+}
+
+#define DictionaryH2(hash) CAST(signed char)((hash) & 0x7F)
+// Return the first slot of the first group to probe.
+#define DictionaryProbeStart(hash_table, hash) \
+(DictionarySlotIndex(hash_table, (hash) >> 7) & ~CAST(int64_t)(DICTIONARY_GROUP_WIDTH - 1))
+
+// Allocate the inline nodes, the cached hash values(if cache_hash) and the control bytes
+// of a hash table that has size slots.
+// O(N)
+static void DictionaryOpenCreateHashTable(HashTable *hash_table, const int64_t size,
+        int cache_hash)
+{
+	int64_t slot_size = CAST(int64_t)sizeof(HashTableNode) + 1 +
+	                    (cache_hash ? CAST(int64_t)sizeof(uint64_t) : 0);
+	hash_table->entry_ = Malloc(size * slot_size);
+	hash_table->hash_ = cache_hash ? CAST(uint64_t*)(hash_table->entry_ + size) : NULL;
+	hash_table->control_ = cache_hash ? CAST(signed char*)(hash_table->hash_ + size) :
+	                       CAST(signed char*)(hash_table->entry_ + size);
+	memset(hash_table->control_, DICTIONARY_CONTROL_EMPTY, CAST(size_t)size);
+	hash_table->size_ = size;
+	hash_table->size_mask_ = size - 1;
+	hash_table->element_number_ = hash_table->deleted_number_ = 0;
+}
+
+// Return the slot index of key in hash_table, -1 if can't find. If view is nonzero, key
+// is a view of a key, compared by ViewKeyCompare().
+// O(1) expected.
+static int64_t DictionaryOpenFindInHashTable(Dictionary *dictionary, HashTable *hash_table,
+        const void *key, uint64_t hash, int view)
+{
+	if(hash_table->size_ == 0)
+	{
+		return -1;
+	}
+	signed char h2 = DictionaryH2(hash);
+	int64_t group_number = hash_table->size_ / DICTIONARY_GROUP_WIDTH;
+	int64_t position = DictionaryProbeStart(hash_table, hash);
+	for(int64_t probe = 1; probe <= group_number; ++probe)
+	{
+		const signed char *control = hash_table->control_ + position;
+		for(uint32_t match = DictionaryGroupMatch(control, h2); match != 0; match &= match - 1)
+		{
+			int64_t slot_index = position + __builtin_ctz(match);
+			if(hash_table->hash_ != NULL && hash_table->hash_[slot_index] != hash)
+			{
+				continue; // H2 matches by chance, skip KeyCompare().
+			}
+			if(DictionaryCompareLookupKeys(dictionary, key, hash_table->entry_[slot_index].key_,
+			                               view))
+			{
+				return slot_index;
+			}
+		}
+		if(DictionaryGroupMatch(control, DICTIONARY_CONTROL_EMPTY) != 0)
+		{
+			return -1; // The probe sequence of key ends at this group.
+		}
+		position = (position + probe * DICTIONARY_GROUP_WIDTH) & hash_table->size_mask_;
+	}
+	return -1;
+}
+
+// Take the first empty or deleted slot in the probe sequence of hash and return its node.
+// The caller must guarantee that the key is not in hash_table and hash_table isn't full.
+// O(1) expected.
+static HashTableNode *DictionaryOpenInsertInHashTable(HashTable *hash_table, uint64_t hash)
+{
+	int64_t position = DictionaryProbeStart(hash_table, hash);
+	for(int64_t probe = 1; ; ++probe)
+	{
+		uint32_t match = DictionaryGroupMatchFree(hash_table->control_ + position);
+		if(match != 0)
+		{
+			int64_t slot_index = position + __builtin_ctz(match);
+			if(hash_table->control_[slot_index] == DICTIONARY_CONTROL_DELETED)
+			{
+				--hash_table->deleted_number_;
+			}
+			hash_table->control_[slot_index] = DictionaryH2(hash);
+			if(hash_table->hash_ != NULL)
+			{
+				hash_table->hash_[slot_index] = hash;
+			}
+			++hash_table->element_number_;
+			return &hash_table->entry_[slot_index];
+		}
+		position = (position + probe * DICTIONARY_GROUP_WIDTH) & hash_table->size_mask_;
+	}
+}
+
+// Mark the slot as free after its key and value have been released or moved.
+// If its group already has an empty slot, every probe sequence that reaches this group
+// stops here, so the slot can be empty; otherwise it must be a tombstone so that
+// probing continues to the next groups.
+// O(1)
+static void DictionaryOpenEraseSlot(HashTable *hash_table, int64_t slot_index)
+{
+	const signed char *group =
+	    hash_table->control_ + (slot_index & ~CAST(int64_t)(DICTIONARY_GROUP_WIDTH - 1));
+	if(DictionaryGroupMatch(group, DICTIONARY_CONTROL_EMPTY) != 0)
+	{
+		hash_table->control_[slot_index] = DICTIONARY_CONTROL_EMPTY;
+	}
+	else
+	{
+		hash_table->control_[slot_index] = DICTIONARY_CONTROL_DELETED;
+		++hash_table->deleted_number_;
+	}
+	--hash_table->element_number_;
+}
+
+// Whether the used(full or deleted) slots of an open addressing hash table reach 15/16 of
+// its slots, the most that adds may use before the table is resized.
+#define DictionaryOpenIsFull(hash_table) ((hash_table)->element_number_ + \
+	(hash_table)->deleted_number_ >= (hash_table)->size_ / 16 * 15)
+
+// Insert the element of the full slot slot_index of from into to. The caller frees the slot.
+// O(1) expected.
+static void DictionaryOpenMoveSlot(Dictionary *dictionary, HashTable *from, int64_t slot_index,
+                                   HashTable *to)
+{
+	HashTableNode *node = &from->entry_[slot_index];
+	uint64_t hash = from->hash_ != NULL ? from->hash_[slot_index] :
+	                DictionaryMixHash(DictionaryHashKey(dictionary, node->key_));
+	*DictionaryOpenInsertInHashTable(to, hash) = *node;
+}
+
+// Move all the elements of the hash table index table of a rehashing dictionary to a new
+// table that has at least 2 slots per element of both tables, so that it has room for all
+// of them. The elements move around, so no safe iterator may be in the middle of this table.
+// O(N)
+static void DictionaryOpenGrowHashTable(Dictionary *dictionary, int table)
+{
+	HashTable *hash_table = &dictionary->hash_table_[table], new_hash_table;
+	int64_t element_number = dictionary->hash_table_[0].element_number_ +
+	                         dictionary->hash_table_[1].element_number_;
+	int64_t size = hash_table->size_;
+	while(size < element_number * 2)
+	{
+		size <<= 1; // *2
+	}
+	DictionaryResetHashTable(&new_hash_table);
+	DictionaryOpenCreateHashTable(&new_hash_table, size, DictionaryCachesHash(dictionary));
+	for(int64_t slot_index = 0; slot_index < hash_table->size_; ++slot_index)
+	{
+		if(hash_table->control_[slot_index] >= 0) // Full slot.
+		{
+			DictionaryOpenMoveSlot(dictionary, hash_table, slot_index, &new_hash_table);
+		}
+	}
+	Free(hash_table->entry_);
+	*hash_table = new_hash_table;
+	if(table == 0)
+	{
+		dictionary->rehash_index_ = 0; // Rehash the new first table from the start.
+	}
 }
 
 // Return a pointer to new dictionary created specified by type and argument.
 // O(1)
 Dictionary *DictionaryCreate(HashTableType *type, void *argument)
 {
+	// Make sure the built-in hash functions use a random seed before any key is hashed.
+	HashInitRandomSeed();
 	// Allocate memory only for Dictionary structure.
 	Dictionary *dictionary = Malloc(CAST(int)sizeof(Dictionary));
 	// Initialize two hash tables without allocating memory. Allocate memory for them
@@ -57,18 +344,25 @@ Dictionary *DictionaryCreate(HashTableType *type, void *argument)
 	dictionary->argument_ = argument;
 	dictionary->rehash_index_ = -1; // Not in rehashing.
 	dictionary->iterator_number_ = 0;
+	dictionary->second_iterator_number_ = 0;
+	dictionary->rehash_start_time_ = 0;
+	dictionary->rehash_total_time_ = 0;
+	dictionary->rehash_finished_number_ = 0;
 	return dictionary;
 }
 
-// Perform rehash_count steps of incremental rehashing. Return 1 if there are still
-// keys to move from the old to the new hash table, otherwise 0 is returned.
+// Perform rehash_count steps of incremental rehashing and add the number of steps
+// performed to *step_number. Return 1 if there are still keys to move from the old to
+// the new hash table, otherwise 0 is returned.
 // A rehashing step consists in moving a slot, which may have more than one key
-// as we use chaining, from the old to the new hash table.
+// as we use chaining, from the old to the new hash table. In the open addressing
+// layout, a rehashing step moves a group of slots instead.
 // Since part of the hash table may be composed of empty slots, so we allow visiting
 // empty slot for at most rehash_count*10 times, otherwise the amount of work
 // it does would be unbound and the function may block for a int time.
 // O(N)
-int DictionaryRehash(Dictionary *dictionary, int rehash_count)
+static int DictionaryRehashCounting(Dictionary *dictionary, int rehash_count,
+                                    int64_t *step_number)
 {
 	// 1. Check whether in the process of rehashing. If not, return.
 	if(DictionaryIsRehashing(dictionary) == 0)
@@ -80,64 +374,126 @@ int DictionaryRehash(Dictionary *dictionary, int rehash_count)
 	HashTable *first_hash_table = &(dictionary->hash_table_[0]),
 	           *second_hash_table = &(dictionary->hash_table_[1]);
 	int empty_visit = rehash_count * 10; // Max number of empty slots to visit.
-	while(rehash_count-- && first_hash_table->element_number_ != 0)
+	if(DictionaryIsOpenAddressing(dictionary))
 	{
-		// Make sure rehash_index_ can't overflow.
-		assert(dictionary->rehash_index_ < first_hash_table->size_);
-		// Empty slots don't need rehash.
-		while(first_hash_table->slot_[dictionary->rehash_index_] == NULL)
+		// Open addressing: a table can't hold more elements than slots. If safe iterators
+		// paused rehashing during many adds, the second hash table may be too small for the
+		// elements of both tables, then grow it before moving any element into it.
+		if(first_hash_table->element_number_ + second_hash_table->element_number_ >
+		        second_hash_table->size_ / 8 * 7)
+		{
+			DictionaryOpenGrowHashTable(dictionary, 1);
+		}
+		while(rehash_count-- && first_hash_table->element_number_ != 0)
 		{
-			++dictionary->rehash_index_;
-			if(--empty_visit == 0)
+			assert(dictionary->rehash_index_ < first_hash_table->size_);
+			// Skip groups that have no full slot.
+			uint32_t full = ~DictionaryGroupMatchFree(first_hash_table->control_ +
+			                dictionary->rehash_index_) & DICTIONARY_GROUP_FULL_MASK;
+			while(full == 0)
+			{
+				dictionary->rehash_index_ += DICTIONARY_GROUP_WIDTH;
+				if(--empty_visit == 0)
+				{
+					return 1;
+				}
+				full = ~DictionaryGroupMatchFree(first_hash_table->control_ +
+				                                 dictionary->rehash_index_) &
+				       DICTIONARY_GROUP_FULL_MASK;
+			}
+			// Move all the full slots in this group to the second hash table. The moved
+			// slots become tombstones, since the probe sequences of keys not rehashed yet
+			// may pass them.
+			for(; full != 0; full &= full - 1)
 			{
-				return 1; // Only allow visit at most 10*rehash_count empty slots.
+				int64_t slot_index = dictionary->rehash_index_ + __builtin_ctz(full);
+				DictionaryOpenMoveSlot(dictionary, first_hash_table, slot_index,
+				                       second_hash_table);
+				first_hash_table->control_[slot_index] = DICTIONARY_CONTROL_DELETED;
+				++first_hash_table->deleted_number_;
+				--first_hash_table->element_number_;
 			}
+			dictionary->rehash_index_ += DICTIONARY_GROUP_WIDTH;
+			++*step_number;
 		}
-
-		// Rehash all the keys in this slot to the second hash table.
-		HashTableNode *current_node = first_hash_table->slot_[dictionary->rehash_index_];
-		HashTableNode *next_node = NULL;
-		int new_slot_index = 0;
-		new_slot_index += 0; // No warning, please.
-		while(current_node != NULL)
+	}
+	else
+	{
+		while(rehash_count-- && first_hash_table->element_number_ != 0)
 		{
-			next_node = current_node->next_; // Store next hash table node.
-			new_slot_index = DictionaryHashKey(dictionary, current_node->key_)
-			                 & second_hash_table->size_mask_;
+			// Make sure rehash_index_ can't overflow.
+			assert(dictionary->rehash_index_ < first_hash_table->size_);
+			// Empty slots don't need rehash.
+			while(first_hash_table->slot_[dictionary->rehash_index_] == NULL)
+			{
+				++dictionary->rehash_index_;
+				if(--empty_visit == 0)
+				{
+					return 1; // Only allow visit at most 10*rehash_count empty slots.
+				}
+			}
+
+			// Rehash all the keys in this slot to the second hash table.
+			HashTableNode *current_node = first_hash_table->slot_[dictionary->rehash_index_];
+			HashTableNode *next_node = NULL;
+			int64_t new_slot_index = 0;
+			while(current_node != NULL)
+			{
+				next_node = DictionaryNodeNext(current_node); // Store next hash table node.
+				uint64_t hash_value = DictionaryCachesHash(dictionary) ?
+				                      DictionaryNodeHash(current_node) :
+				                      DictionaryHashKey(dictionary, current_node->key_);
+				new_slot_index = DictionarySlotIndex(second_hash_table, hash_value);
 
-			// Add this node to the head of corresponding slot's head.
-			current_node->next_ = second_hash_table->slot_[dictionary->rehash_index_];
-			second_hash_table->slot_[dictionary->rehash_index_] = current_node;
+				// Add this node to the head of corresponding slot's head.
+				DictionaryNodeNext(current_node) = second_hash_table->slot_[new_slot_index];
+				second_hash_table->slot_[new_slot_index] = current_node;
 
-			// Update two hash tables' elements number.
-			--first_hash_table->element_number_;
-			++second_hash_table->element_number_;
+				// Update two hash tables' elements number.
+				--first_hash_table->element_number_;
+				++second_hash_table->element_number_;
 
-			// Move to the next node in the same slot.
-			current_node = next_node;
+				// Move to the next node in the same slot.
+				current_node = next_node;
+			}
+			// Mark the rehashed slot in the first hash table as empty(NULL).
+			first_hash_table->slot_[dictionary->rehash_index_] = NULL;
+			++dictionary->rehash_index_; // Rehash the next slot.
+			++*step_number;
 		}
-		// Mark the rehashed slot in the first hash table as empty(NULL).
-		first_hash_table->slot_[dictionary->rehash_index_] = NULL;
-		++dictionary->rehash_index_; // Rehash the next slot.
 	}
 
 	// 3. Update dictionary's hash table if rehash all done(i.e., the first has no elements).
 	if(first_hash_table->element_number_ == 0)
 	{
 		// Since all elements have rehashed(linked) to the second hash table,
-		// free the first hash table's array, whose element is HashTableNode *.
+		// free the first hash table's array, whose element is HashTableNode *
+		// (or HashTableNode in the open addressing layout).
 		Free(first_hash_table->slot_);
+		Free(first_hash_table->entry_);
 		DictionaryResetHashTable(first_hash_table); // Omit can okay, supply better.
 		// Replace the first hash table by the second: Pass by Value, not by pointer!
 		// Otherwise, when we Reset the second hash table, the first is also reseted.
 		*first_hash_table = *second_hash_table;
 		DictionaryResetHashTable(second_hash_table);
 		dictionary->rehash_index_ = -1; // Turn off rehash flag since we finish rehash.
+		dictionary->rehash_total_time_ += DictionaryRehashingTime(dictionary);
+		++dictionary->rehash_finished_number_;
+		dictionary->rehash_start_time_ = 0;
 		return 0;
 	}
 	return 1;
 }
 
+// Perform rehash_count steps of incremental rehashing. Return 1 if there are still
+// keys to move from the old to the new hash table, otherwise 0 is returned.
+// O(N)
+int DictionaryRehash(Dictionary *dictionary, int rehash_count)
+{
+	int64_t step_number = 0;
+	return DictionaryRehashCounting(dictionary, rehash_count, &step_number);
+}
+
 // If there are no safe iterators bound to hash table, perform a step of rehashing.
 // When we have iterators in the middle of a rehashing, we can't mess with the
 // two hash tables, otherwise some element can be missed or duplicated.
@@ -152,15 +508,52 @@ void DictionaryRehashStep(Dictionary *dictionary)
 	}
 }
 
+// Rehash in batches of 100 steps until rehashing is done or milliseconds has been spent.
+// Return the number of steps performed. Lookups and updates only rehash one step each,
+// so a dictionary that stops receiving traffic would stay in the middle of rehashing,
+// keeping both hash tables, forever. Server cron calls this for such dictionaries.
+// Like DictionaryRehashStep(), do nothing if there are safe iterators.
+// O(N)
+int64_t DictionaryRehashMilliseconds(Dictionary *dictionary, int64_t milliseconds)
+{
+	if(dictionary->iterator_number_ != 0)
+	{
+		return 0;
+	}
+	int64_t start = DictionaryTimeInMicroseconds();
+	int64_t rehash_number = 0;
+	// Count the steps actually performed: the last batch, which finishes rehashing, and
+	// batches that stop after visiting too many empty slots, perform less than 100 steps.
+	while(DictionaryRehashCounting(dictionary, 100, &rehash_number))
+	{
+		if(DictionaryTimeInMicroseconds() - start > milliseconds * 1000)
+		{
+			break;
+		}
+	}
+	return rehash_number;
+}
+
+// Return how long the current rehashing has lasted in microseconds, 0 if not rehashing.
+// O(1)
+int64_t DictionaryRehashingTime(Dictionary *dictionary)
+{
+	if(dictionary->rehash_start_time_ == 0)
+	{
+		return 0;
+	}
+	return DictionaryTimeInMicroseconds() - dictionary->rehash_start_time_;
+}
+
 // Return the first number that is a power of 2 and is greater than or equal to size.
 // O(1)
-static int DictionaryNextPower(const int size)
+static int64_t DictionaryNextPower(const int64_t size)
 {
-	if(size >= INT_MAX) // INT_MAX defined in <limits.h>
+	if(size >= INT64_MAX / 2) // INT64_MAX defined in <stdint.h>
 	{
-		return INT_MAX;
+		return INT64_MAX / 2 + 1; // 2^62
 	}
-	int real_size = DICTIONARY_HASH_TABLE_INITIAL_SIZE; // 4
+	int64_t real_size = DICTIONARY_HASH_TABLE_INITIAL_SIZE; // 4
 	for(;;)
 	{
 		if(real_size >= size)
@@ -171,31 +564,26 @@ static int DictionaryNextPower(const int size)
 	}
 }
 
-// Create(when dictionary is empty) or Expand the hash table.
-// O(1)
-int DictionaryExpand(Dictionary *dictionary, const int size)
+// Allocate a new hash table that has real_size slots, and make it the first hash table
+// (when dictionary is empty) or the second hash table to start incremental rehashing.
+// O(N)
+static int DictionaryResize(Dictionary *dictionary, const int64_t real_size)
 {
-	// real_length is the first number that is a power of 2 and is greater than or equal to length.
-	int real_size = DictionaryNextPower(size);
-	// 1. Exclude the conditions that we can't expand the hash table.
-	// When at least one of the following condition satisfy, expand is rejected:
-	// (1). In the process of rehashing(since we should expand/shrink before rehashing).
-	// (2). The specified size is less than the number of elements already in hash table.
-	// (3). The real expand size is equal to the current size(legal but useless).
-	if(DictionaryIsRehashing(dictionary) ||
-	        dictionary->hash_table_[0].element_number_ > size ||
-	        real_size == dictionary->hash_table_[0].size_)
+	// 1. Allocate the new hash table and initialize all pointers to NULL.
+	HashTable new_hash_table;
+	DictionaryResetHashTable(&new_hash_table);
+	if(DictionaryIsOpenAddressing(dictionary))
 	{
-		return DICTIONARY_ERROR;
+		DictionaryOpenCreateHashTable(&new_hash_table, real_size, DictionaryCachesHash(dictionary));
 	}
-	// 2. Allocate the new hash table and initialize all pointers to NULL.
-	HashTable new_hash_table;
-	// This hash table has real_size slots.
-	new_hash_table.slot_ = Calloc(real_size * CAST(int)sizeof(HashTableNode*));
-	new_hash_table.size_ = real_size;
-	new_hash_table.size_mask_ = real_size - 1;
-	new_hash_table.element_number_ = 0;
-	// 3. Choose hash table index of the new_hash_table in the dictionary.
+	else
+	{
+		// This hash table has real_size slots.
+		new_hash_table.slot_ = Calloc(real_size * CAST(int64_t)sizeof(HashTableNode*));
+		new_hash_table.size_ = real_size;
+		new_hash_table.size_mask_ = real_size - 1;
+	}
+	// 2. Choose hash table index of the new_hash_table in the dictionary.
 	// (1)	If the first hash table is empty, then this is the first initialization,
 	//			set the first hash table so that it can accept keys.
 	if(dictionary->hash_table_[0].size_ == 0)
@@ -208,10 +596,79 @@ int DictionaryExpand(Dictionary *dictionary, const int size)
 	{
 		dictionary->hash_table_[1] = new_hash_table;
 		dictionary->rehash_index_ = 0;
+		dictionary->rehash_start_time_ = DictionaryTimeInMicroseconds();
 	}
 	return DICTIONARY_SUCCESS;
 }
 
+// Create(when dictionary is empty) or Expand the hash table.
+// O(N)
+int DictionaryExpand(Dictionary *dictionary, const int64_t size)
+{
+	// real_length is the first number that is a power of 2 and is greater than or equal to length.
+	int64_t real_size = DictionaryNextPower(size);
+	if(DictionaryIsOpenAddressing(dictionary) && real_size < DICTIONARY_GROUP_WIDTH)
+	{
+		real_size = DICTIONARY_GROUP_WIDTH; // At least one group.
+	}
+	// 1. Exclude the conditions that we can't expand the hash table.
+	// When at least one of the following condition satisfy, expand is rejected:
+	// (1). In the process of rehashing(since we should expand/shrink before rehashing).
+	// (2). The specified size is less than the number of elements already in hash table.
+	// (3). The real expand size is equal to the current size(legal but useless).
+	// (4). Open addressing: the elements would fill more than 7/8 of the slots.
+	if(DictionaryIsRehashing(dictionary) ||
+	        dictionary->hash_table_[0].element_number_ > size ||
+	        real_size == dictionary->hash_table_[0].size_ ||
+	        (DictionaryIsOpenAddressing(dictionary) &&
+	         dictionary->hash_table_[0].element_number_ > real_size / 8 * 7))
+	{
+		return DICTIONARY_ERROR;
+	}
+	return DictionaryResize(dictionary, real_size);
+}
+
+// Resize the hash table to the minimal size that contains all the elements: the
+// element/slot ratio is near 1(1/2 in the open addressing layout) after resizing.
+// Like any resizing, the elements are moved by incremental rehashing.
+// O(N)
+int DictionaryResizeToFit(Dictionary *dictionary)
+{
+	if(dictionary_can_resize == 0 || DictionaryIsRehashing(dictionary))
+	{
+		return DICTIONARY_ERROR;
+	}
+	int64_t minimal_size = dictionary->hash_table_[0].element_number_;
+	if(DictionaryIsOpenAddressing(dictionary))
+	{
+		minimal_size *= 2;
+	}
+	if(minimal_size < DICTIONARY_HASH_TABLE_INITIAL_SIZE)
+	{
+		minimal_size = DICTIONARY_HASH_TABLE_INITIAL_SIZE;
+	}
+	return DictionaryExpand(dictionary, minimal_size);
+}
+
+// Shrink the hash table if less than DICTIONARY_SHRINK_FILL_PERCENT of its slots are
+// used, e.g., after most keys expired. Otherwise the large and almost empty slot array
+// wastes memory and slows down scanning and random sampling.
+// Never shrink while resizing is disabled: shrinking isn't urgent, so it can wait until
+// the child process finishes, as opposed to expanding.
+// O(1)
+static void DictionaryShrinkIfNeeded(Dictionary *dictionary)
+{
+	HashTable *hash_table = &(dictionary->hash_table_[0]);
+	int64_t minimal_size = DictionaryIsOpenAddressing(dictionary) ?
+	                       DICTIONARY_GROUP_WIDTH : DICTIONARY_HASH_TABLE_INITIAL_SIZE;
+	if(dictionary_can_resize && DictionaryIsRehashing(dictionary) == 0 &&
+	        hash_table->size_ > minimal_size &&
+	        hash_table->element_number_ * 100 / hash_table->size_ < DICTIONARY_SHRINK_FILL_PERCENT)
+	{
+		DictionaryResizeToFit(dictionary);
+	}
+}
+
 // Expand the hash table if needed.
 // O(1)
 static int DictionaryExpandIfNeeded(Dictionary *dictionary)
@@ -230,11 +687,29 @@ static int DictionaryExpandIfNeeded(Dictionary *dictionary)
 		return DICTIONARY_SUCCESS;
 	}
 
+	// Open addressing: a table can't hold more elements than slots, and tombstones make
+	// probe sequences as long as full slots do, so both count as used slots. Resize when
+	// used slots reach 7/8 of the slots(15/16 when resizing is disabled), to a table
+	// that has 2 slots per element. When most used slots are tombstones, the new table
+	// may have the same size: it's a rebuild to drop the tombstones.
+	if(DictionaryIsOpenAddressing(dictionary))
+	{
+		int64_t used_number = hash_table->element_number_ + hash_table->deleted_number_;
+		if(used_number >= hash_table->size_ / 8 * 7 &&
+		        (dictionary_can_resize || used_number >= hash_table->size_ / 16 * 15))
+		{
+			int64_t real_size = DictionaryNextPower(hash_table->element_number_ * 2);
+			return DictionaryResize(dictionary, real_size < DICTIONARY_GROUP_WIDTH ?
+			                        DICTIONARY_GROUP_WIDTH : real_size);
+		}
+		return DICTIONARY_SUCCESS;
+	}
+
 	// 3.	Expand if element_number/slot_number(i.e., size_) >= 1:1, and if
 	//			(1) we are allowed to resize the hash table(dictionary_can_resize), or
 	//			(2) this ratio is over the safe threshold(dictionary_force_resize_ratio),
 	//		we resize doubling the number of buckets.
-	int element_slot_ratio = hash_table->element_number_ / hash_table->size_;
+	int64_t element_slot_ratio = hash_table->element_number_ / hash_table->size_;
 	if(element_slot_ratio >= 1 &&
 	        (dictionary_can_resize || element_slot_ratio > dictionary_force_resize_ratio))
 	{
@@ -243,12 +718,13 @@ static int DictionaryExpandIfNeeded(Dictionary *dictionary)
 	return DICTIONARY_SUCCESS;
 }
 
-// Return the index of a slot to which that we can add `key`.
-// -1 means the same key already exists.
+// Return the index of a slot to which that we can add `key`, and store the hash value
+// of key in *hash_value. -1 means the same key already exists.
 // When in the process of rehashing, the returned index is always in the second hash
 // table, that guarantee the elements_number of the first hash table can't increase.
 // O(N)
-static int DictionaryKeyIndex(Dictionary *dictionary, const void *key)
+static int64_t DictionaryKeyIndex(Dictionary *dictionary, const void *key,
+                                  uint64_t *hash_value)
 {
 	// DictionaryExpandIfNeeded() is only used in DictionaryKeyIndex(), and
 	// DictionaryKeyIndex() is only used in DictionaryAddRaw(). This fact means
@@ -262,29 +738,120 @@ static int DictionaryKeyIndex(Dictionary *dictionary, const void *key)
 	}
 
 	// 2. Calculate the hash value of key.
-	int hash_value = DictionaryHashKey(dictionary, key), slot_index = 0;
+	*hash_value = DictionaryHashKey(dictionary, key);
+	int64_t slot_index = 0;
 
 	// 3.	Calculate the slot index that should added to and check whether the same key
-	//		already exists in target hash table.
+	//		already exists in both hash tables(the key may not be rehashed yet).
 	// Not in rehashing: add element to the first hash table([0]); otherwise second.
-	int index = (DictionaryIsRehashing(dictionary) ? 1 : 0);
-	// slot_index = hash_value & added_to_hash_table_size_mask;
-	slot_index = hash_value & dictionary->hash_table_[index].size_mask_;
-	HashTableNode *node = dictionary->hash_table_[index].slot_[slot_index];
-	while(node) // If the target slot is not empty, check if there is the same key.
+	for(int index = 0; index <= 1; ++index)
 	{
-		if(DictionaryCompareKeys(dictionary, key, node->key_))
+		// slot_index = hash_value & added_to_hash_table_size_mask;
+		slot_index = DictionarySlotIndex(&dictionary->hash_table_[index], *hash_value);
+		HashTableNode *node = dictionary->hash_table_[index].slot_[slot_index];
+		while(node) // If the target slot is not empty, check if there is the same key.
+		{
+			if(DictionaryNodeHashMatch(dictionary, node, *hash_value) &&
+			        DictionaryCompareKeys(dictionary, key, node->key_))
+			{
+				// The same key(compared by KeyCompare(), if any, or ==) already exists.
+				// Dictionary allows two different keys that have the same hash value
+				// (if happens, use chaining), disallows two elements that have the same key.
+				return -1;
+			}
+			node = DictionaryNodeNext(node);
+		}
+		if(DictionaryIsRehashing(dictionary) == 0)
 		{
-			// The same key(compared by KeyCompare(), if any, or ==) already exists.
-			// Dictionary allows two different keys that have the same hash value
-			// (if happens, use chaining), disallows two elements that have the same key.
-			return -1;
+			break;
 		}
-		node = node->next_;
 	}
 	return slot_index;
 }
 
+// Return the hash table that a new element is added to during rehashing: the second one,
+// unless it's full, which only happens if safe iterators paused rehashing during many adds.
+// Then, if there are no iterators, finish rehashing, which grows the second hash table if
+// needed. Otherwise no element may move in a table that an iterator is in the middle of:
+// add to the first hash table while it has room, then grow a table that no iterator is in.
+// If iterators are in both tables, the second one is grown anyway, and the iterators in it
+// may miss elements or return them twice.
+// O(N) if it finishes rehashing or grows a table, otherwise O(1).
+static HashTable *DictionaryOpenRehashingTable(Dictionary *dictionary)
+{
+	HashTable *first_hash_table = &dictionary->hash_table_[0],
+	           *second_hash_table = &dictionary->hash_table_[1];
+	if(DictionaryOpenIsFull(second_hash_table) == 0)
+	{
+		return second_hash_table;
+	}
+	if(dictionary->iterator_number_ == 0)
+	{
+		while(DictionaryRehash(dictionary, 100))
+		{
+		}
+		return first_hash_table; // The second hash table has become the first one.
+	}
+	if(DictionaryOpenIsFull(first_hash_table) == 0)
+	{
+		return first_hash_table;
+	}
+	// The iterators in the second hash table have returned all elements of the first one.
+	if(dictionary->second_iterator_number_ != 0 &&
+	        dictionary->second_iterator_number_ == dictionary->iterator_number_)
+	{
+		DictionaryOpenGrowHashTable(dictionary, 0);
+		return first_hash_table;
+	}
+	DictionaryOpenGrowHashTable(dictionary, 1);
+	return second_hash_table;
+}
+
+// DictionaryAddRaw() for the open addressing layout.
+// O(1) expected.
+static HashTableNode *DictionaryOpenAddRaw(Dictionary *dictionary, const void *key)
+{
+	// 1. Perform a step of incremental rehashing, and expand the hash table if needed.
+	if(DictionaryIsRehashing(dictionary))
+	{
+		DictionaryRehashStep(dictionary);
+	}
+	if(DictionaryExpandIfNeeded(dictionary) == DICTIONARY_ERROR)
+	{
+		return NULL;
+	}
+
+	// 2. Check whether key already exists in any hash table.
+	uint64_t hash = DictionaryMixHash(DictionaryHashKey(dictionary, key));
+	for(int index = 0; index <= 1; ++index)
+	{
+		if(DictionaryOpenFindInHashTable(dictionary, &dictionary->hash_table_[index],
+		                                 key, hash, 0) != -1)
+		{
+			return NULL;
+		}
+		if(DictionaryIsRehashing(dictionary) == 0)
+		{
+			break;
+		}
+	}
+
+	// 3.	Take a slot in the hash table that new elements are added to. If it's in the
+	//		first hash table below rehash_index_, move the rehash index back to its group,
+	//		since the slots below the rehash index must stay empty.
+	HashTable *hash_table = DictionaryIsRehashing(dictionary) ?
+	                        DictionaryOpenRehashingTable(dictionary) : &dictionary->hash_table_[0];
+	HashTableNode *node = DictionaryOpenInsertInHashTable(hash_table, hash);
+	int64_t group_index = (node - hash_table->entry_) & ~CAST(int64_t)(DICTIONARY_GROUP_WIDTH - 1);
+	if(DictionaryIsRehashing(dictionary) && hash_table == &dictionary->hash_table_[0] &&
+	        group_index < dictionary->rehash_index_)
+	{
+		dictionary->rehash_index_ = group_index;
+	}
+	DictionarySetKey(dictionary, node, CAST(void*)key);
+	return node;
+}
+
 // Add a new node to dictionary without setting its value, and return the added
 // node's pointer, which let the user fill the value field as he wishes.
 // This function is exposed to the user API to be called mainly in order to
@@ -295,18 +862,23 @@ static int DictionaryKeyIndex(Dictionary *dictionary, const void *key)
 // O(1)
 HashTableNode *DictionaryAddRaw(Dictionary *dictionary, const void *key)
 {
+	if(DictionaryIsOpenAddressing(dictionary))
+	{
+		return DictionaryOpenAddRaw(dictionary, key);
+	}
+
 	// 1.	Check whether is in the process of incremental rehashing.
 	//		If so, perform a step of incremental rehashing.
-	int is_rehashing = DictionaryIsRehashing(dictionary);
-	if(is_rehashing)
+	if(DictionaryIsRehashing(dictionary))
 	{
 		DictionaryRehashStep(dictionary);
 	}
 
 	// 2.	Check whether key already exists in dictionary.
 	//		If so, return NULL; otherwise return the index of hashed slot.
-	int slot_index = 0; // slot_index = HashFunction(key) & size_mask_;
-	if((slot_index = DictionaryKeyIndex(dictionary, key)) == -1)
+	int64_t slot_index = 0; // slot_index = HashFunction(key) & size_mask_;
+	uint64_t hash_value = 0;
+	if((slot_index = DictionaryKeyIndex(dictionary, key, &hash_value)) == -1)
 	{
 		// The same key(compared by KeyCompare(), if any, or ==) already exists
 		// in dictionary. Dictionary allows two different keys that have the same hash
@@ -317,13 +889,23 @@ HashTableNode *DictionaryAddRaw(Dictionary *dictionary, const void *key)
 	// 3. Select the hash table add to, Construct a new node, Initialize key_ and next_ field.
 	// Always add new element to hash_table[1] when incremental rehashing to
 	// guarantee that the element_number_ of hash_table[0] don't increase.
-	HashTable *hash_table = is_rehashing ?
+	// DictionaryKeyIndex() may have started a rehashing, so check the flag again.
+	HashTable *hash_table = DictionaryIsRehashing(dictionary) ?
 	                        &dictionary->hash_table_[1] : &dictionary->hash_table_[0];
-	HashTableNode *node = Malloc(sizeof(HashTableNode)); // Get new node.
+	HashTableNode *node = NULL; // Get new node.
+	if(DictionaryCachesHash(dictionary))
+	{
+		node = Malloc(CAST(int64_t)sizeof(HashTableHashedNode));
+		DictionaryNodeHash(node) = hash_value;
+	}
+	else
+	{
+		node = Malloc(CAST(int64_t)sizeof(HashTableChainedNode));
+	}
 	// Initialize node member: key_, next_. Don't set value_ field, see notes above.
 	DictionarySetKey(dictionary, node, CAST(void*)key);
 	// Add new node to the head of corresponding slot in hash table. O(1)
-	node->next_ = hash_table->slot_[slot_index];
+	DictionaryNodeNext(node) = hash_table->slot_[slot_index];
 	hash_table->slot_[slot_index] = node;
 
 	// 4. Update this hash table's elements' number.
@@ -347,35 +929,44 @@ int DictionaryAdd(Dictionary *dictionary, const void *key, const void *value)
 	return DICTIONARY_SUCCESS;
 }
 
-// Return the pointer to the node whose key matches the argument key.
-// NULL if can't find.
-HashTableNode *DictionaryFind(Dictionary *dictionary, const void *key)
+// Return the pointer to the node whose key, whose hash value is hash_value, matches
+// the argument key, which is a view of a key if view is nonzero. NULL if can't find.
+// The dictionary must have been created.
+// O(1) expected.
+static HashTableNode *DictionaryFindWithHash(Dictionary *dictionary, const void *key,
+        uint64_t hash_value, int view)
 {
-	// 1. Check if dictionary has elements. If not, return NULL directly.
-	if(dictionary->hash_table_[0].size_ == 0)
+	if(DictionaryIsOpenAddressing(dictionary))
 	{
+		uint64_t hash = DictionaryMixHash(hash_value);
+		for(int index = 0; index <= 1; ++index)
+		{
+			HashTable *hash_table = &dictionary->hash_table_[index];
+			int64_t slot_index =
+			    DictionaryOpenFindInHashTable(dictionary, hash_table, key, hash, view);
+			if(slot_index != -1)
+			{
+				return &hash_table->entry_[slot_index];
+			}
+			if(DictionaryIsRehashing(dictionary) == 0)
+			{
+				break;
+			}
+		}
 		return NULL;
 	}
-
-	// 2. Always try to perform one step of incremental rehash before actual operation.
-	if(DictionaryIsRehashing(dictionary))
-	{
-		DictionaryRehashStep(dictionary);
-	}
-
-	// 3. Find the node in dictionary whose key matches the specified key.
-	int hash_value = DictionaryHashKey(dictionary, key);
 	for(int index = 0; index <= 1; ++index)
 	{
-		int slot_index = hash_value & dictionary->hash_table_[index].size_mask_;
+		int64_t slot_index = DictionarySlotIndex(&dictionary->hash_table_[index], hash_value);
 		HashTableNode *node = dictionary->hash_table_[index].slot_[slot_index];
 		while(node)
 		{
-			if(DictionaryCompareKeys(dictionary, key, node->key_))
+			if(DictionaryNodeHashMatch(dictionary, node, hash_value) &&
+			        DictionaryCompareLookupKeys(dictionary, key, node->key_, view))
 			{
 				return node;
 			}
-			node = node->next_;
+			node = DictionaryNodeNext(node);
 		}
 		//(1)	When not in the process of incremental rehashing, only find in the first hash
 		//		table since the second hash table is only used in rehashing. If can't find, break
@@ -390,6 +981,153 @@ HashTableNode *DictionaryFind(Dictionary *dictionary, const void *key)
 	return NULL;
 }
 
+// Return the pointer to the node whose key matches the argument key.
+// NULL if can't find.
+HashTableNode *DictionaryFind(Dictionary *dictionary, const void *key)
+{
+	// 1. Check if dictionary has elements. If not, return NULL directly.
+	if(dictionary->hash_table_[0].size_ == 0)
+	{
+		return NULL;
+	}
+
+	// 2. Always try to perform one step of incremental rehash before actual operation.
+	if(DictionaryIsRehashing(dictionary))
+	{
+		DictionaryRehashStep(dictionary);
+	}
+
+	// 3. Find the node in dictionary whose key matches the specified key.
+	return DictionaryFindWithHash(dictionary, key, DictionaryHashKey(dictionary, key), 0);
+}
+
+// Return the pointer to the node whose key matches the view, which is another
+// representation of a key, e.g., a slice of a network buffer for SDS keys, so that
+// looking up doesn't need to create a key. The type of the dictionary must have
+// ViewHashFunction() and ViewKeyCompare(). NULL if can't find.
+// O(1) expected.
+HashTableNode *DictionaryFindView(Dictionary *dictionary, const void *view)
+{
+	if(dictionary->hash_table_[0].size_ == 0)
+	{
+		return NULL;
+	}
+	if(DictionaryIsRehashing(dictionary))
+	{
+		DictionaryRehashStep(dictionary);
+	}
+	return DictionaryFindWithHash(dictionary, view, dictionary->type_->ViewHashFunction(view), 1);
+}
+
+// Prefetch the memory of the first probe of hash_value in hash_table: the slot
+// (chained layout) or the control bytes of the first group(open addressing layout).
+// O(1)
+static inline void DictionaryPrefetchSlot(Dictionary *dictionary, HashTable *hash_table,
+        uint64_t hash_value)
+{
+	if(DictionaryIsOpenAddressing(dictionary))
+	{
+		uint64_t hash = DictionaryMixHash(hash_value);
+		__builtin_prefetch(hash_table->control_ + DictionaryProbeStart(hash_table, hash));
+	}
+	else
+	{
+		__builtin_prefetch(&hash_table->slot_[DictionarySlotIndex(hash_table, hash_value)]);
+	}
+}
+
+// Prefetch the first node that may store the key whose hash value is hash_value in
+// hash_table, after its slot has been prefetched.
+// O(1)
+static inline void DictionaryPrefetchNode(Dictionary *dictionary, HashTable *hash_table,
+        uint64_t hash_value)
+{
+	if(DictionaryIsOpenAddressing(dictionary))
+	{
+		uint64_t hash = DictionaryMixHash(hash_value);
+		int64_t position = DictionaryProbeStart(hash_table, hash);
+		uint32_t match = DictionaryGroupMatch(hash_table->control_ + position, DictionaryH2(hash));
+		if(match != 0)
+		{
+			int64_t slot_index = position + __builtin_ctz(match);
+			__builtin_prefetch(&hash_table->entry_[slot_index]);
+			if(hash_table->hash_ != NULL)
+			{
+				__builtin_prefetch(&hash_table->hash_[slot_index]);
+			}
+		}
+	}
+	else
+	{
+		HashTableNode *node = hash_table->slot_[DictionarySlotIndex(hash_table, hash_value)];
+		if(node != NULL)
+		{
+			__builtin_prefetch(node);
+		}
+	}
+}
+
+// Find key_number keys at once: out_nodes[i] is the node of keys[i], NULL if can't find.
+// Return the number of keys found.
+// A DictionaryFind() of a large table usually waits for two dependent cache misses:
+// the slot, then the node. Here the keys are processed in batches of
+// DICTIONARY_FIND_BATCH_SIZE in stages: hash all keys and prefetch their slots, then
+// prefetch their first nodes, then compare, so that the cache misses of the keys in
+// the same batch overlap instead of being paid one after another.
+// O(N) expected.
+int64_t DictionaryFindBatch(Dictionary *dictionary, const void **keys, int64_t key_number,
+                            HashTableNode **out_nodes)
+{
+	if(dictionary->hash_table_[0].size_ == 0)
+	{
+		for(int64_t index = 0; index < key_number; ++index)
+		{
+			out_nodes[index] = NULL;
+		}
+		return 0;
+	}
+	// A single step of incremental rehashing before the first lookup. A step between the
+	// batches could move the nodes found by the previous ones, or finish rehashing and free
+	// their table, in the open addressing layout.
+	if(DictionaryIsRehashing(dictionary))
+	{
+		DictionaryRehashStep(dictionary);
+	}
+	int table_number = DictionaryIsRehashing(dictionary) ? 2 : 1;
+	int64_t found_number = 0;
+	uint64_t hash_values[DICTIONARY_FIND_BATCH_SIZE];
+	for(int64_t begin = 0; begin < key_number; begin += DICTIONARY_FIND_BATCH_SIZE)
+	{
+		int batch_size = key_number - begin < DICTIONARY_FIND_BATCH_SIZE ?
+		                 CAST(int)(key_number - begin) : DICTIONARY_FIND_BATCH_SIZE;
+		// 1. Hash all keys and prefetch their slots.
+		for(int index = 0; index < batch_size; ++index)
+		{
+			hash_values[index] = DictionaryHashKey(dictionary, keys[begin + index]);
+			for(int table = 0; table < table_number; ++table)
+			{
+				DictionaryPrefetchSlot(dictionary, &dictionary->hash_table_[table], hash_values[index]);
+			}
+		}
+		// 2. Prefetch the first nodes.
+		for(int index = 0; index < batch_size; ++index)
+		{
+			for(int table = 0; table < table_number; ++table)
+			{
+				DictionaryPrefetchNode(dictionary, &dictionary->hash_table_[table], hash_values[index]);
+			}
+		}
+		// 3. Compare the keys.
+		for(int index = 0; index < batch_size; ++index)
+		{
+			out_nodes[begin + index] =
+			    DictionaryFindWithHash(dictionary, keys[begin + index], hash_values[index], 0);
+			found_number += out_nodes[begin + index] != NULL;
+		}
+	}
+	return found_number;
+}
+
 // Add a new key-value pair if the key doesn't exist in dictionary yet;
 // otherwise replace current value with argument value.
 // Return 1 if the new key-value pair is added; 0 if only replace value.
@@ -425,6 +1163,13 @@ void *DictionaryGetValue(Dictionary *dictionary, const void *key)
 	return node ? DictionaryGetElementValue(node) : NULL;
 }
 
+// Get the value of element whose key matches the view, see DictionaryFindView().
+void *DictionaryGetValueView(Dictionary *dictionary, const void *view)
+{
+	HashTableNode *node = DictionaryFindView(dictionary, view);
+	return node ? DictionaryGetElementValue(node) : NULL;
+}
+
 // Return SUCCESS if delete the node whose key matches the argument key,
 // ERROR if can't find.
 static int DictionaryGenericDelete(Dictionary *dictionary, const void *key, const int no_free)
@@ -442,23 +1187,50 @@ static int DictionaryGenericDelete(Dictionary *dictionary, const void *key, cons
 	}
 
 	// 3. Find the node in dictionary whose key matches the specified key.
-	int hash_value = DictionaryHashKey(dictionary, key);
+	uint64_t hash_value = DictionaryHashKey(dictionary, key);
+	if(DictionaryIsOpenAddressing(dictionary))
+	{
+		uint64_t hash = DictionaryMixHash(hash_value);
+		for(int index = 0; index <= 1; ++index)
+		{
+			HashTable *hash_table = &dictionary->hash_table_[index];
+			int64_t slot_index =
+			    DictionaryOpenFindInHashTable(dictionary, hash_table, key, hash, 0);
+			if(slot_index != -1)
+			{
+				if(no_free == 0)
+				{
+					DictionaryFreeKey(dictionary, &hash_table->entry_[slot_index]);
+					DictionaryFreeValue(dictionary, &hash_table->entry_[slot_index]);
+				}
+				DictionaryOpenEraseSlot(hash_table, slot_index);
+				DictionaryShrinkIfNeeded(dictionary);
+				return DICTIONARY_SUCCESS;
+			}
+			if(DictionaryIsRehashing(dictionary) == 0)
+			{
+				break;
+			}
+		}
+		return DICTIONARY_ERROR;
+	}
 	for(int index = 0; index <= 1; ++index)
 	{
-		int slot_index = hash_value & dictionary->hash_table_[index].size_mask_;
+		int64_t slot_index = DictionarySlotIndex(&dictionary->hash_table_[index], hash_value);
 		HashTableNode *previous_node = NULL;
 		HashTableNode *node = dictionary->hash_table_[index].slot_[slot_index];
 		while(node)
 		{
-			if(DictionaryCompareKeys(dictionary, key, node->key_))
+			if(DictionaryNodeHashMatch(dictionary, node, hash_value) &&
+			        DictionaryCompareKeys(dictionary, key, node->key_))
 			{
 				if(previous_node)
 				{
-					previous_node->next_ = node->next_;
+					DictionaryNodeNext(previous_node) = DictionaryNodeNext(node);
 				}
 				else
 				{
-					dictionary->hash_table_[index].slot_[slot_index] = node->next_;
+					dictionary->hash_table_[index].slot_[slot_index] = DictionaryNodeNext(node);
 				}
 				if(no_free == 0)
 				{
@@ -467,10 +1239,11 @@ static int DictionaryGenericDelete(Dictionary *dictionary, const void *key, cons
 				}
 				Free(node);
 				--dictionary->hash_table_[index].element_number_;
+				DictionaryShrinkIfNeeded(dictionary);
 				return DICTIONARY_SUCCESS;
 			}
 			previous_node = node;
-			node = node->next_;
+			node = DictionaryNodeNext(node);
 		}
 		//(1)	When not in the process of incremental rehashing, only find in the first hash
 		//		table since the second hash table is only used in rehashing. If can't find, break
@@ -497,24 +1270,195 @@ int DictionaryDeleteNoFree(Dictionary *dictionary, const void *key)
 	return DictionaryGenericDelete(dictionary, key, 1);
 }
 
+// Return a 64 bits pseudo random number(SplitMix64), seeded by the hash seed.
+// O(1)
+static uint64_t DictionaryRandom()
+{
+	if(dictionary_random_state == 0)
+	{
+		memcpy(&dictionary_random_state, HashGetSeed(), sizeof(dictionary_random_state));
+		dictionary_random_state |= 1;
+	}
+	dictionary_random_state += 0x9e3779b97f4a7c15ULL;
+	return DictionaryMixHash(dictionary_random_state);
+}
+
+// Return the first element of the slot index of hash_table: the head of the linked list
+// (chained layout), or the slot's element if it's full(open addressing layout).
+#define DictionarySlotNode(hash_table, index) \
+((hash_table)->control_ == NULL ? (hash_table)->slot_[index] : \
+	(hash_table)->control_[index] >= 0 ? &(hash_table)->entry_[index] : NULL)
+
+// Return a random element of the dictionary, NULL if it's empty.
+// Pick random slots until a non-empty one is found, then a random element of its linked
+// list. During rehashing, the slots of the first hash table that are below rehash_index_
+// are known to be empty, so they're excluded. Elements in long linked lists are less
+// likely to be returned, but the lists are short as the load factor is kept near 1.
+// O(1) expected.
+HashTableNode *DictionaryGetRandomKey(Dictionary *dictionary)
+{
+	HashTable *first_hash_table = &dictionary->hash_table_[0],
+	           *second_hash_table = &dictionary->hash_table_[1];
+	if(first_hash_table->element_number_ + second_hash_table->element_number_ == 0)
+	{
+		return NULL;
+	}
+	if(DictionaryIsRehashing(dictionary))
+	{
+		DictionaryRehashStep(dictionary);
+	}
+	HashTableNode *node = NULL;
+	if(DictionaryIsRehashing(dictionary))
+	{
+		// Slots [rehash_index_, size0) of the first table and [0, size1) of the second.
+		int64_t range = first_hash_table->size_ + second_hash_table->size_ -
+		                dictionary->rehash_index_;
+		do
+		{
+			int64_t index = dictionary->rehash_index_ +
+			                CAST(int64_t)(DictionaryRandom() % CAST(uint64_t)range);
+			node = index >= first_hash_table->size_ ?
+			       DictionarySlotNode(second_hash_table, index - first_hash_table->size_) :
+			       DictionarySlotNode(first_hash_table, index);
+		}
+		while(node == NULL);
+	}
+	else
+	{
+		do
+		{
+			int64_t index = CAST(int64_t)(DictionaryRandom() & CAST(uint64_t)first_hash_table->size_mask_);
+			node = DictionarySlotNode(first_hash_table, index);
+		}
+		while(node == NULL);
+	}
+	if(DictionaryIsOpenAddressing(dictionary))
+	{
+		return node;
+	}
+	// Pick a random element of the linked list.
+	int64_t list_length = 0;
+	for(HashTableNode *list_node = node; list_node != NULL;
+	        list_node = DictionaryNodeNext(list_node))
+	{
+		++list_length;
+	}
+	for(int64_t index = CAST(int64_t)(DictionaryRandom() % CAST(uint64_t)list_length);
+	        index > 0; --index)
+	{
+		node = DictionaryNodeNext(node);
+	}
+	return node;
+}
+
+// Sample up to count elements from random positions, store them in out and return the
+// number of elements stored, which is less than count only if the dictionary has less
+// than count elements or too many empty slots were visited.
+// Start at a random slot and take all elements of the consecutive slots. This is much
+// cheaper per sample than DictionaryGetRandomKey(), which is enough for approximate
+// algorithms like eviction, but the elements aren't uniformly distributed and may be
+// returned more than once. At most count*10 slots are visited, and after more than
+// count(at least 5) consecutive empty slots, jump to another random slot.
+// O(count)
+int64_t DictionaryGetSomeKeys(Dictionary *dictionary, HashTableNode **out, int64_t count)
+{
+	int64_t element_number =
+	    dictionary->hash_table_[0].element_number_ + dictionary->hash_table_[1].element_number_;
+	if(count > element_number)
+	{
+		count = element_number;
+	}
+	int64_t max_step = count * 10;
+	// Make rehashing progress proportionally to the work, like count lookups would.
+	for(int64_t step = 0; step < count && DictionaryIsRehashing(dictionary); ++step)
+	{
+		DictionaryRehashStep(dictionary);
+	}
+	int table_number = DictionaryIsRehashing(dictionary) ? 2 : 1;
+	uint64_t max_size_mask = CAST(uint64_t)dictionary->hash_table_[0].size_mask_;
+	if(table_number == 2 && CAST(uint64_t)dictionary->hash_table_[1].size_mask_ > max_size_mask)
+	{
+		max_size_mask = CAST(uint64_t)dictionary->hash_table_[1].size_mask_;
+	}
+	int64_t index = CAST(int64_t)(DictionaryRandom() & max_size_mask);
+	int64_t stored_number = 0, empty_length = 0;
+	while(stored_number < count && max_step-- > 0)
+	{
+		for(int table = 0; table < table_number; ++table)
+		{
+			HashTable *hash_table = &dictionary->hash_table_[table];
+			// The slots of the first table below rehash_index_ are empty: skip to the
+			// rehash index unless the index is also valid in the second table.
+			if(table_number == 2 && table == 0 && index < dictionary->rehash_index_)
+			{
+				if(index >= dictionary->hash_table_[1].size_)
+				{
+					index = dictionary->rehash_index_;
+				}
+				else
+				{
+					continue;
+				}
+			}
+			if(index >= hash_table->size_)
+			{
+				continue; // Out of range for this table.
+			}
+			HashTableNode *node = DictionarySlotNode(hash_table, index);
+			if(node == NULL)
+			{
+				// Jump to another random slot after a long run of empty slots.
+				if(++empty_length >= 5 && empty_length > count)
+				{
+					index = CAST(int64_t)(DictionaryRandom() & max_size_mask);
+					empty_length = 0;
+				}
+				continue;
+			}
+			empty_length = 0;
+			for(; node != NULL;
+			        node = hash_table->control_ == NULL ? DictionaryNodeNext(node) : NULL)
+			{
+				out[stored_number++] = node;
+				if(stored_number == count)
+				{
+					return stored_number;
+				}
+			}
+		}
+		index = CAST(int64_t)(CAST(uint64_t)(index + 1) & max_size_mask);
+	}
+	return stored_number;
+}
+
 // Destroy specified hash table of dictionary.
 void DictionaryClear(Dictionary *dictionary, HashTable *hash_table, void (callback)(void*))
 {
 	HashTableNode *node = NULL, *next_node = NULL;
-	for(int index = 0;
+	for(int64_t index = 0;
 	        index < hash_table->size_ && hash_table->element_number_ > 0; ++index)
 	{
 		if(callback && (index & 65535) == 0) // TODO: What use?
 		{
 			callback(dictionary->argument_);
 		}
+		if(hash_table->control_ != NULL) // Open addressing layout.
+		{
+			if(hash_table->control_[index] >= 0) // Full slot.
+			{
+				DictionaryFreeKey(dictionary, &hash_table->entry_[index]);
+				DictionaryFreeValue(dictionary, &hash_table->entry_[index]);
+				--hash_table->element_number_;
+			}
+			continue;
+		}
 		if((node = hash_table->slot_[index]) == NULL)
 		{
 			continue;
 		}
 		while(node)
 		{
-			next_node = node;
+			next_node = DictionaryNodeNext(node);
 			DictionaryFreeKey(dictionary, node);
 			DictionaryFreeValue(dictionary, node);
 			Free(node);
@@ -523,6 +1467,7 @@ void DictionaryClear(Dictionary *dictionary, HashTable *hash_table, void (callba
 		}
 	}
 	Free(hash_table->slot_);
+	Free(hash_table->entry_);
 	DictionaryResetHashTable(hash_table);
 }
 
@@ -533,3 +1478,280 @@ void DictionaryRelease(Dictionary *dictionary)
 	DictionaryClear(dictionary, &dictionary->hash_table_[1], NULL);
 	Free(dictionary);
 }
+
+// Return a 64 bits number that represents the current state of the dictionary: the slot
+// arrays, sizes and element numbers of both hash tables. Unsafe iterators check that the
+// fingerprint at release is the same as at the first DictionaryNext(), otherwise the
+// dictionary was modified(e.g., by a rehashing step) during an unsafe iteration.
+// O(1)
+uint64_t DictionaryFingerprint(Dictionary *dictionary)
+{
+	uint64_t fingerprint = 0;
+	for(int index = 0; index <= 1; ++index)
+	{
+		HashTable *hash_table = &dictionary->hash_table_[index];
+		uint64_t state[3] =
+		{
+			CAST(uint64_t)(hash_table->slot_ != NULL ? CAST(uintptr_t)hash_table->slot_ :
+			               CAST(uintptr_t)hash_table->entry_),
+			CAST(uint64_t)hash_table->size_,
+			CAST(uint64_t)hash_table->element_number_
+		};
+		// Mix in every state in turn, so that the same states in a different order
+		// give a different fingerprint.
+		for(int state_index = 0; state_index < 3; ++state_index)
+		{
+			fingerprint = DictionaryMixHash(fingerprint + state[state_index]);
+		}
+	}
+	return fingerprint;
+}
+
+// Return an iterator of the dictionary that is safe or not.
+// O(1)
+static DictionaryIterator *DictionaryCreateIterator(Dictionary *dictionary, int safe)
+{
+	DictionaryIterator *iterator = Malloc(CAST(int64_t)sizeof(DictionaryIterator));
+	iterator->dictionary_ = dictionary;
+	iterator->table_ = 0;
+	iterator->index_ = -1;
+	iterator->safe_ = safe;
+	iterator->node_ = NULL;
+	iterator->next_node_ = NULL;
+	iterator->fingerprint_ = 0;
+	return iterator;
+}
+
+// Return an unsafe iterator of the dictionary. It doesn't pause rehashing, so it's
+// cheaper for read-only loops, but only DictionaryNext() should be called until it's
+// released, which asserts that the dictionary wasn't modified.
+// O(1)
+DictionaryIterator *DictionaryGetIterator(Dictionary *dictionary)
+{
+	return DictionaryCreateIterator(dictionary, 0);
+}
+
+// Return a safe iterator of the dictionary. Rehashing is paused until it's released,
+// so that no element is missed or returned twice, and elements can be deleted, or
+// looked up, while iterating. Elements added while iterating may or may not be returned.
+// O(1)
+DictionaryIterator *DictionaryGetSafeIterator(Dictionary *dictionary)
+{
+	return DictionaryCreateIterator(dictionary, 1);
+}
+
+// Return the next element of the iterator, NULL if all elements have been returned.
+// O(1) amortized.
+HashTableNode *DictionaryNext(DictionaryIterator *iterator)
+{
+	Dictionary *dictionary = iterator->dictionary_;
+	for(;;)
+	{
+		if(iterator->node_ != NULL) // Move to the next node in the same slot.
+		{
+			iterator->node_ = iterator->next_node_;
+		}
+		else // Move to the next slot.
+		{
+			HashTable *hash_table = &dictionary->hash_table_[iterator->table_];
+			if(iterator->index_ == -1 && iterator->table_ == 0) // The first call.
+			{
+				if(iterator->safe_)
+				{
+					++dictionary->iterator_number_;
+				}
+				else
+				{
+					iterator->fingerprint_ = DictionaryFingerprint(dictionary);
+				}
+			}
+			++iterator->index_;
+			if(iterator->index_ >= hash_table->size_)
+			{
+				// All slots of this table have been iterated. Iterate the second hash table
+				// if in rehashing, otherwise the iteration is over.
+				if(DictionaryIsRehashing(dictionary) && iterator->table_ == 0)
+				{
+					iterator->table_ = 1;
+					iterator->index_ = 0;
+					if(iterator->safe_)
+					{
+						++dictionary->second_iterator_number_;
+					}
+					hash_table = &dictionary->hash_table_[1];
+				}
+				else
+				{
+					return NULL;
+				}
+			}
+			if(hash_table->control_ != NULL) // Open addressing layout.
+			{
+				if(hash_table->control_[iterator->index_] >= 0) // Full slot.
+				{
+					return &hash_table->entry_[iterator->index_];
+				}
+				continue;
+			}
+			iterator->node_ = hash_table->slot_[iterator->index_];
+		}
+		if(iterator->node_ != NULL)
+		{
+			// Save the next node, since the returned node may be deleted by the user.
+			iterator->next_node_ = DictionaryNodeNext(iterator->node_);
+			return iterator->node_;
+		}
+	}
+}
+
+// Free the iterator memory. Resume rehashing if it's a safe iterator, or assert that
+// the dictionary wasn't modified during the iteration if it's unsafe.
+// O(1)
+void DictionaryReleaseIterator(DictionaryIterator *iterator)
+{
+	if(iterator->index_ != -1 || iterator->table_ != 0) // The iteration has started.
+	{
+		if(iterator->safe_)
+		{
+			--iterator->dictionary_->iterator_number_;
+			if(iterator->table_ == 1)
+			{
+				--iterator->dictionary_->second_iterator_number_;
+			}
+		}
+		else
+		{
+			assert(iterator->fingerprint_ == DictionaryFingerprint(iterator->dictionary_));
+		}
+	}
+	Free(iterator);
+}
+
+// Reverse the bits of value.
+// O(1)
+static uint64_t DictionaryReverseBits(uint64_t value)
+{
+	value = ((value >> 1) & 0x5555555555555555ULL) | ((value & 0x5555555555555555ULL) << 1);
+	value = ((value >> 2) & 0x3333333333333333ULL) | ((value & 0x3333333333333333ULL) << 2);
+	value = ((value >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((value & 0x0F0F0F0F0F0F0F0FULL) << 4);
+	value = ((value >> 8) & 0x00FF00FF00FF00FFULL) | ((value & 0x00FF00FF00FF00FFULL) << 8);
+	value = ((value >> 16) & 0x0000FFFF0000FFFFULL) | ((value & 0x0000FFFF0000FFFFULL) << 16);
+	return (value >> 32) | (value << 32);
+}
+
+// Return the mask of the scan cursor of hash_table: the slots of the chained layout,
+// the groups of the open addressing layout.
+#define DictionaryScanMask(dictionary, hash_table) \
+(DictionaryIsOpenAddressing(dictionary) ? \
+	CAST(uint64_t)((hash_table)->size_ / DICTIONARY_GROUP_WIDTH - 1) : \
+	CAST(uint64_t)(hash_table)->size_mask_)
+
+// Call callback for every element of the bucket index of hash_table.
+// Chained layout: the bucket is the slot's linked list.
+// Open addressing layout: the bucket is all the elements whose probe sequence starts at
+// the group index. They are all in the groups of this probe sequence up to the first group
+// that has an empty slot, where DictionaryOpenFindInHashTable() would stop, so we walk
+// it and check the home group of every full slot.
+// O(1) expected.
+static void DictionaryScanBucket(Dictionary *dictionary, HashTable *hash_table, uint64_t index,
+                                 DictionaryScanFunction callback, void *argument)
+{
+	if(DictionaryIsOpenAddressing(dictionary) == 0)
+	{
+		HashTableNode *node = hash_table->slot_[index], *next_node = NULL;
+		while(node != NULL)
+		{
+			next_node = DictionaryNodeNext(node);
+			callback(argument, node);
+			node = next_node;
+		}
+		return;
+	}
+	int64_t home = CAST(int64_t)index * DICTIONARY_GROUP_WIDTH;
+	int64_t position = home;
+	int64_t group_number = hash_table->size_ / DICTIONARY_GROUP_WIDTH;
+	for(int64_t probe = 1; probe <= group_number; ++probe)
+	{
+		const signed char *control = hash_table->control_ + position;
+		uint32_t full = ~DictionaryGroupMatchFree(control) & DICTIONARY_GROUP_FULL_MASK;
+		for(; full != 0; full &= full - 1)
+		{
+			int64_t slot_index = position + __builtin_ctz(full);
+			HashTableNode *node = &hash_table->entry_[slot_index];
+			uint64_t hash = hash_table->hash_ != NULL ? hash_table->hash_[slot_index] :
+			                DictionaryMixHash(DictionaryHashKey(dictionary, node->key_));
+			if(DictionaryProbeStart(hash_table, hash) == home)
+			{
+				callback(argument, node);
+			}
+		}
+		if(DictionaryGroupMatch(control, DICTIONARY_CONTROL_EMPTY) != 0)
+		{
+			return;
+		}
+		position = (position + probe * DICTIONARY_GROUP_WIDTH) & hash_table->size_mask_;
+	}
+}
+
+// Call callback for the elements of the slot(s) specified by cursor and return the cursor
+// of the next call, 0 when the scan is finished. Start a scan with cursor 0.
+// A scan is stateless: the dictionary keeps nothing, so scans can be abandoned at any
+// time, and every element that is in the dictionary during the whole scan is returned
+// at least once, even if the hash table is resized between the calls. An element may be
+// returned more than once, which the caller must handle.
+//
+// The cursor is the slot index(the group index in the open addressing layout), but it's
+// incremented in reverse binary order: its high bits are incremented first. As the size of
+// hash table is a power of 2, a slot of a table whose mask has m bits is split into
+// the slots that have the same low m bits in a larger table, and they are consecutive
+// in reverse binary order, so the slots already scanned before expanding are not
+// scanned again, and the slots not scanned yet are not skipped. After shrinking,
+// some slots may be scanned again, but none are skipped.
+// During rehashing, scan the slot of the smaller table, and then all the slots of the
+// larger table that it will be split into.
+//
+// The callback must not modify the dictionary; rehashing steps are paused as the
+// callback may look up keys.
+// O(1) expected for each call.
+uint64_t DictionaryScan(Dictionary *dictionary, uint64_t cursor,
+                        DictionaryScanFunction callback, void *argument)
+{
+	if(dictionary->hash_table_[0].element_number_ + dictionary->hash_table_[1].element_number_ == 0)
+	{
+		return 0;
+	}
+	++dictionary->iterator_number_; // Pause rehashing.
+	if(DictionaryIsRehashing(dictionary) == 0)
+	{
+		HashTable *hash_table = &dictionary->hash_table_[0];
+		uint64_t mask = DictionaryScanMask(dictionary, hash_table);
+		DictionaryScanBucket(dictionary, hash_table, cursor & mask, callback, argument);
+		// Set the unmasked bits so that incrementing the reversed cursor carries into
+		// the masked bits.
+		cursor |= ~mask;
+		cursor = DictionaryReverseBits(DictionaryReverseBits(cursor) + 1);
+	}
+	else
+	{
+		HashTable *small_table = &dictionary->hash_table_[0],
+		           *large_table = &dictionary->hash_table_[1];
+		if(small_table->size_ > large_table->size_)
+		{
+			small_table = &dictionary->hash_table_[1];
+			large_table = &dictionary->hash_table_[0];
+		}
+		uint64_t small_mask = DictionaryScanMask(dictionary, small_table),
+		         large_mask = DictionaryScanMask(dictionary, large_table);
+		DictionaryScanBucket(dictionary, small_table, cursor & small_mask, callback, argument);
+		// Scan all the slots of the large table that the small table's slot is split into.
+		do
+		{
+			DictionaryScanBucket(dictionary, large_table, cursor & large_mask, callback, argument);
+			cursor |= ~large_mask;
+			cursor = DictionaryReverseBits(DictionaryReverseBits(cursor) + 1);
+		}
+		while(cursor & (small_mask ^ large_mask));
+	}
+	--dictionary->iterator_number_;
+	return cursor;
+}
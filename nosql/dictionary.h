@@ -10,6 +10,17 @@
 #define DICTIONARY_SUCCESS 1
 #define DICTIONARY_ERROR 0
 #define DICTIONARY_HASH_TABLE_INITIAL_SIZE 4
+// The number of keys that DictionaryFindBatch() looks up at once.
+#define DICTIONARY_FIND_BATCH_SIZE 16
+// Shrink the hash table when less than this percent of its slots are used.
+#define DICTIONARY_SHRINK_FILL_PERCENT 10
+
+// Hash table layouts, selected by HashTableType.layout_.
+// Chained: every slot points to a linked list of separately allocated nodes.
+// Open addressing(Swiss table): nodes are stored inline in an array, and an array of
+// one control byte per slot is scanned a group at a time with SIMD instructions.
+#define DICTIONARY_LAYOUT_CHAINED 0
+#define DICTIONARY_LAYOUT_OPEN_ADDRESSING 1
 
 typedef struct HashTableNode
 {
@@ -21,10 +32,9 @@ typedef struct HashTableNode
 		int64_t int64_value_;
 		double double_value_;
 	} union_value_; // Value
-	// We use chaining to solve collision(two or more keys hash to the same slot):
-	// place all the elements that hash to the same slot into the same linked list.
-	// The next_ field is used to link node one by one to make up a link list.
-	struct HashTableNode *next_;
+	// The chained layout links the nodes of a slot by a pointer after the HashTableNode,
+	// see HashTableChainedNode in dictionary.c, so that the inline nodes of the open
+	// addressing layout don't waste room for it.
 } HashTableNode;
 
 typedef struct HashTable
@@ -32,22 +42,44 @@ typedef struct HashTable
 	// slot_ is an array of pointers to HashTableNode. Every pointer can be think of
 	// as a slot and it points to the first element in its slot.
 	HashTableNode **slot_;
-	int size_; // The number of slots.
-	int size_mask_; // size_mask_ = size_ -1, it is used to calculate slot index.
+	int64_t size_; // The number of slots.
+	int64_t size_mask_; // size_mask_ = size_ -1, it is used to calculate slot index.
 	// Since we use chaining to solve collision, there may be many nodes chained in
 	// the same slot. This field stores the number of all elements in hash table, which is
 	// may be greater than size_.
-	int element_number_;
+	int64_t element_number_;
+	// Open addressing layout only, slot_ is NULL.
+	// entry_ is an array of size_ inline nodes, followed in the same allocation by
+	// control_, an array of size_ control bytes: control_[i] is empty, deleted or
+	// the 7 low bits of the mixed hash value of the key stored in entry_[i].
+	HashTableNode *entry_;
+	signed char *control_;
+	int64_t deleted_number_; // The number of deleted(tombstone) slots.
+	// Open addressing layout with HashTableType.cache_hash_ only, otherwise NULL.
+	// hash_[i] is the mixed hash value of the key stored in entry_[i], it's stored in the
+	// same allocation between entry_ and control_.
+	uint64_t *hash_;
 } HashTable;
 
 typedef struct HashTableType
 {
-	int (*HashFunction) (const void *key); // Calculate hash value.
+	uint64_t (*HashFunction) (const void *key); // Calculate 64 bits hash value.
 	int (*KeyCompare) (void *argument, const void *key1, const void *key2); // Compare keys.
 	void* (*KeyDuplicate) (void *argument, const void *key); // Duplicate key.
 	void* (*ValueDuplicate) (void *argument, const void *value); // Duplicate value.
 	void (*KeyDestructor) (void *argument, void *key); // Destruct key.
 	void (*ValueDestructor) (void *argument, void *value); // Destruct value.
+	int layout_; // DICTIONARY_LAYOUT_CHAINED(default, 0) or DICTIONARY_LAYOUT_OPEN_ADDRESSING.
+	// Nonzero: store the hash value of every key beside its node, 8 more bytes per key.
+	// Rehashing moves nodes without calling HashFunction(), and KeyCompare() is only
+	// called for keys whose hash values are equal. Worth it for keys that are expensive to
+	// hash or compare, e.g., strings.
+	int cache_hash_;
+	// Optional, for DictionaryFindView(): a view is another representation of a key that
+	// is cheaper to build, e.g., a slice of a buffer instead of an SDS key. The hash value
+	// of a view must be equal to the one of the key it's equal to.
+	uint64_t (*ViewHashFunction) (const void *view);
+	int (*ViewKeyCompare) (void *argument, const void *view, const void *key);
 } HashTableType;
 
 typedef struct Dictionary
@@ -57,19 +89,55 @@ typedef struct Dictionary
 	HashTable hash_table_[2];
 	HashTableType *type_; // Functions that are type-specific
 	void *argument_; // Argument that passed to functions pointed by type_.
-	int rehash_index_; // The index that is rehashing in progress. -1: stop; 0: start.
+	// The index that is rehashing in progress. -1: stop; 0: start.
+	// In the open addressing layout, it's always the first slot of a group.
+	int64_t rehash_index_;
 	int iterator_number_; // The number of iterators currently running.
+	// The number of safe iterators that have moved to the second hash table.
+	int second_iterator_number_;
+	// Rehashing statistics, times are in microseconds of a monotonic clock.
+	int64_t rehash_start_time_; // When the current rehashing started, 0 if not rehashing.
+	int64_t rehash_total_time_; // The total time spent in the finished rehashings.
+	int64_t rehash_finished_number_; // The number of finished rehashings.
 } Dictionary;
 
+// If safe_ is 1, this is a safe iterator: we can call DictionaryAdd(), DictionaryFind(),
+// and other functions against the dictionary while iterating, e.g., delete the element
+// just returned. Otherwise it is an unsafe iterator: only DictionaryNext() should be
+// called while iterating, which is checked by the fingerprint when it's released.
+typedef struct DictionaryIterator
+{
+	Dictionary *dictionary_;
+	int table_; // The index of the hash table that is iterated, 0 or 1.
+	int64_t index_; // The slot index that is iterated, -1 before the first DictionaryNext().
+	int safe_;
+	HashTableNode *node_; // The current node of a chained slot.
+	// The node next to node_, saved before node_ is returned, since it may be deleted.
+	HashTableNode *next_node_;
+	uint64_t fingerprint_; // Unsafe iterator only, see DictionaryFingerprint().
+} DictionaryIterator;
+
+// The callback of DictionaryScan(), called for every scanned element.
+typedef void (*DictionaryScanFunction) (void *argument, const HashTableNode *node);
+
 // Functions implemented as macros:
 #define DictionaryIsRehashing(dictionary) ((dictionary)->rehash_index_ != -1)
+#define DictionaryIsOpenAddressing(dictionary) \
+((dictionary)->type_->layout_ == DICTIONARY_LAYOUT_OPEN_ADDRESSING)
 // Calculate the hash key's value.
 #define DictionaryHashKey(dictionary, key) (dictionary)->type_->HashFunction(key)
+// Return the index of the slot in hash_table that hash value is mapped to.
+#define DictionarySlotIndex(hash_table, hash) \
+CAST(int64_t)((hash) & CAST(uint64_t)(hash_table)->size_mask_)
 // Compare two keys by dictionary's own KeyCompare(), if any, or use ordinary equal.
 #define DictionaryCompareKeys(dictionary, key1, key2) \
 (((dictionary)->type_->KeyCompare) ? \
 	(dictionary)->type_->KeyCompare((dictionary)->argument_, key1, key2) : \
 	(key1) == (key2))
+// Compare key, which is a view if view is nonzero, with the key of a node.
+#define DictionaryCompareLookupKeys(dictionary, key, node_key, view) \
+((view) ? (dictionary)->type_->ViewKeyCompare((dictionary)->argument_, key, node_key) : \
+	DictionaryCompareKeys(dictionary, key, node_key))
 // Set the node's key by KeyDuplicate(), if any, or share the argument key.
 #define DictionarySetKey(dictionary, node, key) \
 node->key_ = (((dictionary)->type_->KeyDuplicate) ? \
@@ -104,29 +172,68 @@ Dictionary *DictionaryCreate(HashTableType *type, void *argument);
 int DictionaryRehash(Dictionary *dictionary, int rehash_count);
 // If there are no safe iterators bound to hash table, perform a step of rehashing.
 void DictionaryRehashStep(Dictionary *dictionary);
+// Rehash in batches of 100 steps until rehashing is done or milliseconds has been spent.
+// Return the number of steps performed. To be called periodically for idle dictionaries.
+int64_t DictionaryRehashMilliseconds(Dictionary *dictionary, int64_t milliseconds);
+// Return how long the current rehashing has lasted in microseconds, 0 if not rehashing.
+int64_t DictionaryRehashingTime(Dictionary *dictionary);
 // Create(when dictionary is empty) or Expand the hash table.
-int DictionaryExpand(Dictionary *dictionary, const int size);
+int DictionaryExpand(Dictionary *dictionary, const int64_t size);
+// Resize the hash table to the minimal size that contains all the elements.
+int DictionaryResizeToFit(Dictionary *dictionary);
 // Add a new node to dictionary without setting its value, and return the added
 // node's pointer, which let the user fill the value field as he wishes.
+// In the open addressing layout, nodes are moved by rehashing, so node pointers returned
+// by any function are only valid until the next call on the same dictionary.
 HashTableNode *DictionaryAddRaw(Dictionary *dictionary, const void *key);
 // Add a pair of key-value to dictionary.
 int DictionaryAdd(Dictionary *dictionary, const void *key, const void *value);
 // Return the pointer to the node whose key matches the argument key.
 // NULL if can't find.
 HashTableNode *DictionaryFind(Dictionary *dictionary, const void *key);
+// Return the pointer to the node whose key matches the view of a key, see
+// HashTableType.ViewHashFunction(). NULL if can't find.
+HashTableNode *DictionaryFindView(Dictionary *dictionary, const void *view);
+// Find key_number keys at once: out_nodes[i] is the node of keys[i], NULL if can't find.
+// Return the number of keys found. Faster than DictionaryFind() one by one for large
+// tables, since the cache misses of several keys overlap.
+int64_t DictionaryFindBatch(Dictionary *dictionary, const void **keys, int64_t key_number,
+                            HashTableNode **out_nodes);
 // Add a new key-value pair if the key doesn't exist in dictionary yet;
 // otherwise replace current value with argument value.
 // Return 1 if the new key-value pair is added; 0 if only replace value.
 int DictionaryReplace(Dictionary *dictionary, const void *key, const void *value);
 // Get the value of element whose key matches the supplied key.
 void *DictionaryGetValue(Dictionary *dictionary, const void *key);
+// Get the value of element whose key matches the view of a key.
+void *DictionaryGetValueView(Dictionary *dictionary, const void *view);
 // Delete specified key-value pair in the dictionary.
 int DictionaryDelete(Dictionary *dictionary, const void *key);
 // Delete specified key-value pair in the dictionary, not free its key and value.
 int DictionaryDeleteNoFree(Dictionary *dictionary, const void *key);
+// Return a random element of the dictionary, NULL if it's empty.
+HashTableNode *DictionaryGetRandomKey(Dictionary *dictionary);
+// Sample up to count elements from random positions, store them in out and return the
+// number of elements stored. Much cheaper per sample than DictionaryGetRandomKey(),
+// but less random, and elements may be returned more than once.
+int64_t DictionaryGetSomeKeys(Dictionary *dictionary, HashTableNode **out, int64_t count);
 // Destroy specified hash table of dictionary.
 void DictionaryClear(Dictionary *dictionary, HashTable *hash_table, void (callback)(void*));
 // Clear and free dictionary's memory.
 void DictionaryRelease(Dictionary *dictionary);
+// Return a 64 bits number that represents the current state of the dictionary.
+uint64_t DictionaryFingerprint(Dictionary *dictionary);
+// Return an unsafe iterator of the dictionary.
+DictionaryIterator *DictionaryGetIterator(Dictionary *dictionary);
+// Return a safe iterator of the dictionary.
+DictionaryIterator *DictionaryGetSafeIterator(Dictionary *dictionary);
+// Return the next element of the iterator, NULL if all elements have been returned.
+HashTableNode *DictionaryNext(DictionaryIterator *iterator);
+// Free the iterator memory.
+void DictionaryReleaseIterator(DictionaryIterator *iterator);
+// Call callback for the elements of the slot(s) specified by cursor and return the cursor
+// of the next call, 0 when the scan is finished. Start a scan with cursor 0.
+uint64_t DictionaryScan(Dictionary *dictionary, uint64_t cursor,
+                        DictionaryScanFunction callback, void *argument);
 
 #endif // NOSQL_SRC_HASH_TABLE_H_
@@ -0,0 +1,311 @@
+#include <hash_function.h>
+
+#include <stdio.h> // fopen(), fread(), fclose()
+#include <string.h> // memcpy()
+#include <time.h> // time(), clock()
+
+#include <simple_dynamic_string.h>
+
+// The wyhash secret.
+#define HASH_SECRET0 0xa0761d6478bd642fULL
+#define HASH_SECRET1 0xe7037ed1a0b428dbULL
+#define HASH_SECRET2 0x8ebc6af09c88c6e3ULL
+#define HASH_SECRET3 0x589965cc75374cc3ULL
+
+// The process-wide seed of all hash functions. A fixed seed makes hash values
+// predictable, so servers should call HashInitRandomSeed() at startup, which is done by
+// DictionaryCreate() if nobody did it before.
+static uint8_t g_hash_seed[HASH_SEED_SIZE];
+static int g_hash_seed_initialized = 0;
+static uint64_t g_hash_fast_seed = 0; // The seed of HashFast(), derived from g_hash_seed.
+
+static inline uint64_t HashRead64(const uint8_t *data);
+static inline uint64_t HashMultiplyFold(uint64_t a, uint64_t b);
+
+// Set the process-wide seed of all hash functions.
+// O(1)
+void HashSetSeed(const uint8_t *seed)
+{
+	memcpy(g_hash_seed, seed, HASH_SEED_SIZE);
+	g_hash_seed_initialized = 1;
+	g_hash_fast_seed = HashRead64(g_hash_seed) ^ HashRead64(g_hash_seed + 8);
+	g_hash_fast_seed ^= HashMultiplyFold(g_hash_fast_seed ^ HASH_SECRET0, HASH_SECRET1);
+}
+
+// Return a pointer to the HASH_SEED_SIZE bytes process-wide seed.
+// O(1)
+const uint8_t *HashGetSeed()
+{
+	return g_hash_seed;
+}
+
+// Generate a random process-wide seed from /dev/urandom if no seed has been set yet.
+// If /dev/urandom is not available, fall back to the time and a stack address, which
+// is randomized by ASLR.
+// O(1)
+void HashInitRandomSeed()
+{
+	if(g_hash_seed_initialized)
+	{
+		return;
+	}
+	uint8_t seed[HASH_SEED_SIZE];
+	FILE *file = fopen("/dev/urandom", "rb");
+	if(file == NULL || fread(seed, 1, HASH_SEED_SIZE, file) != HASH_SEED_SIZE)
+	{
+		uint64_t entropy[2] = {CAST(uint64_t)time(NULL) ^ CAST(uint64_t)clock(),
+		                       CAST(uint64_t)CAST(uintptr_t)seed
+		                      };
+		memcpy(seed, entropy, HASH_SEED_SIZE);
+	}
+	if(file != NULL)
+	{
+		fclose(file);
+	}
+	HashSetSeed(seed);
+}
+
+// Read 8 bytes as a little endian integer on little endian machines; it doesn't
+// matter on big endian machines as long as the result is always the same.
+static inline uint64_t HashRead64(const uint8_t *data)
+{
+	uint64_t word;
+	memcpy(&word, data, sizeof(word));
+	return word;
+}
+
+static inline uint64_t HashRead32(const uint8_t *data)
+{
+	uint32_t word;
+	memcpy(&word, data, sizeof(word));
+	return word;
+}
+
+// Convert the 8 bytes of word to lower case at once(SWAR): a byte is an upper case
+// ASCII letter if its low 7 bits are in ['A', 'Z'] and its high bit is not set.
+// O(1)
+static inline uint64_t HashToLower64(uint64_t word)
+{
+	uint64_t heptets = word & 0x7f7f7f7f7f7f7f7fULL;
+	uint64_t at_least_a = heptets + 0x3f3f3f3f3f3f3f3fULL; // High bit set if >= 'A'.
+	uint64_t above_z = heptets + 0x2525252525252525ULL; // High bit set if > 'Z'.
+	uint64_t upper = (at_least_a ^ above_z) & ~word & 0x8080808080808080ULL;
+	return word | (upper >> 2); // 0x80 >> 2 == 'a' - 'A'
+}
+
+// Read the last length(< 8) bytes into an integer, padding with zero bytes.
+static inline uint64_t HashReadTail(const uint8_t *data, int64_t length, int no_case)
+{
+	uint8_t tail[8] = {0};
+	memcpy(tail, data, CAST(size_t)length);
+	uint64_t word = HashRead64(tail);
+	return no_case ? HashToLower64(word) : word;
+}
+
+#define HASH_ROTATE_LEFT(x, b) CAST(uint64_t)(((x) << (b)) | ((x) >> (64 - (b))))
+#define HASH_SIP_ROUND(v0, v1, v2, v3) \
+do \
+{ \
+	v0 += v1; v1 = HASH_ROTATE_LEFT(v1, 13); v1 ^= v0; v0 = HASH_ROTATE_LEFT(v0, 32); \
+	v2 += v3; v3 = HASH_ROTATE_LEFT(v3, 16); v3 ^= v2; \
+	v0 += v3; v3 = HASH_ROTATE_LEFT(v3, 21); v3 ^= v0; \
+	v2 += v1; v1 = HASH_ROTATE_LEFT(v1, 17); v1 ^= v2; v2 = HASH_ROTATE_LEFT(v2, 32); \
+} while(0)
+
+// SipHash with 1 compression round and 2 finalization rounds, as used by Redis and
+// Python: much faster than SipHash-2-4 and still keyed, so attackers that don't know
+// the seed can't generate colliding keys. The compiler specializes it for no_case.
+// O(N)
+static uint64_t HashSipGeneric(const uint8_t *data, int64_t length, int no_case)
+{
+	uint64_t k0 = HashRead64(g_hash_seed), k1 = HashRead64(g_hash_seed + 8);
+	uint64_t v0 = 0x736f6d6570736575ULL ^ k0, v1 = 0x646f72616e646f6dULL ^ k1,
+	         v2 = 0x6c7967656e657261ULL ^ k0, v3 = 0x7465646279746573ULL ^ k1;
+	const uint8_t *end = data + (length & ~CAST(int64_t)7);
+	for(; data != end; data += 8)
+	{
+		uint64_t word = HashRead64(data);
+		word = no_case ? HashToLower64(word) : word;
+		v3 ^= word;
+		HASH_SIP_ROUND(v0, v1, v2, v3);
+		v0 ^= word;
+	}
+	uint64_t last = (CAST(uint64_t)length << 56) | HashReadTail(data, length & 7, no_case);
+	v3 ^= last;
+	HASH_SIP_ROUND(v0, v1, v2, v3);
+	v0 ^= last;
+	v2 ^= 0xff;
+	HASH_SIP_ROUND(v0, v1, v2, v3);
+	HASH_SIP_ROUND(v0, v1, v2, v3);
+	return v0 ^ v1 ^ v2 ^ v3;
+}
+
+// Multiply a and b to a 128 bits integer: low and high are its low and high 64 bits.
+static inline void HashMultiply(uint64_t a, uint64_t b, uint64_t *low, uint64_t *high)
+{
+#ifdef __SIZEOF_INT128__
+	__uint128_t product = CAST(__uint128_t)a * b;
+	*low = CAST(uint64_t)product;
+	*high = CAST(uint64_t)(product >> 64);
+#else
+	uint64_t a_high = a >> 32, a_low = CAST(uint32_t)a, b_high = b >> 32, b_low = CAST(uint32_t)b;
+	uint64_t high_high = a_high * b_high, high_low = a_high * b_low,
+	         low_high = a_low * b_high, low_low = a_low * b_low;
+	uint64_t middle = (low_low >> 32) + CAST(uint32_t)high_low + CAST(uint32_t)low_high;
+	*low = (middle << 32) | CAST(uint32_t)low_low;
+	*high = high_high + (high_low >> 32) + (low_high >> 32) + (middle >> 32);
+#endif
+}
+
+// Multiply a and b to a 128 bits integer and fold it to 64 bits by xor.
+static inline uint64_t HashMultiplyFold(uint64_t a, uint64_t b)
+{
+	uint64_t low, high;
+	HashMultiply(a, b, &low, &high);
+	return low ^ high;
+}
+
+static inline uint64_t HashFastRead64(const uint8_t *data, int no_case)
+{
+	return no_case ? HashToLower64(HashRead64(data)) : HashRead64(data);
+}
+
+// A wyhash-style hash: every 16 bytes of data cost one 64x64->128 multiplication,
+// and keys up to 16 bytes are read with at most 2 overlapping loads.
+// It's not designed to resist hash flooding, only use it for trusted keys.
+// O(N)
+static uint64_t HashFastGeneric(const uint8_t *data, int64_t length, int no_case)
+{
+	uint64_t seed = g_hash_fast_seed;
+	uint64_t a = 0, b = 0;
+	if(length <= 16)
+	{
+		if(length >= 4)
+		{
+			// Two overlapping 8 bytes, or four overlapping 4 bytes, cover all the data.
+			int64_t middle = (length >> 3) << 2;
+			a = (HashRead32(data) << 32) | HashRead32(data + middle);
+			b = (HashRead32(data + length - 4) << 32) | HashRead32(data + length - 4 - middle);
+			if(no_case)
+			{
+				a = HashToLower64(a);
+				b = HashToLower64(b);
+			}
+		}
+		else if(length > 0)
+		{
+			a = HashReadTail(data, length, no_case);
+		}
+	}
+	else
+	{
+		int64_t left = length;
+		if(left > 48) // Three independent lanes to use instruction level parallelism.
+		{
+			uint64_t seed1 = seed, seed2 = seed;
+			do
+			{
+				seed = HashMultiplyFold(HashFastRead64(data, no_case) ^ HASH_SECRET1,
+				                        HashFastRead64(data + 8, no_case) ^ seed);
+				seed1 = HashMultiplyFold(HashFastRead64(data + 16, no_case) ^ HASH_SECRET2,
+				                         HashFastRead64(data + 24, no_case) ^ seed1);
+				seed2 = HashMultiplyFold(HashFastRead64(data + 32, no_case) ^ HASH_SECRET3,
+				                         HashFastRead64(data + 40, no_case) ^ seed2);
+				data += 48;
+				left -= 48;
+			}
+			while(left > 48);
+			seed ^= seed1 ^ seed2;
+		}
+		while(left > 16)
+		{
+			seed = HashMultiplyFold(HashFastRead64(data, no_case) ^ HASH_SECRET1,
+			                        HashFastRead64(data + 8, no_case) ^ seed);
+			data += 16;
+			left -= 16;
+		}
+		// The last 16 bytes, which may overlap the bytes already hashed.
+		a = HashFastRead64(data + left - 16, no_case);
+		b = HashFastRead64(data + left - 8, no_case);
+	}
+	HashMultiply(a ^ HASH_SECRET1, b ^ seed, &a, &b);
+	return HashMultiplyFold(a ^ HASH_SECRET0 ^ CAST(uint64_t)length, b ^ HASH_SECRET1);
+}
+
+// O(N)
+uint64_t HashSip(const void *data, int64_t length)
+{
+	return HashSipGeneric(data, length, 0);
+}
+
+// O(N)
+uint64_t HashSipNoCase(const void *data, int64_t length)
+{
+	return HashSipGeneric(data, length, 1);
+}
+
+// O(N)
+uint64_t HashFast(const void *data, int64_t length)
+{
+	return HashFastGeneric(data, length, 0);
+}
+
+// O(N)
+uint64_t HashFastNoCase(const void *data, int64_t length)
+{
+	return HashFastGeneric(data, length, 1);
+}
+
+// O(N)
+uint64_t HashSDS(const void *key)
+{
+	return HashSip(key, get_length(CAST(const String)key));
+}
+
+// O(N)
+uint64_t HashSDSNoCase(const void *key)
+{
+	return HashSipNoCase(key, get_length(CAST(const String)key));
+}
+
+// O(N)
+uint64_t HashSDSFast(const void *key)
+{
+	return HashFast(key, get_length(CAST(const String)key));
+}
+
+// O(N)
+uint64_t HashSDSFastNoCase(const void *key)
+{
+	return HashFastNoCase(key, get_length(CAST(const String)key));
+}
+
+// Hash functions of SDSView, equal to the ones of the SDS strings with the same content,
+// to be used as HashTableType.ViewHashFunction.
+// O(N)
+uint64_t HashSDSView(const void *view)
+{
+	const SDSView *sds_view = view;
+	return HashSip(sds_view->data_, sds_view->length_);
+}
+
+// O(N)
+uint64_t HashSDSViewNoCase(const void *view)
+{
+	const SDSView *sds_view = view;
+	return HashSipNoCase(sds_view->data_, sds_view->length_);
+}
+
+// O(N)
+uint64_t HashSDSFastView(const void *view)
+{
+	const SDSView *sds_view = view;
+	return HashFast(sds_view->data_, sds_view->length_);
+}
+
+// O(N)
+uint64_t HashSDSFastViewNoCase(const void *view)
+{
+	const SDSView *sds_view = view;
+	return HashFastNoCase(sds_view->data_, sds_view->length_);
+}
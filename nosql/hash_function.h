@@ -0,0 +1,41 @@
+#ifndef NOSQL_SRC_HASH_FUNCTION_H_
+#define NOSQL_SRC_HASH_FUNCTION_H_
+
+#ifndef CAST
+#define CAST(type) (type)
+#endif
+
+#include <stdint.h>
+
+#define HASH_SEED_SIZE 16 // The seed of all hash functions is 16 bytes.
+
+// Set the process-wide seed of all hash functions. Should be called before any key is
+// hashed, since changing the seed changes all hash values.
+void HashSetSeed(const uint8_t *seed);
+// Return a pointer to the HASH_SEED_SIZE bytes process-wide seed.
+const uint8_t *HashGetSeed();
+// Generate a random process-wide seed if no seed has been set yet.
+void HashInitRandomSeed();
+
+// SipHash-1-2: a keyed hash that is resistant to hash flooding, for untrusted keys.
+uint64_t HashSip(const void *data, int64_t length);
+// SipHash-1-2 of the data with ASCII letters converted to lower case.
+uint64_t HashSipNoCase(const void *data, int64_t length);
+// A wyhash-style hash: several times faster than SipHash, for trusted keys only.
+uint64_t HashFast(const void *data, int64_t length);
+// The wyhash-style hash of the data with ASCII letters converted to lower case.
+uint64_t HashFastNoCase(const void *data, int64_t length);
+
+// Hash functions for SDS keys, to be used as HashTableType.HashFunction.
+uint64_t HashSDS(const void *key);
+uint64_t HashSDSNoCase(const void *key);
+uint64_t HashSDSFast(const void *key);
+uint64_t HashSDSFastNoCase(const void *key);
+// Hash functions for SDSView, equal to the ones of SDS keys with the same content, to be
+// used as HashTableType.ViewHashFunction.
+uint64_t HashSDSView(const void *view);
+uint64_t HashSDSViewNoCase(const void *view);
+uint64_t HashSDSFastView(const void *view);
+uint64_t HashSDSFastViewNoCase(const void *view);
+
+#endif // NOSQL_SRC_HASH_FUNCTION_H_
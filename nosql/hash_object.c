@@ -0,0 +1,174 @@
+#include <hash_object.h>
+
+#include <assert.h>
+#include <string.h> // memcmp()
+
+#include <dictionary.h>
+#include <hash_function.h>
+#include <memory.h>
+#include <simple_dynamic_string.h>
+
+static int HashObjectCompareSDS(void *argument, const void *key1, const void *key2)
+{
+	int64_t length = get_length(CAST(const String)key1);
+	return length == get_length(CAST(const String)key2) &&
+	       memcmp(key1, key2, CAST(size_t)length) == 0;
+}
+
+static int HashObjectCompareView(void *argument, const void *view, const void *key)
+{
+	return SDSViewEqual(view, CAST(const String)key);
+}
+
+static void HashObjectFreeSDS(void *argument, void *string)
+{
+	SDSFree(string);
+}
+
+// Fields are looked up by views of the argument strings, so that no SDS string is built
+// unless a field is added.
+static HashTableType hash_dictionary_type =
+{
+	HashSDS, HashObjectCompareSDS, NULL, NULL, HashObjectFreeSDS, HashObjectFreeSDS,
+	DICTIONARY_LAYOUT_CHAINED, 0, HashSDSView, HashObjectCompareView
+};
+
+// Return the value position of the field in the listpack, or NULL if not found.
+// O(N)
+static uint8_t *HashTypeListPackFind(uint8_t *list_pack, const char *field, int64_t length)
+{
+	uint8_t *position = ListPackFind(list_pack, ListPackFirst(list_pack), field, length, 1);
+	return position == NULL ? NULL : ListPackNext(list_pack, position);
+}
+
+// O(1) for the hash table encoding, O(N) for the listpack encoding.
+int HashTypeSet(NosqlObject *hash, const char *field, int64_t field_length, const char *value,
+                int64_t value_length)
+{
+	if(hash->encoding_ == NOSQL_ENCODING_LIST_PACK &&
+	        (field_length > g_hash_max_list_pack_value || value_length > g_hash_max_list_pack_value))
+	{
+		HashTypeConvert(hash, NOSQL_ENCODING_HASH_TABLE);
+	}
+	if(hash->encoding_ == NOSQL_ENCODING_LIST_PACK)
+	{
+		uint8_t *list_pack = hash->ptr_;
+		uint8_t *position = HashTypeListPackFind(list_pack, field, field_length);
+		if(position != NULL)
+		{
+			hash->ptr_ = ListPackInsert(list_pack, value, value_length, position, LIST_PACK_REPLACE,
+			                            NULL);
+			return 0;
+		}
+		list_pack = ListPackAppend(list_pack, field, field_length);
+		hash->ptr_ = ListPackAppend(list_pack, value, value_length);
+		if(HashTypeLength(hash) > g_hash_max_list_pack_entries)
+		{
+			HashTypeConvert(hash, NOSQL_ENCODING_HASH_TABLE);
+		}
+		return 1;
+	}
+	assert(hash->encoding_ == NOSQL_ENCODING_HASH_TABLE);
+	Dictionary *d = hash->ptr_;
+	SDSView view = {field, field_length};
+	HashTableNode *node = DictionaryFindView(d, &view);
+	if(node != NULL)
+	{
+		SDSFree(DictionaryGetElementValue(node));
+		DictionaryGetElementValue(node) = SDSNewLength(value, value_length);
+		return 0;
+	}
+	DictionaryAdd(d, SDSNewLength(field, field_length), SDSNewLength(value, value_length));
+	return 1;
+}
+
+// O(1) for the hash table encoding, O(N) for the listpack encoding.
+int HashTypeGet(NosqlObject *hash, const char *field, int64_t length, ListPackEntry *value)
+{
+	if(hash->encoding_ == NOSQL_ENCODING_LIST_PACK)
+	{
+		uint8_t *position = HashTypeListPackFind(hash->ptr_, field, length);
+		if(position == NULL)
+		{
+			return 0;
+		}
+		ListPackGet(position, value);
+		return 1;
+	}
+	SDSView view = {field, length};
+	String string = DictionaryGetValueView(hash->ptr_, &view);
+	if(string == NULL)
+	{
+		return 0;
+	}
+	value->string_ = string;
+	value->length_ = get_length(string);
+	value->integer_ = 0;
+	return 1;
+}
+
+// O(1) for the hash table encoding, O(N) for the listpack encoding.
+int HashTypeExists(NosqlObject *hash, const char *field, int64_t length)
+{
+	ListPackEntry value;
+	return HashTypeGet(hash, field, length, &value);
+}
+
+// The listpack encoding is kept even if the hash becomes empty.
+// O(1) for the hash table encoding, O(N) for the listpack encoding.
+int HashTypeDelete(NosqlObject *hash, const char *field, int64_t length)
+{
+	if(hash->encoding_ == NOSQL_ENCODING_LIST_PACK)
+	{
+		uint8_t *list_pack = hash->ptr_;
+		uint8_t *position = ListPackFind(list_pack, ListPackFirst(list_pack), field, length, 1);
+		if(position == NULL)
+		{
+			return 0;
+		}
+		list_pack = ListPackDelete(list_pack, position, &position); // The field.
+		hash->ptr_ = ListPackDelete(list_pack, position, NULL); // Its value.
+		return 1;
+	}
+	SDSView view = {field, length};
+	HashTableNode *node = DictionaryFindView(hash->ptr_, &view);
+	if(node == NULL)
+	{
+		return 0;
+	}
+	// The key is deleted by itself, since its node may be moved by rehashing.
+	String key = node->key_;
+	DictionaryDelete(hash->ptr_, key);
+	return 1;
+}
+
+// O(1)
+int64_t HashTypeLength(const NosqlObject *hash)
+{
+	if(hash->encoding_ == NOSQL_ENCODING_LIST_PACK)
+	{
+		return ListPackLength(hash->ptr_) / 2;
+	}
+	const Dictionary *d = hash->ptr_;
+	return d->hash_table_[0].element_number_ + d->hash_table_[1].element_number_;
+}
+
+// O(N)
+void HashTypeConvert(NosqlObject *hash, int encoding)
+{
+	assert(hash->encoding_ == NOSQL_ENCODING_LIST_PACK && encoding == NOSQL_ENCODING_HASH_TABLE);
+	uint8_t *list_pack = hash->ptr_;
+	Dictionary *d = DictionaryCreate(&hash_dictionary_type, NULL);
+	DictionaryExpand(d, ListPackLength(list_pack) / 2);
+	ListPackEntry field, value;
+	for(uint8_t *position = ListPackFirst(list_pack); position != NULL;
+	        position = ListPackNext(list_pack, ListPackNext(list_pack, position)))
+	{
+		ListPackGet(position, &field);
+		ListPackGet(ListPackNext(list_pack, position), &value);
+		DictionaryAdd(d, ListPackEntryToSDS(&field), ListPackEntryToSDS(&value));
+	}
+	ListPackFree(list_pack);
+	hash->ptr_ = d;
+	hash->encoding_ = NOSQL_ENCODING_HASH_TABLE;
+}
@@ -0,0 +1,32 @@
+#ifndef NOSQL_SRC_HASH_OBJECT_H_
+#define NOSQL_SRC_HASH_OBJECT_H_
+
+#ifndef CAST
+#define CAST(type) (type)
+#endif
+
+#include <stdint.h>
+
+#include <list_pack.h>
+#include <nosql.h>
+
+// Hash objects map fields to values, both strings. A small hash is a listpack of
+// alternating fields and values; a large one is a Dictionary of SDS strings, see
+// g_hash_max_list_pack_entries.
+
+// Set the value of the field, and return 1 if the field is new or 0 if it was updated.
+int HashTypeSet(NosqlObject *hash, const char *field, int64_t field_length, const char *value,
+                int64_t value_length);
+// Store the value of the field in *value, whose string_ points into the hash, and return 1,
+// or return 0 if the field doesn't exist. The value is valid until the hash changes.
+int HashTypeGet(NosqlObject *hash, const char *field, int64_t length, ListPackEntry *value);
+// Return whether the field exists.
+int HashTypeExists(NosqlObject *hash, const char *field, int64_t length);
+// Delete the field and return 1, or return 0 if it doesn't exist.
+int HashTypeDelete(NosqlObject *hash, const char *field, int64_t length);
+// Return the number of fields.
+int64_t HashTypeLength(const NosqlObject *hash);
+// Convert the listpack encoded hash to the encoding, NOSQL_ENCODING_HASH_TABLE.
+void HashTypeConvert(NosqlObject *hash, int encoding);
+
+#endif // NOSQL_SRC_HASH_OBJECT_H_
@@ -0,0 +1,610 @@
+#include <int_set.h>
+
+#include <string.h> // memcpy(), memmove()
+
+#include <memory.h>
+#include <simple_dynamic_string.h> // SDSGetSIMDLevel()
+
+// Return the encoding of the smallest width that holds the value.
+// O(1)
+static inline __attribute__ ((always_inline)) uint32_t IntSetValueEncoding(int64_t value)
+{
+	if(value < INT32_MIN || value > INT32_MAX)
+	{
+		return INT_SET_ENCODING_INT64;
+	}
+	if(value < INT16_MIN || value > INT16_MAX)
+	{
+		return INT_SET_ENCODING_INT32;
+	}
+	return INT_SET_ENCODING_INT16;
+}
+
+// Return contents[index] of the encoding.
+// O(1)
+static inline __attribute__ ((always_inline)) int64_t IntSetGetEncoded(const int8_t *contents,
+        int64_t index, uint32_t encoding)
+{
+	if(encoding == INT_SET_ENCODING_INT64)
+	{
+		return (CAST(const int64_t*)contents)[index];
+	}
+	if(encoding == INT_SET_ENCODING_INT32)
+	{
+		return (CAST(const int32_t*)contents)[index];
+	}
+	return (CAST(const int16_t*)contents)[index];
+}
+
+// Set contents[index] of the encoding to the value, which fits the encoding.
+// O(1)
+static inline __attribute__ ((always_inline)) void IntSetSetEncoded(int8_t *contents,
+        int64_t index, int64_t value, uint32_t encoding)
+{
+	if(encoding == INT_SET_ENCODING_INT64)
+	{
+		(CAST(int64_t*)contents)[index] = value;
+	}
+	else if(encoding == INT_SET_ENCODING_INT32)
+	{
+		(CAST(int32_t*)contents)[index] = CAST(int32_t)value;
+	}
+	else
+	{
+		(CAST(int16_t*)contents)[index] = CAST(int16_t)value;
+	}
+}
+
+// Resize the set to hold length elements of its encoding and return the new set.
+// O(N)
+static IntSet *IntSetResize(IntSet *set, int64_t length)
+{
+	return Realloc(set, CAST(int64_t)sizeof(IntSet) + length * set->encoding_);
+}
+
+// Return a new set of the encoding that can hold capacity elements.
+// O(1)
+static IntSet *IntSetNewCapacity(uint32_t encoding, int64_t capacity)
+{
+	IntSet *set = Malloc(CAST(int64_t)sizeof(IntSet) + capacity * encoding);
+	set->encoding_ = encoding;
+	set->length_ = 0;
+	return set;
+}
+
+// O(1)
+IntSet *IntSetNew()
+{
+	return IntSetNewCapacity(INT_SET_ENCODING_INT16, 0);
+}
+
+// O(1)
+void IntSetFree(IntSet *set)
+{
+	Free(set);
+}
+
+// O(1)
+int64_t IntSetBytes(const IntSet *set)
+{
+	return CAST(int64_t)sizeof(IntSet) + IntSetLength(set) * set->encoding_;
+}
+
+// Return the index of the first element of the contents that isn't smaller than the value.
+// The search halves the range without branches, which mispredict on every step otherwise.
+// O(logN)
+static inline __attribute__ ((always_inline)) int64_t IntSetLowerBound(const int8_t *contents,
+        int64_t length, int64_t value, uint32_t encoding)
+{
+	int64_t low = 0;
+	while(length > 1)
+	{
+		int64_t half = length / 2;
+		low = IntSetGetEncoded(contents, low + half - 1, encoding) < value ? low + half : low;
+		length -= half;
+	}
+	return low + (IntSetGetEncoded(contents, low, encoding) < value);
+}
+
+// Return whether the value is in the set, and store in *position its index, or the index
+// where it would be inserted.
+// O(logN)
+static int IntSetSearch(const IntSet *set, int64_t value, int64_t *position)
+{
+	int64_t length = IntSetLength(set);
+	// Values out of the range of the set are common when it is built in order.
+	if(length == 0 || value > IntSetGetEncoded(set->contents_, length - 1, set->encoding_))
+	{
+		*position = length;
+		return 0;
+	}
+	switch(set->encoding_)
+	{
+	case INT_SET_ENCODING_INT16:
+		*position = IntSetLowerBound(set->contents_, length, value, INT_SET_ENCODING_INT16);
+		break;
+	case INT_SET_ENCODING_INT32:
+		*position = IntSetLowerBound(set->contents_, length, value, INT_SET_ENCODING_INT32);
+		break;
+	default:
+		*position = IntSetLowerBound(set->contents_, length, value, INT_SET_ENCODING_INT64);
+	}
+	return IntSetGetEncoded(set->contents_, *position, set->encoding_) == value;
+}
+
+// Widen the set to the encoding of the value and add it, which is either smaller or larger
+// than all elements since it doesn't fit the current encoding.
+// O(N)
+static IntSet *IntSetUpgradeAndAdd(IntSet *set, int64_t value)
+{
+	uint32_t old_encoding = set->encoding_;
+	int64_t length = IntSetLength(set), prepend = value < 0 ? 1 : 0;
+	set->encoding_ = IntSetValueEncoding(value);
+	set = IntSetResize(set, length + 1);
+	// From the tail, so that no element is overwritten before it is moved.
+	for(int64_t index = length - 1; index >= 0; --index)
+	{
+		IntSetSetEncoded(set->contents_, index + prepend,
+		                 IntSetGetEncoded(set->contents_, index, old_encoding), set->encoding_);
+	}
+	IntSetSetEncoded(set->contents_, prepend ? 0 : length, value, set->encoding_);
+	++set->length_;
+	return set;
+}
+
+// O(N)
+IntSet *IntSetAdd(IntSet *set, int64_t value, int *success)
+{
+	if(success != NULL)
+	{
+		*success = 1;
+	}
+	if(IntSetValueEncoding(value) > set->encoding_)
+	{
+		return IntSetUpgradeAndAdd(set, value);
+	}
+	int64_t position;
+	if(IntSetSearch(set, value, &position))
+	{
+		if(success != NULL)
+		{
+			*success = 0;
+		}
+		return set;
+	}
+	int64_t length = IntSetLength(set);
+	set = IntSetResize(set, length + 1);
+	memmove(set->contents_ + (position + 1) * set->encoding_,
+	        set->contents_ + position * set->encoding_,
+	        CAST(size_t)((length - position) * set->encoding_));
+	IntSetSetEncoded(set->contents_, position, value, set->encoding_);
+	++set->length_;
+	return set;
+}
+
+// O(N)
+IntSet *IntSetRemove(IntSet *set, int64_t value, int *success)
+{
+	int64_t position;
+	if(IntSetValueEncoding(value) > set->encoding_ || !IntSetSearch(set, value, &position))
+	{
+		if(success != NULL)
+		{
+			*success = 0;
+		}
+		return set;
+	}
+	if(success != NULL)
+	{
+		*success = 1;
+	}
+	int64_t length = IntSetLength(set);
+	memmove(set->contents_ + position * set->encoding_,
+	        set->contents_ + (position + 1) * set->encoding_,
+	        CAST(size_t)((length - position - 1) * set->encoding_));
+	--set->length_;
+	return IntSetResize(set, length - 1);
+}
+
+// O(logN)
+int IntSetFind(const IntSet *set, int64_t value)
+{
+	int64_t position;
+	return IntSetValueEncoding(value) <= set->encoding_ && IntSetSearch(set, value, &position);
+}
+
+// O(1)
+int IntSetGet(const IntSet *set, int64_t index, int64_t *value)
+{
+	if(index < 0 || index >= IntSetLength(set))
+	{
+		return 0;
+	}
+	*value = IntSetGetEncoded(set->contents_, index, set->encoding_);
+	return 1;
+}
+
+// The intersection and the union of two sets are merges of sorted arrays, which the SIMD
+// kernels do a vector of elements at a time for sets of the same width; the scalar merges
+// handle the other sets and the elements left after the last full vectors.
+// The intersection compares a vector of each set, every element of one against the whole
+// vector of the other, emits the matches and moves past the vector with the smaller
+// last element, or both. The union copies a whole vector of one set if all of it is
+// smaller than the head of the other set, and merges one element without branches
+// otherwise: sets often interleave in runs, e.g., ranges of IDs, and when they don't, that
+// test is predicted well while comparing the heads isn't.
+
+// Store the elements of set1[index1...] that are in set2[index2...] in out of the encoding
+// from out[count] on, return the new count.
+// O(N + M)
+static int64_t IntSetIntersectScalar(const IntSet *set1, int64_t index1, const IntSet *set2,
+                                     int64_t index2, int8_t *out, int64_t count,
+                                     uint32_t encoding)
+{
+	while(index1 < IntSetLength(set1) && index2 < IntSetLength(set2))
+	{
+		int64_t value1 = IntSetGetEncoded(set1->contents_, index1, set1->encoding_);
+		int64_t value2 = IntSetGetEncoded(set2->contents_, index2, set2->encoding_);
+		if(value1 < value2)
+		{
+			++index1;
+		}
+		else if(value2 < value1)
+		{
+			++index2;
+		}
+		else
+		{
+			IntSetSetEncoded(out, count++, value1, encoding);
+			++index1;
+			++index2;
+		}
+	}
+	return count;
+}
+
+// Store the elements of set1[index1...] and set2[index2...] in out of the encoding from
+// out[count] on, return the new count.
+// O(N + M)
+static int64_t IntSetUnionScalar(const IntSet *set1, int64_t index1, const IntSet *set2,
+                                 int64_t index2, int8_t *out, int64_t count, uint32_t encoding)
+{
+	while(index1 < IntSetLength(set1) && index2 < IntSetLength(set2))
+	{
+		int64_t value1 = IntSetGetEncoded(set1->contents_, index1, set1->encoding_);
+		int64_t value2 = IntSetGetEncoded(set2->contents_, index2, set2->encoding_);
+		IntSetSetEncoded(out, count++, value1 < value2 ? value1 : value2, encoding);
+		index1 += value1 <= value2;
+		index2 += value2 <= value1;
+	}
+	for(; index1 < IntSetLength(set1); ++index1)
+	{
+		IntSetSetEncoded(out, count++, IntSetGetEncoded(set1->contents_, index1, set1->encoding_),
+		                 encoding);
+	}
+	for(; index2 < IntSetLength(set2); ++index2)
+	{
+		IntSetSetEncoded(out, count++, IntSetGetEncoded(set2->contents_, index2, set2->encoding_),
+		                 encoding);
+	}
+	return count;
+}
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+
+// The SSE2 intersection has 16 and 32 bits lanes only: SSE2 has no 64 bits compare, and
+// one built from 32 bits compares is slower than the scalar merge.
+
+// Return the vector of the value in every lane of width bytes.
+// O(1)
+static inline __attribute__ ((always_inline)) __m128i IntSetBroadcastSSE2(int64_t value,
+        uint32_t width)
+{
+	return width == INT_SET_ENCODING_INT16 ? _mm_set1_epi16(CAST(int16_t)value) :
+	       _mm_set1_epi32(CAST(int32_t)value);
+}
+
+// Return the lanes where block1 is equal to block2 with all bits set.
+// O(1)
+static inline __attribute__ ((always_inline)) __m128i IntSetEqualSSE2(__m128i block1,
+        __m128i block2, uint32_t width)
+{
+	return width == INT_SET_ENCODING_INT16 ? _mm_cmpeq_epi16(block1, block2) :
+	       _mm_cmpeq_epi32(block1, block2);
+}
+
+// Return the mask of the first byte of the set lanes, so that the bit index of a lane is
+// its byte offset.
+// O(1)
+static inline __attribute__ ((always_inline)) uint32_t IntSetLaneMaskSSE2(__m128i lanes,
+        uint32_t width)
+{
+	return CAST(uint32_t)_mm_movemask_epi8(lanes) &
+	       (width == INT_SET_ENCODING_INT16 ? 0x5555u : 0x1111u);
+}
+
+// O(N + M)
+static inline __attribute__ ((always_inline)) int64_t IntSetIntersectBodySSE2(
+    const IntSet *set1, const IntSet *set2, int8_t *out, uint32_t width)
+{
+	const int64_t lanes = 16 / width;
+	const int8_t *contents1 = set1->contents_, *contents2 = set2->contents_;
+	int64_t index1 = 0, index2 = 0, count = 0;
+	while(index1 + lanes <= IntSetLength(set1) && index2 + lanes <= IntSetLength(set2))
+	{
+		__m128i block = _mm_loadu_si128(CAST(const __m128i*)(contents1 + index1 * width));
+		__m128i equal = _mm_setzero_si128();
+		for(int64_t lane = 0; lane < lanes; ++lane)
+		{
+			__m128i value = IntSetBroadcastSSE2(IntSetGetEncoded(contents2, index2 + lane, width),
+			                                    width);
+			equal = _mm_or_si128(equal, IntSetEqualSSE2(block, value, width));
+		}
+		for(uint32_t mask = IntSetLaneMaskSSE2(equal, width); mask != 0; mask &= mask - 1)
+		{
+			memcpy(out + count++ * width, contents1 + index1 * width + __builtin_ctz(mask), width);
+		}
+		int64_t last1 = IntSetGetEncoded(contents1, index1 + lanes - 1, width);
+		int64_t last2 = IntSetGetEncoded(contents2, index2 + lanes - 1, width);
+		index1 += last1 <= last2 ? lanes : 0;
+		index2 += last2 <= last1 ? lanes : 0;
+	}
+	return IntSetIntersectScalar(set1, index1, set2, index2, out, count, width);
+}
+
+// The full vector is stored to out, which has room for it: count is at most index1 +
+// index2 and the vector ends before the end of its set.
+// O(N + M)
+static inline __attribute__ ((always_inline)) int64_t IntSetUnionBodySSE2(const IntSet *set1,
+        const IntSet *set2, int8_t *out, uint32_t width)
+{
+	const int64_t lanes = 16 / width;
+	const int8_t *contents1 = set1->contents_, *contents2 = set2->contents_;
+	int64_t index1 = 0, index2 = 0, count = 0;
+	while(index1 + lanes <= IntSetLength(set1) && index2 + lanes <= IntSetLength(set2))
+	{
+		int64_t value1 = IntSetGetEncoded(contents1, index1, width);
+		int64_t value2 = IntSetGetEncoded(contents2, index2, width);
+		if(IntSetGetEncoded(contents1, index1 + lanes - 1, width) < value2)
+		{
+			_mm_storeu_si128(CAST(__m128i*)(out + count * width),
+			                 _mm_loadu_si128(CAST(const __m128i*)(contents1 + index1 * width)));
+			index1 += lanes;
+			count += lanes;
+		}
+		else if(IntSetGetEncoded(contents2, index2 + lanes - 1, width) < value1)
+		{
+			_mm_storeu_si128(CAST(__m128i*)(out + count * width),
+			                 _mm_loadu_si128(CAST(const __m128i*)(contents2 + index2 * width)));
+			index2 += lanes;
+			count += lanes;
+		}
+		else
+		{
+			IntSetSetEncoded(out, count++, value1 < value2 ? value1 : value2, width);
+			index1 += value1 <= value2;
+			index2 += value2 <= value1;
+		}
+	}
+	return IntSetUnionScalar(set1, index1, set2, index2, out, count, width);
+}
+
+// O(N + M)
+static int64_t IntSetIntersectSSE2(const IntSet *set1, const IntSet *set2, int8_t *out)
+{
+	switch(set1->encoding_)
+	{
+	case INT_SET_ENCODING_INT16:
+		return IntSetIntersectBodySSE2(set1, set2, out, INT_SET_ENCODING_INT16);
+	case INT_SET_ENCODING_INT32:
+		return IntSetIntersectBodySSE2(set1, set2, out, INT_SET_ENCODING_INT32);
+	default:
+		return IntSetIntersectScalar(set1, 0, set2, 0, out, 0, INT_SET_ENCODING_INT64);
+	}
+}
+
+// O(N + M)
+static int64_t IntSetUnionSSE2(const IntSet *set1, const IntSet *set2, int8_t *out)
+{
+	switch(set1->encoding_)
+	{
+	case INT_SET_ENCODING_INT16:
+		return IntSetUnionBodySSE2(set1, set2, out, INT_SET_ENCODING_INT16);
+	case INT_SET_ENCODING_INT32:
+		return IntSetUnionBodySSE2(set1, set2, out, INT_SET_ENCODING_INT32);
+	default:
+		return IntSetUnionBodySSE2(set1, set2, out, INT_SET_ENCODING_INT64);
+	}
+}
+#endif
+
+#if defined(__SSE2__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define INT_SET_HAVE_AVX2
+// The AVX2 kernels are the SSE2 ones with 32 bytes vectors, see above.
+#define INT_SET_AVX2 __attribute__ ((target("avx2")))
+
+static inline __attribute__ ((always_inline)) INT_SET_AVX2 __m256i IntSetBroadcastAVX2(
+    int64_t value, uint32_t width)
+{
+	if(width == INT_SET_ENCODING_INT16)
+	{
+		return _mm256_set1_epi16(CAST(int16_t)value);
+	}
+	if(width == INT_SET_ENCODING_INT32)
+	{
+		return _mm256_set1_epi32(CAST(int32_t)value);
+	}
+	return _mm256_set1_epi64x(value);
+}
+
+static inline __attribute__ ((always_inline)) INT_SET_AVX2 __m256i IntSetEqualAVX2(
+    __m256i block1, __m256i block2, uint32_t width)
+{
+	if(width == INT_SET_ENCODING_INT16)
+	{
+		return _mm256_cmpeq_epi16(block1, block2);
+	}
+	if(width == INT_SET_ENCODING_INT32)
+	{
+		return _mm256_cmpeq_epi32(block1, block2);
+	}
+	return _mm256_cmpeq_epi64(block1, block2);
+}
+
+static inline __attribute__ ((always_inline)) INT_SET_AVX2 uint32_t IntSetLaneMaskAVX2(
+    __m256i lanes, uint32_t width)
+{
+	uint32_t first_bytes = width == INT_SET_ENCODING_INT16 ? 0x55555555 :
+	                       width == INT_SET_ENCODING_INT32 ? 0x11111111 : 0x01010101;
+	return CAST(uint32_t)_mm256_movemask_epi8(lanes) & first_bytes;
+}
+
+// O(N + M)
+static inline __attribute__ ((always_inline)) INT_SET_AVX2 int64_t IntSetIntersectBodyAVX2(
+    const IntSet *set1, const IntSet *set2, int8_t *out, uint32_t width)
+{
+	const int64_t lanes = 32 / width;
+	const int8_t *contents1 = set1->contents_, *contents2 = set2->contents_;
+	int64_t index1 = 0, index2 = 0, count = 0;
+	while(index1 + lanes <= IntSetLength(set1) && index2 + lanes <= IntSetLength(set2))
+	{
+		__m256i block = _mm256_loadu_si256(CAST(const __m256i*)(contents1 + index1 * width));
+		__m256i equal = _mm256_setzero_si256();
+		for(int64_t lane = 0; lane < lanes; ++lane)
+		{
+			__m256i value = IntSetBroadcastAVX2(IntSetGetEncoded(contents2, index2 + lane, width),
+			                                    width);
+			equal = _mm256_or_si256(equal, IntSetEqualAVX2(block, value, width));
+		}
+		for(uint32_t mask = IntSetLaneMaskAVX2(equal, width); mask != 0; mask &= mask - 1)
+		{
+			memcpy(out + count++ * width, contents1 + index1 * width + __builtin_ctz(mask), width);
+		}
+		int64_t last1 = IntSetGetEncoded(contents1, index1 + lanes - 1, width);
+		int64_t last2 = IntSetGetEncoded(contents2, index2 + lanes - 1, width);
+		index1 += last1 <= last2 ? lanes : 0;
+		index2 += last2 <= last1 ? lanes : 0;
+	}
+	return IntSetIntersectScalar(set1, index1, set2, index2, out, count, width);
+}
+
+// O(N + M)
+static inline __attribute__ ((always_inline)) INT_SET_AVX2 int64_t IntSetUnionBodyAVX2(
+    const IntSet *set1, const IntSet *set2, int8_t *out, uint32_t width)
+{
+	const int64_t lanes = 32 / width;
+	const int8_t *contents1 = set1->contents_, *contents2 = set2->contents_;
+	int64_t index1 = 0, index2 = 0, count = 0;
+	while(index1 + lanes <= IntSetLength(set1) && index2 + lanes <= IntSetLength(set2))
+	{
+		int64_t value1 = IntSetGetEncoded(contents1, index1, width);
+		int64_t value2 = IntSetGetEncoded(contents2, index2, width);
+		if(IntSetGetEncoded(contents1, index1 + lanes - 1, width) < value2)
+		{
+			_mm256_storeu_si256(CAST(__m256i*)(out + count * width),
+			                    _mm256_loadu_si256(CAST(const __m256i*)(contents1 + index1 * width)));
+			index1 += lanes;
+			count += lanes;
+		}
+		else if(IntSetGetEncoded(contents2, index2 + lanes - 1, width) < value1)
+		{
+			_mm256_storeu_si256(CAST(__m256i*)(out + count * width),
+			                    _mm256_loadu_si256(CAST(const __m256i*)(contents2 + index2 * width)));
+			index2 += lanes;
+			count += lanes;
+		}
+		else
+		{
+			IntSetSetEncoded(out, count++, value1 < value2 ? value1 : value2, width);
+			index1 += value1 <= value2;
+			index2 += value2 <= value1;
+		}
+	}
+	return IntSetUnionScalar(set1, index1, set2, index2, out, count, width);
+}
+
+// O(N + M)
+static INT_SET_AVX2 int64_t IntSetIntersectAVX2(const IntSet *set1, const IntSet *set2,
+        int8_t *out)
+{
+	switch(set1->encoding_)
+	{
+	case INT_SET_ENCODING_INT16:
+		return IntSetIntersectBodyAVX2(set1, set2, out, INT_SET_ENCODING_INT16);
+	case INT_SET_ENCODING_INT32:
+		return IntSetIntersectBodyAVX2(set1, set2, out, INT_SET_ENCODING_INT32);
+	default:
+		return IntSetIntersectBodyAVX2(set1, set2, out, INT_SET_ENCODING_INT64);
+	}
+}
+
+// O(N + M)
+static INT_SET_AVX2 int64_t IntSetUnionAVX2(const IntSet *set1, const IntSet *set2, int8_t *out)
+{
+	switch(set1->encoding_)
+	{
+	case INT_SET_ENCODING_INT16:
+		return IntSetUnionBodyAVX2(set1, set2, out, INT_SET_ENCODING_INT16);
+	case INT_SET_ENCODING_INT32:
+		return IntSetUnionBodyAVX2(set1, set2, out, INT_SET_ENCODING_INT32);
+	default:
+		return IntSetUnionBodyAVX2(set1, set2, out, INT_SET_ENCODING_INT64);
+	}
+}
+#endif
+
+// The elements in both sets fit the narrower encoding.
+// O(N + M)
+IntSet *IntSetIntersect(const IntSet *set1, const IntSet *set2)
+{
+	uint32_t encoding = set1->encoding_ < set2->encoding_ ? set1->encoding_ : set2->encoding_;
+	IntSet *set = IntSetNewCapacity(encoding, IntSetLength(set1) < IntSetLength(set2) ?
+	                                IntSetLength(set1) : IntSetLength(set2));
+	int64_t length = -1;
+	if(set1->encoding_ == set2->encoding_)
+	{
+		int level = SDSGetSIMDLevel();
+		(void)level;
+#if defined(INT_SET_HAVE_AVX2)
+		length = level == SDS_SIMD_AVX2 ? IntSetIntersectAVX2(set1, set2, set->contents_) : length;
+#endif
+#if defined(__SSE2__)
+		length = length < 0 && level >= SDS_SIMD_SSE2 ?
+		         IntSetIntersectSSE2(set1, set2, set->contents_) : length;
+#endif
+	}
+	if(length < 0)
+	{
+		length = IntSetIntersectScalar(set1, 0, set2, 0, set->contents_, 0, encoding);
+	}
+	set->length_ = CAST(uint32_t)length;
+	return IntSetResize(set, length);
+}
+
+// O(N + M)
+IntSet *IntSetUnion(const IntSet *set1, const IntSet *set2)
+{
+	uint32_t encoding = set1->encoding_ > set2->encoding_ ? set1->encoding_ : set2->encoding_;
+	IntSet *set = IntSetNewCapacity(encoding, IntSetLength(set1) + IntSetLength(set2));
+	int64_t length = -1;
+	if(set1->encoding_ == set2->encoding_)
+	{
+		int level = SDSGetSIMDLevel();
+		(void)level;
+#if defined(INT_SET_HAVE_AVX2)
+		length = level == SDS_SIMD_AVX2 ? IntSetUnionAVX2(set1, set2, set->contents_) : length;
+#endif
+#if defined(__SSE2__)
+		length = length < 0 && level >= SDS_SIMD_SSE2 ?
+		         IntSetUnionSSE2(set1, set2, set->contents_) : length;
+#endif
+	}
+	if(length < 0)
+	{
+		length = IntSetUnionScalar(set1, 0, set2, 0, set->contents_, 0, encoding);
+	}
+	set->length_ = CAST(uint32_t)length;
+	return IntSetResize(set, length);
+}
@@ -0,0 +1,51 @@
+#ifndef NOSQL_SRC_INT_SET_H_
+#define NOSQL_SRC_INT_SET_H_
+
+#ifndef CAST
+#define CAST(type) (type)
+#endif
+
+#include <stdint.h>
+
+// An intset is a sorted array of distinct integers in one contiguous memory block, whose
+// elements all have the width of the largest one: 2, 4 or 8 bytes. Adding a value that
+// doesn't fit the current width upgrades the whole set, and it is never downgraded.
+// Membership is a binary search. The intersection and the union of two sets of the same
+// width use the SIMD kernels of the level chosen by SDSSetSIMDLevel().
+
+#define INT_SET_ENCODING_INT16 CAST(uint32_t)sizeof(int16_t)
+#define INT_SET_ENCODING_INT32 CAST(uint32_t)sizeof(int32_t)
+#define INT_SET_ENCODING_INT64 CAST(uint32_t)sizeof(int64_t)
+
+typedef struct IntSet
+{
+	uint32_t encoding_; // The bytes of an element.
+	uint32_t length_; // The number of elements.
+	int8_t contents_[]; // The elements in ascending order.
+} IntSet;
+
+// Functions implemented as macros.
+#define IntSetLength(set) CAST(int64_t)((set)->length_)
+
+// Create a new empty intset and return the pointer to it.
+IntSet *IntSetNew();
+// Free the intset memory.
+void IntSetFree(IntSet *set);
+// Return the number of bytes of the intset.
+int64_t IntSetBytes(const IntSet *set);
+// Add the value, store in *success whether it was added, i.e., it wasn't in the set, if
+// success isn't NULL, and return the new intset.
+IntSet *IntSetAdd(IntSet *set, int64_t value, int *success);
+// Remove the value, store in *success whether it was in the set if success isn't NULL, and
+// return the new intset.
+IntSet *IntSetRemove(IntSet *set, int64_t value, int *success);
+// Return whether the value is in the set.
+int IntSetFind(const IntSet *set, int64_t value);
+// Store set[index] in *value and return 1, or return 0 if the index is out of range.
+int IntSetGet(const IntSet *set, int64_t index, int64_t *value);
+// Return a new intset of the values in both sets.
+IntSet *IntSetIntersect(const IntSet *set1, const IntSet *set2);
+// Return a new intset of the values in either set.
+IntSet *IntSetUnion(const IntSet *set1, const IntSet *set2);
+
+#endif // NOSQL_SRC_INT_SET_H_
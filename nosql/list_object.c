@@ -0,0 +1,98 @@
+#include <list_object.h>
+
+#include <assert.h>
+#include <stddef.h> // NULL
+
+#include <list_pack.h>
+#include <quick_list.h>
+
+// O(1) for the quicklist encoding, O(N) for the listpack encoding.
+void ListTypePush(NosqlObject *list, const char *value, int64_t length, int where)
+{
+	if(list->encoding_ == NOSQL_ENCODING_LIST_PACK &&
+	        (length > g_list_max_list_pack_value ||
+	         ListPackLength(list->ptr_) >= g_list_max_list_pack_entries))
+	{
+		ListTypeConvert(list, NOSQL_ENCODING_QUICK_LIST);
+	}
+	if(list->encoding_ == NOSQL_ENCODING_LIST_PACK)
+	{
+		list->ptr_ = where == QUICK_LIST_HEAD ? ListPackPrepend(list->ptr_, value, length) :
+		             ListPackAppend(list->ptr_, value, length);
+		return;
+	}
+	assert(list->encoding_ == NOSQL_ENCODING_QUICK_LIST);
+	QuickListPush(list->ptr_, value, length, where);
+}
+
+// O(1) for the quicklist encoding, O(N) for the listpack encoding.
+String ListTypePop(NosqlObject *list, int where)
+{
+	if(list->encoding_ == NOSQL_ENCODING_QUICK_LIST)
+	{
+		return QuickListPop(list->ptr_, where);
+	}
+	uint8_t *list_pack = list->ptr_;
+	uint8_t *position = where == QUICK_LIST_HEAD ? ListPackFirst(list_pack) :
+	                    ListPackLast(list_pack);
+	if(position == NULL)
+	{
+		return NULL;
+	}
+	ListPackEntry entry;
+	ListPackGet(position, &entry);
+	String string = ListPackEntryToSDS(&entry);
+	list->ptr_ = ListPackDelete(list_pack, position, NULL);
+	return string;
+}
+
+// O(N)
+String ListTypeIndex(NosqlObject *list, int64_t index)
+{
+	if(list->encoding_ == NOSQL_ENCODING_QUICK_LIST)
+	{
+		return QuickListIndex(list->ptr_, index);
+	}
+	uint8_t *position = ListPackSeek(list->ptr_, index);
+	if(position == NULL)
+	{
+		return NULL;
+	}
+	ListPackEntry entry;
+	ListPackGet(position, &entry);
+	return ListPackEntryToSDS(&entry);
+}
+
+// O(1)
+int64_t ListTypeLength(const NosqlObject *list)
+{
+	return list->encoding_ == NOSQL_ENCODING_LIST_PACK ? ListPackLength(list->ptr_) :
+	       QuickListLength(CAST(const QuickList*)list->ptr_);
+}
+
+// The entries are pushed one by one, so that the nodes are bounded by the default fill.
+// O(N)
+void ListTypeConvert(NosqlObject *list, int encoding)
+{
+	assert(list->encoding_ == NOSQL_ENCODING_LIST_PACK && encoding == NOSQL_ENCODING_QUICK_LIST);
+	uint8_t *list_pack = list->ptr_;
+	QuickList *quick_list = QuickListCreate(QUICK_LIST_DEFAULT_FILL, 0);
+	ListPackEntry entry;
+	char buffer[SDS_INT64_STRING_SIZE];
+	for(uint8_t *position = ListPackFirst(list_pack); position != NULL;
+	        position = ListPackNext(list_pack, position))
+	{
+		ListPackGet(position, &entry);
+		if(entry.string_ != NULL)
+		{
+			QuickListPushTail(quick_list, entry.string_, entry.length_);
+		}
+		else
+		{
+			QuickListPushTail(quick_list, buffer, SDSFormatInt64(buffer, entry.integer_));
+		}
+	}
+	ListPackFree(list_pack);
+	list->ptr_ = quick_list;
+	list->encoding_ = NOSQL_ENCODING_QUICK_LIST;
+}
@@ -0,0 +1,30 @@
+#ifndef NOSQL_SRC_LIST_OBJECT_H_
+#define NOSQL_SRC_LIST_OBJECT_H_
+
+#ifndef CAST
+#define CAST(type) (type)
+#endif
+
+#include <stdint.h>
+
+#include <nosql.h>
+#include <simple_dynamic_string.h>
+
+// List objects are a single listpack while they are small, and a QuickList of listpacks
+// once they grow, see g_list_max_list_pack_entries. Both ends are QUICK_LIST_HEAD and
+// QUICK_LIST_TAIL.
+
+// Add the string to the head or the tail of the list according to where.
+void ListTypePush(NosqlObject *list, const char *value, int64_t length, int where);
+// Remove the head or the tail entry according to where and return it as a new SDS string,
+// or NULL if the list is empty.
+String ListTypePop(NosqlObject *list, int where);
+// Return list[index] as a new SDS string, where negative indexes count from the tail.
+// Return NULL if the index is out of range.
+String ListTypeIndex(NosqlObject *list, int64_t index);
+// Return the number of entries.
+int64_t ListTypeLength(const NosqlObject *list);
+// Convert the listpack encoded list to the encoding, NOSQL_ENCODING_QUICK_LIST.
+void ListTypeConvert(NosqlObject *list, int encoding);
+
+#endif // NOSQL_SRC_LIST_OBJECT_H_
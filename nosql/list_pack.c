@@ -0,0 +1,548 @@
+#include <list_pack.h>
+
+#include <assert.h>
+#include <string.h> // memcpy(), memmove()
+
+#include <memory.h>
+
+#define LIST_PACK_MAX_ENCODED_INTEGER 9 // The encoding byte and 8 bytes.
+#define LIST_PACK_MAX_BACK_LENGTH 5
+
+// Read/write a little endian number of byte_number bytes.
+// O(1)
+static inline __attribute__ ((always_inline))
+uint64_t ListPackReadNumber(const uint8_t *position, int byte_number)
+{
+	uint64_t value = 0;
+	for(int index = byte_number - 1; index >= 0; --index)
+	{
+		value = (value << 8) | position[index];
+	}
+	return value;
+}
+
+static inline __attribute__ ((always_inline))
+void ListPackWriteNumber(uint8_t *position, uint64_t value, int byte_number)
+{
+	for(int index = 0; index < byte_number; ++index)
+	{
+		position[index] = CAST(uint8_t)(value >> (8 * index));
+	}
+}
+
+static inline __attribute__ ((always_inline))
+void ListPackSetBytes(uint8_t *list_pack, int64_t bytes)
+{
+	assert(bytes <= UINT32_MAX);
+	ListPackWriteNumber(list_pack, CAST(uint64_t)bytes, 4);
+}
+
+static inline __attribute__ ((always_inline))
+void ListPackSetLength(uint8_t *list_pack, int64_t length)
+{
+	ListPackWriteNumber(list_pack + 4, CAST(uint64_t)(length < LIST_PACK_UNKNOWN_LENGTH ?
+	                    length : LIST_PACK_UNKNOWN_LENGTH), 2);
+}
+
+// Return the number of bytes of the back length of an entry whose encoding and data take
+// length bytes: 7 bits per byte.
+// O(1)
+static inline __attribute__ ((always_inline))
+int ListPackBackLengthSize(int64_t length)
+{
+	return length < (1 << 7) ? 1 : length < (1 << 14) ? 2 : length < (1 << 21) ? 3 :
+	       length < (1 << 28) ? 4 : 5;
+}
+
+// The most significant 7 bits go first. All bytes but the first one have the high bit set,
+// so the reader that starts from the last byte knows when to stop.
+// O(1)
+static int ListPackEncodeBackLength(uint8_t *buffer, int64_t length)
+{
+	int size = ListPackBackLengthSize(length);
+	buffer[0] = CAST(uint8_t)((length >> (7 * (size - 1))) & 127);
+	for(int index = 1; index < size; ++index)
+	{
+		buffer[index] = CAST(uint8_t)(((length >> (7 * (size - 1 - index))) & 127) | 128);
+	}
+	return size;
+}
+
+// Decode the back length whose last byte is at position.
+// O(1)
+static int64_t ListPackDecodeBackLength(const uint8_t *position)
+{
+	int64_t length = 0;
+	for(int shift = 0; shift < 7 * LIST_PACK_MAX_BACK_LENGTH; shift += 7, --position)
+	{
+		length |= CAST(int64_t)(*position & 127) << shift;
+		if((*position & 128) == 0)
+		{
+			break;
+		}
+	}
+	return length;
+}
+
+// Encode the integer with the least bytes into buffer and return their number.
+// O(1)
+static int ListPackEncodeInteger(uint8_t *buffer, int64_t value)
+{
+	if(value >= 0 && value <= 127)
+	{
+		buffer[0] = CAST(uint8_t)value;
+		return 1;
+	}
+	if(value >= -4096 && value <= 4095)
+	{
+		uint64_t bits = CAST(uint64_t)value & 0x1FFF;
+		buffer[0] = CAST(uint8_t)(0xC0 | (bits >> 8));
+		buffer[1] = CAST(uint8_t)bits;
+		return 2;
+	}
+	int byte_number = value >= INT16_MIN && value <= INT16_MAX ? 2 :
+	                  value >= -(1 << 23) && value <= (1 << 23) - 1 ? 3 :
+	                  value >= INT32_MIN && value <= INT32_MAX ? 4 : 8;
+	buffer[0] = byte_number == 2 ? 0xF1 : byte_number == 3 ? 0xF2 : byte_number == 4 ? 0xF3 : 0xF4;
+	ListPackWriteNumber(buffer + 1, CAST(uint64_t)value, byte_number);
+	return 1 + byte_number;
+}
+
+// Return the number of bytes of the encoding of a string of length bytes.
+// O(1)
+static inline __attribute__ ((always_inline))
+int ListPackStringHeaderSize(int64_t length)
+{
+	return length < 64 ? 1 : length < 4096 ? 2 : 5;
+}
+
+// O(1)
+static int ListPackEncodeStringHeader(uint8_t *buffer, int64_t length)
+{
+	if(length < 64)
+	{
+		buffer[0] = CAST(uint8_t)(0x80 | length);
+		return 1;
+	}
+	if(length < 4096)
+	{
+		buffer[0] = CAST(uint8_t)(0xE0 | (length >> 8));
+		buffer[1] = CAST(uint8_t)length;
+		return 2;
+	}
+	assert(length <= UINT32_MAX);
+	buffer[0] = 0xF0;
+	ListPackWriteNumber(buffer + 1, CAST(uint64_t)length, 4);
+	return 5;
+}
+
+// Return the number of bytes of the encoding and the data of the entry at position.
+// O(1)
+static int64_t ListPackEncodedSize(const uint8_t *position)
+{
+	uint8_t encoding = position[0];
+	if((encoding & 0x80) == 0)
+	{
+		return 1;
+	}
+	if((encoding & 0xC0) == 0x80)
+	{
+		return 1 + (encoding & 0x3F);
+	}
+	if((encoding & 0xE0) == 0xC0)
+	{
+		return 2;
+	}
+	if((encoding & 0xF0) == 0xE0)
+	{
+		return 2 + (((encoding & 0x0F) << 8) | position[1]);
+	}
+	switch(encoding)
+	{
+	case 0xF0:
+		return 5 + CAST(int64_t)ListPackReadNumber(position + 1, 4);
+	case 0xF1:
+		return 3;
+	case 0xF2:
+		return 4;
+	case 0xF3:
+		return 5;
+	case 0xF4:
+		return 9;
+	}
+	assert(0 && "Invalid listpack encoding");
+	return 0;
+}
+
+// Return the number of bytes of the whole entry at position.
+// O(1)
+static inline __attribute__ ((always_inline))
+int64_t ListPackEntrySize(const uint8_t *position)
+{
+	int64_t length = ListPackEncodedSize(position);
+	return length + ListPackBackLengthSize(length);
+}
+
+// Make room for bytes bytes: grow by a quarter more than needed, so that appending is O(1)
+// amortized, and shrink only when at most half of the block is used, so that deleting at
+// the ends doesn't reallocate every time.
+// O(N)
+static uint8_t *ListPackResize(uint8_t *list_pack, int64_t bytes)
+{
+	int64_t capacity = MallocUsableSize(list_pack);
+	if(bytes > capacity)
+	{
+		return ReallocUsable(list_pack, bytes + bytes / 4, NULL);
+	}
+	if(bytes <= capacity / 2)
+	{
+		return Realloc(list_pack, bytes);
+	}
+	return list_pack;
+}
+
+// O(1)
+uint8_t *ListPackNew()
+{
+	uint8_t *list_pack = Malloc(LIST_PACK_HEADER_SIZE + 1);
+	ListPackSetBytes(list_pack, LIST_PACK_HEADER_SIZE + 1);
+	ListPackSetLength(list_pack, 0);
+	list_pack[LIST_PACK_HEADER_SIZE] = LIST_PACK_END;
+	return list_pack;
+}
+
+// O(1)
+void ListPackFree(uint8_t *list_pack)
+{
+	Free(list_pack);
+}
+
+// O(1)
+int64_t ListPackBytes(const uint8_t *list_pack)
+{
+	return CAST(int64_t)ListPackReadNumber(list_pack, 4);
+}
+
+// O(1), or O(N) if there are at least LIST_PACK_UNKNOWN_LENGTH entries.
+int64_t ListPackLength(const uint8_t *list_pack)
+{
+	int64_t length = CAST(int64_t)ListPackReadNumber(list_pack + 4, 2);
+	if(length < LIST_PACK_UNKNOWN_LENGTH)
+	{
+		return length;
+	}
+	length = 0;
+	for(const uint8_t *position = list_pack + LIST_PACK_HEADER_SIZE; *position != LIST_PACK_END;
+	        position += ListPackEntrySize(position))
+	{
+		++length;
+	}
+	return length;
+}
+
+// O(1)
+uint8_t *ListPackFirst(uint8_t *list_pack)
+{
+	uint8_t *position = list_pack + LIST_PACK_HEADER_SIZE;
+	return *position == LIST_PACK_END ? NULL : position;
+}
+
+// O(1)
+uint8_t *ListPackLast(uint8_t *list_pack)
+{
+	uint8_t *end = list_pack + ListPackBytes(list_pack) - 1;
+	return ListPackPrevious(list_pack, end);
+}
+
+// O(1)
+uint8_t *ListPackNext(uint8_t *list_pack, uint8_t *position)
+{
+	position += ListPackEntrySize(position);
+	return *position == LIST_PACK_END ? NULL : position;
+}
+
+// O(1)
+uint8_t *ListPackPrevious(uint8_t *list_pack, uint8_t *position)
+{
+	if(position == list_pack + LIST_PACK_HEADER_SIZE)
+	{
+		return NULL;
+	}
+	int64_t length = ListPackDecodeBackLength(position - 1);
+	return position - ListPackBackLengthSize(length) - length;
+}
+
+// Walk from the nearer end when the entry number is known.
+// O(N)
+uint8_t *ListPackSeek(uint8_t *list_pack, int64_t index)
+{
+	int64_t length = CAST(int64_t)ListPackReadNumber(list_pack + 4, 2);
+	if(length < LIST_PACK_UNKNOWN_LENGTH)
+	{
+		if(index < 0)
+		{
+			index += length;
+		}
+		if(index < 0 || index >= length)
+		{
+			return NULL;
+		}
+		if(index > length / 2)
+		{
+			index -= length;
+		}
+	}
+	uint8_t *position;
+	if(index >= 0)
+	{
+		for(position = ListPackFirst(list_pack); position != NULL && index > 0; --index)
+		{
+			position = ListPackNext(list_pack, position);
+		}
+	}
+	else
+	{
+		for(position = ListPackLast(list_pack); position != NULL && index < -1; ++index)
+		{
+			position = ListPackPrevious(list_pack, position);
+		}
+	}
+	return position;
+}
+
+// O(1)
+void ListPackGet(const uint8_t *position, ListPackEntry *entry)
+{
+	uint8_t encoding = position[0];
+	entry->string_ = NULL;
+	entry->length_ = 0;
+	if((encoding & 0x80) == 0)
+	{
+		entry->integer_ = encoding;
+	}
+	else if((encoding & 0xC0) == 0x80)
+	{
+		entry->string_ = CAST(const char*)position + 1;
+		entry->length_ = encoding & 0x3F;
+	}
+	else if((encoding & 0xE0) == 0xC0)
+	{
+		int64_t value = ((encoding & 0x1F) << 8) | position[1];
+		entry->integer_ = value >= 4096 ? value - 8192 : value;
+	}
+	else if((encoding & 0xF0) == 0xE0)
+	{
+		entry->string_ = CAST(const char*)position + 2;
+		entry->length_ = ((encoding & 0x0F) << 8) | position[1];
+	}
+	else if(encoding == 0xF0)
+	{
+		entry->string_ = CAST(const char*)position + 5;
+		entry->length_ = CAST(int64_t)ListPackReadNumber(position + 1, 4);
+	}
+	else
+	{
+		// Sign extend the byte_number bytes integer.
+		int byte_number = encoding == 0xF1 ? 2 : encoding == 0xF2 ? 3 : encoding == 0xF3 ? 4 : 8;
+		uint64_t value = ListPackReadNumber(position + 1, byte_number);
+		if(byte_number < 8 && (value >> (8 * byte_number - 1)) != 0)
+		{
+			value |= ~CAST(uint64_t)0 << (8 * byte_number);
+		}
+		entry->integer_ = CAST(int64_t)value;
+	}
+}
+
+// O(N)
+String ListPackEntryToSDS(const ListPackEntry *entry)
+{
+	return entry->string_ != NULL ? SDSNewLength(entry->string_, entry->length_) :
+	       SDSFromLongLong(entry->integer_);
+}
+
+// Compare with the string, which was parsed into *value if is_integer: since strings that
+// are the canonical form of an integer are always stored as integers, an integer entry can
+// only be equal to such a string and a string entry to any other string.
+// O(N)
+static inline __attribute__ ((always_inline))
+int ListPackEqualParsed(const uint8_t *position, const char *string, int64_t length,
+                        int is_integer, int64_t value)
+{
+	ListPackEntry entry;
+	ListPackGet(position, &entry);
+	if(entry.string_ == NULL)
+	{
+		return is_integer && entry.integer_ == value;
+	}
+	return !is_integer && entry.length_ == length &&
+	       memcmp(entry.string_, string, CAST(size_t)length) == 0;
+}
+
+// O(N)
+int ListPackEqual(const uint8_t *position, const char *string, int64_t length)
+{
+	int64_t value = 0;
+	int is_integer = SDSParseInt64(string, length, &value);
+	return ListPackEqualParsed(position, string, length, is_integer, value);
+}
+
+// The string is parsed once, not for every entry.
+// O(N)
+uint8_t *ListPackFind(uint8_t *list_pack, uint8_t *position, const char *string, int64_t length,
+                      int skip)
+{
+	int64_t value = 0;
+	int is_integer = SDSParseInt64(string, length, &value);
+	for(int skipped = 0; position != NULL; position = ListPackNext(list_pack, position))
+	{
+		if(skipped > 0)
+		{
+			--skipped;
+			continue;
+		}
+		if(ListPackEqualParsed(position, string, length, is_integer, value))
+		{
+			return position;
+		}
+		skipped = skip;
+	}
+	return NULL;
+}
+
+// Insert or replace with the entry whose encoding and data are header, then string. The
+// listpack is grown before moving the tail to the right, or shrunk after moving it to the
+// left, so that the moved bytes are always inside the block.
+// O(N)
+static uint8_t *ListPackInsertEncoded(uint8_t *list_pack, const uint8_t *header,
+                                      int64_t header_size, const char *string, int64_t length,
+                                      uint8_t *position, int where, uint8_t **new_position)
+{
+	int64_t bytes = ListPackBytes(list_pack);
+	if(position == NULL)
+	{
+		position = list_pack + bytes - 1;
+		where = LIST_PACK_BEFORE;
+	}
+	else if(where == LIST_PACK_AFTER)
+	{
+		position += ListPackEntrySize(position);
+		where = LIST_PACK_BEFORE;
+	}
+	int64_t offset = position - list_pack;
+	int64_t old_size = where == LIST_PACK_REPLACE ? ListPackEntrySize(position) : 0;
+	int64_t encoded_size = header_size + length;
+	int64_t new_size = encoded_size + ListPackBackLengthSize(encoded_size);
+	int64_t new_bytes = bytes + new_size - old_size;
+	int64_t tail_size = bytes - offset - old_size;
+	if(new_size > old_size)
+	{
+		list_pack = ListPackResize(list_pack, new_bytes);
+	}
+	memmove(list_pack + offset + new_size, list_pack + offset + old_size, CAST(size_t)tail_size);
+	if(new_size < old_size)
+	{
+		list_pack = ListPackResize(list_pack, new_bytes);
+	}
+	uint8_t *entry = list_pack + offset;
+	memcpy(entry, header, CAST(size_t)header_size);
+	if(length != 0)
+	{
+		memcpy(entry + header_size, string, CAST(size_t)length);
+	}
+	ListPackEncodeBackLength(entry + encoded_size, encoded_size);
+	ListPackSetBytes(list_pack, new_bytes);
+	if(where != LIST_PACK_REPLACE)
+	{
+		int64_t list_length = CAST(int64_t)ListPackReadNumber(list_pack + 4, 2);
+		if(list_length < LIST_PACK_UNKNOWN_LENGTH)
+		{
+			ListPackSetLength(list_pack, list_length + 1);
+		}
+	}
+	if(new_position != NULL)
+	{
+		*new_position = entry;
+	}
+	return list_pack;
+}
+
+// O(N)
+uint8_t *ListPackInsert(uint8_t *list_pack, const char *string, int64_t length,
+                        uint8_t *position, int where, uint8_t **new_position)
+{
+	int64_t value;
+	if(SDSParseInt64(string, length, &value))
+	{
+		return ListPackInsertInteger(list_pack, value, position, where, new_position);
+	}
+	uint8_t header[5];
+	int header_size = ListPackEncodeStringHeader(header, length);
+	return ListPackInsertEncoded(list_pack, header, header_size, string, length, position, where,
+	                             new_position);
+}
+
+// O(N)
+uint8_t *ListPackInsertInteger(uint8_t *list_pack, int64_t value, uint8_t *position,
+                               int where, uint8_t **new_position)
+{
+	uint8_t header[LIST_PACK_MAX_ENCODED_INTEGER];
+	int header_size = ListPackEncodeInteger(header, value);
+	return ListPackInsertEncoded(list_pack, header, header_size, NULL, 0, position, where,
+	                             new_position);
+}
+
+// O(1) amortized.
+uint8_t *ListPackAppend(uint8_t *list_pack, const char *string, int64_t length)
+{
+	return ListPackInsert(list_pack, string, length, NULL, LIST_PACK_BEFORE, NULL);
+}
+
+// O(N)
+uint8_t *ListPackPrepend(uint8_t *list_pack, const char *string, int64_t length)
+{
+	uint8_t *first = ListPackFirst(list_pack);
+	return ListPackInsert(list_pack, string, length, first, LIST_PACK_BEFORE, NULL);
+}
+
+// Remove the size bytes at offset, which are count entries.
+// O(N)
+static uint8_t *ListPackRemove(uint8_t *list_pack, int64_t offset, int64_t size, int64_t count)
+{
+	int64_t bytes = ListPackBytes(list_pack);
+	int64_t length = CAST(int64_t)ListPackReadNumber(list_pack + 4, 2);
+	memmove(list_pack + offset, list_pack + offset + size, CAST(size_t)(bytes - offset - size));
+	list_pack = ListPackResize(list_pack, bytes - size);
+	ListPackSetBytes(list_pack, bytes - size);
+	ListPackSetLength(list_pack, length < LIST_PACK_UNKNOWN_LENGTH ? length - count :
+	                  ListPackLength(list_pack));
+	return list_pack;
+}
+
+// O(N)
+uint8_t *ListPackDelete(uint8_t *list_pack, uint8_t *position, uint8_t **next)
+{
+	int64_t offset = position - list_pack;
+	list_pack = ListPackRemove(list_pack, offset, ListPackEntrySize(position), 1);
+	if(next != NULL)
+	{
+		*next = list_pack[offset] == LIST_PACK_END ? NULL : list_pack + offset;
+	}
+	return list_pack;
+}
+
+// O(N)
+uint8_t *ListPackDeleteRange(uint8_t *list_pack, int64_t index, int64_t count)
+{
+	uint8_t *first = ListPackSeek(list_pack, index);
+	if(first == NULL || count <= 0)
+	{
+		return list_pack;
+	}
+	uint8_t *last = first;
+	int64_t deleted = 0;
+	for(; deleted < count && *last != LIST_PACK_END; ++deleted)
+	{
+		last += ListPackEntrySize(last);
+	}
+	return ListPackRemove(list_pack, first - list_pack, last - first, deleted);
+}
@@ -0,0 +1,95 @@
+#ifndef NOSQL_SRC_LIST_PACK_H_
+#define NOSQL_SRC_LIST_PACK_H_
+
+#ifndef CAST
+#define CAST(type) (type)
+#endif
+
+#include <stdint.h>
+
+#include <simple_dynamic_string.h>
+
+// A listpack is a list of strings and integers packed in one contiguous memory block, which
+// spends 2 to 11 bytes per entry on bookkeeping instead of the 2 pointers and the separate
+// allocations of a List node:
+// <total bytes:uint32_t><entry number:uint16_t><entry>...<entry><0xFF>
+// Every entry is <encoding><data><back length>, where the encoding holds the type and the
+// length of the data, and the back length holds the length of <encoding><data> in 1 to 5
+// bytes that can be read from right to left, so that the list can be traversed both ways:
+// 0xxxxxxx - 7 bits unsigned integer
+// 10xxxxxx - string of at most 63 bytes
+// 110xxxxx yyyyyyyy - 13 bits signed integer
+// 1110xxxx yyyyyyyy - string of at most 4095 bytes
+// 11110000 <4 bytes length> - string of at most 4GB
+// 11110001 <2 bytes> - 16 bits signed integer
+// 11110010 <3 bytes> - 24 bits signed integer
+// 11110011 <4 bytes> - 32 bits signed integer
+// 11110100 <8 bytes> - 64 bits signed integer
+// All multibyte numbers are little endian. Strings that are the canonical form of an int64_t
+// are stored as integers. Entries are addressed by pointers into the listpack, which are
+// invalid after any call that returns a new listpack.
+
+#define LIST_PACK_HEADER_SIZE 6 // The total bytes and the entry number.
+#define LIST_PACK_END 0xFF
+#define LIST_PACK_UNKNOWN_LENGTH UINT16_MAX // The entry number is too large to be stored.
+
+#define LIST_PACK_BEFORE 0 // Insert before the entry.
+#define LIST_PACK_AFTER 1 // Insert after the entry.
+#define LIST_PACK_REPLACE 2 // Replace the entry.
+
+typedef struct ListPackEntry
+{
+	const char *string_; // The string value, or NULL if the entry is an integer.
+	int64_t length_; // The length of the string value.
+	int64_t integer_; // The integer value if string_ is NULL.
+} ListPackEntry;
+
+// Create a new empty listpack and return the pointer to it.
+uint8_t *ListPackNew();
+// Free the listpack memory.
+void ListPackFree(uint8_t *list_pack);
+// Return the number of bytes of the listpack.
+int64_t ListPackBytes(const uint8_t *list_pack);
+// Return the number of entries of the listpack.
+int64_t ListPackLength(const uint8_t *list_pack);
+// Return the first entry, or NULL if the listpack is empty.
+uint8_t *ListPackFirst(uint8_t *list_pack);
+// Return the last entry, or NULL if the listpack is empty.
+uint8_t *ListPackLast(uint8_t *list_pack);
+// Return the entry after position, or NULL if position is the last entry.
+uint8_t *ListPackNext(uint8_t *list_pack, uint8_t *position);
+// Return the entry before position, or NULL if position is the first entry.
+uint8_t *ListPackPrevious(uint8_t *list_pack, uint8_t *position);
+// Return list_pack[index] where negative indexes count from the tail: -1 is the last
+// entry. Return NULL if the index is out of range.
+uint8_t *ListPackSeek(uint8_t *list_pack, int64_t index);
+// Decode the entry at position into *entry, whose string_ points into the listpack.
+void ListPackGet(const uint8_t *position, ListPackEntry *entry);
+// Return the decoded entry as a new SDS string.
+String ListPackEntryToSDS(const ListPackEntry *entry);
+// Return whether the entry at position is equal to the string.
+int ListPackEqual(const uint8_t *position, const char *string, int64_t length);
+// Return the first entry equal to the string from position on, comparing an entry and
+// skipping the skip entries after it, e.g., skip is 1 to search the fields of field-value
+// pairs. Return NULL if not found.
+uint8_t *ListPackFind(uint8_t *list_pack, uint8_t *position, const char *string, int64_t length,
+                      int skip);
+// Insert the string before or after the entry at position, or replace it, according to
+// where. A NULL position with LIST_PACK_BEFORE appends to the listpack. Store the position of
+// the new entry in *new_position if it isn't NULL and return the new listpack.
+uint8_t *ListPackInsert(uint8_t *list_pack, const char *string, int64_t length,
+                        uint8_t *position, int where, uint8_t **new_position);
+// Like ListPackInsert(), but insert an integer.
+uint8_t *ListPackInsertInteger(uint8_t *list_pack, int64_t value, uint8_t *position,
+                               int where, uint8_t **new_position);
+// Add the string to the tail of the listpack and return the new listpack.
+uint8_t *ListPackAppend(uint8_t *list_pack, const char *string, int64_t length);
+// Add the string to the head of the listpack and return the new listpack.
+uint8_t *ListPackPrepend(uint8_t *list_pack, const char *string, int64_t length);
+// Delete the entry at position, store the position of the entry after it, or NULL if it was
+// the last one, in *next if it isn't NULL and return the new listpack.
+uint8_t *ListPackDelete(uint8_t *list_pack, uint8_t *position, uint8_t **next);
+// Delete count entries from list_pack[index] and return the new listpack.
+uint8_t *ListPackDeleteRange(uint8_t *list_pack, int64_t index, int64_t count);
+
+#endif // NOSQL_SRC_LIST_PACK_H_
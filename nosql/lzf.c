@@ -0,0 +1,161 @@
+#include <lzf.h>
+
+#include <string.h> // memcpy(), memset()
+
+// The compressed data is a sequence of:
+// - literal runs: 000LLLLL followed by L + 1 bytes(1 to 32).
+// - back references: LLLOOOOO OOOOOOOO(or LLLOOOOO EEEEEEEE OOOOOOOO if LLL is 7): copy
+//   LLL + 2(or 7 + EEEEEEEE + 2) bytes from OOOOOOOOOOOOO + 1 bytes back, which may
+//   overlap the bytes being copied.
+#define LZF_MAX_LITERAL (1 << 5)
+#define LZF_MAX_OFFSET (1 << 13)
+#define LZF_MAX_REFERENCE ((1 << 8) + (1 << 3))
+#define LZF_HASH_LOG 13 // 8K positions, 64KB of stack on 64 bits machines.
+#define LZF_HASH_SIZE (1 << LZF_HASH_LOG)
+
+// Hash the 3 bytes at data.
+// O(1)
+static inline uint32_t LZFHash(const uint8_t *data)
+{
+	uint32_t word = (CAST(uint32_t)data[0] << 16) | (CAST(uint32_t)data[1] << 8) | data[2];
+	return (word * 2654435761U) >> (32 - LZF_HASH_LOG);
+}
+
+// Find the previous occurrence of the 3 bytes at the input position by a hash table of
+// the last position of every hash value, and emit a back reference if it's close enough,
+// or a literal byte otherwise. The control byte of a literal run is reserved before its
+// bytes are known and written when the run ends.
+// O(N)
+int64_t LZFCompress(const void *in, int64_t in_length, void *out, int64_t out_length)
+{
+	const uint8_t *input = in, *in_end = input + in_length;
+	uint8_t *output = out, *out_end = output + out_length;
+	const uint8_t *table[LZF_HASH_SIZE];
+	memset(table, 0, sizeof(table));
+	if(in_length == 0 || out_length < 2)
+	{
+		return 0;
+	}
+	uint8_t *control = output++; // The control byte of the current literal run.
+	int literal_length = 0;
+	while(input < in_end)
+	{
+		if(input + 2 < in_end)
+		{
+			uint32_t hash = LZFHash(input);
+			const uint8_t *reference = table[hash];
+			table[hash] = input;
+			int64_t offset = reference == NULL ? LZF_MAX_OFFSET : input - reference - 1;
+			if(offset < LZF_MAX_OFFSET && reference[0] == input[0] &&
+			        reference[1] == input[1] && reference[2] == input[2])
+			{
+				int64_t max_length = in_end - input;
+				max_length = max_length > LZF_MAX_REFERENCE ? LZF_MAX_REFERENCE : max_length;
+				int64_t length = 3;
+				while(length < max_length && reference[length] == input[length])
+				{
+					++length;
+				}
+				// Close the literal run, or take back its unused control byte.
+				if(literal_length != 0)
+				{
+					*control = CAST(uint8_t)(literal_length - 1);
+				}
+				else
+				{
+					--output;
+				}
+				if(output + 3 + 1 > out_end) // The reference and the next control byte.
+				{
+					return 0;
+				}
+				int64_t encoded_length = length - 2;
+				if(encoded_length < 7)
+				{
+					*output++ = CAST(uint8_t)((offset >> 8) + (encoded_length << 5));
+				}
+				else
+				{
+					*output++ = CAST(uint8_t)((offset >> 8) + (7 << 5));
+					*output++ = CAST(uint8_t)(encoded_length - 7);
+				}
+				*output++ = CAST(uint8_t)offset;
+				control = output++;
+				literal_length = 0;
+				// Index the positions inside the match, so that the next matches can
+				// refer to them.
+				const uint8_t *end = input + length;
+				for(++input; input < end && input + 2 < in_end; ++input)
+				{
+					table[LZFHash(input)] = input;
+				}
+				input = end;
+				continue;
+			}
+		}
+		if(output + 1 + 1 > out_end) // The literal and the next control byte.
+		{
+			return 0;
+		}
+		*output++ = *input++;
+		if(++literal_length == LZF_MAX_LITERAL)
+		{
+			*control = LZF_MAX_LITERAL - 1;
+			control = output++;
+			literal_length = 0;
+		}
+	}
+	if(literal_length != 0)
+	{
+		*control = CAST(uint8_t)(literal_length - 1);
+	}
+	else
+	{
+		--output;
+	}
+	return output - CAST(uint8_t*)out;
+}
+
+// O(N)
+int64_t LZFDecompress(const void *in, int64_t in_length, void *out, int64_t out_length)
+{
+	const uint8_t *input = in, *in_end = input + in_length;
+	uint8_t *output = out, *out_end = output + out_length;
+	while(input < in_end)
+	{
+		int64_t control = *input++;
+		if(control < LZF_MAX_LITERAL) // A literal run.
+		{
+			int64_t length = control + 1;
+			if(output + length > out_end || input + length > in_end)
+			{
+				return 0;
+			}
+			memcpy(output, input, CAST(size_t)length);
+			output += length;
+			input += length;
+			continue;
+		}
+		int64_t length = control >> 5;
+		if(input + (length == 7) + 1 > in_end)
+		{
+			return 0;
+		}
+		if(length == 7)
+		{
+			length += *input++;
+		}
+		length += 2;
+		int64_t offset = ((control & 0x1f) << 8) + *input++ + 1;
+		if(output + length > out_end || offset > output - CAST(uint8_t*)out)
+		{
+			return 0;
+		}
+		// Byte by byte, since the source may overlap the destination to repeat bytes.
+		for(const uint8_t *reference = output - offset; length > 0; --length)
+		{
+			*output++ = *reference++;
+		}
+	}
+	return output - CAST(uint8_t*)out;
+}
@@ -0,0 +1,20 @@
+#ifndef NOSQL_SRC_LZF_H_
+#define NOSQL_SRC_LZF_H_
+
+#ifndef CAST
+#define CAST(type) (type)
+#endif
+
+#include <stdint.h>
+
+// LZF: a very fast Lempel-Ziv compressor, in the format of liblzf by Marc Lehmann, for
+// data that is compressed and decompressed often, e.g., the interior nodes of quicklists.
+
+// Compress in_length bytes of in to out. Return the compressed length, or 0 if the result
+// doesn't fit in out_length bytes, i.e., the data doesn't compress well enough.
+int64_t LZFCompress(const void *in, int64_t in_length, void *out, int64_t out_length);
+// Decompress in_length bytes of in to out. Return the decompressed length, or 0 if it
+// doesn't fit in out_length bytes or the data is corrupted.
+int64_t LZFDecompress(const void *in, int64_t in_length, void *out, int64_t out_length);
+
+#endif // NOSQL_SRC_LZF_H_
@@ -3,38 +3,130 @@
 #include <stdint.h>
 #include <stdlib.h> // malloc(), abort()
 #include <stdio.h> // fprintf(), fflush()
+#include <string.h> // memset(), memcpy()
+#ifdef __GLIBC__
+#include <malloc.h> // malloc_usable_size()
+#endif
 // pthread_mutex_lock(), pthread_mutex_unlock()
 // pthread_mutex_t, PTHREAD_MUTEX_INITIALIZER
 #include <pthread.h>
 
-static int g_used_memory = 0; // Record the number of bytes that have been allocated.
-static int g_malloc_thread_safe = 0; // TODO: what is this variable's function?
-static pthread_mutex_t g_used_memory_mutex = PTHREAD_MUTEX_INITIALIZER;
+// Record the number of bytes that have been allocated while the allocator is not thread
+// safe, plus the bytes left by exited threads. 64 bits so that we can use more than 2GB.
+static int64_t g_used_memory = 0;
+// When set, the global allocator state(used memory and slab free lists) is kept per thread
+// or protected against concurrent access, so that Malloc() and Free() can be called from
+// several threads.
+static int g_malloc_thread_safe = 0;
 
-static inline void UpdateMallocStateAdd(int size) // g_used_memory += size;
+// Per-thread used memory counter.
+// In thread safe mode every thread adds and subtracts the sizes it allocates and frees
+// to its own counter, so allocation-heavy threads never contend on a lock or even on a
+// shared cache line. A counter may become negative when memory allocated by one thread
+// is freed by another, only the sum of all counters is meaningful. UsedMemory() sums up
+// all registered counters. When a thread exits, its counter is folded into g_used_memory.
+typedef struct MallocThreadCounter
 {
-	pthread_mutex_lock(&g_used_memory_mutex);
-	g_used_memory += size;
-	pthread_mutex_unlock(&g_used_memory_mutex);
+	int64_t used_memory_; // Only written by its owner thread, read by UsedMemory().
+	struct MallocThreadCounter *previous_;
+	struct MallocThreadCounter *next_;
+	char padding_[64 - sizeof(int64_t) - 2 * sizeof(void*)]; // One cache line per counter.
+} MallocThreadCounter;
+
+static __thread MallocThreadCounter *t_thread_counter = NULL; // This thread's counter.
+static MallocThreadCounter *g_thread_counter_list = NULL; // All live threads' counters.
+// Protect g_thread_counter_list. Only taken when a thread registers/exits and by UsedMemory().
+static pthread_mutex_t g_thread_counter_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t g_thread_counter_key; // Its destructor runs when a thread exits.
+static pthread_once_t g_thread_counter_key_once = PTHREAD_ONCE_INIT;
+// Set when this thread's counter has been folded into g_used_memory at its exit. Malloc()
+// and Free() called later by other destructors of the exiting thread update g_used_memory
+// and the shared slab free lists directly.
+static __thread int t_thread_exited = 0;
+
+static void SlabCacheReleaseAll();
+
+// Give the exiting thread's cached slab blocks back, then fold its counter into
+// g_used_memory and unregister it.
+static void MallocThreadCounterDestructor(void *ptr)
+{
+	SlabCacheReleaseAll();
+	MallocThreadCounter *counter = ptr;
+	pthread_mutex_lock(&g_thread_counter_mutex);
+	__atomic_add_fetch(&g_used_memory, counter->used_memory_, __ATOMIC_RELAXED);
+	if(counter->previous_)
+	{
+		counter->previous_->next_ = counter->next_;
+	}
+	else
+	{
+		g_thread_counter_list = counter->next_;
+	}
+	if(counter->next_)
+	{
+		counter->next_->previous_ = counter->previous_;
+	}
+	pthread_mutex_unlock(&g_thread_counter_mutex);
+	free(counter);
+	t_thread_counter = NULL;
+	t_thread_exited = 1;
+}
+
+static void MallocThreadCounterKeyCreate()
+{
+	pthread_key_create(&g_thread_counter_key, MallocThreadCounterDestructor);
+}
+
+// Return the calling thread's counter, create and register it at the first call.
+static MallocThreadCounter *MallocThreadCounterGet()
+{
+	if(t_thread_counter == NULL)
+	{
+		MallocThreadCounter *counter = calloc(1, sizeof(MallocThreadCounter));
+		if(counter == NULL)
+		{
+			fprintf(stderr, "Malloc: Out of memory trying to allocate thread counter\n");
+			fflush(stderr);
+			abort();
+		}
+		pthread_once(&g_thread_counter_key_once, MallocThreadCounterKeyCreate);
+		pthread_setspecific(g_thread_counter_key, counter);
+		pthread_mutex_lock(&g_thread_counter_mutex);
+		counter->next_ = g_thread_counter_list;
+		if(g_thread_counter_list)
+		{
+			g_thread_counter_list->previous_ = counter;
+		}
+		g_thread_counter_list = counter;
+		pthread_mutex_unlock(&g_thread_counter_mutex);
+		t_thread_counter = counter;
+	}
+	return t_thread_counter;
 }
 
-static inline void UpdateMallocStateSubtract(int size) // g_used_memory -= size;
+// Add size(may be negative) to the calling thread's counter. Only the owner thread writes
+// the counter, so a relaxed load and store is enough: no lock and no atomic read-modify-write.
+static inline void UpdateMallocStateThreadSafe(int64_t size)
 {
-	pthread_mutex_lock(&g_used_memory_mutex);
-	g_used_memory -= size;
-	pthread_mutex_unlock(&g_used_memory_mutex);
+	if(t_thread_exited)
+	{
+		__atomic_add_fetch(&g_used_memory, size, __ATOMIC_RELAXED);
+		return;
+	}
+	MallocThreadCounter *counter = MallocThreadCounterGet();
+	__atomic_store_n(&counter->used_memory_, counter->used_memory_ + size, __ATOMIC_RELAXED);
 }
 
-// Make size a multiple of `CAST(int)sizeof(int64_t)` and then add size to g_used_memory.
-static inline void UpdateMallocStateAllocate(int size)
+// Make size a multiple of `CAST(int64_t)sizeof(int64_t)` and then add size to used memory.
+static inline void UpdateMallocStateAllocate(int64_t size)
 {
-	if(size&(CAST(int)sizeof(int64_t) - 1)) // Memory alignment: align = CAST(int)sizeof(int64_t)
+	if(size&(CAST(int64_t)sizeof(int64_t) - 1)) // Memory alignment: align = CAST(int64_t)sizeof(int64_t)
 	{
-		size += CAST(int)sizeof(int64_t) - (size&(CAST(int)sizeof(int64_t) - 1));
+		size += CAST(int64_t)sizeof(int64_t) - (size&(CAST(int64_t)sizeof(int64_t) - 1));
 	}
 	if(g_malloc_thread_safe)
 	{
-		UpdateMallocStateAdd(size);
+		UpdateMallocStateThreadSafe(size);
 	}
 	else
 	{
@@ -42,16 +134,16 @@ static inline void UpdateMallocStateAllocate(int size)
 	}
 }
 
-// Make size a multiple of `CAST(int)sizeof(int64_t)` and then subtract size to g_used_memory.
-static inline void UpdateMallocStateFree(int size)
+// Make size a multiple of `CAST(int64_t)sizeof(int64_t)` and then subtract size from used memory.
+static inline void UpdateMallocStateFree(int64_t size)
 {
-	if(size&(CAST(int)sizeof(int64_t) - 1))
+	if(size&(CAST(int64_t)sizeof(int64_t) - 1))
 	{
-		size += CAST(int)sizeof(int64_t) - (size&(CAST(int)sizeof(int64_t) - 1));
+		size += CAST(int64_t)sizeof(int64_t) - (size&(CAST(int64_t)sizeof(int64_t) - 1));
 	}
 	if(g_malloc_thread_safe)
 	{
-		UpdateMallocStateSubtract(size);
+		UpdateMallocStateThreadSafe(-size);
 	}
 	else
 	{
@@ -60,53 +152,365 @@ static inline void UpdateMallocStateFree(int size)
 }
 
 // Output out of memory message to stderr and abort this process.
-static inline void MallocDefaultOOMHandler(int size)
+static inline void MallocDefaultOOMHandler(int64_t size)
 {
-	// z: int; u: unsigned decimal
-	fprintf(stderr, "Malloc: Out of memory trying to allocate %d bytes\n", size);
+	fprintf(stderr, "Malloc: Out of memory trying to allocate %lld bytes\n", CAST(long long)size);
 	fflush(stderr);
 	abort(); // Raise SIGABRT signal for the calling process.
 }
 
 // Function pointer.
-static void (*MallocOOMHandler) (int) = MallocDefaultOOMHandler;
+static void (*MallocOOMHandler) (int64_t) = MallocDefaultOOMHandler;
+
+// The size header of every block. 8 bytes so that blocks can be larger than 2GB and
+// the returned pointers are 8 bytes aligned.
+#define PREFIX_SIZE (CAST(int64_t)sizeof(int64_t))
+
+// Slab allocator for small blocks.
+// Every block whose size(including the PREFIX_SIZE header) is not greater than
+// SLAB_MAX_BLOCK_SIZE is served from the free list of its size class instead of libc.
+// Size classes are multiples of SLAB_ALIGNMENT: 8, 16, 24, ..., SLAB_MAX_BLOCK_SIZE, so
+// the class of a block is computed from the size stored in its header and we don't
+// need any extra per-block metadata. When a free list is empty, we carve a new
+// SLAB_CHUNK_SIZE bytes chunk obtained by malloc() into blocks of that class.
+// Chunks are never returned to libc: freed blocks only go back to their free list.
+// Compile with -DMALLOC_NO_SLAB to route all allocations to libc.
+//
+// In thread safe mode every thread has its own cache of free blocks of every class, so that
+// allocations and frees don't take g_slab_mutex. A thread only takes it to move
+// SLAB_CACHE_BATCH blocks at once between its cache and the shared free lists: when its
+// cache of a class is empty, or holds more than SLAB_CACHE_MAX blocks because it frees
+// blocks allocated by other threads. An exiting thread gives its cache back.
+#define SLAB_ALIGNMENT (CAST(int)sizeof(int64_t))
+#define SLAB_MAX_BLOCK_SIZE 256
+#define SLAB_CLASS_NUMBER (SLAB_MAX_BLOCK_SIZE / SLAB_ALIGNMENT)
+#define SLAB_CHUNK_SIZE (64 * 1024)
+#define SLAB_CACHE_BATCH 32
+#define SLAB_CACHE_MAX (2 * SLAB_CACHE_BATCH)
+
+typedef struct SlabBlock // A free block is linked to its free list by its first bytes.
+{
+	struct SlabBlock *next_;
+} SlabBlock;
+
+// The free list of each size class, shared by all threads.
+static SlabBlock *g_slab_free_list[SLAB_CLASS_NUMBER];
+// Protect g_slab_free_list in thread safe mode. Only taken to move a batch of blocks.
+static pthread_mutex_t g_slab_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+typedef struct SlabCache // The free blocks of a size class cached by a thread.
+{
+	SlabBlock *free_list_;
+	int block_number_;
+} SlabCache;
+
+static __thread SlabCache t_slab_cache[SLAB_CLASS_NUMBER]; // Only used in thread safe mode.
+
+// Return the size class of a block that stores `size` bytes for user, -1 if the block
+// is too large to be served by the slab allocator.
+// O(1)
+static inline int SlabClass(int64_t size)
+{
+#ifdef MALLOC_NO_SLAB
+	(void)size;
+	return -1;
+#else
+	int64_t block_size = size + PREFIX_SIZE;
+	if(block_size > SLAB_MAX_BLOCK_SIZE)
+	{
+		return -1;
+	}
+	return CAST(int)(block_size - 1) / SLAB_ALIGNMENT; // Class i holds blocks of (i+1)*8 bytes.
+#endif
+}
+
+// Carve a new chunk into blocks of class `class_index` and push them to its free list.
+// Return 0 if malloc() fails.
+// O(N)
+static int SlabRefill(int class_index)
+{
+	int block_size = (class_index + 1) * SLAB_ALIGNMENT;
+	char *chunk = malloc(SLAB_CHUNK_SIZE);
+	if(chunk == NULL)
+	{
+		return 0;
+	}
+	// Link blocks in address order so that successive allocations are adjacent.
+	int block_number = SLAB_CHUNK_SIZE / block_size;
+	SlabBlock *next = g_slab_free_list[class_index];
+	for(int index = block_number - 1; index >= 0; --index)
+	{
+		SlabBlock *block = CAST(SlabBlock*)(chunk + index * block_size);
+		block->next_ = next;
+		next = block;
+	}
+	g_slab_free_list[class_index] = next;
+	return 1;
+}
+
+// Pop a block from the shared free list of class `class_index`, carving a new chunk if
+// it's empty. NULL if out of memory. Must hold g_slab_mutex in thread safe mode.
+// O(1), or O(N) to carve a chunk.
+static SlabBlock *SlabPop(int class_index)
+{
+	SlabBlock *block = g_slab_free_list[class_index];
+	if(block == NULL && SlabRefill(class_index))
+	{
+		block = g_slab_free_list[class_index];
+	}
+	if(block != NULL)
+	{
+		g_slab_free_list[class_index] = block->next_;
+	}
+	return block;
+}
+
+// Move up to SLAB_CACHE_BATCH blocks of class `class_index` from the shared free list to the
+// empty cache of the calling thread. Return 0 if out of memory.
+// O(SLAB_CACHE_BATCH)
+static int SlabCacheFill(SlabCache *cache, int class_index)
+{
+	pthread_mutex_lock(&g_slab_mutex);
+	while(cache->block_number_ < SLAB_CACHE_BATCH)
+	{
+		SlabBlock *block = SlabPop(class_index);
+		if(block == NULL)
+		{
+			break;
+		}
+		block->next_ = cache->free_list_;
+		cache->free_list_ = block;
+		++cache->block_number_;
+	}
+	pthread_mutex_unlock(&g_slab_mutex);
+	return cache->block_number_ > 0;
+}
 
-#define PREFIX_SIZE (CAST(int)sizeof(int))
+// Move the first block_number blocks of the cache of class `class_index` of the calling
+// thread to the shared free list. They are counted out of the lock, which is taken once.
+// O(N), N is block_number.
+static void SlabCacheRelease(SlabCache *cache, int class_index, int block_number)
+{
+	if(block_number == 0)
+	{
+		return;
+	}
+	SlabBlock *first = cache->free_list_, *last = first;
+	for(int index = 1; index < block_number; ++index)
+	{
+		last = last->next_;
+	}
+	cache->free_list_ = last->next_;
+	cache->block_number_ -= block_number;
+	pthread_mutex_lock(&g_slab_mutex);
+	last->next_ = g_slab_free_list[class_index];
+	g_slab_free_list[class_index] = first;
+	pthread_mutex_unlock(&g_slab_mutex);
+}
+
+// Move all the cached blocks of the calling thread to the shared free lists.
+// O(N), N is the number of cached blocks.
+static void SlabCacheReleaseAll()
+{
+	for(int class_index = 0; class_index < SLAB_CLASS_NUMBER; ++class_index)
+	{
+		SlabCache *cache = &t_slab_cache[class_index];
+		SlabCacheRelease(cache, class_index, cache->block_number_);
+	}
+}
+
+// Pop a block of class `class_index` from the cache of the calling thread in thread safe
+// mode, or else(or after the thread's cache is released at its exit) from the shared free
+// list. NULL if out of memory.
+// O(1), or O(SLAB_CACHE_BATCH) to fill the cache.
+static void *SlabAllocate(int class_index)
+{
+	if(!g_malloc_thread_safe)
+	{
+		return SlabPop(class_index);
+	}
+	if(t_thread_exited)
+	{
+		pthread_mutex_lock(&g_slab_mutex);
+		SlabBlock *block = SlabPop(class_index);
+		pthread_mutex_unlock(&g_slab_mutex);
+		return block;
+	}
+	SlabCache *cache = &t_slab_cache[class_index];
+	if(cache->free_list_ == NULL && !SlabCacheFill(cache, class_index))
+	{
+		return NULL;
+	}
+	SlabBlock *block = cache->free_list_;
+	cache->free_list_ = block->next_;
+	--cache->block_number_;
+	return block;
+}
+
+// Push a block to the cache of class `class_index` of the calling thread in thread safe
+// mode, or else(or after the thread's cache is released at its exit) to the shared free list.
+// O(1), or O(SLAB_CACHE_BATCH) to release a batch of the cache.
+static void SlabFree(void *ptr, int class_index)
+{
+	SlabBlock *block = ptr;
+	if(!g_malloc_thread_safe)
+	{
+		block->next_ = g_slab_free_list[class_index];
+		g_slab_free_list[class_index] = block;
+		return;
+	}
+	if(t_thread_exited)
+	{
+		pthread_mutex_lock(&g_slab_mutex);
+		block->next_ = g_slab_free_list[class_index];
+		g_slab_free_list[class_index] = block;
+		pthread_mutex_unlock(&g_slab_mutex);
+		return;
+	}
+	SlabCache *cache = &t_slab_cache[class_index];
+	block->next_ = cache->free_list_;
+	cache->free_list_ = block;
+	if(++cache->block_number_ > SLAB_CACHE_MAX)
+	{
+		SlabCacheRelease(cache, class_index, SLAB_CACHE_BATCH);
+	}
+}
+
+// Return a block of size + PREFIX_SIZE bytes from the slab or libc. NULL if out of memory.
+static inline void *MallocBlock(int64_t size)
+{
+	int class_index = SlabClass(size);
+	if(class_index >= 0)
+	{
+		return SlabAllocate(class_index);
+	}
+	return malloc(CAST(size_t)size + PREFIX_SIZE);
+}
+
+// Return a block whose header records `size` to the slab or libc.
+static inline void FreeBlock(void *real_ptr, int64_t size)
+{
+	int class_index = SlabClass(size);
+	if(class_index >= 0)
+	{
+		SlabFree(real_ptr, class_index);
+	}
+	else
+	{
+		free(real_ptr);
+	}
+}
+
+// Return the number of bytes that the user can use in the block real_ptr, which was
+// allocated for size bytes: the whole size class for slab blocks, what glibc reports
+// for libc blocks, otherwise size.
+// O(1)
+static int64_t MallocBlockUsableSize(void *real_ptr, int64_t size)
+{
+	int class_index = SlabClass(size);
+	if(class_index >= 0)
+	{
+		return (class_index + 1) * SLAB_ALIGNMENT - PREFIX_SIZE;
+	}
+#ifdef __GLIBC__
+	return CAST(int64_t)malloc_usable_size(real_ptr) - PREFIX_SIZE;
+#else
+	return size;
+#endif
+}
+
+// Grow the recorded size of the block ptr to all its usable bytes, so that Realloc()
+// keeps them and UsedMemory() counts them, and store it in *usable if usable isn't NULL.
+// O(1)
+static void *MallocExtendToUsableSize(void *ptr, int64_t *usable)
+{
+	void *real_ptr = CAST(char*)ptr - PREFIX_SIZE;
+	int64_t size = *(CAST(int64_t*)real_ptr);
+	int64_t usable_size = MallocBlockUsableSize(real_ptr, size);
+	if(usable_size > size)
+	{
+		*(CAST(int64_t*)real_ptr) = usable_size;
+		UpdateMallocStateFree(size + PREFIX_SIZE);
+		UpdateMallocStateAllocate(usable_size + PREFIX_SIZE);
+	}
+	if(usable != NULL)
+	{
+		*usable = usable_size > size ? usable_size : size;
+	}
+	return ptr;
+}
+
+// Make the allocator safe to be called from several threads.
+// Should be called before any other thread is started.
+void MallocEnableThreadSafeness()
+{
+	g_malloc_thread_safe = 1;
+}
+
+// Return the number of bytes currently allocated by Malloc() and friends in all threads.
+// O(T), T is the number of threads that have allocated memory in thread safe mode.
+int64_t UsedMemory()
+{
+	int64_t used_memory = __atomic_load_n(&g_used_memory, __ATOMIC_RELAXED);
+	if(g_malloc_thread_safe)
+	{
+		pthread_mutex_lock(&g_thread_counter_mutex);
+		for(MallocThreadCounter *counter = g_thread_counter_list;
+		        counter != NULL; counter = counter->next_)
+		{
+			used_memory += __atomic_load_n(&counter->used_memory_, __ATOMIC_RELAXED);
+		}
+		pthread_mutex_unlock(&g_thread_counter_mutex);
+	}
+	return used_memory;
+}
 
 //Allocate size bytes and return a pointer to the allocated, uninitialized memory.
-void *Malloc(int size)
+void *Malloc(int64_t size)
 {
 	// Allocate more PREFIX_SIZE bytes to store this memory block's size in bytes.
-	void *ptr = malloc(CAST(size_t)size + PREFIX_SIZE);
+	void *ptr = MallocBlock(size);
 	if(ptr == NULL)
 	{
 		MallocOOMHandler(size);
 	}
-	*(CAST(int*)ptr) = size; // Store this memory block's size.
+	*(CAST(int64_t*)ptr) = size; // Store this memory block's size.
 	UpdateMallocStateAllocate(size + PREFIX_SIZE);
 	// Return the size bytes memory block, the header is transparent to user.
 	return CAST(char*)ptr + PREFIX_SIZE;
 }
 
 // Allocate size bytes and return a pointer to the allocated, initialized(set to zero) memory.
-void *Calloc(int size)
+void *Calloc(int64_t size)
 {
-	// `void *calloc(int count, int size)` allocates memory for
-	// an array of `count` elements of `size` bytes each and
-	// returns a pointer to the allocated, initialized(set to 0) memory.
-	void *ptr = calloc(1, CAST(size_t)size + PREFIX_SIZE); // Same as Malloc.
+	void *ptr = NULL;
+	if(SlabClass(size) >= 0)
+	{
+		// Recycled slab blocks contain old data, so we clear them by hand.
+		if((ptr = SlabAllocate(SlabClass(size))) != NULL)
+		{
+			memset(ptr, 0, CAST(size_t)size + PREFIX_SIZE);
+		}
+	}
+	else
+	{
+		// `void *calloc(int count, int size)` allocates memory for
+		// an array of `count` elements of `size` bytes each and
+		// returns a pointer to the allocated, initialized(set to 0) memory.
+		ptr = calloc(1, CAST(size_t)size + PREFIX_SIZE); // Same as Malloc.
+	}
 	if(ptr == NULL)
 	{
 		MallocOOMHandler(size);
 	}
-	*(CAST(int*)ptr) = size;
+	*(CAST(int64_t*)ptr) = size;
 	UpdateMallocStateAllocate(size + PREFIX_SIZE);
 	return CAST(char*)ptr + PREFIX_SIZE;
 }
 
 // Change the size of the memory block pointed to by ptr to `size` bytes and
 // return a pointer to the newly allocated memory.
-void *Realloc(void *ptr, int size)
+void *Realloc(void *ptr, int64_t size)
 {
 	if(ptr == NULL)
 	{
@@ -114,25 +518,65 @@ void *Realloc(void *ptr, int size)
 	}
 
 	void *real_ptr = CAST(char*)ptr - PREFIX_SIZE; // Get this memory block's header.
-	int old_size = *(CAST(int*)real_ptr); // Get this memory block's old size.
-	void *new_ptr = realloc(real_ptr, CAST(size_t)size + PREFIX_SIZE);
-	// `void *realloc(void *ptr, int size)` changes the size of the memory block
-	// pointed to by `ptr` to `size` bytes. The contents will be unchanged in the range
-	// [start of the region, min{old_size, new_size}]. If the new size is larger than
-	// the old size, the added memory will not be initialized. Unless ptr is NULL,
-	// it must have been returned by an earlier call to malloc(), calloc() or realloc().
+	int64_t old_size = *(CAST(int64_t*)real_ptr); // Get this memory block's old size.
+	int old_class = SlabClass(old_size), new_class = SlabClass(size);
+	void *new_ptr = NULL;
+	if(old_class < 0 && new_class < 0) // Both are libc blocks.
+	{
+		new_ptr = realloc(real_ptr, CAST(size_t)size + PREFIX_SIZE);
+		// `void *realloc(void *ptr, int size)` changes the size of the memory block
+		// pointed to by `ptr` to `size` bytes. The contents will be unchanged in the range
+		// [start of the region, min{old_size, new_size}]. If the new size is larger than
+		// the old size, the added memory will not be initialized. Unless ptr is NULL,
+		// it must have been returned by an earlier call to malloc(), calloc() or realloc().
+	}
+	else if(old_class == new_class) // The same slab class: the block is already big enough.
+	{
+		new_ptr = real_ptr;
+	}
+	else // Move between the slab and libc, or between two slab classes.
+	{
+		if((new_ptr = MallocBlock(size)) != NULL)
+		{
+			memcpy(CAST(char*)new_ptr + PREFIX_SIZE, ptr,
+			       CAST(size_t)(old_size < size ? old_size : size));
+			FreeBlock(real_ptr, old_size);
+		}
+	}
 
 	if(new_ptr == NULL)
 	{
 		MallocOOMHandler(size);
 	}
-	*(CAST(int*)new_ptr) = size;
+	*(CAST(int64_t*)new_ptr) = size;
 	// Update use_memory variable.
-	UpdateMallocStateFree(old_size);
-	UpdateMallocStateAllocate(size);
+	UpdateMallocStateFree(old_size + PREFIX_SIZE);
+	UpdateMallocStateAllocate(size + PREFIX_SIZE);
 	return CAST(char*)new_ptr + PREFIX_SIZE;
 }
 
+// Like Malloc(), but the block keeps all the bytes the allocator actually reserved, which
+// may be more than size because of size classes, and their number is stored in *usable.
+void *MallocUsable(int64_t size, int64_t *usable)
+{
+	return MallocExtendToUsableSize(Malloc(size), usable);
+}
+
+// Like Realloc(), but the block keeps all the bytes the allocator actually reserved, and
+// their number is stored in *usable.
+void *ReallocUsable(void *ptr, int64_t size, int64_t *usable)
+{
+	return MallocExtendToUsableSize(Realloc(ptr, size), usable);
+}
+
+// Return the number of bytes that can be used in the block pointed to by ptr: the size
+// it was allocated with, or all the usable bytes for MallocUsable()/ReallocUsable().
+// O(1)
+int64_t MallocUsableSize(void *ptr)
+{
+	return *(CAST(int64_t*)(CAST(char*)ptr - PREFIX_SIZE));
+}
+
 // Free the memory space pointed to by ptr and set ptr to NULL.
 void Free(void *ptr)
 {
@@ -142,7 +586,7 @@ void Free(void *ptr)
 	}
 
 	void *real_ptr = CAST(char*)ptr - PREFIX_SIZE;
-	int old_size = *(CAST(int*)real_ptr);
+	int64_t old_size = *(CAST(int64_t*)real_ptr);
 	UpdateMallocStateFree(old_size + PREFIX_SIZE);
-	free(real_ptr);
+	FreeBlock(real_ptr, old_size);
 }
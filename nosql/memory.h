@@ -5,14 +5,29 @@
 #define CAST(type) (type)
 #endif
 
+#include <stdint.h>
+
+// Make the allocator safe to be called from several threads.
+// Should be called before any other thread is started.
+void MallocEnableThreadSafeness();
 //Allocate size bytes and return a pointer to the allocated, uninitialized memory.
-void *Malloc(int size);
+void *Malloc(int64_t size);
 // Allocate size bytes and return a pointer to the allocated, initialized(set to zero) memory.
-void *Calloc(int size);
+void *Calloc(int64_t size);
 // Change the size of the memory block pointed to by ptr to `size` bytes and
 // return a pointer to the newly allocated memory.
-void *Realloc(void *ptr, int size);
+void *Realloc(void *ptr, int64_t size);
+// Like Malloc(), but keep all the bytes the allocator reserved and store their number,
+// which is at least size, in *usable.
+void *MallocUsable(int64_t size, int64_t *usable);
+// Like Realloc(), but keep all the bytes the allocator reserved and store their number,
+// which is at least size, in *usable.
+void *ReallocUsable(void *ptr, int64_t size, int64_t *usable);
+// Return the number of bytes that can be used in the block pointed to by ptr.
+int64_t MallocUsableSize(void *ptr);
 // Free the memory space pointed to by ptr and set ptr to NULL.
 void Free(void *ptr);
+// Return the number of bytes currently allocated by Malloc() and friends in all threads.
+int64_t UsedMemory();
 
 #endif // NOSQL_SRC_MEMORY_H_
@@ -1,4 +1,14 @@
 #ifndef NOSQL_SRC_NOSQL_H_
+#define NOSQL_SRC_NOSQL_H_
+
+#ifndef CAST
+#define CAST(type) (type)
+#endif
+
+#include <limits.h> // INT_MAX
+#include <stdint.h>
+
+#include <simple_dynamic_string.h>
 
 // Actual Nosql Object
 #define NOSQL_LRU_BITS 24
@@ -7,6 +17,35 @@
 // LRU clock resolution in ms
 #define NOSQL_LRU_CLOCK_RESOLUTION 1000
 
+// Object types, stored in type_.
+#define NOSQL_STRING 0
+#define NOSQL_LIST 1
+#define NOSQL_SET 2
+#define NOSQL_ZSET 3
+#define NOSQL_HASH 4
+
+// Object encodings, stored in encoding_: how ptr_ represents the value of its type.
+#define NOSQL_ENCODING_RAW 0 // An SDS string.
+#define NOSQL_ENCODING_HASH_TABLE 1 // A Dictionary.
+#define NOSQL_ENCODING_LIST_PACK 2 // A listpack, see list_pack.h.
+#define NOSQL_ENCODING_QUICK_LIST 3 // A QuickList.
+#define NOSQL_ENCODING_INT_SET 4 // An IntSet.
+#define NOSQL_ENCODING_SKIP_LIST 5 // A SortedSet: a SkipList and a Dictionary.
+#define NOSQL_ENCODING_INT 6 // An integer stored in ptr_ itself, as an intptr_t.
+#define NOSQL_ENCODING_EMBEDDED_STRING 7 // An SDS string in the allocation of the object.
+
+// Strings of up to NOSQL_EMBEDDED_STRING_SIZE_LIMIT bytes are embedded: the object and the
+// SDS string are one allocation of at most 64 bytes, a cache line, instead of two. ptr_ is
+// an SDS string for both the raw and the embedded encodings, so readers don't tell them
+// apart, but embedded strings are never modified in place.
+#define NOSQL_EMBEDDED_STRING_SIZE_LIMIT 44
+
+// Integer string objects from 0 to NOSQL_SHARED_INTEGERS - 1 are shared by all their users, so
+// counters and flags cost a pointer instead of an object. A shared object has a pinned
+// reference count, which reference counting leaves as is, and is never freed.
+#define NOSQL_SHARED_INTEGERS 10000
+#define NOSQL_SHARED_REFERENCE_COUNT INT_MAX
+
 typedef struct NosqlObject
 {
 	unsigned type_ : 4;
@@ -15,4 +54,60 @@ typedef struct NosqlObject
 	int reference_count_;
 	void *ptr_;
 } NosqlObject;
+
+// Small hashes, lists and sorted sets are encoded as a listpack, which takes a fraction of the
+// memory of a Dictionary, a QuickList or a SortedSet, but is searched linearly. They are
+// converted to the general encoding, and never back, once they have more than
+// *_max_list_pack_entries entries(pairs for hashes, members for sorted sets) or a value longer
+// than *_max_list_pack_value bytes.
+extern int64_t g_hash_max_list_pack_entries;
+extern int64_t g_hash_max_list_pack_value;
+extern int64_t g_list_max_list_pack_entries;
+extern int64_t g_list_max_list_pack_value;
+extern int64_t g_zset_max_list_pack_entries;
+extern int64_t g_zset_max_list_pack_value;
+// Sets of integers are encoded as an intset until they have more than
+// g_set_max_int_set_entries elements or a member that isn't an integer.
+extern int64_t g_set_max_int_set_entries;
+// Whether integer string objects are created without sharing, which an eviction policy by
+// per-key LRU or LFU needs: a shared object has a single lru_ for all its keys.
+extern int g_no_shared_integers;
+
+// Create an object whose reference count is 1.
+NosqlObject *CreateObject(int type, int encoding, void *ptr);
+// Create a string object of a copy of the string, embedded if it's short, or raw.
+NosqlObject *CreateStringObject(const char *string, int64_t length);
+// Create a string object of a copy of the string in its own SDS string.
+NosqlObject *CreateRawStringObject(const char *string, int64_t length);
+// Create a string object of a copy of the string, which has at most
+// NOSQL_EMBEDDED_STRING_SIZE_LIMIT bytes, in the allocation of the object.
+NosqlObject *CreateEmbeddedStringObject(const char *string, int64_t length);
+// Create a string object of the decimal form of value, encoded as an integer. It's a shared
+// object if value is below NOSQL_SHARED_INTEGERS, unless g_no_shared_integers is set.
+NosqlObject *CreateStringObjectFromInt64(int64_t value);
+// Return the string object in its most compact encoding: an integer if the string is the
+// canonical form of one, or embedded if it's short. The object may be released and a new one
+// returned instead. An object that has other references is returned as is.
+NosqlObject *TryObjectEncoding(NosqlObject *object);
+// Return the view of the bytes of the string object. The decimal form of an integer encoded
+// object is written to buffer, which must have SDS_INT64_STRING_SIZE bytes.
+SDSView StringObjectView(const NosqlObject *object, char *buffer);
+// Create an empty list object.
+NosqlObject *CreateListObject();
+// Create an empty set object.
+NosqlObject *CreateSetObject();
+// Create an empty hash object.
+NosqlObject *CreateHashObject();
+// Create an empty sorted set object.
+NosqlObject *CreateSortedSetObject();
+// Increase the reference count of the object, unless it's shared.
+void IncreaseReferenceCount(NosqlObject *object);
+// Decrease the reference count of the object and free it when it drops to 0, unless it's
+// shared.
+void DecreaseReferenceCount(NosqlObject *object);
+// Compare the strings of two string objects byte by byte, return <0, 0 or >0 as memcmp().
+int CompareStringObjects(const NosqlObject *object1, const NosqlObject *object2);
+// Return the name of the encoding, e.g., "listpack".
+const char *ObjectEncodingName(int encoding);
+
 #endif // NOSQL_SRC_NOSQL_H_
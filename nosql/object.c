@@ -1,5 +1,222 @@
 #include <nosql.h>
 
+#include <assert.h>
+#include <pthread.h> // pthread_once()
+
+#include <dictionary.h>
+#include <int_set.h>
+#include <list_pack.h>
+#include <memory.h>
+#include <quick_list.h>
+#include <simple_dynamic_string.h>
+#include <sorted_set_object.h>
+
+int64_t g_hash_max_list_pack_entries = 128;
+int64_t g_hash_max_list_pack_value = 64;
+int64_t g_list_max_list_pack_entries = 128;
+int64_t g_list_max_list_pack_value = 64;
+int64_t g_set_max_int_set_entries = 512;
+int64_t g_zset_max_list_pack_entries = 128;
+int64_t g_zset_max_list_pack_value = 64;
+int g_no_shared_integers = 0;
+
+// Filled once by SharedIntegersInit() before the first shared integer is returned, so that
+// nothing needs to set it up, and objects can be created from several threads.
+static NosqlObject g_shared_integers[NOSQL_SHARED_INTEGERS];
+static pthread_once_t g_shared_integers_once = PTHREAD_ONCE_INIT;
+
+// O(1)
+NosqlObject *CreateObject(int type, int encoding, void *ptr)
+{
+	NosqlObject *object = Malloc(CAST(int64_t)sizeof(NosqlObject));
+	object->type_ = CAST(unsigned)type & 0xF;
+	object->encoding_ = CAST(unsigned)encoding & 0xF;
+	object->lru_ = 0;
+	object->reference_count_ = 1;
+	object->ptr_ = ptr;
+	return object;
+}
+
+// O(N)
+NosqlObject *CreateStringObject(const char *string, int64_t length)
+{
+	return length <= NOSQL_EMBEDDED_STRING_SIZE_LIMIT ? CreateEmbeddedStringObject(string, length) :
+	       CreateRawStringObject(string, length);
+}
+
+// O(N)
+NosqlObject *CreateRawStringObject(const char *string, int64_t length)
+{
+	return CreateObject(NOSQL_STRING, NOSQL_ENCODING_RAW, SDSNewLength(string, length));
+}
+
+// The SDS string follows the object in the same allocation, and is freed with it.
+// O(N)
+NosqlObject *CreateEmbeddedStringObject(const char *string, int64_t length)
+{
+	assert(length <= NOSQL_EMBEDDED_STRING_SIZE_LIMIT);
+	NosqlObject *object = Malloc(CAST(int64_t)sizeof(NosqlObject) + SDSEmbeddedSize(length));
+	object->type_ = NOSQL_STRING;
+	object->encoding_ = NOSQL_ENCODING_EMBEDDED_STRING;
+	object->lru_ = 0;
+	object->reference_count_ = 1;
+	object->ptr_ = SDSNewEmbedded(object + 1, string, length);
+	return object;
+}
+
+// O(N), N is NOSQL_SHARED_INTEGERS.
+static void SharedIntegersInit()
+{
+	for(int64_t value = 0; value < NOSQL_SHARED_INTEGERS; ++value)
+	{
+		NosqlObject *object = g_shared_integers + value;
+		object->type_ = NOSQL_STRING;
+		object->encoding_ = NOSQL_ENCODING_INT;
+		object->lru_ = 0;
+		object->reference_count_ = NOSQL_SHARED_REFERENCE_COUNT;
+		object->ptr_ = CAST(void*)CAST(intptr_t)value;
+	}
+}
+
+// Return the shared object of value, which is below NOSQL_SHARED_INTEGERS.
+// O(1)
+static NosqlObject *SharedIntegerObject(int64_t value)
+{
+	pthread_once(&g_shared_integers_once, SharedIntegersInit);
+	return g_shared_integers + value;
+}
+
+// O(1)
+NosqlObject *CreateStringObjectFromInt64(int64_t value)
+{
+	if(value >= 0 && value < NOSQL_SHARED_INTEGERS && !g_no_shared_integers)
+	{
+		return SharedIntegerObject(value);
+	}
+	return CreateObject(NOSQL_STRING, NOSQL_ENCODING_INT, CAST(void*)CAST(intptr_t)value);
+}
+
+// A raw string changes its encoding in place; an embedded one can't free its string, so it's
+// replaced. Either is replaced by a shared integer if there is one.
+// O(N)
+NosqlObject *TryObjectEncoding(NosqlObject *object)
+{
+	assert(object->type_ == NOSQL_STRING);
+	if(object->encoding_ == NOSQL_ENCODING_INT || object->reference_count_ > 1)
+	{
+		return object;
+	}
+	String string = object->ptr_;
+	int64_t length = get_length(string), value;
+	if(SDSParseInt64(string, length, &value))
+	{
+		if(object->encoding_ == NOSQL_ENCODING_RAW &&
+		        (value < 0 || value >= NOSQL_SHARED_INTEGERS || g_no_shared_integers))
+		{
+			SDSFree(string);
+			object->encoding_ = NOSQL_ENCODING_INT;
+			object->ptr_ = CAST(void*)CAST(intptr_t)value;
+			return object;
+		}
+		DecreaseReferenceCount(object);
+		return CreateStringObjectFromInt64(value);
+	}
+	if(object->encoding_ == NOSQL_ENCODING_RAW && length <= NOSQL_EMBEDDED_STRING_SIZE_LIMIT)
+	{
+		NosqlObject *embedded = CreateEmbeddedStringObject(string, length);
+		DecreaseReferenceCount(object);
+		return embedded;
+	}
+	return object;
+}
+
+// O(1), or O(N) to format an integer, N being its number of digits.
+SDSView StringObjectView(const NosqlObject *object, char *buffer)
+{
+	assert(object->type_ == NOSQL_STRING);
+	if(object->encoding_ == NOSQL_ENCODING_INT)
+	{
+		SDSView view = {buffer, SDSFormatInt64(buffer, CAST(intptr_t)object->ptr_)};
+		return view;
+	}
+	return SDSViewOfSDS(object->ptr_);
+}
+
+// O(1)
+NosqlObject *CreateListObject()
+{
+	return CreateObject(NOSQL_LIST, NOSQL_ENCODING_LIST_PACK, ListPackNew());
+}
+
+// O(1)
+NosqlObject *CreateSetObject()
+{
+	return CreateObject(NOSQL_SET, NOSQL_ENCODING_INT_SET, IntSetNew());
+}
+
+// O(1)
+NosqlObject *CreateHashObject()
+{
+	return CreateObject(NOSQL_HASH, NOSQL_ENCODING_LIST_PACK, ListPackNew());
+}
+
+// O(1)
+NosqlObject *CreateSortedSetObject()
+{
+	return CreateObject(NOSQL_ZSET, NOSQL_ENCODING_LIST_PACK, ListPackNew());
+}
+
+// O(1)
+void IncreaseReferenceCount(NosqlObject *object)
+{
+	if(object->reference_count_ != NOSQL_SHARED_REFERENCE_COUNT)
+	{
+		++object->reference_count_;
+	}
+}
+
+// Free the dictionary, which shares the members of the skip list, then the skip list.
+// O(N)
+static void FreeSortedSet(SortedSet *sorted_set)
+{
+	DictionaryRelease(sorted_set->dictionary_);
+	SkipListFree(sorted_set->skip_list_);
+	Free(sorted_set);
+}
+
+// Free the value of the object according to its encoding.
+// O(N)
+static void FreeObjectValue(NosqlObject *object)
+{
+	switch(object->encoding_)
+	{
+	case NOSQL_ENCODING_RAW:
+		SDSFree(object->ptr_);
+		break;
+	case NOSQL_ENCODING_INT:
+	case NOSQL_ENCODING_EMBEDDED_STRING:
+		break; // Nothing but the object is allocated.
+	case NOSQL_ENCODING_HASH_TABLE:
+		DictionaryRelease(object->ptr_);
+		break;
+	case NOSQL_ENCODING_LIST_PACK:
+		ListPackFree(object->ptr_);
+		break;
+	case NOSQL_ENCODING_QUICK_LIST:
+		QuickListFree(object->ptr_);
+		break;
+	case NOSQL_ENCODING_INT_SET:
+		IntSetFree(object->ptr_);
+		break;
+	case NOSQL_ENCODING_SKIP_LIST:
+		FreeSortedSet(object->ptr_);
+		break;
+	default:
+		assert(0 && "Unknown object encoding");
+	}
+}
+
+// O(1), or O(N) to free the value.
 void DecreaseReferenceCount(NosqlObject *object)
 {
 	if(object->reference_count_ <= 0)
@@ -8,12 +225,56 @@ void DecreaseReferenceCount(NosqlObject *object)
 	}
 	else if(object->reference_count_ == 1)
 	{
-		// TODO: switch(object->type_) {...}
+		FreeObjectValue(object);
 		object->reference_count_ = 0;
 		Free(object);
 	}
-	else
+	else if(object->reference_count_ != NOSQL_SHARED_REFERENCE_COUNT)
 	{
 		--object->reference_count_;
 	}
 }
+
+// Integers compare by their decimal forms, like the strings they stand for.
+// O(N)
+int CompareStringObjects(const NosqlObject *object1, const NosqlObject *object2)
+{
+	assert(object1->type_ == NOSQL_STRING && object2->type_ == NOSQL_STRING);
+	if(object1 == object2)
+	{
+		return 0;
+	}
+	if(object1->encoding_ != NOSQL_ENCODING_INT && object2->encoding_ != NOSQL_ENCODING_INT)
+	{
+		return SDSCompare(object1->ptr_, object2->ptr_);
+	}
+	char buffer1[SDS_INT64_STRING_SIZE], buffer2[SDS_INT64_STRING_SIZE];
+	SDSView view1 = StringObjectView(object1, buffer1), view2 = StringObjectView(object2, buffer2);
+	return SDSViewCompare(&view1, &view2);
+}
+
+// O(1)
+const char *ObjectEncodingName(int encoding)
+{
+	switch(encoding)
+	{
+	case NOSQL_ENCODING_RAW:
+		return "raw";
+	case NOSQL_ENCODING_HASH_TABLE:
+		return "hashtable";
+	case NOSQL_ENCODING_LIST_PACK:
+		return "listpack";
+	case NOSQL_ENCODING_QUICK_LIST:
+		return "quicklist";
+	case NOSQL_ENCODING_INT_SET:
+		return "intset";
+	case NOSQL_ENCODING_SKIP_LIST:
+		return "skiplist";
+	case NOSQL_ENCODING_INT:
+		return "int";
+	case NOSQL_ENCODING_EMBEDDED_STRING:
+		return "embstr";
+	default:
+		return "unknown";
+	}
+}
@@ -0,0 +1,617 @@
+#include <quick_list.h>
+
+#include <assert.h>
+#include <string.h> // memcpy()
+
+#include <lzf.h>
+#include <memory.h>
+
+// The most bytes an entry spends on its encoding and back length besides the string.
+#define QUICK_LIST_ENTRY_OVERHEAD 10
+
+// Create a node with an empty listpack.
+// O(1)
+static QuickListNode *QuickListCreateNode()
+{
+	QuickListNode *node = Calloc(CAST(int64_t)sizeof(QuickListNode));
+	node->entry_ = ListPackNew();
+	node->size_ = ListPackBytes(node->entry_);
+	return node;
+}
+
+// Update the node after its listpack changed.
+// O(1)
+static void QuickListUpdateNode(QuickListNode *node)
+{
+	node->size_ = ListPackBytes(node->entry_);
+	node->incompressible_ = 0;
+}
+
+// Return whether a string of length bytes can be added to the node.
+// O(1)
+static int QuickListNodeAllowInsert(const QuickList *list, const QuickListNode *node,
+                                    int64_t length)
+{
+	return node->count_ == 0 || node->size_ + length + QUICK_LIST_ENTRY_OVERHEAD <= list->fill_;
+}
+
+// Compress the listpack of the node by LZF, unless it's too small or LZF doesn't save any
+// byte, which is remembered until the listpack changes.
+// O(N)
+static void QuickListCompressNode(QuickListNode *node)
+{
+	node->recompress_ = 0;
+	if(node->compressed_ || node->incompressible_ || node->size_ < QUICK_LIST_MIN_COMPRESS_BYTES)
+	{
+		return;
+	}
+	QuickListLZF *lzf = Malloc(CAST(int64_t)sizeof(QuickListLZF) + node->size_);
+	lzf->size_ = LZFCompress(node->entry_, node->size_, lzf->data_,
+	                         node->size_ - CAST(int64_t)sizeof(QuickListLZF) - 1);
+	if(lzf->size_ == 0)
+	{
+		Free(lzf);
+		node->incompressible_ = 1;
+		return;
+	}
+	lzf = Realloc(lzf, CAST(int64_t)sizeof(QuickListLZF) + lzf->size_);
+	ListPackFree(node->entry_);
+	node->entry_ = CAST(uint8_t*)lzf;
+	node->compressed_ = 1;
+}
+
+// O(N)
+static void QuickListDecompressNode(QuickListNode *node)
+{
+	if(!node->compressed_)
+	{
+		return;
+	}
+	QuickListLZF *lzf = CAST(QuickListLZF*)node->entry_;
+	uint8_t *list_pack = Malloc(node->size_);
+	int64_t size = LZFDecompress(lzf->data_, lzf->size_, list_pack, node->size_);
+	assert(size == node->size_ && "Corrupted quicklist node");
+	(void)size;
+	Free(lzf);
+	node->entry_ = list_pack;
+	node->compressed_ = 0;
+}
+
+// Decompress the node to read it, and remember to compress it back once done.
+// O(N)
+static void QuickListDecompressForUse(QuickListNode *node)
+{
+	if(node->compressed_)
+	{
+		QuickListDecompressNode(node);
+		node->recompress_ = 1;
+	}
+}
+
+// O(N)
+static void QuickListRecompress(QuickListNode *node)
+{
+	if(node->recompress_)
+	{
+		QuickListCompressNode(node);
+	}
+}
+
+// Keep the compress_depth_ nodes at both ends uncompressed and compress the node if it's
+// farther from the ends. The 2 nodes right after the uncompressed ones are compressed too,
+// since adding nodes near an end moves them inwards: a push adds 1 node and an insert that
+// splits a node adds 2.
+// O(compress_depth_)
+static void QuickListCompress(QuickList *list, QuickListNode *node)
+{
+	if(list->compress_depth_ == 0)
+	{
+		return;
+	}
+	if(list->node_number_ <= 2 * CAST(int64_t)list->compress_depth_) // All in depth.
+	{
+		for(QuickListNode *current = list->head_; current != NULL; current = current->next_)
+		{
+			QuickListDecompressNode(current);
+			current->recompress_ = 0;
+		}
+		return;
+	}
+	QuickListNode *forward = list->head_, *reverse = list->tail_;
+	int in_depth = 0;
+	for(int depth = 0; depth < list->compress_depth_; ++depth)
+	{
+		QuickListDecompressNode(forward);
+		QuickListDecompressNode(reverse);
+		forward->recompress_ = reverse->recompress_ = 0;
+		in_depth |= node == forward || node == reverse;
+		forward = forward->next_;
+		reverse = reverse->previous_;
+	}
+	if(node != NULL && !in_depth)
+	{
+		QuickListCompressNode(node);
+	}
+	QuickListCompressNode(forward);
+	QuickListCompressNode(reverse);
+	if(list->node_number_ > 2 * CAST(int64_t)list->compress_depth_ + 2)
+	{
+		QuickListCompressNode(forward->next_);
+		QuickListCompressNode(reverse->previous_);
+	}
+}
+
+// Link new_node before or after old_node according to after, or as the only node if
+// old_node is NULL.
+// O(1)
+static void QuickListLinkNode(QuickList *list, QuickListNode *old_node, QuickListNode *new_node,
+                              int after)
+{
+	if(old_node == NULL)
+	{
+		new_node->previous_ = new_node->next_ = NULL;
+		list->head_ = list->tail_ = new_node;
+	}
+	else if(after)
+	{
+		new_node->previous_ = old_node;
+		new_node->next_ = old_node->next_;
+		if(old_node->next_ != NULL)
+		{
+			old_node->next_->previous_ = new_node;
+		}
+		else
+		{
+			list->tail_ = new_node;
+		}
+		old_node->next_ = new_node;
+	}
+	else
+	{
+		new_node->next_ = old_node;
+		new_node->previous_ = old_node->previous_;
+		if(old_node->previous_ != NULL)
+		{
+			old_node->previous_->next_ = new_node;
+		}
+		else
+		{
+			list->head_ = new_node;
+		}
+		old_node->previous_ = new_node;
+	}
+	++list->node_number_;
+	list->count_ += new_node->count_;
+}
+
+// Unlink and free the node with all its entries.
+// O(compress_depth_)
+static void QuickListDeleteNode(QuickList *list, QuickListNode *node)
+{
+	if(node->previous_ != NULL)
+	{
+		node->previous_->next_ = node->next_;
+	}
+	else
+	{
+		list->head_ = node->next_;
+	}
+	if(node->next_ != NULL)
+	{
+		node->next_->previous_ = node->previous_;
+	}
+	else
+	{
+		list->tail_ = node->previous_;
+	}
+	--list->node_number_;
+	list->count_ -= node->count_;
+	Free(node->entry_);
+	Free(node);
+	QuickListCompress(list, NULL); // A compressed node may have become one of the ends.
+}
+
+// Delete the entry at position from the uncompressed node, and the node if it becomes empty.
+// Return whether the node was deleted.
+// O(N)
+static int QuickListDeleteFromNode(QuickList *list, QuickListNode *node, uint8_t *position)
+{
+	if(node->count_ == 1)
+	{
+		QuickListDeleteNode(list, node);
+		return 1;
+	}
+	node->entry_ = ListPackDelete(node->entry_, position, NULL);
+	--node->count_;
+	--list->count_;
+	QuickListUpdateNode(node);
+	return 0;
+}
+
+// Add the string at the head or the tail of the uncompressed node according to after.
+// O(N)
+static void QuickListAddToNode(QuickList *list, QuickListNode *node, const char *value,
+                               int64_t length, int after)
+{
+	node->entry_ = after ? ListPackAppend(node->entry_, value, length) :
+	               ListPackPrepend(node->entry_, value, length);
+	++node->count_;
+	++list->count_;
+	QuickListUpdateNode(node);
+}
+
+// Find the node of list[index] and store the index of the entry in the node in *offset.
+// O(N / entries per node)
+static QuickListNode *QuickListLocate(const QuickList *list, int64_t index, int64_t *offset)
+{
+	if(index < 0)
+	{
+		index += list->count_;
+	}
+	if(index < 0 || index >= list->count_)
+	{
+		return NULL;
+	}
+	QuickListNode *node;
+	if(index < list->count_ / 2)
+	{
+		for(node = list->head_; index >= node->count_; node = node->next_)
+		{
+			index -= node->count_;
+		}
+	}
+	else
+	{
+		index = list->count_ - 1 - index; // The index from the tail.
+		for(node = list->tail_; index >= node->count_; node = node->previous_)
+		{
+			index -= node->count_;
+		}
+		index = node->count_ - 1 - index;
+	}
+	*offset = index;
+	return node;
+}
+
+// Move the entries from the offset-th one of the uncompressed node to a new node after it,
+// and return the new node.
+// O(N)
+static QuickListNode *QuickListSplitNode(QuickList *list, QuickListNode *node, int64_t offset)
+{
+	QuickListNode *new_node = Calloc(CAST(int64_t)sizeof(QuickListNode));
+	new_node->entry_ = Malloc(node->size_);
+	memcpy(new_node->entry_, node->entry_, CAST(size_t)node->size_);
+	new_node->entry_ = ListPackDeleteRange(new_node->entry_, 0, offset);
+	new_node->count_ = CAST(int32_t)(node->count_ - offset);
+	QuickListUpdateNode(new_node);
+	node->entry_ = ListPackDeleteRange(node->entry_, offset, node->count_ - offset);
+	node->count_ = CAST(int32_t)offset;
+	QuickListUpdateNode(node);
+	list->count_ -= new_node->count_; // Added back by QuickListLinkNode().
+	QuickListLinkNode(list, node, new_node, 1);
+	return new_node;
+}
+
+// O(1)
+QuickList *QuickListCreate(int64_t fill, int compress_depth)
+{
+	QuickList *list = Calloc(CAST(int64_t)sizeof(QuickList));
+	list->fill_ = fill > 0 ? fill : QUICK_LIST_DEFAULT_FILL;
+	list->compress_depth_ = compress_depth > 0 ? compress_depth : 0;
+	return list;
+}
+
+// O(N)
+void QuickListFree(QuickList *list)
+{
+	QuickListNode *node = list->head_, *next;
+	while(node != NULL)
+	{
+		next = node->next_;
+		Free(node->entry_);
+		Free(node);
+		node = next;
+	}
+	Free(list);
+}
+
+// The end nodes are never compressed.
+// O(1) amortized, since a node has a bounded size.
+void QuickListPush(QuickList *list, const char *value, int64_t length, int where)
+{
+	int after = where == QUICK_LIST_TAIL;
+	QuickListNode *node = after ? list->tail_ : list->head_;
+	if(node != NULL && QuickListNodeAllowInsert(list, node, length))
+	{
+		QuickListAddToNode(list, node, value, length, after);
+		return;
+	}
+	QuickListNode *new_node = QuickListCreateNode();
+	QuickListLinkNode(list, node, new_node, after);
+	QuickListAddToNode(list, new_node, value, length, after);
+	QuickListCompress(list, new_node);
+}
+
+// O(1)
+void QuickListPushHead(QuickList *list, const char *value, int64_t length)
+{
+	QuickListPush(list, value, length, QUICK_LIST_HEAD);
+}
+
+// O(1)
+void QuickListPushTail(QuickList *list, const char *value, int64_t length)
+{
+	QuickListPush(list, value, length, QUICK_LIST_TAIL);
+}
+
+// O(1) amortized, since a node has a bounded size.
+String QuickListPop(QuickList *list, int where)
+{
+	QuickListNode *node = where == QUICK_LIST_TAIL ? list->tail_ : list->head_;
+	if(node == NULL)
+	{
+		return NULL;
+	}
+	uint8_t *position = where == QUICK_LIST_TAIL ? ListPackLast(node->entry_) :
+	                    ListPackFirst(node->entry_);
+	ListPackEntry value;
+	ListPackGet(position, &value);
+	String string = ListPackEntryToSDS(&value);
+	QuickListDeleteFromNode(list, node, position);
+	return string;
+}
+
+// O(N)
+String QuickListIndex(QuickList *list, int64_t index)
+{
+	int64_t offset;
+	QuickListNode *node = QuickListLocate(list, index, &offset);
+	if(node == NULL)
+	{
+		return NULL;
+	}
+	QuickListDecompressForUse(node);
+	ListPackEntry value;
+	ListPackGet(ListPackSeek(node->entry_, offset), &value);
+	String string = ListPackEntryToSDS(&value);
+	QuickListRecompress(node);
+	return string;
+}
+
+// Insert in the node if it has room; otherwise at the near end of its neighbor if the
+// entry is at the edge of the node, or in a new node between them; otherwise split the
+// node at the entry.
+// O(N)
+int QuickListInsert(QuickList *list, int64_t index, const char *value, int64_t length, int after)
+{
+	int64_t offset;
+	QuickListNode *node = QuickListLocate(list, index, &offset);
+	if(node == NULL)
+	{
+		return 0;
+	}
+	after = after != 0;
+	if(QuickListNodeAllowInsert(list, node, length))
+	{
+		QuickListDecompressForUse(node);
+		uint8_t *position = ListPackSeek(node->entry_, offset);
+		node->entry_ = ListPackInsert(node->entry_, value, length, position,
+		                              after ? LIST_PACK_AFTER : LIST_PACK_BEFORE, NULL);
+		++node->count_;
+		++list->count_;
+		QuickListUpdateNode(node);
+		QuickListCompress(list, node);
+		return 1;
+	}
+	if((after && offset == node->count_ - 1) || (!after && offset == 0))
+	{
+		QuickListNode *neighbor = after ? node->next_ : node->previous_;
+		if(neighbor == NULL || !QuickListNodeAllowInsert(list, neighbor, length))
+		{
+			neighbor = QuickListCreateNode();
+			QuickListLinkNode(list, node, neighbor, after);
+		}
+		QuickListDecompressForUse(neighbor);
+		QuickListAddToNode(list, neighbor, value, length, !after);
+		QuickListCompress(list, neighbor);
+		return 1;
+	}
+	QuickListDecompressForUse(node);
+	QuickListNode *right = QuickListSplitNode(list, node, after ? offset + 1 : offset);
+	if(QuickListNodeAllowInsert(list, node, length))
+	{
+		QuickListAddToNode(list, node, value, length, 1);
+	}
+	else if(QuickListNodeAllowInsert(list, right, length))
+	{
+		QuickListAddToNode(list, right, value, length, 0);
+	}
+	else
+	{
+		QuickListNode *new_node = QuickListCreateNode();
+		QuickListLinkNode(list, node, new_node, 1);
+		QuickListAddToNode(list, new_node, value, length, 1);
+		QuickListCompress(list, new_node);
+	}
+	QuickListCompress(list, node);
+	QuickListCompress(list, right);
+	return 1;
+}
+
+// Replace in place if the node has room, otherwise delete and insert.
+// O(N)
+int QuickListReplaceAtIndex(QuickList *list, int64_t index, const char *value, int64_t length)
+{
+	int64_t offset;
+	QuickListNode *node = QuickListLocate(list, index, &offset);
+	if(node == NULL)
+	{
+		return 0;
+	}
+	QuickListDecompressForUse(node);
+	uint8_t *position = ListPackSeek(node->entry_, offset);
+	if(node->count_ == 1 || QuickListNodeAllowInsert(list, node, length))
+	{
+		node->entry_ = ListPackInsert(node->entry_, value, length, position, LIST_PACK_REPLACE,
+		                              NULL);
+		QuickListUpdateNode(node);
+		QuickListCompress(list, node);
+		return 1;
+	}
+	index = index < 0 ? index + list->count_ : index;
+	QuickListDeleteFromNode(list, node, position);
+	QuickListCompress(list, node);
+	return index == list->count_ ? QuickListInsert(list, index - 1, value, length, 1) :
+	       QuickListInsert(list, index, value, length, 0);
+}
+
+// O(N)
+int64_t QuickListDeleteRange(QuickList *list, int64_t start, int64_t count)
+{
+	int64_t offset;
+	QuickListNode *node = QuickListLocate(list, start, &offset);
+	if(node == NULL || count <= 0)
+	{
+		return 0;
+	}
+	start = start < 0 ? start + list->count_ : start;
+	count = count < list->count_ - start ? count : list->count_ - start;
+	for(int64_t remaining = count; remaining > 0; offset = 0)
+	{
+		QuickListNode *next = node->next_;
+		int64_t delete_number = node->count_ - offset < remaining ? node->count_ - offset : remaining;
+		if(delete_number == node->count_)
+		{
+			QuickListDeleteNode(list, node);
+		}
+		else
+		{
+			QuickListDecompressForUse(node);
+			node->entry_ = ListPackDeleteRange(node->entry_, offset, delete_number);
+			node->count_ = CAST(int32_t)(node->count_ - delete_number);
+			list->count_ -= delete_number;
+			QuickListUpdateNode(node);
+			QuickListCompress(list, node);
+		}
+		remaining -= delete_number;
+		node = next;
+	}
+	return count;
+}
+
+// Negative indexes count from the tail and out of range indexes are clamped.
+// O(N)
+int64_t QuickListRange(QuickList *list, int64_t start, int64_t stop,
+                       void (*Function)(void *argument, const QuickListEntry *entry),
+                       void *argument)
+{
+	start = start < 0 ? start + list->count_ : start;
+	stop = stop < 0 ? stop + list->count_ : stop;
+	start = start < 0 ? 0 : start;
+	stop = stop >= list->count_ ? list->count_ - 1 : stop;
+	if(start > stop)
+	{
+		return 0;
+	}
+	QuickListIterator *iterator = QuickListGetIteratorAtIndex(list, QUICK_LIST_HEAD, start);
+	QuickListEntry entry;
+	int64_t number = 0;
+	while(number <= stop - start && QuickListNext(iterator, &entry))
+	{
+		Function(argument, &entry);
+		++number;
+	}
+	QuickListFreeIterator(iterator);
+	return number;
+}
+
+// O(1)
+QuickListIterator *QuickListGetIterator(QuickList *list, int direction)
+{
+	QuickListIterator *iterator = Malloc(CAST(int64_t)sizeof(QuickListIterator));
+	iterator->list_ = list;
+	iterator->node_ = direction == QUICK_LIST_HEAD ? list->head_ : list->tail_;
+	iterator->position_ = NULL;
+	iterator->offset_ = direction == QUICK_LIST_HEAD ? 0 : -1;
+	iterator->direction_ = direction;
+	return iterator;
+}
+
+// O(N / entries per node)
+QuickListIterator *QuickListGetIteratorAtIndex(QuickList *list, int direction, int64_t index)
+{
+	int64_t offset;
+	QuickListNode *node = QuickListLocate(list, index, &offset);
+	if(node == NULL)
+	{
+		return NULL;
+	}
+	QuickListIterator *iterator = QuickListGetIterator(list, direction);
+	iterator->node_ = node;
+	iterator->offset_ = direction == QUICK_LIST_HEAD ? offset : offset - node->count_;
+	return iterator;
+}
+
+// A node is decompressed when the iterator enters it and compressed back when it leaves.
+// O(1) amortized, since a node has a bounded size.
+int QuickListNext(QuickListIterator *iterator, QuickListEntry *entry)
+{
+	int forward = iterator->direction_ == QUICK_LIST_HEAD;
+	while(iterator->node_ != NULL)
+	{
+		QuickListNode *node = iterator->node_;
+		if(iterator->position_ == NULL)
+		{
+			QuickListDecompressForUse(node);
+			iterator->position_ = ListPackSeek(node->entry_, iterator->offset_);
+		}
+		else if(forward)
+		{
+			iterator->position_ = ListPackNext(node->entry_, iterator->position_);
+			++iterator->offset_;
+		}
+		else
+		{
+			iterator->position_ = ListPackPrevious(node->entry_, iterator->position_);
+			--iterator->offset_;
+		}
+		if(iterator->position_ != NULL)
+		{
+			entry->node_ = node;
+			entry->position_ = iterator->position_;
+			ListPackGet(iterator->position_, &entry->value_);
+			return 1;
+		}
+		QuickListCompress(iterator->list_, node); // It may have changed by QuickListDeleteEntry().
+		iterator->node_ = forward ? node->next_ : node->previous_;
+		iterator->offset_ = forward ? 0 : -1;
+	}
+	return 0;
+}
+
+// The next entry has the same offset in the node as the deleted one in both directions,
+// since offsets from the tail are negative; it's found again by the next call.
+// O(N)
+void QuickListDeleteEntry(QuickListIterator *iterator, QuickListEntry *entry)
+{
+	QuickListNode *node = entry->node_;
+	QuickListNode *next = iterator->direction_ == QUICK_LIST_HEAD ? node->next_ : node->previous_;
+	if(QuickListDeleteFromNode(iterator->list_, node, entry->position_))
+	{
+		iterator->node_ = next;
+		iterator->offset_ = iterator->direction_ == QUICK_LIST_HEAD ? 0 : -1;
+	}
+	iterator->position_ = NULL;
+	entry->node_ = NULL;
+	entry->position_ = NULL;
+}
+
+// O(N)
+void QuickListFreeIterator(QuickListIterator *iterator)
+{
+	if(iterator->node_ != NULL)
+	{
+		QuickListCompress(iterator->list_, iterator->node_);
+	}
+	Free(iterator);
+}
@@ -0,0 +1,112 @@
+#ifndef NOSQL_SRC_QUICK_LIST_H_
+#define NOSQL_SRC_QUICK_LIST_H_
+
+#ifndef CAST
+#define CAST(type) (type)
+#endif
+
+#include <stdint.h>
+
+#include <list_pack.h>
+#include <simple_dynamic_string.h>
+
+// A quicklist is a double linked list of listpacks: the entries are packed in nodes of at
+// most fill_ bytes, so that long lists cost a few bytes per entry instead of a List node,
+// and keep O(1) push and pop at both ends. The nodes that are more than compress_depth_
+// nodes away from both ends are compressed by LZF, since lists are mostly accessed at
+// their ends.
+
+#define QUICK_LIST_HEAD 0 // Push/pop at the head; iterate from head to tail.
+#define QUICK_LIST_TAIL 1 // Push/pop at the tail; iterate from tail to head.
+#define QUICK_LIST_DEFAULT_FILL 8192 // The default maximum bytes of a node.
+#define QUICK_LIST_MIN_COMPRESS_BYTES 48 // Smaller nodes are never compressed.
+
+typedef struct QuickListNode
+{
+	struct QuickListNode *previous_;
+	struct QuickListNode *next_;
+	uint8_t *entry_; // The listpack, or a QuickListLZF if compressed_.
+	int64_t size_; // The bytes of the uncompressed listpack.
+	int32_t count_; // The number of entries in the listpack.
+	uint8_t compressed_; // Whether entry_ is compressed.
+	uint8_t recompress_; // Whether the node was decompressed temporarily to be read.
+	uint8_t incompressible_; // Whether LZF failed to shrink the current listpack.
+} QuickListNode;
+
+typedef struct QuickListLZF
+{
+	int64_t size_; // The compressed bytes.
+	uint8_t data_[];
+} QuickListLZF;
+
+typedef struct QuickList
+{
+	QuickListNode *head_; // The first node in this quicklist.
+	QuickListNode *tail_; // The last node.
+	int64_t count_; // The number of entries in all nodes.
+	int64_t node_number_; // The number of nodes.
+	int64_t fill_; // The maximum bytes of a node, unless it has a single entry.
+	int compress_depth_; // The number of uncompressed nodes at each end, 0 to never compress.
+} QuickList;
+
+typedef struct QuickListEntry
+{
+	QuickListNode *node_; // The node that holds the entry.
+	uint8_t *position_; // The entry in the listpack of node_.
+	ListPackEntry value_; // The value, whose string_ points into the listpack.
+} QuickListEntry;
+
+typedef struct QuickListIterator
+{
+	QuickList *list_;
+	QuickListNode *node_; // The current node.
+	uint8_t *position_; // The last returned entry, or NULL before the first one of node_.
+	int64_t offset_; // The index of position_ in node_, negative when iterating from tail.
+	int direction_;
+} QuickListIterator;
+
+// Functions implemented as macros.
+#define QuickListLength(list) ((list)->count_)
+#define QuickListNodeNumber(list) ((list)->node_number_)
+
+// Create a new quicklist whose nodes have at most fill bytes and return the pointer to it.
+QuickList *QuickListCreate(int64_t fill, int compress_depth);
+// Free the whole quicklist(including all its nodes) memory.
+void QuickListFree(QuickList *list);
+// Add the string to the head or the tail of the list according to where.
+void QuickListPush(QuickList *list, const char *value, int64_t length, int where);
+// Add the string to the head of the list.
+void QuickListPushHead(QuickList *list, const char *value, int64_t length);
+// Add the string to the tail of the list.
+void QuickListPushTail(QuickList *list, const char *value, int64_t length);
+// Remove the head or the tail entry of the list according to where and return it as a new
+// SDS string, or NULL if the list is empty.
+String QuickListPop(QuickList *list, int where);
+// Return list[index] as a new SDS string, where negative indexes count from the tail.
+// Return NULL if the index is out of range.
+String QuickListIndex(QuickList *list, int64_t index);
+// Insert the string before or after list[index] according to after. Return 0 if the index
+// is out of range, 1 otherwise.
+int QuickListInsert(QuickList *list, int64_t index, const char *value, int64_t length, int after);
+// Replace list[index] by the string. Return 0 if the index is out of range, 1 otherwise.
+int QuickListReplaceAtIndex(QuickList *list, int64_t index, const char *value, int64_t length);
+// Delete count entries from list[start] and return the number of deleted entries.
+int64_t QuickListDeleteRange(QuickList *list, int64_t start, int64_t count);
+// Call Function for the entries from list[start] to list[stop], both included, and return
+// their number.
+int64_t QuickListRange(QuickList *list, int64_t start, int64_t stop,
+                       void (*Function)(void *argument, const QuickListEntry *entry),
+                       void *argument);
+// Return an iterator from the head or the tail according to direction.
+QuickListIterator *QuickListGetIterator(QuickList *list, int direction);
+// Return an iterator whose first entry is list[index], or NULL if the index is out of range.
+QuickListIterator *QuickListGetIteratorAtIndex(QuickList *list, int direction, int64_t index);
+// Store the next entry in *entry and return 1, or return 0 at the end of the list. The entry
+// is valid until the next call on the iterator.
+int QuickListNext(QuickListIterator *iterator, QuickListEntry *entry);
+// Delete the entry last returned by QuickListNext(); the iteration goes on after it.
+void QuickListDeleteEntry(QuickListIterator *iterator, QuickListEntry *entry);
+// Free the iterator memory.
+void QuickListFreeIterator(QuickListIterator *iterator);
+
+#endif // NOSQL_SRC_QUICK_LIST_H_
@@ -0,0 +1,209 @@
+#include <set_object.h>
+
+#include <assert.h>
+#include <string.h> // memcmp()
+
+#include <dictionary.h>
+#include <hash_function.h>
+#include <int_set.h>
+#include <simple_dynamic_string.h>
+
+static int SetObjectCompareSDS(void *argument, const void *key1, const void *key2)
+{
+	int64_t length = get_length(CAST(const String)key1);
+	return length == get_length(CAST(const String)key2) &&
+	       memcmp(key1, key2, CAST(size_t)length) == 0;
+}
+
+static int SetObjectCompareView(void *argument, const void *view, const void *key)
+{
+	return SDSViewEqual(view, CAST(const String)key);
+}
+
+static void SetObjectFreeSDS(void *argument, void *string)
+{
+	SDSFree(string);
+}
+
+// Members are looked up by views of the argument strings, and have no value.
+static HashTableType set_dictionary_type =
+{
+	HashSDS, SetObjectCompareSDS, NULL, NULL, SetObjectFreeSDS, NULL,
+	DICTIONARY_LAYOUT_CHAINED, 0, HashSDSView, SetObjectCompareView
+};
+
+// O(1) for the hash table encoding, O(N) for the intset encoding.
+int SetTypeAdd(NosqlObject *set, const char *member, int64_t length)
+{
+	if(set->encoding_ == NOSQL_ENCODING_INT_SET)
+	{
+		int64_t value;
+		if(SDSParseInt64(member, length, &value))
+		{
+			int success;
+			set->ptr_ = IntSetAdd(set->ptr_, value, &success);
+			if(success && IntSetLength(CAST(IntSet*)set->ptr_) > g_set_max_int_set_entries)
+			{
+				SetTypeConvert(set, NOSQL_ENCODING_HASH_TABLE);
+			}
+			return success;
+		}
+		SetTypeConvert(set, NOSQL_ENCODING_HASH_TABLE);
+	}
+	assert(set->encoding_ == NOSQL_ENCODING_HASH_TABLE);
+	SDSView view = {member, length};
+	if(DictionaryFindView(set->ptr_, &view) != NULL)
+	{
+		return 0;
+	}
+	DictionaryAdd(set->ptr_, SDSNewLength(member, length), NULL);
+	return 1;
+}
+
+// The intset encoding is kept even if the set becomes empty.
+// O(1) for the hash table encoding, O(N) for the intset encoding.
+int SetTypeRemove(NosqlObject *set, const char *member, int64_t length)
+{
+	if(set->encoding_ == NOSQL_ENCODING_INT_SET)
+	{
+		int64_t value;
+		int success = 0;
+		if(SDSParseInt64(member, length, &value))
+		{
+			set->ptr_ = IntSetRemove(set->ptr_, value, &success);
+		}
+		return success;
+	}
+	SDSView view = {member, length};
+	HashTableNode *node = DictionaryFindView(set->ptr_, &view);
+	if(node == NULL)
+	{
+		return 0;
+	}
+	// The key is deleted by itself, since its node may be moved by rehashing.
+	String key = node->key_;
+	DictionaryDelete(set->ptr_, key);
+	return 1;
+}
+
+// O(1) for the hash table encoding, O(logN) for the intset encoding.
+int SetTypeIsMember(NosqlObject *set, const char *member, int64_t length)
+{
+	if(set->encoding_ == NOSQL_ENCODING_INT_SET)
+	{
+		int64_t value;
+		return SDSParseInt64(member, length, &value) && IntSetFind(set->ptr_, value);
+	}
+	SDSView view = {member, length};
+	return DictionaryFindView(set->ptr_, &view) != NULL;
+}
+
+// O(1)
+int64_t SetTypeLength(const NosqlObject *set)
+{
+	if(set->encoding_ == NOSQL_ENCODING_INT_SET)
+	{
+		return IntSetLength(CAST(const IntSet*)set->ptr_);
+	}
+	const Dictionary *d = set->ptr_;
+	return d->hash_table_[0].element_number_ + d->hash_table_[1].element_number_;
+}
+
+// O(N)
+void SetTypeConvert(NosqlObject *set, int encoding)
+{
+	assert(set->encoding_ == NOSQL_ENCODING_INT_SET && encoding == NOSQL_ENCODING_HASH_TABLE);
+	IntSet *int_set = set->ptr_;
+	Dictionary *d = DictionaryCreate(&set_dictionary_type, NULL);
+	DictionaryExpand(d, IntSetLength(int_set));
+	char buffer[SDS_INT64_STRING_SIZE];
+	int64_t value;
+	for(int64_t index = 0; IntSetGet(int_set, index, &value); ++index)
+	{
+		DictionaryAdd(d, SDSNewLength(buffer, SDSFormatInt64(buffer, value)), NULL);
+	}
+	IntSetFree(int_set);
+	set->ptr_ = d;
+	set->encoding_ = NOSQL_ENCODING_HASH_TABLE;
+}
+
+// Call Function for every member of the set.
+// O(N)
+static void SetTypeForEach(NosqlObject *set,
+                           void (*Function)(void *argument, const char *member, int64_t length),
+                           void *argument)
+{
+	if(set->encoding_ == NOSQL_ENCODING_INT_SET)
+	{
+		char buffer[SDS_INT64_STRING_SIZE];
+		int64_t value;
+		for(int64_t index = 0; IntSetGet(set->ptr_, index, &value); ++index)
+		{
+			Function(argument, buffer, SDSFormatInt64(buffer, value));
+		}
+		return;
+	}
+	DictionaryIterator *iterator = DictionaryGetIterator(set->ptr_);
+	HashTableNode *node;
+	while((node = DictionaryNext(iterator)) != NULL)
+	{
+		Function(argument, node->key_, get_length(node->key_));
+	}
+	DictionaryReleaseIterator(iterator);
+}
+
+// The argument is the result set.
+static void SetTypeAddMember(void *argument, const char *member, int64_t length)
+{
+	SetTypeAdd(argument, member, length);
+}
+
+// The argument is the other set and the result set.
+static void SetTypeAddCommonMember(void *argument, const char *member, int64_t length)
+{
+	NosqlObject **sets = argument;
+	if(SetTypeIsMember(sets[0], member, length))
+	{
+		SetTypeAdd(sets[1], member, length);
+	}
+}
+
+// Two intsets are intersected by a merge, otherwise the members of the smaller set are
+// looked up in the larger one.
+// O(N + M) for intsets, O(min(N, M)) otherwise.
+NosqlObject *SetTypeIntersect(NosqlObject *set1, NosqlObject *set2)
+{
+	if(set1->encoding_ == NOSQL_ENCODING_INT_SET && set2->encoding_ == NOSQL_ENCODING_INT_SET)
+	{
+		return CreateObject(NOSQL_SET, NOSQL_ENCODING_INT_SET, IntSetIntersect(set1->ptr_,
+		                    set2->ptr_));
+	}
+	NosqlObject *result = CreateSetObject();
+	NosqlObject *sets[2] = {set2, result};
+	if(SetTypeLength(set1) > SetTypeLength(set2))
+	{
+		sets[0] = set1;
+		set1 = set2;
+	}
+	SetTypeForEach(set1, SetTypeAddCommonMember, sets);
+	return result;
+}
+
+// O(N + M)
+NosqlObject *SetTypeUnion(NosqlObject *set1, NosqlObject *set2)
+{
+	if(set1->encoding_ == NOSQL_ENCODING_INT_SET && set2->encoding_ == NOSQL_ENCODING_INT_SET)
+	{
+		NosqlObject *result = CreateObject(NOSQL_SET, NOSQL_ENCODING_INT_SET,
+		                                   IntSetUnion(set1->ptr_, set2->ptr_));
+		if(SetTypeLength(result) > g_set_max_int_set_entries)
+		{
+			SetTypeConvert(result, NOSQL_ENCODING_HASH_TABLE);
+		}
+		return result;
+	}
+	NosqlObject *result = CreateSetObject();
+	SetTypeForEach(set1, SetTypeAddMember, result);
+	SetTypeForEach(set2, SetTypeAddMember, result);
+	return result;
+}
@@ -0,0 +1,31 @@
+#ifndef NOSQL_SRC_SET_OBJECT_H_
+#define NOSQL_SRC_SET_OBJECT_H_
+
+#ifndef CAST
+#define CAST(type) (type)
+#endif
+
+#include <stdint.h>
+
+#include <nosql.h>
+
+// Set objects are sets of distinct strings. A set whose members are all integers is an
+// intset; any other set is a Dictionary of SDS strings without values, see
+// g_set_max_int_set_entries.
+
+// Add the member and return 1, or return 0 if it was already in the set.
+int SetTypeAdd(NosqlObject *set, const char *member, int64_t length);
+// Remove the member and return 1, or return 0 if it isn't in the set.
+int SetTypeRemove(NosqlObject *set, const char *member, int64_t length);
+// Return whether the member is in the set.
+int SetTypeIsMember(NosqlObject *set, const char *member, int64_t length);
+// Return the number of members.
+int64_t SetTypeLength(const NosqlObject *set);
+// Convert the intset encoded set to the encoding, NOSQL_ENCODING_HASH_TABLE.
+void SetTypeConvert(NosqlObject *set, int encoding);
+// Return a new set object of the members in both sets.
+NosqlObject *SetTypeIntersect(NosqlObject *set1, NosqlObject *set2);
+// Return a new set object of the members in either set.
+NosqlObject *SetTypeUnion(NosqlObject *set1, NosqlObject *set2);
+
+#endif // NOSQL_SRC_SET_OBJECT_H_
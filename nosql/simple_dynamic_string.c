@@ -1,39 +1,124 @@
 #include <simple_dynamic_string.h>
 
+#include <assert.h>
+#include <math.h> // isinf(), signbit()
+#include <stdarg.h> // va_list
 #include <string.h> // memcpy(), memset(), memmove(), memcmp()
 
 #include <memory.h>
 
+// Return the size of the header of type.
+// O(1)
+static inline int64_t SDSHeaderSize(int type)
+{
+	switch(type)
+	{
+	case SDS_TYPE_5:
+		return CAST(int64_t)sizeof(SDS5);
+	case SDS_TYPE_8:
+		return CAST(int64_t)sizeof(SDS8);
+	case SDS_TYPE_16:
+		return CAST(int64_t)sizeof(SDS16);
+	case SDS_TYPE_32:
+		return CAST(int64_t)sizeof(SDS32);
+	default:
+		return CAST(int64_t)sizeof(SDS64);
+	}
+}
+
+// Return the smallest header type that can hold a string whose capacity is capacity.
+// O(1)
+static inline int SDSRequiredType(int64_t capacity)
+{
+	if(capacity < (1 << 5))
+	{
+		return SDS_TYPE_5;
+	}
+	if(capacity < (1 << 8))
+	{
+		return SDS_TYPE_8;
+	}
+	if(capacity < (1 << 16))
+	{
+		return SDS_TYPE_16;
+	}
+	if(capacity < (CAST(int64_t)1 << 32))
+	{
+		return SDS_TYPE_32;
+	}
+	return SDS_TYPE_64;
+}
+
+// Set the length_ and free_ of string, whose type must be able to hold length + free.
+// A type 5 string has no free space, so free is dropped: the bytes stay allocated but
+// can't be used until the string is freed.
+// O(1)
+static void SDSSetLengthFree(String string, int64_t length, int64_t free)
+{
+	assert(!SDSIsShared(string));
+	switch(string[-1] & SDS_TYPE_MASK)
+	{
+	case SDS_TYPE_5:
+		string[-1] = CAST(char)(SDS_TYPE_5 | (length << SDS_TYPE_BITS));
+		break;
+	case SDS_TYPE_8:
+		SDS_HEADER(8, string)->length_ = CAST(uint8_t)length;
+		SDS_HEADER(8, string)->free_ = CAST(uint8_t)free;
+		break;
+	case SDS_TYPE_16:
+		SDS_HEADER(16, string)->length_ = CAST(uint16_t)length;
+		SDS_HEADER(16, string)->free_ = CAST(uint16_t)free;
+		break;
+	case SDS_TYPE_32:
+		SDS_HEADER(32, string)->length_ = CAST(uint32_t)length;
+		SDS_HEADER(32, string)->free_ = CAST(uint32_t)free;
+		break;
+	default:
+		SDS_HEADER(64, string)->length_ = CAST(uint64_t)length;
+		SDS_HEADER(64, string)->free_ = CAST(uint64_t)free;
+		break;
+	}
+}
+
 // Create a new SDS string with the data specified by the 'string' pointer and 'length'.
+// The string has the smallest header type that can hold length. Empty strings are
+// usually created in order to append, so they use type 8 instead of type 5.
 // O(N)
-String SDSNewLength(const void *string, int length)
+String SDSNewLength(const void *string, int64_t length)
 {
+	int type = SDSRequiredType(length);
+	if(type == SDS_TYPE_5 && length == 0)
+	{
+		type = SDS_TYPE_8;
+	}
+	int64_t header_size = SDSHeaderSize(type);
 	// One more byte is allocated for the null-terminated byte '\0'.
 	// Malloc does not initialize the memory.
 	// Calloc initializes all the allocated memory to 0.
-	SDS *sds = ((string == NULL) ?
-	            Calloc(CAST(int)sizeof(SDS) + length + 1) : Malloc(CAST(int)sizeof(SDS) + length + 1));
+	char *header = ((string == NULL) ?
+	                Calloc(header_size + length + 1) : Malloc(header_size + length + 1));
 
-	if(sds == NULL) // Allocate memory fail, return NULL.
+	if(header == NULL) // Allocate memory fail, return NULL.
 	{
 		return NULL;
 	}
-	// Initialize the structure's members.
-	sds->length_ = length;
-	sds->free_ = 0;
+	// Initialize the header's members.
+	String data = header + header_size;
+	data[-1] = CAST(char)type;
+	SDSSetLengthFree(data, length, 0);
 	if(string != NULL && length != 0)
 	{
-		memcpy(sds->data_, string, CAST(size_t)length); // Copy string.
+		memcpy(data, string, CAST(size_t)length); // Copy string.
 	}
-	sds->data_[length] = '\0'; // The string is always null-terminated.
-	return sds->data_; // Return the data part of structure.
+	data[length] = '\0'; // The string is always null-terminated.
+	return data; // Return the data part of structure.
 }
 
 // Create a new SDS string starting from a null terminated C string.
 // O(N)
 String SDSNew(const void *string)
 {
-	int length = (string == NULL ? 0 : CAST(int)strlen(string));
+	int64_t length = (string == NULL ? 0 : CAST(int64_t)strlen(string));
 	return SDSNewLength(string, length); // Delegate work to SDSNewLength.
 }
 
@@ -48,9 +133,18 @@ String SDSNewEmpty()
 // O(1)
 void SDSFree(String string)
 {
-	if(string != NULL) // If string is null, no operation is done.
+	if(string == NULL) // If string is null, no operation is done.
+	{
+		return;
+	}
+	char *header = string - SDSHeaderSize(string[-1] & SDS_TYPE_MASK);
+	if(!SDSIsShared(string))
+	{
+		Free(header);
+	}
+	else if(__atomic_sub_fetch(CAST(int64_t*)header - 1, 1, __ATOMIC_ACQ_REL) == 0)
 	{
-		Free(string - CAST(int)sizeof(SDS));
+		Free(CAST(int64_t*)header - 1); // The last reference.
 	}
 }
 
@@ -65,59 +159,172 @@ String SDSDuplicate(const String string)
 // O(1)
 void SDSClear(String string)
 {
-	SDS *sds = CAST(SDS*)(string - CAST(int)sizeof(SDS));
-	// Update data members.
-	sds->free_ += sds->length_;
-	sds->length_ = 0;
-	sds->data_[0] = '\0';
+	SDSSetLengthFree(string, 0, get_length(string) + get_free(string));
+	string[0] = '\0';
 }
 
-// Guarantee that there is at least free `need` bytes in at the end of the SDS string.
+// Return the largest capacity(length + free) that the fields of type can hold.
 // O(1)
-String SDSAllocateMemory(String string, int need)
+static inline int64_t SDSTypeMaxCapacity(int type)
+{
+	switch(type)
+	{
+	case SDS_TYPE_5:
+		return (1 << 5) - 1;
+	case SDS_TYPE_8:
+		return (1 << 8) - 1;
+	case SDS_TYPE_16:
+		return (1 << 16) - 1;
+	case SDS_TYPE_32:
+		return (CAST(int64_t)1 << 32) - 1;
+	default:
+		return INT64_MAX;
+	}
+}
+
+// Guarantee that there is at least free `need` bytes in at the end of the SDS string.
+// If greedy, allocate more than needed to make the following appends cheap.
+// The header type may change to hold the new capacity, which moves the data.
+// Type 5 can't record free space, so it's always converted to type 8 at least.
+// The allocator may reserve more bytes than we ask for(e.g., the rest of a size class),
+// they are recorded as free space too, instead of being wasted.
+// O(N)
+static String SDSMakeRoom(String string, int64_t need, int greedy)
 {
-	SDS *old_sds = CAST(SDS*)(string - CAST(int)sizeof(SDS));
-	if(old_sds->free_ >= need) // No need to reallocate memory, just return origin SDS.
+	if(get_free(string) >= need) // No need to reallocate memory, just return origin SDS.
 	{
 		return string;
 	}
+	assert(!SDSIsShared(string));
 
-	int new_length = old_sds->length_ + need; // The least need new length.
-	if(new_length < SDS_MAX_PREALLOC)
+	int64_t length = get_length(string);
+	int64_t new_length = length + need; // The least need new length.
+	if(greedy && new_length < SDS_MAX_PREALLOC)
 	{
 		new_length *= 2; // Double needed length.
 	}
-	else
+	else if(greedy)
 	{
 		new_length += SDS_MAX_PREALLOC; // Only allocate more 1MB.
 	}
-	SDS *new_sds = Realloc(old_sds, CAST(int)sizeof(SDS) + new_length + 1);
-	if(new_sds == NULL)
+	int old_type = string[-1] & SDS_TYPE_MASK, type = SDSRequiredType(new_length);
+	if(type == SDS_TYPE_5)
 	{
-		return NULL;
+		type = SDS_TYPE_8;
+	}
+	int64_t header_size = SDSHeaderSize(type), usable = 0;
+	char *old_header = string - SDSHeaderSize(old_type), *header = NULL;
+	if(old_type == type)
+	{
+		if((header = ReallocUsable(old_header, header_size + new_length + 1, &usable)) == NULL)
+		{
+			return NULL;
+		}
+		string = header + header_size;
+	}
+	else
+	{
+		// The header size changes, so the data moves anyway.
+		if((header = MallocUsable(header_size + new_length + 1, &usable)) == NULL)
+		{
+			return NULL;
+		}
+		memcpy(header + header_size, string, CAST(size_t)length + 1);
+		Free(old_header);
+		string = header + header_size;
+		string[-1] = CAST(char)type;
+	}
+	// The true capacity, as long as the header fields can hold it.
+	new_length = usable - header_size - 1;
+	if(new_length > SDSTypeMaxCapacity(type))
+	{
+		new_length = SDSTypeMaxCapacity(type);
+	}
+	// length_ field remain unchanged, only update free_ field.
+	SDSSetLengthFree(string, length, new_length - length);
+	return string;
+}
+
+// Guarantee that there is at least free `need` bytes in at the end of the SDS string.
+// Allocate twice the needed length(at most 1MB more), so appending N bytes one by one
+// only reallocates O(log(N)) times.
+// O(N)
+String SDSAllocateMemory(String string, int64_t need)
+{
+	return SDSMakeRoom(string, need, 1);
+}
+
+// Guarantee that there is at least free `need` bytes in at the end of the SDS string,
+// without allocating more than needed(except the allocator's own rounding). For strings
+// whose final size is known, e.g., when reading a bulk of known length.
+// O(N)
+String SDSMakeRoomForNonGreedy(String string, int64_t need)
+{
+	return SDSMakeRoom(string, need, 0);
+}
+
+// Reallocate the SDS string so that it has no free space, which is wasted memory for
+// long-lived strings that won't be appended anymore. The header type may become
+// smaller. After the call, the passed SDS string is no longer valid.
+// O(N)
+String SDSRemoveFreeSpace(String string)
+{
+	if(get_free(string) == 0)
+	{
+		return string;
+	}
+	int64_t length = get_length(string);
+	int old_type = string[-1] & SDS_TYPE_MASK, type = SDSRequiredType(length);
+	int64_t header_size = SDSHeaderSize(type);
+	char *old_header = string - SDSHeaderSize(old_type), *header = NULL;
+	if(old_type == type)
+	{
+		if((header = Realloc(old_header, header_size + length + 1)) == NULL)
+		{
+			return NULL;
+		}
+		string = header + header_size;
+	}
+	else
+	{
+		if((header = Malloc(header_size + length + 1)) == NULL)
+		{
+			return NULL;
+		}
+		memcpy(header + header_size, string, CAST(size_t)length + 1);
+		Free(old_header);
+		string = header + header_size;
+		string[-1] = CAST(char)type;
 	}
-	// Update data members: length_ field remain unchanged, only update free_ field.
-	new_sds->free_ = new_length - new_sds->length_;
-	return new_sds->data_;
+	SDSSetLengthFree(string, length, 0);
+	return string;
+}
+
+// Return the total number of bytes allocated for the SDS string: the header, the
+// string, the free space and the null byte.
+// O(1)
+int64_t SDSAllocatedSize(const String string)
+{
+	char *header = string - SDSHeaderSize(string[-1] & SDS_TYPE_MASK);
+	return MallocUsableSize(SDSIsShared(string) ? header - sizeof(int64_t) : header);
 }
 
 // Append the string `append` of 'length' bytes to the end of SDS string `string`.
 // After the call, the passed SDS string is no longer valid and all the
 // references must be substituted with the new pointer returned by the call.
 // O(N)
-String SDSAppendLength(String string, const void *append, int length)
+String SDSAppendLength(String string, const void *append, int64_t length)
 {
 	if((string = SDSAllocateMemory(string, length)) == NULL)
 	{
 		return NULL; // Can't allocate need memory.
 	}
 
-	SDS *sds = CAST(SDS*)(string - CAST(int)sizeof(SDS));
-	memcpy(string + sds->length_, append, CAST(size_t)length); // Append
+	int64_t old_length = get_length(string);
+	memcpy(string + old_length, append, CAST(size_t)length); // Append
 	// Update data members.
-	sds->length_ += length;
-	sds->free_ -= length;
-	sds->data_[sds->length_] = '\0';
+	SDSSetLengthFree(string, old_length + length, get_free(string) - length);
+	string[old_length + length] = '\0';
 	return string;
 }
 
@@ -127,7 +334,7 @@ String SDSAppendLength(String string, const void *append, int length)
 // O(N)
 String SDSAppend(String string, const char *append)
 {
-	return SDSAppendLength(string, append, CAST(int)strlen(append));
+	return SDSAppendLength(string, append, CAST(int64_t)strlen(append));
 }
 
 // Append the specified SDS string `append` to the existing SDS string `string`
@@ -139,25 +346,21 @@ String SDSAppendSDS(String string, const String append)
 
 // Destructively modify the SDS string `string` to hold the string `copy` of `need` bytes.
 // O(N)
-String SDSCopyLength(String string, const char *copy, int need)
+String SDSCopyLength(String string, const char *copy, int64_t need)
 {
-	SDS *sds = CAST(SDS*)(string - CAST(int)sizeof(SDS)); // Get structure.
-	int total_length = sds->length_ + sds->free_;
+	int64_t total_length = get_length(string) + get_free(string);
 	if(total_length < need) // Current memory is not enough.
 	{
 		// Try to allocate more memory.
-		if((string = SDSAllocateMemory(string, need - sds->length_)) == NULL)
+		if((string = SDSAllocateMemory(string, need - get_length(string))) == NULL)
 		{
 			return NULL;
 		}
-		// Update the new structure.
-		sds = CAST(SDS*)(string - CAST(int)sizeof(SDS));
-		total_length = sds->length_ + sds->free_;
+		total_length = get_length(string) + get_free(string);
 	}
 	memcpy(string, copy, CAST(size_t)need); // Copy `copy` to `string`
 	string[need] = '\0'; // Always end with null byte.
-	sds->length_ = need; // Update data members.
-	sds->free_ = total_length - sds->length_;
+	SDSSetLengthFree(string, need, total_length - need); // Update data members.
 	return string;
 }
 
@@ -165,16 +368,15 @@ String SDSCopyLength(String string, const char *copy, int need)
 // O(N)
 String SDSCopy(String string, const char *copy)
 {
-	return SDSCopyLength(string, copy, CAST(int)strlen(copy));
+	return SDSCopyLength(string, copy, CAST(int64_t)strlen(copy));
 }
 
 // Grow the SDS string to have the specified length and fill the added bytes with null.
 // If the specified length is smaller than the current length, no operation is performed.
 // O(N)
-String SDSGrowWithNull(String string, int new_length)
+String SDSGrowWithNull(String string, int64_t new_length)
 {
-	SDS *sds = CAST(SDS*)(string - CAST(int)sizeof(SDS));
-	int old_length = sds->length_;
+	int64_t old_length = get_length(string);
 	if(old_length > new_length) // Don't shrink string.
 	{
 		return string;
@@ -184,88 +386,1447 @@ String SDSGrowWithNull(String string, int new_length)
 	{
 		return NULL;
 	}
-	sds = CAST(SDS*)(string - CAST(int)sizeof(SDS));
 	// Fill added bytes with null '\0'; always end with one more null byte.
-	memset(string + old_length, 0, CAST(size_t)new_length - CAST(size_t)old_length + 1);
-	sds->free_ = old_length + sds->free_ - new_length; // old_length remain unchanged.
-	sds->length_ = new_length;
+	memset(string + old_length, 0, CAST(size_t)(new_length - old_length + 1));
+	// old_length remain unchanged.
+	SDSSetLengthFree(string, new_length, old_length + get_free(string) - new_length);
 	return string;
 }
 
 // Modify the string into a substring specified by the `begin` and `end` indexes.
 // The interval is inclusive, i.e., [begin, end]
 // O(N)
-void SDSRange(String string, int begin, int end)
+void SDSRange(String string, int64_t begin, int64_t end)
 {
-	SDS *sds = CAST(SDS*)(string - CAST(int)sizeof(SDS));
-	int old_length = (sds->length_);
+	int64_t old_length = get_length(string);
 	if(old_length == 0) // No content to move.
 	{
 		return;
 	}
-	int new_length = ((0 <= begin && begin < old_length) &&
-	                  (0 <= end && end < old_length) &&
-	                  begin < end) ? end - begin + 1: 0; // Get the new length.
+	int64_t new_length = ((0 <= begin && begin < old_length) &&
+	                      (0 <= end && end < old_length) &&
+	                      begin < end) ? end - begin + 1: 0; // Get the new length.
 	if(begin > 0 && new_length > 0) // The range is legal and we need to move.
 	{
-		// void *memmove(void *dest, const void *src, int n);
-		memmove(sds->data_, sds->data_ + begin, CAST(size_t)new_length);
+		// void *memmove(void *dest, const void *src, size_t n);
+		memmove(string, string + begin, CAST(size_t)new_length);
 	}
-	sds->data_[new_length] = '\0';
-	sds->length_ = new_length;
-	sds->free_ = sds->free_ + old_length - new_length;
+	string[new_length] = '\0';
+	SDSSetLengthFree(string, new_length, get_free(string) + old_length - new_length);
 }
 
-// Remove the part of the string from left and from right composed just of
-// contiguous characters found in 'set', which is a null terminated C string.
-// After the call, the modified SDS string is no longer valid and all the
-// references must be substituted with the new pointer returned by the call.
+// The kernels of the byte scanning operations, one set per instruction set: SSE2 is
+// compiled if the target has it(every x86-64 CPU), AVX2 is compiled for x86 with the
+// target attribute and only used if the CPU supports it, which is checked at runtime.
+// The SIMD kernels fall back to the scalar ones for inputs shorter than a vector.
+// Kernels that match bytes against a set compare a whole vector with each byte of the
+// set, so they are only used for sets of at most SDS_SIMD_SET_MAX bytes.
+#define SDS_SIMD_SET_MAX 16
+typedef struct SDSKernels
+{
+	int level_;
+	// Return the number of leading bytes of string that are in set.
+	int64_t (*Span)(const char *string, int64_t length, const char *set, int64_t set_length);
+	// Return the number of trailing bytes of string that are in set.
+	int64_t (*ReverseSpan)(const char *string, int64_t length, const char *set,
+	                       int64_t set_length);
+	// Flip the case of the bytes in [first, first + 25], i.e., the letters of one case.
+	void (*FlipCase)(char *string, int64_t length, char first);
+	// Replace every byte equal to from[i] by to[i], the first i that matches wins.
+	void (*MapChars)(char *string, int64_t length, const char *from, const char *to,
+	                 int64_t set_length);
+	// Return the index of the first byte that differs ignoring the case, or length.
+	int64_t (*MismatchNoCase)(const char *string1, const char *string2, int64_t length);
+	// Return the index of the first occurrence of needle in haystack, or -1.
+	int64_t (*Find)(const char *haystack, int64_t haystack_length, const char *needle,
+	                int64_t needle_length);
+} SDSKernels;
+
+#if defined(__SSE2__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SDS_SIMD_HAVE_AVX2
+#endif
+
+// Return the ASCII lower case of the byte c.
+// O(1)
+static inline unsigned char SDSLowerByte(char c)
+{
+	unsigned char byte = CAST(unsigned char)c;
+	return CAST(unsigned char)(CAST(unsigned char)(byte - 'A') < 26 ? byte | 0x20 : byte);
+}
+
+// Set the bit of every byte of set in the 256 bits bitmap.
 // O(N)
-String SDSTrim(String string, const char *set)
+static void SDSSetBitmap(const char *set, int64_t set_length, uint64_t *bitmap)
 {
-	// Define a map: key is the character, and value(0/!0) indicate
-	// whether corresponding character is in set.
-	int map_size = (1 << (CAST(int)sizeof(char) * 8)) + 10;
-	char map[map_size];
-	// void *memset(void *s, int c, int n);
-	memset(map, 0, CAST(size_t)map_size);
-	for(const char *key = set; *key != 0; ++key)
+	memset(bitmap, 0, 4 * sizeof(uint64_t));
+	for(int64_t index = 0; index < set_length; ++index)
 	{
-		map[CAST(int)*key] = 1;
+		unsigned char byte = CAST(unsigned char)set[index];
+		bitmap[byte >> 6] |= CAST(uint64_t)1 << (byte & 63);
 	}
-	SDS *sds = CAST(SDS*)(string - CAST(int)sizeof(SDS));
-	char *start = string, *end = string + sds->length_ - 1;
-	while(start <= string + sds->length_ - 1 && map[CAST(int)*start] != 0) // O(N).
+}
+
+#define SDS_BITMAP_TEST(bitmap, c) \
+(((bitmap)[CAST(unsigned char)(c) >> 6] >> (CAST(unsigned char)(c) & 63)) & 1)
+
+// O(N)
+static int64_t SDSSpanScalar(const char *string, int64_t length, const char *set,
+                             int64_t set_length)
+{
+	uint64_t bitmap[4];
+	SDSSetBitmap(set, set_length, bitmap);
+	int64_t index = 0;
+	while(index < length && SDS_BITMAP_TEST(bitmap, string[index]))
 	{
-		++start;
+		++index;
 	}
-	while(end >= string && map[CAST(int)*end] != 0) // O(N)
+	return index;
+}
+
+// O(N)
+static int64_t SDSReverseSpanScalar(const char *string, int64_t length, const char *set,
+                                    int64_t set_length)
+{
+	uint64_t bitmap[4];
+	SDSSetBitmap(set, set_length, bitmap);
+	int64_t index = length;
+	while(index > 0 && SDS_BITMAP_TEST(bitmap, string[index - 1]))
 	{
-		--end;
+		--index;
 	}
-	int new_length = (start > end) ? 0 : CAST(int)(end - start) + 1;
-	if(sds->data_ != start) // Need to move content.
+	return length - index;
+}
+
+// O(N)
+static void SDSFlipCaseScalar(char *string, int64_t length, char first)
+{
+	for(int64_t index = 0; index < length; ++index)
 	{
-		memmove(sds->data_, start, CAST(size_t)new_length);
+		if(CAST(unsigned char)(string[index] - first) < 26)
+		{
+			string[index] ^= 0x20;
+		}
+	}
+}
+
+// Short strings or small sets are mapped by searching the set for every byte, otherwise
+// a translation table is built.
+// O(N * M) or O(N + 256)
+static void SDSMapCharsScalar(char *string, int64_t length, const char *from, const char *to,
+                              int64_t set_length)
+{
+	if(length > SDS_SIMD_SET_MAX && set_length > SDS_SIMD_SET_MAX)
+	{
+		char table[256];
+		for(int byte = 0; byte < 256; ++byte)
+		{
+			table[byte] = CAST(char)byte;
+		}
+		for(int64_t index = set_length - 1; index >= 0; --index) // The first match wins.
+		{
+			table[CAST(unsigned char)from[index]] = to[index];
+		}
+		for(int64_t index = 0; index < length; ++index)
+		{
+			string[index] = table[CAST(unsigned char)string[index]];
+		}
+		return;
+	}
+	for(int64_t index = 0; index < length; ++index)
+	{
+		for(int64_t set_index = 0; set_index < set_length; ++set_index)
+		{
+			if(string[index] == from[set_index])
+			{
+				string[index] = to[set_index];
+				break;
+			}
+		}
 	}
-	sds->data_[new_length] = '\0';
-	sds->free_ += (sds->length_) - (new_length); // Update data members.
-	sds->length_ = new_length;
-	return string;
 }
 
-// Compare two SDS strings string1 and string2 with memcmp().
-// Return: 1 if s1 > s2, -1 if s1 < s2, 0 if s1 = s2.
-// If two strings have the same prefix, the longer string is larger.
 // O(N)
-int SDSCompare(const String string1, const String string2)
+static int64_t SDSMismatchNoCaseScalar(const char *string1, const char *string2,
+                                       int64_t length)
 {
-	int length1 = get_length(string1), length2 = get_length(string2);
-	int min_length = (length1 < length2) ? length1 : length2;
-	int result = memcmp(string1, string2, CAST(size_t)min_length);
+	int64_t index = 0;
+	while(index < length && SDSLowerByte(string1[index]) == SDSLowerByte(string2[index]))
+	{
+		++index;
+	}
+	return index;
+}
+
+// memchr() finds the candidates for the first byte of needle.
+// O(N * M)
+static int64_t SDSFindScalar(const char *haystack, int64_t haystack_length, const char *needle,
+                             int64_t needle_length)
+{
+	if(needle_length == 0)
+	{
+		return 0;
+	}
+	if(needle_length > haystack_length)
+	{
+		return -1;
+	}
+	const char *position = haystack, *last = haystack + haystack_length - needle_length;
+	while(position <= last &&
+	        (position = memchr(position, needle[0], CAST(size_t)(last - position) + 1)) != NULL)
+	{
+		if(memcmp(position + 1, needle + 1, CAST(size_t)needle_length - 1) == 0)
+		{
+			return position - haystack;
+		}
+		++position;
+	}
+	return -1;
+}
+
+static const SDSKernels sds_scalar_kernels =
+{
+	SDS_SIMD_SCALAR, SDSSpanScalar, SDSReverseSpanScalar, SDSFlipCaseScalar,
+	SDSMapCharsScalar, SDSMismatchNoCaseScalar, SDSFindScalar
+};
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+
+// Return the mask of the bytes of block that are equal to any of the broadcast set bytes.
+// O(M)
+static inline __attribute__ ((always_inline)) uint32_t SDSInSetSSE2(__m128i block,
+        const __m128i *set, int64_t set_length)
+{
+	__m128i in = _mm_cmpeq_epi8(block, set[0]);
+	for(int64_t index = 1; index < set_length; ++index)
+	{
+		in = _mm_or_si128(in, _mm_cmpeq_epi8(block, set[index]));
+	}
+	return CAST(uint32_t)_mm_movemask_epi8(in);
+}
+
+// Return block with the bytes in [first, first + 25] flipped case. Bytes are signed in
+// SSE2 compares, so they are biased to make the range start at -128.
+// O(1)
+static inline __attribute__ ((always_inline)) __m128i SDSFlipCaseBlockSSE2(__m128i block,
+        char first)
+{
+	__m128i biased = _mm_add_epi8(block, _mm_set1_epi8(CAST(char)(128 - first)));
+	__m128i in_range = _mm_cmplt_epi8(biased, _mm_set1_epi8(-128 + 26));
+	return _mm_xor_si128(block, _mm_and_si128(in_range, _mm_set1_epi8(0x20)));
+}
+
+// The last block overlaps the previous one instead of falling back to the scalar kernel
+// for the tail, the overlapped bytes are known to be in set.
+// O(N * M)
+static int64_t SDSSpanSSE2(const char *string, int64_t length, const char *set,
+                           int64_t set_length)
+{
+	if(length < 16 || set_length == 0 || set_length > SDS_SIMD_SET_MAX)
+	{
+		return SDSSpanScalar(string, length, set, set_length);
+	}
+	__m128i broadcast[SDS_SIMD_SET_MAX];
+	for(int64_t index = 0; index < set_length; ++index)
+	{
+		broadcast[index] = _mm_set1_epi8(set[index]);
+	}
+	for(int64_t index = 0; ; index += 16)
+	{
+		index = index > length - 16 ? length - 16 : index;
+		__m128i block = _mm_loadu_si128(CAST(const __m128i*)(string + index));
+		uint32_t out = ~SDSInSetSSE2(block, broadcast, set_length) & 0xffff;
+		if(out != 0)
+		{
+			return index + __builtin_ctz(out);
+		}
+		if(index == length - 16)
+		{
+			return length;
+		}
+	}
+}
+
+// O(N * M)
+static int64_t SDSReverseSpanSSE2(const char *string, int64_t length, const char *set,
+                                  int64_t set_length)
+{
+	if(length < 16 || set_length == 0 || set_length > SDS_SIMD_SET_MAX)
+	{
+		return SDSReverseSpanScalar(string, length, set, set_length);
+	}
+	__m128i broadcast[SDS_SIMD_SET_MAX];
+	for(int64_t index = 0; index < set_length; ++index)
+	{
+		broadcast[index] = _mm_set1_epi8(set[index]);
+	}
+	for(int64_t end = length; ; end -= 16)
+	{
+		end = end < 16 ? 16 : end;
+		__m128i block = _mm_loadu_si128(CAST(const __m128i*)(string + end - 16));
+		uint32_t out = ~SDSInSetSSE2(block, broadcast, set_length) & 0xffff;
+		if(out != 0)
+		{
+			return length - (end - 16 + (31 - __builtin_clz(out))) - 1;
+		}
+		if(end == 16)
+		{
+			return length;
+		}
+	}
+}
+
+// Flipping is idempotent(a flipped byte is out of the range), so the last block may
+// overlap the previous one.
+// O(N)
+static void SDSFlipCaseSSE2(char *string, int64_t length, char first)
+{
+	if(length < 16)
+	{
+		SDSFlipCaseScalar(string, length, first);
+		return;
+	}
+	for(int64_t index = 0; ; index += 16)
+	{
+		index = index > length - 16 ? length - 16 : index;
+		__m128i *address = CAST(__m128i*)(string + index);
+		_mm_storeu_si128(address, SDSFlipCaseBlockSSE2(_mm_loadu_si128(address), first));
+		if(index == length - 16)
+		{
+			return;
+		}
+	}
+}
+
+// The set is blended in reverse order so that the first match wins. Mapping is not
+// idempotent, so the tail is mapped by the scalar kernel.
+// O(N * M)
+static void SDSMapCharsSSE2(char *string, int64_t length, const char *from, const char *to,
+                            int64_t set_length)
+{
+	if(length < 16 || set_length == 0 || set_length > SDS_SIMD_SET_MAX)
+	{
+		SDSMapCharsScalar(string, length, from, to, set_length);
+		return;
+	}
+	__m128i broadcast_from[SDS_SIMD_SET_MAX], broadcast_to[SDS_SIMD_SET_MAX];
+	for(int64_t index = 0; index < set_length; ++index)
+	{
+		broadcast_from[index] = _mm_set1_epi8(from[index]);
+		broadcast_to[index] = _mm_set1_epi8(to[index]);
+	}
+	int64_t index = 0;
+	for(; index + 16 <= length; index += 16)
+	{
+		__m128i *address = CAST(__m128i*)(string + index);
+		__m128i block = _mm_loadu_si128(address), result = block;
+		for(int64_t set_index = set_length - 1; set_index >= 0; --set_index)
+		{
+			__m128i match = _mm_cmpeq_epi8(block, broadcast_from[set_index]);
+			result = _mm_or_si128(_mm_andnot_si128(match, result),
+			                      _mm_and_si128(match, broadcast_to[set_index]));
+		}
+		_mm_storeu_si128(address, result);
+	}
+	SDSMapCharsScalar(string + index, length - index, from, to, set_length);
+}
+
+// O(N)
+static int64_t SDSMismatchNoCaseSSE2(const char *string1, const char *string2, int64_t length)
+{
+	if(length < 16)
+	{
+		return SDSMismatchNoCaseScalar(string1, string2, length);
+	}
+	for(int64_t index = 0; ; index += 16)
+	{
+		index = index > length - 16 ? length - 16 : index;
+		__m128i block1 = SDSFlipCaseBlockSSE2(
+		                     _mm_loadu_si128(CAST(const __m128i*)(string1 + index)), 'A');
+		__m128i block2 = SDSFlipCaseBlockSSE2(
+		                     _mm_loadu_si128(CAST(const __m128i*)(string2 + index)), 'A');
+		uint32_t differ = ~CAST(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(block1, block2)) & 0xffff;
+		if(differ != 0)
+		{
+			return index + __builtin_ctz(differ);
+		}
+		if(index == length - 16)
+		{
+			return length;
+		}
+	}
+}
+
+// Compare 16 positions at once with the first and the last byte of needle, and only
+// compare the middle of needle at the positions where both match, which are rare.
+// O(N * M)
+static int64_t SDSFindSSE2(const char *haystack, int64_t haystack_length, const char *needle,
+                           int64_t needle_length)
+{
+	if(needle_length == 0 || needle_length > haystack_length)
+	{
+		return needle_length == 0 ? 0 : -1;
+	}
+	__m128i first = _mm_set1_epi8(needle[0]), last = _mm_set1_epi8(needle[needle_length - 1]);
+	int64_t index = 0, end = haystack_length - needle_length + 1; // Positions: [0, end)
+	for(; index + 16 <= end; index += 16)
+	{
+		__m128i block_first = _mm_loadu_si128(CAST(const __m128i*)(haystack + index));
+		__m128i block_last =
+		    _mm_loadu_si128(CAST(const __m128i*)(haystack + index + needle_length - 1));
+		uint32_t candidate = CAST(uint32_t)_mm_movemask_epi8(
+		                         _mm_and_si128(_mm_cmpeq_epi8(block_first, first),
+		                                       _mm_cmpeq_epi8(block_last, last)));
+		for(; candidate != 0; candidate &= candidate - 1)
+		{
+			int64_t position = index + __builtin_ctz(candidate);
+			if(needle_length <= 2 || memcmp(haystack + position + 1, needle + 1,
+			                                CAST(size_t)needle_length - 2) == 0)
+			{
+				return position;
+			}
+		}
+	}
+	int64_t position = SDSFindScalar(haystack + index, haystack_length - index, needle,
+	                                 needle_length);
+	return position < 0 ? -1 : index + position;
+}
+
+static const SDSKernels sds_sse2_kernels =
+{
+	SDS_SIMD_SSE2, SDSSpanSSE2, SDSReverseSpanSSE2, SDSFlipCaseSSE2, SDSMapCharsSSE2,
+	SDSMismatchNoCaseSSE2, SDSFindSSE2
+};
+#endif
+
+#if defined(SDS_SIMD_HAVE_AVX2)
+// The AVX2 kernels are the SSE2 ones with 32 bytes vectors, see above.
+#define SDS_AVX2 __attribute__ ((target("avx2")))
+
+static inline __attribute__ ((always_inline)) SDS_AVX2 uint32_t SDSInSetAVX2(__m256i block,
+        const __m256i *set, int64_t set_length)
+{
+	__m256i in = _mm256_cmpeq_epi8(block, set[0]);
+	for(int64_t index = 1; index < set_length; ++index)
+	{
+		in = _mm256_or_si256(in, _mm256_cmpeq_epi8(block, set[index]));
+	}
+	return CAST(uint32_t)_mm256_movemask_epi8(in);
+}
+
+static inline __attribute__ ((always_inline)) SDS_AVX2 __m256i SDSFlipCaseBlockAVX2(
+    __m256i block, char first)
+{
+	__m256i biased = _mm256_add_epi8(block, _mm256_set1_epi8(CAST(char)(128 - first)));
+	__m256i in_range = _mm256_cmpgt_epi8(_mm256_set1_epi8(-128 + 26), biased);
+	return _mm256_xor_si256(block, _mm256_and_si256(in_range, _mm256_set1_epi8(0x20)));
+}
+
+// O(N * M)
+static SDS_AVX2 int64_t SDSSpanAVX2(const char *string, int64_t length, const char *set,
+                                    int64_t set_length)
+{
+	if(length < 32 || set_length == 0 || set_length > SDS_SIMD_SET_MAX)
+	{
+		return SDSSpanScalar(string, length, set, set_length);
+	}
+	__m256i broadcast[SDS_SIMD_SET_MAX];
+	for(int64_t index = 0; index < set_length; ++index)
+	{
+		broadcast[index] = _mm256_set1_epi8(set[index]);
+	}
+	for(int64_t index = 0; ; index += 32)
+	{
+		index = index > length - 32 ? length - 32 : index;
+		__m256i block = _mm256_loadu_si256(CAST(const __m256i*)(string + index));
+		uint32_t out = ~SDSInSetAVX2(block, broadcast, set_length);
+		if(out != 0)
+		{
+			return index + __builtin_ctz(out);
+		}
+		if(index == length - 32)
+		{
+			return length;
+		}
+	}
+}
+
+// O(N * M)
+static SDS_AVX2 int64_t SDSReverseSpanAVX2(const char *string, int64_t length, const char *set,
+        int64_t set_length)
+{
+	if(length < 32 || set_length == 0 || set_length > SDS_SIMD_SET_MAX)
+	{
+		return SDSReverseSpanScalar(string, length, set, set_length);
+	}
+	__m256i broadcast[SDS_SIMD_SET_MAX];
+	for(int64_t index = 0; index < set_length; ++index)
+	{
+		broadcast[index] = _mm256_set1_epi8(set[index]);
+	}
+	for(int64_t end = length; ; end -= 32)
+	{
+		end = end < 32 ? 32 : end;
+		__m256i block = _mm256_loadu_si256(CAST(const __m256i*)(string + end - 32));
+		uint32_t out = ~SDSInSetAVX2(block, broadcast, set_length);
+		if(out != 0)
+		{
+			return length - (end - 32 + (31 - __builtin_clz(out))) - 1;
+		}
+		if(end == 32)
+		{
+			return length;
+		}
+	}
+}
+
+// O(N)
+static SDS_AVX2 void SDSFlipCaseAVX2(char *string, int64_t length, char first)
+{
+	if(length < 32)
+	{
+		SDSFlipCaseSSE2(string, length, first);
+		return;
+	}
+	for(int64_t index = 0; ; index += 32)
+	{
+		index = index > length - 32 ? length - 32 : index;
+		__m256i *address = CAST(__m256i*)(string + index);
+		_mm256_storeu_si256(address, SDSFlipCaseBlockAVX2(_mm256_loadu_si256(address), first));
+		if(index == length - 32)
+		{
+			return;
+		}
+	}
+}
+
+// O(N * M)
+static SDS_AVX2 void SDSMapCharsAVX2(char *string, int64_t length, const char *from,
+                                     const char *to, int64_t set_length)
+{
+	if(length < 32 || set_length == 0 || set_length > SDS_SIMD_SET_MAX)
+	{
+		SDSMapCharsSSE2(string, length, from, to, set_length);
+		return;
+	}
+	__m256i broadcast_from[SDS_SIMD_SET_MAX], broadcast_to[SDS_SIMD_SET_MAX];
+	for(int64_t index = 0; index < set_length; ++index)
+	{
+		broadcast_from[index] = _mm256_set1_epi8(from[index]);
+		broadcast_to[index] = _mm256_set1_epi8(to[index]);
+	}
+	int64_t index = 0;
+	for(; index + 32 <= length; index += 32)
+	{
+		__m256i *address = CAST(__m256i*)(string + index);
+		__m256i block = _mm256_loadu_si256(address), result = block;
+		for(int64_t set_index = set_length - 1; set_index >= 0; --set_index)
+		{
+			result = _mm256_blendv_epi8(result, broadcast_to[set_index],
+			                            _mm256_cmpeq_epi8(block, broadcast_from[set_index]));
+		}
+		_mm256_storeu_si256(address, result);
+	}
+	SDSMapCharsSSE2(string + index, length - index, from, to, set_length);
+}
+
+// O(N)
+static SDS_AVX2 int64_t SDSMismatchNoCaseAVX2(const char *string1, const char *string2,
+        int64_t length)
+{
+	if(length < 32)
+	{
+		return SDSMismatchNoCaseSSE2(string1, string2, length);
+	}
+	for(int64_t index = 0; ; index += 32)
+	{
+		index = index > length - 32 ? length - 32 : index;
+		__m256i block1 = SDSFlipCaseBlockAVX2(
+		                     _mm256_loadu_si256(CAST(const __m256i*)(string1 + index)), 'A');
+		__m256i block2 = SDSFlipCaseBlockAVX2(
+		                     _mm256_loadu_si256(CAST(const __m256i*)(string2 + index)), 'A');
+		uint32_t differ = ~CAST(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block1, block2));
+		if(differ != 0)
+		{
+			return index + __builtin_ctz(differ);
+		}
+		if(index == length - 32)
+		{
+			return length;
+		}
+	}
+}
+
+// O(N * M)
+static SDS_AVX2 int64_t SDSFindAVX2(const char *haystack, int64_t haystack_length,
+                                    const char *needle, int64_t needle_length)
+{
+	if(needle_length == 0 || needle_length > haystack_length)
+	{
+		return needle_length == 0 ? 0 : -1;
+	}
+	__m256i first = _mm256_set1_epi8(needle[0]);
+	__m256i last = _mm256_set1_epi8(needle[needle_length - 1]);
+	int64_t index = 0, end = haystack_length - needle_length + 1; // Positions: [0, end)
+	for(; index + 32 <= end; index += 32)
+	{
+		__m256i block_first = _mm256_loadu_si256(CAST(const __m256i*)(haystack + index));
+		__m256i block_last =
+		    _mm256_loadu_si256(CAST(const __m256i*)(haystack + index + needle_length - 1));
+		uint32_t candidate = CAST(uint32_t)_mm256_movemask_epi8(
+		                         _mm256_and_si256(_mm256_cmpeq_epi8(block_first, first),
+		                                          _mm256_cmpeq_epi8(block_last, last)));
+		for(; candidate != 0; candidate &= candidate - 1)
+		{
+			int64_t position = index + __builtin_ctz(candidate);
+			if(needle_length <= 2 || memcmp(haystack + position + 1, needle + 1,
+			                                CAST(size_t)needle_length - 2) == 0)
+			{
+				return position;
+			}
+		}
+	}
+	int64_t position = SDSFindSSE2(haystack + index, haystack_length - index, needle,
+	                               needle_length);
+	return position < 0 ? -1 : index + position;
+}
+
+static const SDSKernels sds_avx2_kernels =
+{
+	SDS_SIMD_AVX2, SDSSpanAVX2, SDSReverseSpanAVX2, SDSFlipCaseAVX2, SDSMapCharsAVX2,
+	SDSMismatchNoCaseAVX2, SDSFindAVX2
+};
+#endif
+
+// The kernels in use, chosen by the first call of SDSGetKernels() if nobody called
+// SDSSetSIMDLevel() before. Concurrent first calls choose the same kernels.
+static const SDSKernels *sds_kernels = NULL;
+
+// Use the kernels of level, or of the best level supported by the CPU if level is
+// SDS_SIMD_AUTO or isn't supported. Return the level in use.
+// O(1)
+int SDSSetSIMDLevel(int level)
+{
+	int supported = SDS_SIMD_SCALAR;
+#if defined(__SSE2__)
+	supported = SDS_SIMD_SSE2;
+#endif
+#if defined(SDS_SIMD_HAVE_AVX2)
+	if(__builtin_cpu_supports("avx2"))
+	{
+		supported = SDS_SIMD_AVX2;
+	}
+#endif
+	if(level == SDS_SIMD_AUTO || level > supported)
+	{
+		level = supported;
+	}
+	sds_kernels = &sds_scalar_kernels;
+#if defined(__SSE2__)
+	sds_kernels = level >= SDS_SIMD_SSE2 ? &sds_sse2_kernels : sds_kernels;
+#endif
+#if defined(SDS_SIMD_HAVE_AVX2)
+	sds_kernels = level == SDS_SIMD_AVX2 ? &sds_avx2_kernels : sds_kernels;
+#endif
+	return sds_kernels->level_;
+}
+
+// O(1)
+static inline const SDSKernels *SDSGetKernels()
+{
+	if(sds_kernels == NULL)
+	{
+		SDSSetSIMDLevel(SDS_SIMD_AUTO);
+	}
+	return sds_kernels;
+}
+
+// Return the SIMD level used by the string operations.
+// O(1)
+int SDSGetSIMDLevel()
+{
+	return SDSGetKernels()->level_;
+}
+
+// Remove the part of the string from left and from right composed just of
+// contiguous characters found in 'set', which is a null terminated C string.
+// After the call, the modified SDS string is no longer valid and all the
+// references must be substituted with the new pointer returned by the call.
+// O(N * M)
+String SDSTrim(String string, const char *set)
+{
+	const SDSKernels *kernels = SDSGetKernels();
+	int64_t length = get_length(string), set_length = CAST(int64_t)strlen(set);
+	int64_t start = kernels->Span(string, length, set, set_length);
+	int64_t new_length = length - start;
+	if(new_length > 0)
+	{
+		new_length -= kernels->ReverseSpan(string + start, new_length, set, set_length);
+	}
+	if(start != 0) // Need to move content.
+	{
+		memmove(string, string + start, CAST(size_t)new_length);
+	}
+	string[new_length] = '\0';
+	// Update data members.
+	SDSSetLengthFree(string, new_length, get_free(string) + length - new_length);
+	return string;
+}
+
+// Compare two SDS strings string1 and string2 with memcmp().
+// Return: 1 if s1 > s2, -1 if s1 < s2, 0 if s1 = s2.
+// If two strings have the same prefix, the longer string is larger.
+// O(N)
+int SDSCompare(const String string1, const String string2)
+{
+	int64_t length1 = get_length(string1), length2 = get_length(string2);
+	int64_t min_length = (length1 < length2) ? length1 : length2;
+	int result = memcmp(string1, string2, CAST(size_t)min_length);
+	if(result == 0)
+	{
+		return (length1 > length2) - (length1 < length2);
+	}
+	return result;
+}
+
+// Compare two SDS strings like SDSCompare(), but ASCII letters are compared as lower case.
+// Return: 1 if s1 > s2, -1 if s1 < s2, 0 if s1 = s2.
+// O(N)
+int SDSCompareNoCase(const String string1, const String string2)
+{
+	int64_t length1 = get_length(string1), length2 = get_length(string2);
+	int64_t min_length = (length1 < length2) ? length1 : length2;
+	int64_t index = SDSGetKernels()->MismatchNoCase(string1, string2, min_length);
+	if(index == min_length)
+	{
+		return (length1 > length2) - (length1 < length2);
+	}
+	return SDSLowerByte(string1[index]) > SDSLowerByte(string2[index]) ? 1 : -1;
+}
+
+// Return the index of the first occurrence of the needle of needle_length bytes in the
+// SDS string, or -1 if it doesn't occur. An empty needle occurs at index 0.
+// O(N * M), but usually O(N)
+int64_t SDSFind(const String string, const void *needle, int64_t needle_length)
+{
+	return SDSGetKernels()->Find(string, get_length(string), needle, needle_length);
+}
+
+// Convert the ASCII letters of the SDS string to lower case. Other bytes, including the
+// bytes of multi-byte characters, aren't changed.
+// O(N)
+void SDSToLower(String string)
+{
+	assert(!SDSIsShared(string));
+	SDSGetKernels()->FlipCase(string, get_length(string), 'A');
+}
+
+// Convert the ASCII letters of the SDS string to upper case.
+// O(N)
+void SDSToUpper(String string)
+{
+	assert(!SDSIsShared(string));
+	SDSGetKernels()->FlipCase(string, get_length(string), 'a');
+}
+
+// Replace every byte of the SDS string that is equal to from[i] by to[i], for i in
+// [0, set_length). If from has duplicated bytes, the first one wins.
+// For example, SDSMapChars(string, "ho", "01", 2) turns "hello" to "0ell1".
+// O(N * M)
+String SDSMapChars(String string, const char *from, const char *to, int64_t set_length)
+{
+	assert(!SDSIsShared(string));
+	SDSGetKernels()->MapChars(string, get_length(string), from, to, set_length);
+	return string;
+}
+
+// Split the string of length bytes by the separator of separator_length bytes, and
+// return an array of *count SDS tokens, which is freed by SDSFreeSplitResult().
+// Adjacent separators give empty tokens, and an empty string gives no token.
+// Return NULL with *count = 0 if the separator is empty or out of memory.
+// For example, splitting "foo_-_bar" by "_-_" gives "foo" and "bar".
+// O(N * M), but usually O(N)
+String *SDSSplitLength(const char *string, int64_t length, const char *separator,
+                       int64_t separator_length, int64_t *count)
+{
+	*count = 0;
+	if(length < 0 || separator_length < 1)
+	{
+		return NULL;
+	}
+	const SDSKernels *kernels = SDSGetKernels();
+	int64_t slot_number = 5, token_number = 0, start = 0;
+	String *tokens = Malloc(slot_number * CAST(int64_t)sizeof(String)), *new_tokens = NULL;
+	if(tokens == NULL || length == 0)
+	{
+		return tokens;
+	}
+	while(1)
+	{
+		int64_t end = kernels->Find(string + start, length - start, separator, separator_length);
+		end = end < 0 ? length : start + end;
+		if(token_number == slot_number)
+		{
+			slot_number *= 2;
+			if((new_tokens = Realloc(tokens, slot_number * CAST(int64_t)sizeof(String))) == NULL)
+			{
+				break;
+			}
+			tokens = new_tokens;
+		}
+		if((tokens[token_number] = SDSNewLength(string + start, end - start)) == NULL)
+		{
+			break;
+		}
+		++token_number;
+		if(end == length)
+		{
+			*count = token_number;
+			return tokens;
+		}
+		start = end + separator_length;
+	}
+	SDSFreeSplitResult(tokens, token_number); // Out of memory.
+	return NULL;
+}
+
+// Free the result of SDSSplitLength(): the count tokens and the array.
+// O(N)
+void SDSFreeSplitResult(String *tokens, int64_t count)
+{
+	if(tokens == NULL)
+	{
+		return;
+	}
+	for(int64_t index = 0; index < count; ++index)
+	{
+		SDSFree(tokens[index]);
+	}
+	Free(tokens);
+}
+
+// The decimal digits of 0 to 99 in pairs, so that integers are formatted two digits per
+// division instead of one.
+static const char sds_digit_pairs[201] =
+	"00010203040506070809101112131415161718192021222324"
+	"25262728293031323334353637383940414243444546474849"
+	"50515253545556575859606162636465666768697071727374"
+	"75767778798081828384858687888990919293949596979899";
+
+// Return the number of decimal digits of value.
+// O(1)
+static inline int SDSDigitNumber(uint64_t value)
+{
+	int digit_number = 1;
+	while(1)
+	{
+		if(value < 10)
+		{
+			return digit_number;
+		}
+		if(value < 100)
+		{
+			return digit_number + 1;
+		}
+		if(value < 1000)
+		{
+			return digit_number + 2;
+		}
+		if(value < 10000)
+		{
+			return digit_number + 3;
+		}
+		value /= 10000;
+		digit_number += 4;
+	}
+}
+
+// Write the decimal digits of value and a null byte to buffer, which must have at least
+// SDS_INT64_STRING_SIZE bytes, and return the number of digits.
+// O(1)
+int SDSFormatUInt64(char *buffer, uint64_t value)
+{
+	int length = SDSDigitNumber(value);
+	char *position = buffer + length;
+	*position = '\0';
+	while(value >= 100)
+	{
+		uint64_t pair = (value % 100) * 2;
+		value /= 100;
+		*--position = sds_digit_pairs[pair + 1];
+		*--position = sds_digit_pairs[pair];
+	}
+	if(value < 10)
+	{
+		*--position = CAST(char)('0' + value);
+	}
+	else
+	{
+		*--position = sds_digit_pairs[value * 2 + 1];
+		*--position = sds_digit_pairs[value * 2];
+	}
+	return length;
+}
+
+// Write value in decimal and a null byte to buffer, which must have at least
+// SDS_INT64_STRING_SIZE bytes, and return the length.
+// O(1)
+int SDSFormatInt64(char *buffer, int64_t value)
+{
+	if(value >= 0)
+	{
+		return SDSFormatUInt64(buffer, CAST(uint64_t)value);
+	}
+	// -INT64_MIN overflows, but its unsigned negation is right.
+	buffer[0] = '-';
+	return SDSFormatUInt64(buffer + 1, ~CAST(uint64_t)value + 1) + 1;
+}
+
+// Parse the length bytes of string as a decimal int64_t into *value. Return 1 on success,
+// or 0 if the string isn't exactly the canonical form of an int64_t: no spaces, no '+',
+// no leading zeros, no "-0" and no overflow. So an integer and its string form convert
+// back and forth without loss, which is required to store strings as integers.
+// O(1)
+int SDSParseInt64(const char *string, int64_t length, int64_t *value)
+{
+	int negative = length > 0 && string[0] == '-';
+	const char *position = string + negative, *end = string + length;
+	int64_t digit_number = length - negative;
+	if(digit_number == 1 && position[0] == '0' && !negative)
+	{
+		*value = 0;
+		return 1;
+	}
+	if(digit_number <= 0 || digit_number > 19 || position[0] < '1' || position[0] > '9')
+	{
+		return 0;
+	}
+	uint64_t result = 0; // 19 digits always fit in 64 bits.
+	for(; position != end; ++position)
+	{
+		if(*position < '0' || *position > '9')
+		{
+			return 0;
+		}
+		result = result * 10 + CAST(uint64_t)(*position - '0');
+	}
+	if(negative)
+	{
+		if(result > CAST(uint64_t)INT64_MAX + 1)
+		{
+			return 0;
+		}
+		*value = CAST(int64_t)(~result + 1);
+		return 1;
+	}
+	if(result > CAST(uint64_t)INT64_MAX)
+	{
+		return 0;
+	}
+	*value = CAST(int64_t)result;
+	return 1;
+}
+
+// Shortest round-trip formatting of doubles by the Grisu2 algorithm of Florian Loitsch,
+// "Printing Floating-Point Numbers Quickly and Accurately with Integers": the double and
+// the boundaries of the doubles that round to it are scaled by a cached power of ten into
+// 64 bits integers, and the digits are generated until they are inside the boundaries.
+// The result always reads back as the same double, and is the shortest such string for
+// all but 0.06% to 0.08% of random doubles (measured over 4.4M of them), which get one
+// more digit.
+typedef struct SDSDiyFp // A floating point number f * 2^e with a 64 bits significand.
+{
+	uint64_t f_;
+	int e_;
+} SDSDiyFp;
+
+#define SDS_DOUBLE_SIGNIFICAND_SIZE 52
+#define SDS_DOUBLE_HIDDEN_BIT (CAST(uint64_t)1 << SDS_DOUBLE_SIGNIFICAND_SIZE)
+#define SDS_DOUBLE_EXPONENT_BIAS (0x3ff + SDS_DOUBLE_SIGNIFICAND_SIZE)
+
+// The normalized 10^-348, 10^-340, ..., 10^340, rounded to 64 bits significands.
+static const uint64_t sds_cached_powers_f[87] =
+{
+	0xfa8fd5a0081c0288ULL, 0xbaaee17fa23ebf76ULL, 0x8b16fb203055ac76ULL,
+	0xcf42894a5dce35eaULL, 0x9a6bb0aa55653b2dULL, 0xe61acf033d1a45dfULL,
+	0xab70fe17c79ac6caULL, 0xff77b1fcbebcdc4fULL, 0xbe5691ef416bd60cULL,
+	0x8dd01fad907ffc3cULL, 0xd3515c2831559a83ULL, 0x9d71ac8fada6c9b5ULL,
+	0xea9c227723ee8bcbULL, 0xaecc49914078536dULL, 0x823c12795db6ce57ULL,
+	0xc21094364dfb5637ULL, 0x9096ea6f3848984fULL, 0xd77485cb25823ac7ULL,
+	0xa086cfcd97bf97f4ULL, 0xef340a98172aace5ULL, 0xb23867fb2a35b28eULL,
+	0x84c8d4dfd2c63f3bULL, 0xc5dd44271ad3cdbaULL, 0x936b9fcebb25c996ULL,
+	0xdbac6c247d62a584ULL, 0xa3ab66580d5fdaf6ULL, 0xf3e2f893dec3f126ULL,
+	0xb5b5ada8aaff80b8ULL, 0x87625f056c7c4a8bULL, 0xc9bcff6034c13053ULL,
+	0x964e858c91ba2655ULL, 0xdff9772470297ebdULL, 0xa6dfbd9fb8e5b88fULL,
+	0xf8a95fcf88747d94ULL, 0xb94470938fa89bcfULL, 0x8a08f0f8bf0f156bULL,
+	0xcdb02555653131b6ULL, 0x993fe2c6d07b7facULL, 0xe45c10c42a2b3b06ULL,
+	0xaa242499697392d3ULL, 0xfd87b5f28300ca0eULL, 0xbce5086492111aebULL,
+	0x8cbccc096f5088ccULL, 0xd1b71758e219652cULL, 0x9c40000000000000ULL,
+	0xe8d4a51000000000ULL, 0xad78ebc5ac620000ULL, 0x813f3978f8940984ULL,
+	0xc097ce7bc90715b3ULL, 0x8f7e32ce7bea5c70ULL, 0xd5d238a4abe98068ULL,
+	0x9f4f2726179a2245ULL, 0xed63a231d4c4fb27ULL, 0xb0de65388cc8ada8ULL,
+	0x83c7088e1aab65dbULL, 0xc45d1df942711d9aULL, 0x924d692ca61be758ULL,
+	0xda01ee641a708deaULL, 0xa26da3999aef774aULL, 0xf209787bb47d6b85ULL,
+	0xb454e4a179dd1877ULL, 0x865b86925b9bc5c2ULL, 0xc83553c5c8965d3dULL,
+	0x952ab45cfa97a0b3ULL, 0xde469fbd99a05fe3ULL, 0xa59bc234db398c25ULL,
+	0xf6c69a72a3989f5cULL, 0xb7dcbf5354e9beceULL, 0x88fcf317f22241e2ULL,
+	0xcc20ce9bd35c78a5ULL, 0x98165af37b2153dfULL, 0xe2a0b5dc971f303aULL,
+	0xa8d9d1535ce3b396ULL, 0xfb9b7cd9a4a7443cULL, 0xbb764c4ca7a44410ULL,
+	0x8bab8eefb6409c1aULL, 0xd01fef10a657842cULL, 0x9b10a4e5e9913129ULL,
+	0xe7109bfba19c0c9dULL, 0xac2820d9623bf429ULL, 0x80444b5e7aa7cf85ULL,
+	0xbf21e44003acdd2dULL, 0x8e679c2f5e44ff8fULL, 0xd433179d9c8cb841ULL,
+	0x9e19db92b4e31ba9ULL, 0xeb96bf6ebadf77d9ULL, 0xaf87023b9bf0ee6bULL
+};
+static const int16_t sds_cached_powers_e[87] =
+{
+	-1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980, -954, -927, -901,
+	-874, -847, -821, -794, -768, -741, -715, -688, -661, -635, -608, -582, -555, -529, -502,
+	-475, -449, -422, -396, -369, -343, -316, -289, -263, -236, -210, -183, -157, -130, -103,
+	-77, -50, -24, 3, 30, 56, 83, 109, 136, 162, 189, 216, 242, 269, 295, 322, 348, 375, 402,
+	428, 455, 481, 508, 534, 561, 588, 614, 641, 667, 694, 720, 747, 774, 800, 827, 853, 880,
+	907, 933, 960, 986, 1013, 1039, 1066
+};
+
+static const uint64_t sds_powers_of_ten[20] =
+{
+	1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+	100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL,
+	10000000000000ULL, 100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+	100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL
+};
+
+// Multiply x and y, keeping the rounded high 64 bits of the product.
+// O(1)
+static inline SDSDiyFp SDSDiyFpMultiply(SDSDiyFp x, SDSDiyFp y)
+{
+	uint64_t a = x.f_ >> 32, b = x.f_ & 0xffffffff, c = y.f_ >> 32, d = y.f_ & 0xffffffff;
+	uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+	uint64_t middle = (bd >> 32) + (ad & 0xffffffff) + (bc & 0xffffffff) + (CAST(uint64_t)1 << 31);
+	SDSDiyFp product = {ac + (ad >> 32) + (bc >> 32) + (middle >> 32), x.e_ + y.e_ + 64};
+	return product;
+}
+
+// Return the cached power of ten c such that the product of c and a number whose binary
+// exponent is e has a binary exponent in [-60, -32], and the decimal exponent of 1 / c.
+// O(1)
+static inline SDSDiyFp SDSCachedPower(int e, int *decimal_exponent)
+{
+	double dk = (-61 - e) * 0.30102999566398114 + 347; // log10(2)
+	int k = CAST(int)dk;
+	k += dk - k > 0.0;
+	int index = (k >> 3) + 1;
+	*decimal_exponent = -(-348 + index * 8);
+	SDSDiyFp power = {sds_cached_powers_f[index], sds_cached_powers_e[index]};
+	return power;
+}
+
+// Round the last digit down while the number stays in the boundaries and gets closer to
+// the exact value, whose distance from the upper boundary is distance.
+// O(1)
+static inline void SDSGrisuRound(char *buffer, int length, uint64_t delta, uint64_t rest,
+                                 uint64_t ten_kappa, uint64_t distance)
+{
+	while(rest < distance && delta - rest >= ten_kappa &&
+	        (rest + ten_kappa < distance || distance - rest > rest + ten_kappa - distance))
+	{
+		--buffer[length - 1];
+		rest += ten_kappa;
+	}
+}
+
+// Generate the digits of the upper boundary upper until the rest is within delta, which
+// is the distance to the lower boundary.
+// O(1)
+static void SDSGrisuDigits(SDSDiyFp w, SDSDiyFp upper, uint64_t delta, char *buffer,
+                           int *length, int *decimal_exponent)
+{
+	int shift = -upper.e_;
+	uint64_t one = CAST(uint64_t)1 << shift, distance = upper.f_ - w.f_;
+	uint32_t integral = CAST(uint32_t)(upper.f_ >> shift);
+	uint64_t fraction = upper.f_ & (one - 1);
+	int kappa = SDSDigitNumber(integral);
+	*length = 0;
+	while(kappa > 0)
+	{
+		uint32_t divisor = CAST(uint32_t)sds_powers_of_ten[kappa - 1];
+		uint32_t digit = integral / divisor;
+		integral %= divisor;
+		if(digit != 0 || *length != 0)
+		{
+			buffer[(*length)++] = CAST(char)('0' + digit);
+		}
+		--kappa;
+		uint64_t rest = (CAST(uint64_t)integral << shift) + fraction;
+		if(rest <= delta)
+		{
+			*decimal_exponent += kappa;
+			SDSGrisuRound(buffer, *length, delta, rest, sds_powers_of_ten[kappa] << shift,
+			              distance);
+			return;
+		}
+	}
+	while(1)
+	{
+		fraction *= 10;
+		delta *= 10;
+		char digit = CAST(char)(fraction >> shift);
+		if(digit != 0 || *length != 0)
+		{
+			buffer[(*length)++] = CAST(char)('0' + digit);
+		}
+		fraction &= one - 1;
+		--kappa;
+		if(fraction < delta)
+		{
+			*decimal_exponent += kappa;
+			SDSGrisuRound(buffer, *length, delta, fraction, one,
+			              -kappa < 20 ? distance * sds_powers_of_ten[-kappa] : 0);
+			return;
+		}
+	}
+}
+
+// Write the shortest digits of the positive finite value to buffer(at most 17 digits,
+// without a null byte) and return their number: value = digits * 10^*decimal_exponent.
+// O(1)
+static int SDSGrisu2(double value, char *buffer, int *decimal_exponent)
+{
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	int biased_exponent = CAST(int)(bits >> SDS_DOUBLE_SIGNIFICAND_SIZE) & 0x7ff;
+	SDSDiyFp v = {bits & (SDS_DOUBLE_HIDDEN_BIT - 1), 1 - SDS_DOUBLE_EXPONENT_BIAS};
+	if(biased_exponent != 0)
+	{
+		v.f_ += SDS_DOUBLE_HIDDEN_BIT;
+		v.e_ = biased_exponent - SDS_DOUBLE_EXPONENT_BIAS;
+	}
+	// The boundaries are the middles between v and its neighbors, the lower one is closer
+	// if v is a power of 2, as the neighbor below has a smaller exponent.
+	SDSDiyFp upper = {(v.f_ << 1) + 1, v.e_ - 1};
+	while((upper.f_ & (SDS_DOUBLE_HIDDEN_BIT << 1)) == 0)
+	{
+		upper.f_ <<= 1;
+		--upper.e_;
+	}
+	upper.f_ <<= 64 - SDS_DOUBLE_SIGNIFICAND_SIZE - 2;
+	upper.e_ -= 64 - SDS_DOUBLE_SIGNIFICAND_SIZE - 2;
+	SDSDiyFp lower = {(v.f_ << 1) - 1, v.e_ - 1};
+	if(v.f_ == SDS_DOUBLE_HIDDEN_BIT)
+	{
+		lower.f_ = (v.f_ << 2) - 1;
+		lower.e_ = v.e_ - 2;
+	}
+	lower.f_ <<= lower.e_ - upper.e_;
+	lower.e_ = upper.e_;
+	int shift = __builtin_clzll(v.f_);
+	v.f_ <<= shift;
+	v.e_ -= shift;
+
+	SDSDiyFp power = SDSCachedPower(upper.e_, decimal_exponent);
+	SDSDiyFp w = SDSDiyFpMultiply(v, power);
+	upper = SDSDiyFpMultiply(upper, power);
+	lower = SDSDiyFpMultiply(lower, power);
+	// Shrink the boundaries by 1 unit for the rounding errors of the multiplications.
+	++lower.f_;
+	--upper.f_;
+	int length = 0;
+	SDSGrisuDigits(w, upper, upper.f_ - lower.f_, buffer, &length, decimal_exponent);
+	return length;
+}
+
+// Write the shortest string that reads back as value, and a null byte to buffer, which
+// must have at least SDS_DOUBLE_STRING_SIZE bytes, and return the length. The notation
+// is the one of "%.17g": the exponent notation is used if the decimal exponent is less
+// than -4 or at least 17, e.g., 0.1, 100, 1.5e+20, 1e-05, -0, inf, -inf and nan.
+// O(1)
+int SDSFormatDouble(char *buffer, double value)
+{
+	char *position = buffer;
+	if(value != value)
+	{
+		memcpy(buffer, "nan", 4);
+		return 3;
+	}
+	if(signbit(value))
+	{
+		*position++ = '-';
+		value = -value;
+	}
+	if(value == 0 || isinf(value))
+	{
+		memcpy(position, value == 0 ? "0" : "inf", value == 0 ? 2 : 4);
+		return CAST(int)(position - buffer) + (value == 0 ? 1 : 3);
+	}
+	char digits[24];
+	int decimal_exponent = 0, length = SDSGrisu2(value, digits, &decimal_exponent);
+	int point = length + decimal_exponent; // The digits before the decimal point.
+	if(point - 1 < -4 || point - 1 >= 17)
+	{
+		*position++ = digits[0];
+		if(length > 1)
+		{
+			*position++ = '.';
+			memcpy(position, digits + 1, CAST(size_t)length - 1);
+			position += length - 1;
+		}
+		int exponent = point - 1;
+		*position++ = 'e';
+		*position++ = exponent < 0 ? '-' : '+';
+		exponent = exponent < 0 ? -exponent : exponent;
+		if(exponent < 10)
+		{
+			*position++ = '0'; // At least 2 digits, like printf().
+		}
+		position += SDSFormatUInt64(position, CAST(uint64_t)exponent);
+		return CAST(int)(position - buffer);
+	}
+	if(point <= 0) // 0.000ddd
+	{
+		memcpy(position, "0.000", CAST(size_t)(2 - point));
+		position += 2 - point;
+		memcpy(position, digits, CAST(size_t)length);
+		position += length;
+	}
+	else if(point >= length) // ddd000
+	{
+		memcpy(position, digits, CAST(size_t)length);
+		memset(position + length, '0', CAST(size_t)(point - length));
+		position += point;
+	}
+	else // ddd.ddd
+	{
+		memcpy(position, digits, CAST(size_t)point);
+		position[point] = '.';
+		memcpy(position + point + 1, digits + point, CAST(size_t)(length - point));
+		position += length + 1;
+	}
+	*position = '\0';
+	return CAST(int)(position - buffer);
+}
+
+// Create an SDS string holding the decimal form of value.
+// O(1)
+String SDSFromLongLong(int64_t value)
+{
+	char buffer[SDS_INT64_STRING_SIZE];
+	return SDSNewLength(buffer, SDSFormatInt64(buffer, value));
+}
+
+// Create an SDS string holding the shortest form of value that reads back as value.
+// O(1)
+String SDSFromDouble(double value)
+{
+	char buffer[SDS_DOUBLE_STRING_SIZE];
+	return SDSNewLength(buffer, SDSFormatDouble(buffer, value));
+}
+
+// Parse the SDS string as an int64_t into *value. Return 1 on success, or 0 if the string
+// isn't exactly the canonical form of an int64_t, see SDSParseInt64().
+// O(1)
+int SDSToLongLongStrict(const String string, int64_t *value)
+{
+	return SDSParseInt64(string, get_length(string), value);
+}
+
+// Append to the SDS string a string formatted like printf(), but without stdio and with
+// its own specifiers:
+// %s - C string
+// %S - SDS string
+// %i - int
+// %I - int64_t
+// %u - unsigned int
+// %U - uint64_t
+// %g - double, in the shortest form that reads back as the same double
+// %% - '%'
+// Other specifiers are copied as is. The string grows once per argument at most.
+// After the call, the passed SDS string is no longer valid and all the
+// references must be substituted with the new pointer returned by the call.
+// O(N)
+String SDSCatFmt(String string, const char *format, ...)
+{
+	char buffer[SDS_DOUBLE_STRING_SIZE];
+	va_list arguments;
+	va_start(arguments, format);
+	while(*format != '\0' && string != NULL)
+	{
+		const char *literal = format;
+		while(*format != '\0' && *format != '%')
+		{
+			++format;
+		}
+		if(format != literal)
+		{
+			string = SDSAppendLength(string, literal, format - literal);
+			continue;
+		}
+		const char *append = buffer;
+		int64_t length = 0;
+		switch(format[1])
+		{
+		case 's':
+			append = va_arg(arguments, const char*);
+			length = CAST(int64_t)strlen(append);
+			break;
+		case 'S':
+			append = va_arg(arguments, String);
+			length = get_length(CAST(const String)append);
+			break;
+		case 'i':
+			length = SDSFormatInt64(buffer, va_arg(arguments, int));
+			break;
+		case 'I':
+			length = SDSFormatInt64(buffer, va_arg(arguments, int64_t));
+			break;
+		case 'u':
+			length = SDSFormatUInt64(buffer, va_arg(arguments, unsigned int));
+			break;
+		case 'U':
+			length = SDSFormatUInt64(buffer, va_arg(arguments, uint64_t));
+			break;
+		case 'g':
+			length = SDSFormatDouble(buffer, va_arg(arguments, double));
+			break;
+		case '%':
+			append = "%";
+			length = 1;
+			break;
+		default: // An unknown specifier or a '%' at the end.
+			append = format;
+			length = format[1] == '\0' ? 1 : 2;
+			break;
+		}
+		format += format[1] == '\0' ? 1 : 2;
+		string = SDSAppendLength(string, append, length);
+	}
+	va_end(arguments);
+	return string;
+}
+
+// Create an immutable SDS string shared by reference counting: SDSShare() returns the
+// same string with one more reference instead of a copy, and SDSFree() only frees it when
+// the last reference is dropped. For large values referenced from several places, e.g.,
+// the keyspace and output buffers. The counter is an int64_t before the header and is
+// updated atomically, so the references may be dropped by different threads.
+// Modifying a shared string is a bug caught by assertions, use SDSUnshare() first.
+// O(N)
+String SDSNewShared(const void *string, int64_t length)
+{
+	int type = SDSRequiredType(length);
+	type = type == SDS_TYPE_5 ? SDS_TYPE_8 : type; // Type 5 has no room for the flag.
+	int64_t header_size = SDSHeaderSize(type);
+	int64_t *reference = Malloc(CAST(int64_t)sizeof(int64_t) + header_size + length + 1);
+	if(reference == NULL)
+	{
+		return NULL;
+	}
+	*reference = 1;
+	String data = CAST(char*)(reference + 1) + header_size;
+	data[-1] = CAST(char)type;
+	SDSSetLengthFree(data, length, 0);
+	data[-1] = CAST(char)(data[-1] | SDS_FLAG_SHARED);
+	if(string != NULL && length != 0)
+	{
+		memcpy(data, string, CAST(size_t)length);
+	}
+	data[length] = '\0';
+	return data;
+}
+
+// Return another reference to the SDS string, to be freed by SDSFree() on its own: the
+// same string if it's shared, or a copy otherwise.
+// O(1) if shared, O(N) otherwise
+String SDSShare(String string)
+{
+	if(!SDSIsShared(string))
+	{
+		return SDSDuplicate(string);
+	}
+	int64_t *reference = CAST(int64_t*)(string - SDSHeaderSize(string[-1] & SDS_TYPE_MASK)) - 1;
+	__atomic_add_fetch(reference, 1, __ATOMIC_RELAXED);
+	return string;
+}
+
+// Return the number of references to the SDS string, 1 if it isn't shared.
+// O(1)
+int64_t SDSReferenceCount(const String string)
+{
+	if(!SDSIsShared(string))
+	{
+		return 1;
+	}
+	int64_t *reference = CAST(int64_t*)(string - SDSHeaderSize(string[-1] & SDS_TYPE_MASK)) - 1;
+	return __atomic_load_n(reference, __ATOMIC_RELAXED);
+}
+
+// Return a modifiable SDS string with the content of string, which is dropped: the
+// string itself if it isn't shared, or a copy otherwise.
+// After the call, the passed SDS string is no longer valid.
+// O(1) if not shared, O(N) otherwise
+String SDSUnshare(String string)
+{
+	if(!SDSIsShared(string))
+	{
+		return string;
+	}
+	String copy = SDSNewLength(string, get_length(string));
+	if(copy != NULL)
+	{
+		SDSFree(string);
+	}
+	return copy;
+}
+
+// Embedded strings have the smallest header type that can hold length, and no free space.
+// O(1)
+int64_t SDSEmbeddedSize(int64_t length)
+{
+	return SDSHeaderSize(SDSRequiredType(length)) + length + 1;
+}
+
+// Like SDSNewLength(), in memory instead of a new allocation, e.g., right after the header of
+// an object that owns the string, so that both are read and freed together.
+// O(N)
+String SDSNewEmbedded(void *memory, const void *string, int64_t length)
+{
+	int type = SDSRequiredType(length);
+	String data = CAST(char*)memory + SDSHeaderSize(type);
+	data[-1] = CAST(char)type;
+	SDSSetLengthFree(data, length, 0);
+	if(length != 0)
+	{
+		memcpy(data, string, CAST(size_t)length);
+	}
+	data[length] = '\0';
+	return data;
+}
+
+// Return the view of the whole SDS string.
+// O(1)
+SDSView SDSViewOfSDS(const String string)
+{
+	SDSView view = {string, get_length(string)};
+	return view;
+}
+
+// Return 1 if the view and the SDS string have the same content, 0 otherwise.
+// O(N)
+int SDSViewEqual(const SDSView *view, const String string)
+{
+	return view->length_ == get_length(string) &&
+	       memcmp(view->data_, string, CAST(size_t)view->length_) == 0;
+}
+
+// Compare two views like SDSCompare(): the longer one is larger if one is the prefix of
+// the other.
+// O(N)
+int SDSViewCompare(const SDSView *view1, const SDSView *view2)
+{
+	int64_t min_length = view1->length_ < view2->length_ ? view1->length_ : view2->length_;
+	int result = memcmp(view1->data_, view2->data_, CAST(size_t)min_length);
 	if(result == 0)
 	{
-		return length1 - length2;
+		return (view1->length_ > view2->length_) - (view1->length_ < view2->length_);
 	}
 	return result;
 }
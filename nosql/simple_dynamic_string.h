@@ -5,35 +5,135 @@
 #define CAST(type) (type)
 #endif
 
+#include <stdint.h>
+
 #define SDS_MAX_PREALLOC (1024*1024) // The maximum bytes pre-allocate, 1MB
 
+// The instruction sets of the kernels that scan the bytes of strings, e.g., in SDSTrim()
+// and SDSFind(). By default the best one supported by the CPU is chosen at runtime.
+#define SDS_SIMD_AUTO (-1)
+#define SDS_SIMD_SCALAR 0
+#define SDS_SIMD_SSE2 1
+#define SDS_SIMD_AVX2 2
+
+#define SDS_INT64_STRING_SIZE 21 // "-9223372036854775808" and the null byte.
+#define SDS_DOUBLE_STRING_SIZE 32 // "-2.2250738585072014e-308" and the null byte fit.
+
 typedef char* String; // Type alias.
 
-typedef struct SimpleDynamicString // Structure that stores string object.
+// An SDS string has one of 5 header types, the smallest one whose fields can hold its
+// capacity(length + free) is chosen, so that short strings waste less memory.
+// The header is packed and its last byte, just before data_, is always flags_: its 3 low
+// bits are the type, so the header of a String str is found by str[-1].
+// SDS_TYPE_5 stores the length in the 5 high bits of flags_ and has no free space, it's
+// only used for strings shorter than 32 bytes that are never appended to.
+#define SDS_TYPE_5 0
+#define SDS_TYPE_8 1
+#define SDS_TYPE_16 2
+#define SDS_TYPE_32 3
+#define SDS_TYPE_64 4
+#define SDS_TYPE_MASK 7
+#define SDS_TYPE_BITS 3
+// The flag of shared strings(see SDSNewShared()), in the 5 high bits of flags_ that are
+// unused by types other than 5.
+#define SDS_FLAG_SHARED (1 << SDS_TYPE_BITS)
+
+typedef struct __attribute__ ((__packed__)) SimpleDynamicString5
 {
-	int length_; // Space have used in bytes.
-	int free_; // Space free in bytes.
+	unsigned char flags_; // 3 low bits: type; 5 high bits: length.
 	char data_[]; // Store string content.
-} SDS;
+} SDS5;
+
+typedef struct __attribute__ ((__packed__)) SimpleDynamicString8
+{
+	uint8_t length_; // Space have used in bytes.
+	uint8_t free_; // Space free in bytes.
+	unsigned char flags_; // 3 low bits: type; 5 high bits: unused.
+	char data_[]; // Store string content.
+} SDS8;
+
+typedef struct __attribute__ ((__packed__)) SimpleDynamicString16
+{
+	uint16_t length_;
+	uint16_t free_;
+	unsigned char flags_;
+	char data_[];
+} SDS16;
+
+typedef struct __attribute__ ((__packed__)) SimpleDynamicString32
+{
+	uint32_t length_;
+	uint32_t free_;
+	unsigned char flags_;
+	char data_[];
+} SDS32;
+
+typedef struct __attribute__ ((__packed__)) SimpleDynamicString64
+{
+	uint64_t length_;
+	uint64_t free_;
+	unsigned char flags_;
+	char data_[];
+} SDS64;
+
+// Return the header of the String str whose header type is T.
+#define SDS_HEADER(T, str) (CAST(SDS##T*)((str) - sizeof(SDS##T)))
 
 // Return the size of space has used in bytes, i.e., the member length_.
+// Always inlined: the switch makes GCC refuse to inline it in cold code under -Winline.
 // O(1)
-static inline int get_length(const String str)
+static inline __attribute__ ((always_inline)) int64_t get_length(const String str)
 {
-	SDS *sds = CAST(SDS*)(str - sizeof(SDS));
-	return sds->length_;
+	unsigned char flags = CAST(unsigned char)str[-1];
+	switch(flags & SDS_TYPE_MASK)
+	{
+	case SDS_TYPE_5:
+		return flags >> SDS_TYPE_BITS;
+	case SDS_TYPE_8:
+		return SDS_HEADER(8, str)->length_;
+	case SDS_TYPE_16:
+		return SDS_HEADER(16, str)->length_;
+	case SDS_TYPE_32:
+		return SDS_HEADER(32, str)->length_;
+	default:
+		return CAST(int64_t)SDS_HEADER(64, str)->length_;
+	}
 }
 
 // Return the size of free space in bytes, i.e., the member free_.
 // O(1)
-static inline int get_free(const String str)
+static inline __attribute__ ((always_inline)) int64_t get_free(const String str)
 {
-	SDS *sds = CAST(SDS*)(str - sizeof(SDS));
-	return sds->free_;
+	switch(str[-1] & SDS_TYPE_MASK)
+	{
+	case SDS_TYPE_5:
+		return 0;
+	case SDS_TYPE_8:
+		return SDS_HEADER(8, str)->free_;
+	case SDS_TYPE_16:
+		return SDS_HEADER(16, str)->free_;
+	case SDS_TYPE_32:
+		return SDS_HEADER(32, str)->free_;
+	default:
+		return CAST(int64_t)SDS_HEADER(64, str)->free_;
+	}
 }
 
+// A non-owning view of length_ bytes at data_, e.g., a slice of a query buffer, to look
+// up or compare without creating an SDS string. It isn't null-terminated and is only
+// valid as long as the bytes it points to.
+typedef struct SDSView
+{
+	const char *data_;
+	int64_t length_;
+} SDSView;
+
+// Return whether the SDS string is shared, i.e., immutable and reference counted.
+#define SDSIsShared(str) \
+(((str)[-1] & SDS_TYPE_MASK) != SDS_TYPE_5 && ((str)[-1] & SDS_FLAG_SHARED) != 0)
+
 // Create a new SDS string with the data specified by the 'string' pointer and 'length'.
-String SDSNewLength(const void *string, int length);
+String SDSNewLength(const void *string, int64_t length);
 // Create a new SDS string starting from a null terminated C string.
 String SDSNew(const void *string);
 // Create an empty SDS string.
@@ -45,25 +145,86 @@ String SDSDuplicate(const String string);
 // Make an SDS string empty(zero length).
 void SDSClear(String string);
 // Guarantee that there is at least free `need` bytes in at the end of the SDS string.
-String SDSAllocateMemory(String string, int need);
+String SDSAllocateMemory(String string, int64_t need);
+// Guarantee that there is at least free `need` bytes, without allocating more than needed.
+String SDSMakeRoomForNonGreedy(String string, int64_t need);
+// Reallocate the SDS string so that it has no free space.
+String SDSRemoveFreeSpace(String string);
+// Return the total number of bytes allocated for the SDS string.
+int64_t SDSAllocatedSize(const String string);
 // Append the string `append` of 'length' bytes to the end of SDS string `string`.
-String SDSAppendLength(String string, const void *append, int length);
+String SDSAppendLength(String string, const void *append, int64_t length);
 // Append the c-string `append` to the existing SDS `string`.
 String SDSAppend(String string, const char *append);
 // Append the specified SDS string `append` to the existing SDS string `string`
 String SDSAppendSDS(String string, const String append);
 // Destructively modify the SDS string `string` to hold the string `copy` of `need` bytes.
-String SDSCopyLength(String string, const char *copy, int need);
+String SDSCopyLength(String string, const char *copy, int64_t need);
 // Destructively modify the SDS string `string` to hold the string `copy`
 String SDSCopy(String string, const char *copy);
 // Grow the SDS string to have the specified length and fill the added bytes with null.
-String SDSGrowWithNull(String string, int new_length);
+String SDSGrowWithNull(String string, int64_t new_length);
 // Modify the string into a substring specified by the `begin` and `end` indexes.
-void SDSRange(String string, int begin, int end);
+void SDSRange(String string, int64_t begin, int64_t end);
 // Remove the part of the string from left and from right composed just of
 // contiguous characters found in 'set', which is a null terminated C string.
 String SDSTrim(String string, const char *set);
 // Compare two SDS strings string1 and string2 with memcmp().
 int SDSCompare(const String string1, const String string2);
+// Compare two SDS strings ignoring the case of ASCII letters.
+int SDSCompareNoCase(const String string1, const String string2);
+// Return the index of the first occurrence of needle in the SDS string, or -1.
+int64_t SDSFind(const String string, const void *needle, int64_t needle_length);
+// Convert the ASCII letters of the SDS string to lower case.
+void SDSToLower(String string);
+// Convert the ASCII letters of the SDS string to upper case.
+void SDSToUpper(String string);
+// Replace every byte of the SDS string that is equal to from[i] by to[i].
+String SDSMapChars(String string, const char *from, const char *to, int64_t set_length);
+// Split the string by the separator, return an array of *count SDS tokens.
+String *SDSSplitLength(const char *string, int64_t length, const char *separator,
+                       int64_t separator_length, int64_t *count);
+// Free the result of SDSSplitLength().
+void SDSFreeSplitResult(String *tokens, int64_t count);
+// Write the decimal digits of value to buffer, return the length.
+int SDSFormatUInt64(char *buffer, uint64_t value);
+// Write value in decimal to buffer, return the length.
+int SDSFormatInt64(char *buffer, int64_t value);
+// Write the shortest string that reads back as value to buffer, return the length.
+int SDSFormatDouble(char *buffer, double value);
+// Parse the canonical decimal form of an int64_t, return 1 on success or 0.
+int SDSParseInt64(const char *string, int64_t length, int64_t *value);
+// Create an SDS string holding the decimal form of value.
+String SDSFromLongLong(int64_t value);
+// Create an SDS string holding the shortest form of value that reads back as value.
+String SDSFromDouble(double value);
+// Parse the SDS string as an int64_t, return 1 on success or 0.
+int SDSToLongLongStrict(const String string, int64_t *value);
+// Append a string formatted with %s, %S, %i, %I, %u, %U, %g and %% to the SDS string.
+String SDSCatFmt(String string, const char *format, ...);
+// Create an immutable SDS string shared by reference counting.
+String SDSNewShared(const void *string, int64_t length);
+// Return another reference to the SDS string: itself if shared, or a copy.
+String SDSShare(String string);
+// Return the number of references to the SDS string, 1 if it isn't shared.
+int64_t SDSReferenceCount(const String string);
+// Return a modifiable SDS string with the content of string, which is dropped.
+String SDSUnshare(String string);
+// Return the number of bytes of an SDS string of length made by SDSNewEmbedded().
+int64_t SDSEmbeddedSize(int64_t length);
+// Make an SDS string holding a copy of the string in memory, which has
+// SDSEmbeddedSize(length) bytes, and return it. It is part of the caller's allocation: it
+// must never be freed, grown or shared.
+String SDSNewEmbedded(void *memory, const void *string, int64_t length);
+// Return the view of the whole SDS string.
+SDSView SDSViewOfSDS(const String string);
+// Return 1 if the view and the SDS string have the same content, 0 otherwise.
+int SDSViewEqual(const SDSView *view, const String string);
+// Compare two views like SDSCompare().
+int SDSViewCompare(const SDSView *view1, const SDSView *view2);
+// Use the SIMD kernels of level if the CPU supports it, return the level in use.
+int SDSSetSIMDLevel(int level);
+// Return the SIMD level used by the string operations.
+int SDSGetSIMDLevel();
 
 #endif // NOSQL_SRC_SIMPLE_DYNAMIC_STRING_H_
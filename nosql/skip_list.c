@@ -1,13 +1,41 @@
 #include <skip_list.h>
 
-// TODO: replace `sizeof` by `CAST(int)sizeof`
+#include <assert.h>
+#include <math.h> // isnan()
+#include <stddef.h> // NULL
+
+#include <memory.h>
+
+// The state of SkipListRandom(): any odd number.
+static uint64_t skip_list_random_state = 0x2545f4914f6cdd1dULL;
+
+// Return a 64 bits pseudo random number(xorshift64*).
+// O(1)
+static uint64_t SkipListRandom()
+{
+	skip_list_random_state ^= skip_list_random_state >> 12;
+	skip_list_random_state ^= skip_list_random_state << 25;
+	skip_list_random_state ^= skip_list_random_state >> 27;
+	return skip_list_random_state * 0x2545f4914f6cdd1dULL;
+}
+
+// Return a random level for a new node between 1 and SKIP_LIST_MAX_LEVEL: level L + 1 with
+// probability 1/4 of level L. Each 2 trailing zero bits of a random number are one more
+// level, which takes a single random number instead of one per level.
+// O(1)
+static int SkipListRandomLevel()
+{
+	// The bit 62 caps the level at 1 + 62 / 2 = SKIP_LIST_MAX_LEVEL.
+	return 1 + __builtin_ctzll(SkipListRandom() | (1ULL << 62)) / 2;
+}
 
 // Return a pointer to new created skip list node.
-SkipListNode *SkipListCreateNode(NosqlObject *object, double score, int level)
+// O(1)
+static SkipListNode *SkipListCreateNode(NosqlObject *object, double score, int level)
 {
 	// 1. Allocate memory and initialize all memory to 0.
-	SkipListNode *node =
-	    Calloc(sizeof(SkipListNode) + level * sizeof(struct SkipListLevel));
+	SkipListNode *node = Calloc(CAST(int64_t)sizeof(SkipListNode) +
+	                            level * CAST(int64_t)sizeof(struct SkipListLevel));
 	// 2. Initialize object_ and score_ fields with arguments,
 	node->object_ = object;
 	node->score_ = score;
@@ -20,15 +48,17 @@ SkipListNode *SkipListCreateNode(NosqlObject *object, double score, int level)
 SkipList *SkipListCreate()
 {
 	// 1. Allocate memory.
-	SkipList *skip_list = Malloc(sizeof(SkipList));
+	SkipList *skip_list = Malloc(CAST(int64_t)sizeof(SkipList));
 	// 2. Initialize data members: only create head node.
 	skip_list->head_ = SkipListCreateNode(NULL, 0, SKIP_LIST_MAX_LEVEL);
 	skip_list->tail_ = NULL;
 	skip_list->length_ = 0; // Head node is not included.
 	skip_list->level_ = 1;
+	return skip_list;
 }
 
 // Decrease this node's object's reference count and free this node's own memory.
+// O(1)
 void SkipListFreeNode(SkipListNode *node)
 {
 	// 1. Update reference count of this object.
@@ -46,10 +76,10 @@ void SkipListFree(SkipList *skip_list)
 	// 1. Store the first node's pointer(`node`) and free head node.
 	SkipListNode *node = skip_list->head_->level_[0].forward_, *next_node = NULL;
 	Free(skip_list->head_);
-	// 2. Traverse the skip list by level[0].forward_ and free each node by SkipListFreeNode.
+	// 2. Traverse the skip list by level_[0].forward_ and free each node by SkipListFreeNode.
 	while(node)
 	{
-		next_node = node->level_[0].forward_; // All nodes are linked by level[0] pointer.
+		next_node = node->level_[0].forward_; // All nodes are linked by level_[0] pointer.
 		SkipListFreeNode(node);
 		node = next_node;
 	}
@@ -57,33 +87,52 @@ void SkipListFree(SkipList *skip_list)
 	Free(skip_list);
 }
 
-SkipListNode *SkipListInsert(SkipList *skip_list, NosqlObject *object, double score)
+// Return whether the node is before the position of (object, score).
+// O(1), or O(M) to compare the objects of equal scores, M being their length.
+static inline __attribute__ ((always_inline)) int SkipListIsBefore(const SkipListNode *node,
+        const NosqlObject *object, double score)
 {
-	// 1. Check whether score is valid.
-	assert(isnan(score) == 0);
-	// 2. Traverse from the highest level in the skip list to level 0:
-	// (1). Store the previous node in level x of insert node in previous[x].
-	// (2). Store the total span from head to previous[x] in rank[x].
-	SkipListNode *previous[SKIP_LIST_MAX_LEVEL];
-	int rank[SKIP_LIST_MAX_LEVEL];
-	SkipListNode *node = skip_list->head_, *next_node = NULL;
+	return node->score_ < score ||
+	       (node->score_ == score && CompareStringObjects(node->object_, object) < 0);
+}
+
+// Traverse from the highest level in the skip list to level 0, store the previous node of
+// (object, score) in level x in previous[x], and the total span from head to previous[x] in
+// rank[x] if rank isn't NULL.
+// O(logN)
+static void SkipListFindPrevious(SkipList *skip_list, const NosqlObject *object, double score,
+                                 SkipListNode **previous, int64_t *rank)
+{
+	SkipListNode *node = skip_list->head_;
+	int64_t traversed = 0;
 	for(int level = skip_list->level_ - 1; level >= 0; --level)
 	{
-		// Store rank that is crossed to reach the insert position.
-		rank[level] = ((level == skip_list->level_ - 1) ? 0 : rank[level + 1]);
-		next_node = node->level_[level].forward_; // The next node in this level.
-		while(next_node != NULL && (next_node->score_ < score ||
-		                            (next_node->score_ == score &&
-		                             CompareStringObjects(next_node->object_, object) < 0)))
+		SkipListNode *next_node = node->level_[level].forward_; // The next node in this level.
+		while(next_node != NULL && SkipListIsBefore(next_node, object, score))
 		{
-			// We can insert new node after next_node. Update rank and node:
-			rank[level] += node->level_[level].span_;
+			// (object, score) is after next_node. Update rank and node:
+			traversed += node->level_[level].span_;
 			node = next_node;
 			next_node = next_node->level_[level].forward_; // Test the next node in this level.
 		}
-		// previous[level] is the just previous node of insert node in level `level`.
+		// previous[level] is the just previous node of (object, score) in level `level`.
 		previous[level] = node;
+		if(rank != NULL)
+		{
+			rank[level] = traversed;
+		}
 	}
+}
+
+// O(logN)
+SkipListNode *SkipListInsert(SkipList *skip_list, NosqlObject *object, double score)
+{
+	// 1. Check whether score is valid.
+	assert(isnan(score) == 0);
+	// 2. Find the previous node of the insert node in every level and its rank.
+	SkipListNode *previous[SKIP_LIST_MAX_LEVEL];
+	int64_t rank[SKIP_LIST_MAX_LEVEL];
+	SkipListFindPrevious(skip_list, object, score, previous, rank);
 	// 3. Randomly get the level number of insert node and create the new node.
 	int new_level = SkipListRandomLevel();
 	SkipListNode *new_node = SkipListCreateNode(object, score, new_level);
@@ -93,7 +142,7 @@ SkipListNode *SkipListInsert(SkipList *skip_list, NosqlObject *object, double sc
 	{
 		for(int level = skip_list->level_; level < new_level; ++level)
 		{
-			skip_list->level_[level].span_ = skip_list->length_;
+			skip_list->head_->level_[level].span_ = skip_list->length_;
 			rank[level] = 0;
 			previous[level] = skip_list->head_;
 		}
@@ -120,7 +169,7 @@ SkipListNode *SkipListInsert(SkipList *skip_list, NosqlObject *object, double sc
 		//					= previous[level]->level_[level].span_ - rank[0] + rank[level]
 		// We should first use span1 to calculate span3 and then update span1 to span2.
 		new_node->level_[level].span_ = previous[level]->level_[level].span_ - rank[0] + rank[level];
-		previous[level]->levle_[level].span_ = (rank[0] + 1) - rank[level];
+		previous[level]->level_[level].span_ = (rank[0] + 1) - rank[level];
 	}
 	// If new_level is less than the skip list's level, then for the previous[x] that x is
 	// greater than new_level, since new_node doesn't have x level, we don't link
@@ -135,7 +184,7 @@ SkipListNode *SkipListInsert(SkipList *skip_list, NosqlObject *object, double sc
 	new_node->backward_ = ((previous[0] == skip_list->head_) ? NULL // The first node.
 	                       : previous[0]); // Not the first node.
 	// Two conditions: new_node is the last node or not.
-	if(new_node->level[0].forward_) // Not the last node.
+	if(new_node->level_[0].forward_) // Not the last node.
 	{
 		new_node->level_[0].forward_->backward_ = new_node;
 	}
@@ -147,3 +196,350 @@ SkipListNode *SkipListInsert(SkipList *skip_list, NosqlObject *object, double sc
 	++skip_list->length_;
 	return new_node;
 }
+
+// Unlink the node, whose previous node in level x is previous[x], from the skip list.
+// O(1), or O(logN) to shrink the level of the skip list.
+static void SkipListDeleteNode(SkipList *skip_list, SkipListNode *node, SkipListNode **previous)
+{
+	// 1. In the levels of the node, previous[x] links to the node's next node, and spans the
+	// nodes that both of them span but the node. In the higher levels, previous[x] spans the
+	// node, which is gone.
+	for(int level = 0; level < skip_list->level_; ++level)
+	{
+		if(previous[level]->level_[level].forward_ == node)
+		{
+			previous[level]->level_[level].span_ += node->level_[level].span_ - 1;
+			previous[level]->level_[level].forward_ = node->level_[level].forward_;
+		}
+		else
+		{
+			--previous[level]->level_[level].span_;
+		}
+	}
+	// 2. Update the backward pointer of the next node, or the tail.
+	if(node->level_[0].forward_)
+	{
+		node->level_[0].forward_->backward_ = node->backward_;
+	}
+	else
+	{
+		skip_list->tail_ = node->backward_;
+	}
+	// 3. Drop the levels that no node has anymore.
+	while(skip_list->level_ > 1 && skip_list->head_->level_[skip_list->level_ - 1].forward_ == NULL)
+	{
+		--skip_list->level_;
+	}
+	--skip_list->length_;
+}
+
+// O(logN)
+int SkipListDelete(SkipList *skip_list, NosqlObject *object, double score, SkipListNode **node)
+{
+	SkipListNode *previous[SKIP_LIST_MAX_LEVEL];
+	SkipListFindPrevious(skip_list, object, score, previous, NULL);
+	// The object may have equal score with other objects, so compare the object too.
+	SkipListNode *target = previous[0]->level_[0].forward_;
+	if(target == NULL || target->score_ != score || CompareStringObjects(target->object_, object) != 0)
+	{
+		return 0;
+	}
+	SkipListDeleteNode(skip_list, target, previous);
+	if(node == NULL)
+	{
+		SkipListFreeNode(target);
+	}
+	else
+	{
+		*node = target;
+	}
+	return 1;
+}
+
+// If the node stays between its neighbors with the new score, only the score changes;
+// otherwise the node is deleted and inserted again, and its object moves to the new node.
+// O(logN)
+SkipListNode *SkipListUpdateScore(SkipList *skip_list, NosqlObject *object, double current_score,
+                                  double new_score)
+{
+	assert(isnan(new_score) == 0);
+	SkipListNode *previous[SKIP_LIST_MAX_LEVEL];
+	SkipListFindPrevious(skip_list, object, current_score, previous, NULL);
+	SkipListNode *node = previous[0]->level_[0].forward_;
+	assert(node != NULL && node->score_ == current_score &&
+	       CompareStringObjects(node->object_, object) == 0);
+	// Scores equal to a neighbor's would need comparing the objects: move the node instead.
+	if((node->backward_ == NULL || node->backward_->score_ < new_score) &&
+	        (node->level_[0].forward_ == NULL || node->level_[0].forward_->score_ > new_score))
+	{
+		node->score_ = new_score;
+		return node;
+	}
+	SkipListDeleteNode(skip_list, node, previous);
+	SkipListNode *new_node = SkipListInsert(skip_list, node->object_, new_score);
+	// The reference of the object moved to the new node.
+	Free(node);
+	return new_node;
+}
+
+// O(logN)
+int64_t SkipListGetRank(SkipList *skip_list, NosqlObject *object, double score)
+{
+	SkipListNode *node = skip_list->head_;
+	int64_t rank = 0;
+	for(int level = skip_list->level_ - 1; level >= 0; --level)
+	{
+		// Move to the last node that isn't after (object, score) in this level.
+		SkipListNode *next_node = node->level_[level].forward_;
+		while(next_node != NULL && (next_node->score_ < score || (next_node->score_ == score &&
+		                            CompareStringObjects(next_node->object_, object) <= 0)))
+		{
+			rank += node->level_[level].span_;
+			node = next_node;
+			next_node = next_node->level_[level].forward_;
+		}
+		// The node may be the head, whose object_ is NULL.
+		if(node != skip_list->head_ && node->score_ == score &&
+		        CompareStringObjects(node->object_, object) == 0)
+		{
+			return rank;
+		}
+	}
+	return 0;
+}
+
+// O(logN)
+SkipListNode *SkipListGetElementByRank(SkipList *skip_list, int64_t rank)
+{
+	SkipListNode *node = skip_list->head_;
+	int64_t traversed = 0;
+	for(int level = skip_list->level_ - 1; level >= 0; --level)
+	{
+		// Move forward as long as the rank isn't passed.
+		while(node->level_[level].forward_ != NULL && traversed + node->level_[level].span_ <= rank)
+		{
+			traversed += node->level_[level].span_;
+			node = node->level_[level].forward_;
+		}
+		if(traversed == rank)
+		{
+			return node == skip_list->head_ ? NULL : node;
+		}
+	}
+	return NULL;
+}
+
+// O(1)
+int SkipListIsInRange(SkipList *skip_list, const SkipListRange *range)
+{
+	// 1. Check whether the range is empty.
+	if(range->min_ > range->max_ ||
+	        (range->min_ == range->max_ && (range->min_exclusive_ || range->max_exclusive_)))
+	{
+		return 0;
+	}
+	// 2. The last node must be above the minimum and the first node below the maximum.
+	SkipListNode *node = skip_list->tail_;
+	if(node == NULL || !SkipListAboveMin(node->score_, range))
+	{
+		return 0;
+	}
+	node = skip_list->head_->level_[0].forward_;
+	return SkipListBelowMax(node->score_, range);
+}
+
+// O(logN)
+SkipListNode *SkipListFirstInRange(SkipList *skip_list, const SkipListRange *range)
+{
+	if(!SkipListIsInRange(skip_list, range))
+	{
+		return NULL;
+	}
+	// 1. Go to the last node below the minimum.
+	SkipListNode *node = skip_list->head_;
+	for(int level = skip_list->level_ - 1; level >= 0; --level)
+	{
+		while(node->level_[level].forward_ != NULL &&
+		        !SkipListAboveMin(node->level_[level].forward_->score_, range))
+		{
+			node = node->level_[level].forward_;
+		}
+	}
+	// 2. Its next node exists since the last node is above the minimum, and it is in the
+	// range unless it is above the maximum.
+	node = node->level_[0].forward_;
+	return SkipListBelowMax(node->score_, range) ? node : NULL;
+}
+
+// O(logN)
+SkipListNode *SkipListLastInRange(SkipList *skip_list, const SkipListRange *range)
+{
+	if(!SkipListIsInRange(skip_list, range))
+	{
+		return NULL;
+	}
+	// 1. Go to the last node below the maximum, which isn't the head since the first node is
+	// below the maximum.
+	SkipListNode *node = skip_list->head_;
+	for(int level = skip_list->level_ - 1; level >= 0; --level)
+	{
+		while(node->level_[level].forward_ != NULL &&
+		        SkipListBelowMax(node->level_[level].forward_->score_, range))
+		{
+			node = node->level_[level].forward_;
+		}
+	}
+	// 2. It is in the range unless it is below the minimum.
+	return SkipListAboveMin(node->score_, range) ? node : NULL;
+}
+
+// O(M), M being the length of the objects.
+int SkipListLexAboveMin(const NosqlObject *object, const SkipListLexRange *range)
+{
+	if(range->min_ == NULL)
+	{
+		return 1;
+	}
+	int result = CompareStringObjects(object, range->min_);
+	return range->min_exclusive_ ? result > 0 : result >= 0;
+}
+
+// O(M), M being the length of the objects.
+int SkipListLexBelowMax(const NosqlObject *object, const SkipListLexRange *range)
+{
+	if(range->max_ == NULL)
+	{
+		return 1;
+	}
+	int result = CompareStringObjects(object, range->max_);
+	return range->max_exclusive_ ? result < 0 : result <= 0;
+}
+
+// O(M), M being the length of the objects.
+int SkipListIsInLexRange(SkipList *skip_list, const SkipListLexRange *range)
+{
+	// 1. Check whether the range is empty.
+	if(range->min_ != NULL && range->max_ != NULL)
+	{
+		int result = CompareStringObjects(range->min_, range->max_);
+		if(result > 0 || (result == 0 && (range->min_exclusive_ || range->max_exclusive_)))
+		{
+			return 0;
+		}
+	}
+	// 2. The last node must be above the minimum and the first node below the maximum.
+	SkipListNode *node = skip_list->tail_;
+	if(node == NULL || !SkipListLexAboveMin(node->object_, range))
+	{
+		return 0;
+	}
+	node = skip_list->head_->level_[0].forward_;
+	return SkipListLexBelowMax(node->object_, range);
+}
+
+// O(logN * M), M being the length of the objects.
+SkipListNode *SkipListFirstInLexRange(SkipList *skip_list, const SkipListLexRange *range)
+{
+	if(!SkipListIsInLexRange(skip_list, range))
+	{
+		return NULL;
+	}
+	SkipListNode *node = skip_list->head_;
+	for(int level = skip_list->level_ - 1; level >= 0; --level)
+	{
+		while(node->level_[level].forward_ != NULL &&
+		        !SkipListLexAboveMin(node->level_[level].forward_->object_, range))
+		{
+			node = node->level_[level].forward_;
+		}
+	}
+	node = node->level_[0].forward_;
+	return SkipListLexBelowMax(node->object_, range) ? node : NULL;
+}
+
+// O(logN * M), M being the length of the objects.
+SkipListNode *SkipListLastInLexRange(SkipList *skip_list, const SkipListLexRange *range)
+{
+	if(!SkipListIsInLexRange(skip_list, range))
+	{
+		return NULL;
+	}
+	SkipListNode *node = skip_list->head_;
+	for(int level = skip_list->level_ - 1; level >= 0; --level)
+	{
+		while(node->level_[level].forward_ != NULL &&
+		        SkipListLexBelowMax(node->level_[level].forward_->object_, range))
+		{
+			node = node->level_[level].forward_;
+		}
+	}
+	return SkipListLexAboveMin(node->object_, range) ? node : NULL;
+}
+
+// O(logN + M), M being the number of deleted nodes.
+int64_t SkipListDeleteRangeByScore(SkipList *skip_list, const SkipListRange *range,
+                                   SkipListDeleteFunction callback, void *argument)
+{
+	// 1. Find the previous node of the range in every level.
+	SkipListNode *previous[SKIP_LIST_MAX_LEVEL], *node = skip_list->head_;
+	for(int level = skip_list->level_ - 1; level >= 0; --level)
+	{
+		while(node->level_[level].forward_ != NULL &&
+		        !SkipListAboveMin(node->level_[level].forward_->score_, range))
+		{
+			node = node->level_[level].forward_;
+		}
+		previous[level] = node;
+	}
+	// 2. Unlink the nodes in the range one after another: previous[] stays the previous node
+	// of the next one in every level, so it's found only once.
+	int64_t deleted = 0;
+	node = node->level_[0].forward_;
+	while(node != NULL && SkipListBelowMax(node->score_, range))
+	{
+		SkipListNode *next_node = node->level_[0].forward_;
+		SkipListDeleteNode(skip_list, node, previous);
+		if(callback != NULL)
+		{
+			callback(argument, node);
+		}
+		SkipListFreeNode(node);
+		++deleted;
+		node = next_node;
+	}
+	return deleted;
+}
+
+// O(logN + M), M being the number of deleted nodes.
+int64_t SkipListDeleteRangeByRank(SkipList *skip_list, int64_t start, int64_t end,
+                                  SkipListDeleteFunction callback, void *argument)
+{
+	// 1. Find the previous node of rank start in every level.
+	SkipListNode *previous[SKIP_LIST_MAX_LEVEL], *node = skip_list->head_;
+	int64_t traversed = 0;
+	for(int level = skip_list->level_ - 1; level >= 0; --level)
+	{
+		while(node->level_[level].forward_ != NULL && traversed + node->level_[level].span_ < start)
+		{
+			traversed += node->level_[level].span_;
+			node = node->level_[level].forward_;
+		}
+		previous[level] = node;
+	}
+	// 2. Unlink the nodes from rank start to rank end in one pass, as above.
+	int64_t deleted = 0;
+	node = node->level_[0].forward_;
+	for(int64_t rank = traversed + 1; node != NULL && rank <= end; ++rank)
+	{
+		SkipListNode *next_node = node->level_[0].forward_;
+		SkipListDeleteNode(skip_list, node, previous);
+		if(callback != NULL)
+		{
+			callback(argument, node);
+		}
+		SkipListFreeNode(node);
+		++deleted;
+		node = next_node;
+	}
+	return deleted;
+}
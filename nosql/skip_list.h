@@ -5,28 +5,118 @@
 #define CAST(type) (type)
 #endif
 
+#include <stdint.h>
+
 #include <nosql.h>
 
+// A skip list keeps string objects ordered by score, then by the bytes of the object, and
+// finds, inserts and deletes one in O(logN) expected time. Every level of a node links to
+// the next node that has this level, and counts the nodes it skips(span_), so that the
+// rank of a node is the sum of the spans on the way to it.
+
 typedef struct SkipListNode
 {
 	NosqlObject *object_; // Pointer to its stored object.
 	double score_; // Object's corresponding score.
+	struct SkipListNode *backward_; // Point to the just backward node, NULL for the first one.
 	struct SkipListLevel // A structure that combines a forwarding pointer and its span.
 	{
 		// Point to the next node and the distance between them is span_.
 		struct SkipListNode *forward_;
-		int span_; // The number of links between this node and the forward_ node.
+		int64_t span_; // The number of links between this node and the forward_ node.
 	} level_[]; // An array.
-	struct SkipListNode *backward_; // Point to the just backward node.
 } SkipListNode;
 
 typedef struct SkipList
 {
 	struct SkipListNode *head_, *tail_;
-	int length_; // The number of nodes in skip list.
+	int64_t length_; // The number of nodes in skip list.
 	int level_; // The number of levels in the node which has the most levels in the skip list.
 } SkipList;
 
-#define SKIP_LIST_MAX_LEVEL 32 // Should be enough for 2^32 elements
+// A range of scores: [min_, max_], where either end is excluded if its *_exclusive_ is set.
+typedef struct SkipListRange
+{
+	double min_, max_;
+	int min_exclusive_, max_exclusive_;
+} SkipListRange;
+
+// A range of objects in the same way, where a NULL min_ or max_ is unbounded. Lexical ranges
+// are only meaningful if all nodes have the same score.
+typedef struct SkipListLexRange
+{
+	NosqlObject *min_, *max_;
+	int min_exclusive_, max_exclusive_;
+} SkipListLexRange;
+
+// The callback of SkipListDeleteRangeBy*(), called for every deleted node after it's unlinked
+// and before it's freed.
+typedef void (*SkipListDeleteFunction) (void *argument, SkipListNode *node);
+
+// A node of level L also has level L + 1 with probability 1/4.
+#define SKIP_LIST_MAX_LEVEL 32 // Should be enough for 2^64 elements
+
+// Return whether the score is not below the minimum of the range.
+// O(1)
+static inline __attribute__ ((always_inline)) int SkipListAboveMin(double score,
+        const SkipListRange *range)
+{
+	return range->min_exclusive_ ? score > range->min_ : score >= range->min_;
+}
+
+// Return whether the score is not above the maximum of the range.
+// O(1)
+static inline __attribute__ ((always_inline)) int SkipListBelowMax(double score,
+        const SkipListRange *range)
+{
+	return range->max_exclusive_ ? score < range->max_ : score <= range->max_;
+}
+
+// Return a pointer to a new skip list.
+SkipList *SkipListCreate();
+// Free a skip list structure and all its linked nodes.
+void SkipListFree(SkipList *skip_list);
+// Insert the object, which must not be in the skip list, with the score. The skip list takes
+// over the reference of the caller. Return the new node.
+SkipListNode *SkipListInsert(SkipList *skip_list, NosqlObject *object, double score);
+// Delete the node of the object and score and return 1, or return 0 if not found. If node
+// isn't NULL, the node isn't freed but stored in *node, and the caller frees it by
+// SkipListFreeNode(); otherwise the node is freed.
+int SkipListDelete(SkipList *skip_list, NosqlObject *object, double score, SkipListNode **node);
+// Decrease this node's object's reference count and free this node's own memory.
+void SkipListFreeNode(SkipListNode *node);
+// Change the score of the object, which must be in the skip list with current_score, and
+// return its node, which is a new one if the node had to move.
+SkipListNode *SkipListUpdateScore(SkipList *skip_list, NosqlObject *object, double current_score,
+                                  double new_score);
+// Return the rank of the object with the score, the first node being 1, or 0 if not found.
+int64_t SkipListGetRank(SkipList *skip_list, NosqlObject *object, double score);
+// Return the node of rank, the first node being 1, or NULL if out of range.
+SkipListNode *SkipListGetElementByRank(SkipList *skip_list, int64_t rank);
+// Return whether the range overlaps the scores of the skip list, from its first node to its
+// last one. If not, no node is in the range; if so, there may still be none between them.
+int SkipListIsInRange(SkipList *skip_list, const SkipListRange *range);
+// Return the first node whose score is in the range, or NULL.
+SkipListNode *SkipListFirstInRange(SkipList *skip_list, const SkipListRange *range);
+// Return the last node whose score is in the range, or NULL.
+SkipListNode *SkipListLastInRange(SkipList *skip_list, const SkipListRange *range);
+// Return whether the object is not below the minimum of the lexical range.
+int SkipListLexAboveMin(const NosqlObject *object, const SkipListLexRange *range);
+// Return whether the object is not above the maximum of the lexical range.
+int SkipListLexBelowMax(const NosqlObject *object, const SkipListLexRange *range);
+// Return whether the lexical range overlaps the objects of the skip list, in the same way.
+int SkipListIsInLexRange(SkipList *skip_list, const SkipListLexRange *range);
+// Return the first node whose object is in the lexical range, or NULL.
+SkipListNode *SkipListFirstInLexRange(SkipList *skip_list, const SkipListLexRange *range);
+// Return the last node whose object is in the lexical range, or NULL.
+SkipListNode *SkipListLastInLexRange(SkipList *skip_list, const SkipListLexRange *range);
+// Delete the nodes whose scores are in the range in one pass and return their number. If
+// callback isn't NULL, it's called for every deleted node.
+int64_t SkipListDeleteRangeByScore(SkipList *skip_list, const SkipListRange *range,
+                                   SkipListDeleteFunction callback, void *argument);
+// Delete the nodes from rank start to rank end, both included and the first node being 1, in
+// one pass and return their number, in the same way.
+int64_t SkipListDeleteRangeByRank(SkipList *skip_list, int64_t start, int64_t end,
+                                  SkipListDeleteFunction callback, void *argument);
 
 #endif // NOSQL_SRC_SKIP_LIST_H_
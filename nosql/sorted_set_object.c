@@ -0,0 +1,604 @@
+#include <sorted_set_object.h>
+
+#include <assert.h>
+#include <math.h> // isnan(), signbit()
+#include <string.h> // memcmp(), memcpy()
+
+#include <hash_function.h>
+#include <list_pack.h>
+#include <memory.h>
+#include <simple_dynamic_string.h>
+
+static uint64_t SortedSetHashObject(const void *key)
+{
+	return HashSDS((CAST(const NosqlObject*)key)->ptr_);
+}
+
+static int SortedSetCompareObject(void *argument, const void *key1, const void *key2)
+{
+	const String string1 = (CAST(const NosqlObject*)key1)->ptr_;
+	const String string2 = (CAST(const NosqlObject*)key2)->ptr_;
+	int64_t length = get_length(string1);
+	return length == get_length(string2) && memcmp(string1, string2, CAST(size_t)length) == 0;
+}
+
+static int SortedSetCompareView(void *argument, const void *view, const void *key)
+{
+	return SDSViewEqual(view, (CAST(const NosqlObject*)key)->ptr_);
+}
+
+// Members are created by CreateStringObject(), so they are raw or embedded strings whose ptr_
+// is an SDS string. Members are looked up by views of the argument strings. The keys and
+// values belong to the skip list, so the dictionary frees neither.
+static HashTableType sorted_set_dictionary_type =
+{
+	SortedSetHashObject, SortedSetCompareObject, NULL, NULL, NULL, NULL,
+	DICTIONARY_LAYOUT_CHAINED, 0, HashSDSView, SortedSetCompareView
+};
+
+// Store the view of the member at position in *view. An integer member is formatted in
+// buffer, which must have SDS_INT64_STRING_SIZE bytes.
+// O(1)
+static void SortedSetTypeListPackMember(const uint8_t *position, char *buffer, SDSView *view)
+{
+	ListPackEntry entry;
+	ListPackGet(position, &entry);
+	if(entry.string_ == NULL)
+	{
+		view->data_ = buffer;
+		view->length_ = SDSFormatInt64(buffer, entry.integer_);
+	}
+	else
+	{
+		view->data_ = entry.string_;
+		view->length_ = entry.length_;
+	}
+}
+
+// A score that is an integer is stored as one, any other score as the tag byte followed by the
+// bytes of the double. The tag keeps the listpack from taking the string for an integer, and
+// reading the score back is a memcpy() instead of a strtod() on every element of a scan.
+#define SORTED_SET_SCORE_TAG '#'
+#define SORTED_SET_SCORE_SIZE (1 + CAST(int)sizeof(double))
+
+// Write the listpack form of the score to buffer, which has SDS_INT64_STRING_SIZE bytes, and
+// return its length.
+// O(1)
+static int SortedSetTypeListPackFormatScore(char *buffer, double score)
+{
+	if(score >= -9223372036854775808.0 && score < 9223372036854775808.0 &&
+	        CAST(double)CAST(int64_t)score == score && (score != 0 || signbit(score) == 0))
+	{
+		return SDSFormatInt64(buffer, CAST(int64_t)score);
+	}
+	buffer[0] = SORTED_SET_SCORE_TAG;
+	memcpy(buffer + 1, &score, sizeof(score));
+	return SORTED_SET_SCORE_SIZE;
+}
+
+// Return the score at position, which is stored as SortedSetTypeListPackFormatScore() wrote it.
+// O(1)
+static double SortedSetTypeListPackScore(const uint8_t *position)
+{
+	ListPackEntry entry;
+	ListPackGet(position, &entry);
+	if(entry.string_ == NULL)
+	{
+		return CAST(double)entry.integer_;
+	}
+	assert(entry.length_ == SORTED_SET_SCORE_SIZE && entry.string_[0] == SORTED_SET_SCORE_TAG);
+	double score;
+	memcpy(&score, entry.string_ + 1, sizeof(score));
+	return score;
+}
+
+// Insert the member, which isn't in the listpack, and its score before the first member that
+// is after them, and return the new listpack.
+// O(N)
+static uint8_t *SortedSetTypeListPackInsert(uint8_t *list_pack, const char *member,
+        int64_t length, double score)
+{
+	SDSView view = {member, length}, other;
+	char buffer[SDS_INT64_STRING_SIZE];
+	uint8_t *position = ListPackFirst(list_pack);
+	while(position != NULL)
+	{
+		uint8_t *score_position = ListPackNext(list_pack, position);
+		double other_score = SortedSetTypeListPackScore(score_position);
+		if(other_score > score)
+		{
+			break;
+		}
+		if(other_score == score)
+		{
+			SortedSetTypeListPackMember(position, buffer, &other);
+			if(SDSViewCompare(&other, &view) > 0)
+			{
+				break;
+			}
+		}
+		position = ListPackNext(list_pack, score_position);
+	}
+	char score_string[SDS_INT64_STRING_SIZE];
+	int score_length = SortedSetTypeListPackFormatScore(score_string, score);
+	// A NULL position appends the member.
+	list_pack = ListPackInsert(list_pack, member, length, position, LIST_PACK_BEFORE, &position);
+	return ListPackInsert(list_pack, score_string, score_length, position, LIST_PACK_AFTER, NULL);
+}
+
+// Return the member position of the member in the listpack, or NULL if not found.
+// O(N)
+static uint8_t *SortedSetTypeListPackFind(uint8_t *list_pack, const char *member, int64_t length)
+{
+	return ListPackFind(list_pack, ListPackFirst(list_pack), member, length, 1);
+}
+
+// O(logN) for the skip list encoding, O(N) for the listpack encoding.
+int SortedSetTypeAdd(NosqlObject *zset, const char *member, int64_t length, double score)
+{
+	assert(isnan(score) == 0);
+	if(zset->encoding_ == NOSQL_ENCODING_LIST_PACK && length > g_zset_max_list_pack_value)
+	{
+		SortedSetTypeConvert(zset, NOSQL_ENCODING_SKIP_LIST);
+	}
+	if(zset->encoding_ == NOSQL_ENCODING_LIST_PACK)
+	{
+		uint8_t *list_pack = zset->ptr_;
+		uint8_t *position = SortedSetTypeListPackFind(list_pack, member, length);
+		int added = position == NULL;
+		if(position != NULL)
+		{
+			if(SortedSetTypeListPackScore(ListPackNext(list_pack, position)) == score)
+			{
+				return 0;
+			}
+			// The member may move: delete it and its score, and insert it again.
+			list_pack = ListPackDelete(list_pack, position, &position);
+			list_pack = ListPackDelete(list_pack, position, NULL);
+		}
+		zset->ptr_ = SortedSetTypeListPackInsert(list_pack, member, length, score);
+		if(added && SortedSetTypeLength(zset) > g_zset_max_list_pack_entries)
+		{
+			SortedSetTypeConvert(zset, NOSQL_ENCODING_SKIP_LIST);
+		}
+		return added;
+	}
+	assert(zset->encoding_ == NOSQL_ENCODING_SKIP_LIST);
+	SortedSet *sorted_set = zset->ptr_;
+	SDSView view = {member, length};
+	HashTableNode *node = DictionaryFindView(sorted_set->dictionary_, &view);
+	if(node != NULL)
+	{
+		double *current_score = DictionaryGetElementValue(node);
+		if(*current_score != score)
+		{
+			// The skip list node is a new one if it had to move.
+			SkipListNode *skip_list_node = SkipListUpdateScore(sorted_set->skip_list_, node->key_,
+			                               *current_score, score);
+			DictionaryGetElementValue(node) = &skip_list_node->score_;
+		}
+		return 0;
+	}
+	NosqlObject *object = CreateStringObject(member, length);
+	SkipListNode *skip_list_node = SkipListInsert(sorted_set->skip_list_, object, score);
+	DictionaryAdd(sorted_set->dictionary_, object, &skip_list_node->score_);
+	return 1;
+}
+
+// O(logN) for the skip list encoding, O(N) for the listpack encoding.
+int SortedSetTypeIncrementBy(NosqlObject *zset, const char *member, int64_t length,
+                             double increment, double *new_score)
+{
+	double score = 0;
+	SortedSetTypeScore(zset, member, length, &score);
+	score += increment;
+	if(isnan(score))
+	{
+		return 0;
+	}
+	SortedSetTypeAdd(zset, member, length, score);
+	*new_score = score;
+	return 1;
+}
+
+// O(1) for the skip list encoding, O(N) for the listpack encoding.
+int SortedSetTypeScore(NosqlObject *zset, const char *member, int64_t length, double *score)
+{
+	if(zset->encoding_ == NOSQL_ENCODING_LIST_PACK)
+	{
+		uint8_t *list_pack = zset->ptr_;
+		uint8_t *position = SortedSetTypeListPackFind(list_pack, member, length);
+		if(position == NULL)
+		{
+			return 0;
+		}
+		*score = SortedSetTypeListPackScore(ListPackNext(list_pack, position));
+		return 1;
+	}
+	SortedSet *sorted_set = zset->ptr_;
+	SDSView view = {member, length};
+	const double *member_score = DictionaryGetValueView(sorted_set->dictionary_, &view);
+	if(member_score == NULL)
+	{
+		return 0;
+	}
+	*score = *member_score;
+	return 1;
+}
+
+// The listpack encoding is kept even if the sorted set becomes empty.
+// O(logN) for the skip list encoding, O(N) for the listpack encoding.
+int SortedSetTypeRemove(NosqlObject *zset, const char *member, int64_t length)
+{
+	if(zset->encoding_ == NOSQL_ENCODING_LIST_PACK)
+	{
+		uint8_t *list_pack = zset->ptr_;
+		uint8_t *position = SortedSetTypeListPackFind(list_pack, member, length);
+		if(position == NULL)
+		{
+			return 0;
+		}
+		list_pack = ListPackDelete(list_pack, position, &position); // The member.
+		zset->ptr_ = ListPackDelete(list_pack, position, NULL); // Its score.
+		return 1;
+	}
+	SortedSet *sorted_set = zset->ptr_;
+	SDSView view = {member, length};
+	HashTableNode *node = DictionaryFindView(sorted_set->dictionary_, &view);
+	if(node == NULL)
+	{
+		return 0;
+	}
+	// The skip list node frees the object, so it's deleted from the dictionary first.
+	NosqlObject *object = node->key_;
+	double score = *CAST(double*)DictionaryGetElementValue(node);
+	DictionaryDelete(sorted_set->dictionary_, object);
+	SkipListDelete(sorted_set->skip_list_, object, score, NULL);
+	return 1;
+}
+
+// O(logN) for the skip list encoding, O(N) for the listpack encoding.
+int64_t SortedSetTypeRank(NosqlObject *zset, const char *member, int64_t length)
+{
+	if(zset->encoding_ == NOSQL_ENCODING_LIST_PACK)
+	{
+		uint8_t *list_pack = zset->ptr_;
+		int64_t rank = 0;
+		for(uint8_t *position = ListPackFirst(list_pack); position != NULL;
+		        position = ListPackNext(list_pack, ListPackNext(list_pack, position)), ++rank)
+		{
+			if(ListPackEqual(position, member, length))
+			{
+				return rank;
+			}
+		}
+		return -1;
+	}
+	SortedSet *sorted_set = zset->ptr_;
+	SDSView view = {member, length};
+	HashTableNode *node = DictionaryFindView(sorted_set->dictionary_, &view);
+	if(node == NULL)
+	{
+		return -1;
+	}
+	return SkipListGetRank(sorted_set->skip_list_, node->key_,
+	                       *CAST(double*)DictionaryGetElementValue(node)) - 1;
+}
+
+// O(1)
+int64_t SortedSetTypeLength(const NosqlObject *zset)
+{
+	if(zset->encoding_ == NOSQL_ENCODING_LIST_PACK)
+	{
+		return ListPackLength(zset->ptr_) / 2;
+	}
+	return (CAST(const SortedSet*)zset->ptr_)->skip_list_->length_;
+}
+
+// Convert negative ranks of a sorted set of length members and clamp them, and return
+// whether any member is from rank *start to rank *stop.
+// O(1)
+static int SortedSetTypeClampRanks(int64_t length, int64_t *start, int64_t *stop)
+{
+	*start = *start < 0 ? *start + length : *start;
+	*stop = *stop < 0 ? *stop + length : *stop;
+	*start = *start < 0 ? 0 : *start;
+	*stop = *stop >= length ? length - 1 : *stop;
+	return *start <= *stop;
+}
+
+// Call callback for the members from rank first to rank last, 0 <= first <= last < length,
+// from first on, or from last back if reverse is set.
+// O(logN + M) for the skip list encoding, O(N) for the listpack encoding, M being the number
+// of members in the range.
+static void SortedSetTypeRankRange(NosqlObject *zset, int64_t first, int64_t last, int reverse,
+                                   SortedSetRangeFunction callback, void *argument)
+{
+	if(zset->encoding_ == NOSQL_ENCODING_LIST_PACK)
+	{
+		uint8_t *list_pack = zset->ptr_;
+		uint8_t *position = ListPackSeek(list_pack, 2 * (reverse ? last : first));
+		char buffer[SDS_INT64_STRING_SIZE];
+		SDSView member;
+		for(int64_t rank = first; rank <= last; ++rank)
+		{
+			// Step over a score and a member, the previous pair's or this pair's.
+			if(rank != first && reverse)
+			{
+				position = ListPackPrevious(list_pack, ListPackPrevious(list_pack, position));
+			}
+			else if(rank != first)
+			{
+				position = ListPackNext(list_pack, ListPackNext(list_pack, position));
+			}
+			SortedSetTypeListPackMember(position, buffer, &member);
+			callback(argument, member.data_, member.length_,
+			         SortedSetTypeListPackScore(ListPackNext(list_pack, position)));
+		}
+		return;
+	}
+	SortedSet *sorted_set = zset->ptr_;
+	SkipListNode *node = SkipListGetElementByRank(sorted_set->skip_list_,
+	                     1 + (reverse ? last : first));
+	for(int64_t rank = first; rank <= last; ++rank)
+	{
+		const String member = node->object_->ptr_;
+		callback(argument, member, get_length(member), node->score_);
+		node = reverse ? node->backward_ : node->level_[0].forward_;
+	}
+}
+
+// O(logN + M) for the skip list encoding, O(N) for the listpack encoding, M being the number
+// of members in the range.
+int64_t SortedSetTypeRange(NosqlObject *zset, int64_t start, int64_t stop, int reverse,
+                           SortedSetRangeFunction callback, void *argument)
+{
+	int64_t length = SortedSetTypeLength(zset);
+	if(!SortedSetTypeClampRanks(length, &start, &stop))
+	{
+		return 0;
+	}
+	// Reverse ranks count from the last member: convert them to ranks from the first one.
+	SortedSetTypeRankRange(zset, reverse ? length - 1 - stop : start,
+	                       reverse ? length - 1 - start : stop, reverse, callback, argument);
+	return stop - start + 1;
+}
+
+// Return whether the member is not below the minimum of the lexical range.
+// O(M), M being the length of the member.
+static int SortedSetTypeLexAboveMin(const SDSView *member, const SkipListLexRange *range)
+{
+	if(range->min_ == NULL)
+	{
+		return 1;
+	}
+	char buffer[SDS_INT64_STRING_SIZE];
+	SDSView min = StringObjectView(range->min_, buffer);
+	int result = SDSViewCompare(member, &min);
+	return range->min_exclusive_ ? result > 0 : result >= 0;
+}
+
+// Return whether the member is not above the maximum of the lexical range.
+// O(M), M being the length of the member.
+static int SortedSetTypeLexBelowMax(const SDSView *member, const SkipListLexRange *range)
+{
+	if(range->max_ == NULL)
+	{
+		return 1;
+	}
+	char buffer[SDS_INT64_STRING_SIZE];
+	SDSView max = StringObjectView(range->max_, buffer);
+	int result = SDSViewCompare(member, &max);
+	return range->max_exclusive_ ? result < 0 : result <= 0;
+}
+
+// Store the ranks of the first and the last members of the listpack in the range by score, or
+// by lexical order if range is NULL, in *first and *last, and return whether there are any.
+// The members in a range are contiguous, since the listpack is ordered.
+// O(N)
+static int SortedSetTypeListPackRangeRanks(uint8_t *list_pack, const SkipListRange *range,
+        const SkipListLexRange *lex_range, int64_t *first, int64_t *last)
+{
+	char buffer[SDS_INT64_STRING_SIZE];
+	SDSView member;
+	int64_t rank = 0;
+	*first = -1;
+	*last = -1;
+	for(uint8_t *position = ListPackFirst(list_pack); position != NULL;
+	        position = ListPackNext(list_pack, ListPackNext(list_pack, position)), ++rank)
+	{
+		int above_min, below_max;
+		if(range != NULL)
+		{
+			double score = SortedSetTypeListPackScore(ListPackNext(list_pack, position));
+			above_min = SkipListAboveMin(score, range);
+			below_max = SkipListBelowMax(score, range);
+		}
+		else
+		{
+			SortedSetTypeListPackMember(position, buffer, &member);
+			above_min = SortedSetTypeLexAboveMin(&member, lex_range);
+			below_max = SortedSetTypeLexBelowMax(&member, lex_range);
+		}
+		if(!below_max)
+		{
+			break; // So are all the members after it.
+		}
+		if(above_min)
+		{
+			*first = *first < 0 ? rank : *first;
+			*last = rank;
+		}
+	}
+	return *first >= 0;
+}
+
+// Return whether the node is not beyond the end of the range by score, or by lexical order if
+// range is NULL, at which the iteration stops: the minimum if reverse is set, otherwise the
+// maximum.
+// O(1) by score, O(M) by lexical order, M being the length of the member.
+static int SortedSetTypeNodeBeforeEnd(const SkipListNode *node, const SkipListRange *range,
+                                      const SkipListLexRange *lex_range, int reverse)
+{
+	if(range != NULL)
+	{
+		return reverse ? SkipListAboveMin(node->score_, range) :
+		       SkipListBelowMax(node->score_, range);
+	}
+	return reverse ? SkipListLexAboveMin(node->object_, lex_range) :
+	       SkipListLexBelowMax(node->object_, lex_range);
+}
+
+// The implementation of SortedSetTypeRangeByScore() and SortedSetTypeRangeByLex(), by lexical
+// order if range is NULL.
+// O(logN + M) for the skip list encoding, O(N) for the listpack encoding, M being the number
+// of members passed to callback.
+static int64_t SortedSetTypeGenericRange(NosqlObject *zset, const SkipListRange *range,
+        const SkipListLexRange *lex_range, int reverse, int64_t offset, int64_t count,
+        SortedSetRangeFunction callback, void *argument)
+{
+	if(offset < 0 || count == 0)
+	{
+		return 0;
+	}
+	if(zset->encoding_ == NOSQL_ENCODING_LIST_PACK)
+	{
+		// Cut the ranks of the range to the ones of the offset and the count.
+		int64_t first, last;
+		if(!SortedSetTypeListPackRangeRanks(zset->ptr_, range, lex_range, &first, &last) ||
+		        offset > last - first)
+		{
+			return 0;
+		}
+		if(reverse)
+		{
+			last -= offset;
+			first = count > 0 && last - count + 1 > first ? last - count + 1 : first;
+		}
+		else
+		{
+			first += offset;
+			last = count > 0 && first + count - 1 < last ? first + count - 1 : last;
+		}
+		SortedSetTypeRankRange(zset, first, last, reverse, callback, argument);
+		return last - first + 1;
+	}
+	// 1. Find the first node in the range, or the last one if reverse is set.
+	SkipList *skip_list = (CAST(SortedSet*)zset->ptr_)->skip_list_;
+	SkipListNode *node;
+	if(range != NULL)
+	{
+		node = reverse ? SkipListLastInRange(skip_list, range) :
+		       SkipListFirstInRange(skip_list, range);
+	}
+	else
+	{
+		node = reverse ? SkipListLastInLexRange(skip_list, lex_range) :
+		       SkipListFirstInLexRange(skip_list, lex_range);
+	}
+	// 2. Jump over offset nodes by rank instead of walking them.
+	if(node != NULL && offset > 0)
+	{
+		int64_t rank = SkipListGetRank(skip_list, node->object_, node->score_);
+		node = SkipListGetElementByRank(skip_list, reverse ? rank - offset : rank + offset);
+	}
+	// 3. Walk until the end of the range or count nodes.
+	int64_t number = 0;
+	while(node != NULL && number != count &&
+	        SortedSetTypeNodeBeforeEnd(node, range, lex_range, reverse))
+	{
+		const String member = node->object_->ptr_;
+		callback(argument, member, get_length(member), node->score_);
+		++number;
+		node = reverse ? node->backward_ : node->level_[0].forward_;
+	}
+	return number;
+}
+
+// O(logN + M) for the skip list encoding, O(N) for the listpack encoding, M being the number
+// of members passed to callback.
+int64_t SortedSetTypeRangeByScore(NosqlObject *zset, const SkipListRange *range, int reverse,
+                                  int64_t offset, int64_t count, SortedSetRangeFunction callback,
+                                  void *argument)
+{
+	return SortedSetTypeGenericRange(zset, range, NULL, reverse, offset, count, callback, argument);
+}
+
+// O(logN * L + M) for the skip list encoding, O(N * L) for the listpack encoding, M being the
+// number of members passed to callback and L the length of the members.
+int64_t SortedSetTypeRangeByLex(NosqlObject *zset, const SkipListLexRange *range, int reverse,
+                                int64_t offset, int64_t count, SortedSetRangeFunction callback,
+                                void *argument)
+{
+	return SortedSetTypeGenericRange(zset, NULL, range, reverse, offset, count, callback, argument);
+}
+
+// The SkipListDeleteFunction of SortedSetTypeDeleteRangeBy*(): delete the member of the node
+// from the dictionary, which is the argument, before the node frees it.
+static void SortedSetTypeDeleteMember(void *argument, SkipListNode *node)
+{
+	DictionaryDelete(argument, node->object_);
+}
+
+// O(logN + M) for the skip list encoding, O(N) for the listpack encoding, M being the number
+// of deleted members.
+int64_t SortedSetTypeDeleteRangeByScore(NosqlObject *zset, const SkipListRange *range)
+{
+	if(zset->encoding_ == NOSQL_ENCODING_LIST_PACK)
+	{
+		int64_t first, last;
+		if(!SortedSetTypeListPackRangeRanks(zset->ptr_, range, NULL, &first, &last))
+		{
+			return 0;
+		}
+		zset->ptr_ = ListPackDeleteRange(zset->ptr_, 2 * first, 2 * (last - first + 1));
+		return last - first + 1;
+	}
+	SortedSet *sorted_set = zset->ptr_;
+	return SkipListDeleteRangeByScore(sorted_set->skip_list_, range, SortedSetTypeDeleteMember,
+	                                  sorted_set->dictionary_);
+}
+
+// O(logN + M) for the skip list encoding, O(N) for the listpack encoding, M being the number
+// of deleted members.
+int64_t SortedSetTypeDeleteRangeByRank(NosqlObject *zset, int64_t start, int64_t stop)
+{
+	if(!SortedSetTypeClampRanks(SortedSetTypeLength(zset), &start, &stop))
+	{
+		return 0;
+	}
+	if(zset->encoding_ == NOSQL_ENCODING_LIST_PACK)
+	{
+		zset->ptr_ = ListPackDeleteRange(zset->ptr_, 2 * start, 2 * (stop - start + 1));
+		return stop - start + 1;
+	}
+	SortedSet *sorted_set = zset->ptr_;
+	return SkipListDeleteRangeByRank(sorted_set->skip_list_, start + 1, stop + 1,
+	                                 SortedSetTypeDeleteMember, sorted_set->dictionary_);
+}
+
+// O(NlogN)
+void SortedSetTypeConvert(NosqlObject *zset, int encoding)
+{
+	assert(zset->encoding_ == NOSQL_ENCODING_LIST_PACK && encoding == NOSQL_ENCODING_SKIP_LIST);
+	uint8_t *list_pack = zset->ptr_;
+	SortedSet *sorted_set = Malloc(CAST(int64_t)sizeof(SortedSet));
+	sorted_set->dictionary_ = DictionaryCreate(&sorted_set_dictionary_type, NULL);
+	sorted_set->skip_list_ = SkipListCreate();
+	DictionaryExpand(sorted_set->dictionary_, ListPackLength(list_pack) / 2);
+	char buffer[SDS_INT64_STRING_SIZE];
+	SDSView member;
+	for(uint8_t *position = ListPackFirst(list_pack); position != NULL;
+	        position = ListPackNext(list_pack, position))
+	{
+		SortedSetTypeListPackMember(position, buffer, &member);
+		position = ListPackNext(list_pack, position);
+		NosqlObject *object = CreateStringObject(member.data_, member.length_);
+		SkipListNode *node = SkipListInsert(sorted_set->skip_list_, object,
+		                                    SortedSetTypeListPackScore(position));
+		DictionaryAdd(sorted_set->dictionary_, object, &node->score_);
+	}
+	ListPackFree(list_pack);
+	zset->ptr_ = sorted_set;
+	zset->encoding_ = NOSQL_ENCODING_SKIP_LIST;
+}
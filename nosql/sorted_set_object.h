@@ -0,0 +1,74 @@
+#ifndef NOSQL_SRC_SORTED_SET_OBJECT_H_
+#define NOSQL_SRC_SORTED_SET_OBJECT_H_
+
+#ifndef CAST
+#define CAST(type) (type)
+#endif
+
+#include <stdint.h>
+
+#include <dictionary.h>
+#include <nosql.h>
+#include <skip_list.h>
+
+// Sorted set objects are sets of distinct strings, the members, each with a score, ordered by
+// score, then by member. A small sorted set is a listpack of alternating members and scores
+// in this order; a large one is a SortedSet, see g_zset_max_list_pack_entries.
+
+// The skip list orders the members and the dictionary finds the score of a member in O(1).
+// Both share the member objects, which are owned by the skip list: the keys of the dictionary
+// are the objects of the skip list nodes, and its values point to the score_ of the nodes.
+typedef struct SortedSet
+{
+	Dictionary *dictionary_;
+	SkipList *skip_list_;
+} SortedSet;
+
+// The callback of SortedSetTypeRange*(), called for every member in the range. The member is
+// only valid during the call.
+typedef void (*SortedSetRangeFunction) (void *argument, const char *member, int64_t length,
+                                        double score);
+
+// Set the score of the member, which must not be NaN, and return 1 if the member is new or 0
+// if it was updated.
+int SortedSetTypeAdd(NosqlObject *zset, const char *member, int64_t length, double score);
+// Add increment to the score of the member, or add the member with the score increment, and
+// store the new score in *new_score. Return 1, or 0 if the new score would be NaN, e.g.,
+// inf + -inf, in which case the sorted set doesn't change.
+int SortedSetTypeIncrementBy(NosqlObject *zset, const char *member, int64_t length,
+                             double increment, double *new_score);
+// Store the score of the member in *score and return 1, or return 0 if it isn't in the set.
+int SortedSetTypeScore(NosqlObject *zset, const char *member, int64_t length, double *score);
+// Remove the member and return 1, or return 0 if it isn't in the set.
+int SortedSetTypeRemove(NosqlObject *zset, const char *member, int64_t length);
+// Return the rank of the member, the first one being 0, or -1 if it isn't in the set.
+int64_t SortedSetTypeRank(NosqlObject *zset, const char *member, int64_t length);
+// Return the number of members.
+int64_t SortedSetTypeLength(const NosqlObject *zset);
+// Call callback for the members from rank start to rank stop, both included, in order, and
+// return the number of them. Negative ranks count from the last member, which is -1. If
+// reverse is set, ranks count from the last member, which is 0, and members are passed in
+// reverse order, e.g., 0 to 9 are the top 10 members by score.
+int64_t SortedSetTypeRange(NosqlObject *zset, int64_t start, int64_t stop, int reverse,
+                           SortedSetRangeFunction callback, void *argument);
+// Call callback for the members whose scores are in the range, from the first one on, or
+// from the last one back if reverse is set. Skip the first offset members and stop after
+// count members unless count is negative. Return the number of members passed to callback.
+// Scores may be -inf and inf.
+int64_t SortedSetTypeRangeByScore(NosqlObject *zset, const SkipListRange *range, int reverse,
+                                  int64_t offset, int64_t count, SortedSetRangeFunction callback,
+                                  void *argument);
+// Like SortedSetTypeRangeByScore(), for the members in the lexical range. Only meaningful if
+// all members have the same score.
+int64_t SortedSetTypeRangeByLex(NosqlObject *zset, const SkipListLexRange *range, int reverse,
+                                int64_t offset, int64_t count, SortedSetRangeFunction callback,
+                                void *argument);
+// Delete the members whose scores are in the range and return their number.
+int64_t SortedSetTypeDeleteRangeByScore(NosqlObject *zset, const SkipListRange *range);
+// Delete the members from rank start to rank stop, both included and counted as in
+// SortedSetTypeRange(), and return their number.
+int64_t SortedSetTypeDeleteRangeByRank(NosqlObject *zset, int64_t start, int64_t stop);
+// Convert the listpack encoded sorted set to the encoding, NOSQL_ENCODING_SKIP_LIST.
+void SortedSetTypeConvert(NosqlObject *zset, int encoding);
+
+#endif // NOSQL_SRC_SORTED_SET_OBJECT_H_
@@ -0,0 +1,223 @@
+// A skip list against a B+ tree of 10M members with random scores, like a large leaderboard:
+// insert, score update, rank, element by rank, first/last in a score range and a range of 10
+// members throughput, and the memory of the structure without its objects. Both structures
+// share the same objects. Inserts run once, and the best of 3 runs of the queries is reported.
+#include <stdio.h> // printf()
+#include <stdint.h>
+#include <stdlib.h> // rand()
+#include <time.h> // clock()
+
+#include <b_plus_tree.h>
+#include <memory.h>
+#include <nosql.h>
+#include <simple_dynamic_string.h>
+#include <skip_list.h>
+
+#define MEMBER_NUMBER 10000000
+#define QUERY_NUMBER 1000000
+#define RANGE_LENGTH 10
+#define BENCHMARK_RUNS 3
+
+volatile int64_t sink = 0;
+
+NosqlObject *g_members[MEMBER_NUMBER];
+double g_scores[MEMBER_NUMBER];
+
+// The throughput of every operation, in the order they are printed.
+#define INSERT 0
+#define UPDATE 1
+#define RANK 2
+#define ELEMENT 3
+#define FIRST_LAST 4
+#define RANGE 5
+#define OPERATION_NUMBER 6
+
+const char *g_operations[OPERATION_NUMBER] =
+{
+	"insert", "update score", "get rank", "get element by rank", "first/last in range",
+	"range of 10"
+};
+
+double Seconds(clock_t start)
+{
+	return CAST(double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+// Return a random score with a few ties, like points.
+double RandomScore()
+{
+	return rand() % (MEMBER_NUMBER * 4);
+}
+
+// Keep the time if it's the best one of the operation.
+void KeepBest(double *best, int operation, clock_t start)
+{
+	double seconds = Seconds(start);
+	best[operation] = seconds < best[operation] ? seconds : best[operation];
+}
+
+void PrintResults(const char *structure, const double *best, int64_t memory)
+{
+	for(int operation = 0; operation < OPERATION_NUMBER; ++operation)
+	{
+		int64_t number = operation == INSERT ? MEMBER_NUMBER : QUERY_NUMBER;
+		printf("%-10s of %d members %-19s %6.2f Mops/s\n", structure, MEMBER_NUMBER,
+		       g_operations[operation], CAST(double)number / best[operation] / 1e6);
+	}
+	printf("%-10s of %d members %-19s %6.1f bytes/member\n", structure, MEMBER_NUMBER, "memory",
+	       CAST(double)memory / MEMBER_NUMBER);
+}
+
+void BenchmarkSkipList()
+{
+	double best[OPERATION_NUMBER] = {1e9, 1e9, 1e9, 1e9, 1e9, 1e9};
+	int64_t memory = UsedMemory();
+	SkipList *skip_list = SkipListCreate();
+	srand(1);
+	clock_t start = clock();
+	for(int index = 0; index < MEMBER_NUMBER; ++index)
+	{
+		// The skip list takes over a reference, and the benchmark keeps its own.
+		IncreaseReferenceCount(g_members[index]);
+		g_scores[index] = RandomScore();
+		SkipListInsert(skip_list, g_members[index], g_scores[index]);
+	}
+	KeepBest(best, INSERT, start);
+	memory = UsedMemory() - memory;
+	for(int run = 0; run < BENCHMARK_RUNS; ++run)
+	{
+		srand(CAST(unsigned)run + 2);
+		// Small increments mostly keep the order, which is updated in place.
+		start = clock();
+		for(int query = 0; query < QUERY_NUMBER; ++query)
+		{
+			int index = rand() % MEMBER_NUMBER;
+			double new_score = g_scores[index] + (query % 2 ? 1 : RandomScore() - g_scores[index]);
+			SkipListUpdateScore(skip_list, g_members[index], g_scores[index], new_score);
+			g_scores[index] = new_score;
+		}
+		KeepBest(best, UPDATE, start);
+		start = clock();
+		for(int query = 0; query < QUERY_NUMBER; ++query)
+		{
+			int index = rand() % MEMBER_NUMBER;
+			sink += SkipListGetRank(skip_list, g_members[index], g_scores[index]);
+		}
+		KeepBest(best, RANK, start);
+		start = clock();
+		for(int query = 0; query < QUERY_NUMBER; ++query)
+		{
+			sink += SkipListGetElementByRank(skip_list, 1 + rand() % MEMBER_NUMBER)->object_->type_;
+		}
+		KeepBest(best, ELEMENT, start);
+		start = clock();
+		for(int query = 0; query < QUERY_NUMBER; ++query)
+		{
+			double min = RandomScore();
+			SkipListRange range = {min, min + 100, 0, 1};
+			SkipListNode *first = SkipListFirstInRange(skip_list, &range);
+			SkipListNode *last = SkipListLastInRange(skip_list, &range);
+			sink += (first != NULL) + (last != NULL);
+		}
+		KeepBest(best, FIRST_LAST, start);
+		start = clock();
+		for(int query = 0; query < QUERY_NUMBER; ++query)
+		{
+			SkipListNode *node = SkipListGetElementByRank(skip_list, 1 + rand() % MEMBER_NUMBER);
+			for(int number = 0; number < RANGE_LENGTH && node != NULL; ++number)
+			{
+				sink += CAST(int64_t)node->score_;
+				node = node->level_[0].forward_;
+			}
+		}
+		KeepBest(best, RANGE, start);
+	}
+	SkipListFree(skip_list);
+	PrintResults("skip list", best, memory);
+}
+
+void BenchmarkBPlusTree()
+{
+	double best[OPERATION_NUMBER] = {1e9, 1e9, 1e9, 1e9, 1e9, 1e9};
+	int64_t memory = UsedMemory();
+	BPlusTree *tree = BPlusTreeCreate();
+	srand(1);
+	clock_t start = clock();
+	for(int index = 0; index < MEMBER_NUMBER; ++index)
+	{
+		IncreaseReferenceCount(g_members[index]);
+		g_scores[index] = RandomScore();
+		BPlusTreeInsert(tree, g_members[index], g_scores[index]);
+	}
+	KeepBest(best, INSERT, start);
+	// The separators hold references, not copies, of the objects.
+	memory = UsedMemory() - memory;
+	for(int run = 0; run < BENCHMARK_RUNS; ++run)
+	{
+		srand(CAST(unsigned)run + 2);
+		start = clock();
+		for(int query = 0; query < QUERY_NUMBER; ++query)
+		{
+			int index = rand() % MEMBER_NUMBER;
+			double new_score = g_scores[index] + (query % 2 ? 1 : RandomScore() - g_scores[index]);
+			BPlusTreeUpdateScore(tree, g_members[index], g_scores[index], new_score);
+			g_scores[index] = new_score;
+		}
+		KeepBest(best, UPDATE, start);
+		start = clock();
+		for(int query = 0; query < QUERY_NUMBER; ++query)
+		{
+			int index = rand() % MEMBER_NUMBER;
+			sink += BPlusTreeGetRank(tree, g_members[index], g_scores[index]);
+		}
+		KeepBest(best, RANK, start);
+		start = clock();
+		for(int query = 0; query < QUERY_NUMBER; ++query)
+		{
+			BPlusTreeIterator element = BPlusTreeGetElementByRank(tree, 1 + rand() % MEMBER_NUMBER);
+			sink += element.leaf_->object_[element.index_]->type_;
+		}
+		KeepBest(best, ELEMENT, start);
+		start = clock();
+		for(int query = 0; query < QUERY_NUMBER; ++query)
+		{
+			double min = RandomScore();
+			SkipListRange range = {min, min + 100, 0, 1};
+			BPlusTreeIterator first = BPlusTreeFirstInRange(tree, &range);
+			BPlusTreeIterator last = BPlusTreeLastInRange(tree, &range);
+			sink += (first.leaf_ != NULL) + (last.leaf_ != NULL);
+		}
+		KeepBest(best, FIRST_LAST, start);
+		start = clock();
+		for(int query = 0; query < QUERY_NUMBER; ++query)
+		{
+			BPlusTreeIterator element = BPlusTreeGetElementByRank(tree, 1 + rand() % MEMBER_NUMBER);
+			int valid = 1;
+			for(int number = 0; number < RANGE_LENGTH && valid; ++number)
+			{
+				sink += CAST(int64_t)element.leaf_->score_[element.index_];
+				valid = BPlusTreeNext(&element);
+			}
+		}
+		KeepBest(best, RANGE, start);
+	}
+	BPlusTreeFree(tree);
+	PrintResults("B+ tree", best, memory);
+}
+
+int main(void)
+{
+	char buffer[SDS_INT64_STRING_SIZE + 5] = "user:";
+	for(int index = 0; index < MEMBER_NUMBER; ++index)
+	{
+		int length = CAST(int)SDSFormatInt64(buffer + 5, index) + 5;
+		g_members[index] = CreateStringObject(buffer, length);
+	}
+	BenchmarkSkipList();
+	BenchmarkBPlusTree();
+	for(int index = 0; index < MEMBER_NUMBER; ++index)
+	{
+		DecreaseReferenceCount(g_members[index]);
+	}
+	return 0;
+}
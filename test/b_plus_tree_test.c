@@ -0,0 +1,431 @@
+#include <stdio.h> // printf(), snprintf()
+#include <stdlib.h> // rand()
+#include <assert.h>
+
+#include <b_plus_tree.h>
+#include <memory.h>
+#include <nosql.h>
+#include <simple_dynamic_string.h>
+#include <skip_list.h>
+
+// Enough elements for 3 levels.
+#define MAX_NUMBER 3000
+
+#include "sorted_model.h" // The model of the tree: its elements in order.
+
+// Return whether the iterator is the element of the model at index, or none if index is -1.
+int IsElement(BPlusTreeIterator iterator, int index)
+{
+	if(index < 0)
+	{
+		return iterator.leaf_ == NULL;
+	}
+	return iterator.leaf_ != NULL &&
+	       iterator.leaf_->object_[iterator.index_] == g_elements[index].object_ &&
+	       iterator.leaf_->score_[iterator.index_] == g_elements[index].score_;
+}
+
+// Check the node at depth, whose elements are after the separator (*score, *object) and
+// before the separator (*next_score, *next_object) where they aren't NULL, and return the
+// number of its elements.
+int64_t CheckNode(BPlusTree *tree, BPlusTreeNode *node, int depth, const double *score,
+                  NosqlObject *const *object, const double *next_score,
+                  NosqlObject *const *next_object)
+{
+	if(node != tree->root_)
+	{
+		assert(node->count_ >= (node->leaf_ ? B_PLUS_TREE_LEAF_MIN : B_PLUS_TREE_INNER_MIN));
+	}
+	if(node->leaf_)
+	{
+		BPlusTreeLeaf *leaf = CAST(BPlusTreeLeaf *)node;
+		assert(depth == tree->height_ && node->count_ <= B_PLUS_TREE_LEAF_CAPACITY);
+		for(int index = 0; index < node->count_; ++index)
+		{
+			assert(score == NULL ||
+			       CompareElement(*score, *object, leaf->score_[index], leaf->object_[index]) <= 0);
+			assert(next_score == NULL || CompareElement(leaf->score_[index], leaf->object_[index],
+			        *next_score, *next_object) < 0);
+		}
+		return node->count_;
+	}
+	BPlusTreeInner *inner = CAST(BPlusTreeInner *)node;
+	assert(node->count_ >= 2 && node->count_ <= B_PLUS_TREE_INNER_CAPACITY);
+	int64_t size = 0;
+	for(int child = 0; child < node->count_; ++child)
+	{
+		// The separators around the child bound its elements, and are the node's bounds at both
+		// ends.
+		const double *child_score = child == 0 ? score : &inner->score_[child - 1];
+		NosqlObject *const *child_object = child == 0 ? object : &inner->object_[child - 1];
+		int last = child == node->count_ - 1;
+		const double *child_next_score = last ? next_score : &inner->score_[child];
+		NosqlObject *const *child_next_object = last ? next_object : &inner->object_[child];
+		assert(last || inner->object_[child]->reference_count_ >= 1);
+		assert(CheckNode(tree, inner->child_[child], depth + 1, child_score, child_object,
+		                 child_next_score, child_next_object) == inner->size_[child]);
+		size += inner->size_[child];
+	}
+	return size;
+}
+
+// Check the structure, the links, the ranks and the iterators against the model.
+void Check(BPlusTree *tree)
+{
+	assert(tree->length_ == g_element_number);
+	assert(CheckNode(tree, tree->root_, 1, NULL, NULL, NULL, NULL) == g_element_number);
+	BPlusTreeIterator iterator = {tree->first_, 0}, previous = {NULL, 0};
+	int valid = g_element_number > 0;
+	for(int index = 0; index < g_element_number; ++index)
+	{
+		assert(valid && IsElement(iterator, index));
+		assert(BPlusTreeGetRank(tree, g_elements[index].object_, g_elements[index].score_) ==
+		       index + 1);
+		BPlusTreeIterator element = BPlusTreeGetElementByRank(tree, index + 1);
+		assert(element.leaf_ == iterator.leaf_ && element.index_ == iterator.index_);
+		// Going back from the element reaches the previous one.
+		assert(BPlusTreePrevious(&element) == (index > 0));
+		assert(index == 0 || (element.leaf_ == previous.leaf_ && element.index_ == previous.index_));
+		previous = iterator;
+		valid = BPlusTreeNext(&iterator);
+	}
+	assert(!valid || g_element_number == 0);
+	assert(g_element_number == 0 || IsElement(previous, g_element_number - 1));
+	assert(tree->last_->next_ == NULL && tree->first_->previous_ == NULL);
+	assert(g_element_number == 0 || previous.leaf_ == tree->last_);
+	assert(IsElement(BPlusTreeGetElementByRank(tree, 0), -1));
+	assert(IsElement(BPlusTreeGetElementByRank(tree, g_element_number + 1), -1));
+}
+
+// Check the first and last elements in random score ranges against the model.
+void CheckRanges(BPlusTree *tree)
+{
+	for(int round = 0; round < 100; ++round)
+	{
+		SkipListRange range = {rand() % 24 - 2, rand() % 24 - 2, rand() % 2, rand() % 2};
+		int first = -1, last = -1;
+		for(int index = 0; index < g_element_number; ++index)
+		{
+			double score = g_elements[index].score_;
+			if(SkipListAboveMin(score, &range) && SkipListBelowMax(score, &range))
+			{
+				first = first < 0 ? index : first;
+				last = index;
+			}
+		}
+		assert(first < 0 || BPlusTreeIsInRange(tree, &range));
+		assert(IsElement(BPlusTreeFirstInRange(tree, &range), first));
+		assert(IsElement(BPlusTreeLastInRange(tree, &range), last));
+	}
+}
+
+// Insert, delete and update random elements with few distinct scores, so that many of them
+// are ordered by their objects and separators often have equal scores.
+void TestRandomOperations()
+{
+	BPlusTree *tree = BPlusTreeCreate();
+	Check(tree);
+	int max_height = 1;
+	for(int round = 0; round < 40000; ++round)
+	{
+		// Grow most of the time in the first half and shrink in the second half, so that the
+		// tree splits and merges on all levels.
+		int operation = rand() % 4;
+		operation = operation == 3 ? (round < 20000 ? 0 : 1) : operation;
+		if(operation == 0 && g_element_number < MAX_NUMBER)
+		{
+			NosqlObject *object = RandomObject();
+			double score = rand() % 20;
+			int index = LowerBound(object, score);
+			if(index < g_element_number && CompareElement(g_elements[index].score_,
+			        g_elements[index].object_, score, object) == 0)
+			{
+				DecreaseReferenceCount(object); // Already in the tree.
+				continue;
+			}
+			IncreaseReferenceCount(object); // The model keeps a reference.
+			BPlusTreeInsert(tree, object, score);
+			for(int move = g_element_number; move > index; --move)
+			{
+				g_elements[move] = g_elements[move - 1];
+			}
+			g_elements[index].score_ = score;
+			g_elements[index].object_ = object;
+			++g_element_number;
+		}
+		else if(operation == 1 && g_element_number > 0)
+		{
+			int index = rand() % g_element_number;
+			NosqlObject *object = g_elements[index].object_;
+			assert(BPlusTreeDelete(tree, object, g_elements[index].score_ + 0.125) == 0);
+			assert(BPlusTreeDelete(tree, object, g_elements[index].score_) == 1);
+			assert(BPlusTreeGetRank(tree, object, g_elements[index].score_) == 0);
+			DecreaseReferenceCount(object);
+			for(int move = index; move < g_element_number - 1; ++move)
+			{
+				g_elements[move] = g_elements[move + 1];
+			}
+			--g_element_number;
+		}
+		else if(operation == 2 && g_element_number > 0)
+		{
+			// Small changes mostly keep the order, which is updated in place. All scores are multiples
+			// of 0.25, so the delete of score + 0.125 above always misses.
+			int index = rand() % g_element_number;
+			Element element = g_elements[index];
+			double new_score = element.score_ + (rand() % 2 ? (rand() % 5 - 2) * 0.25 :
+			                                     rand() % 20 - element.score_);
+			for(int move = index; move < g_element_number - 1; ++move)
+			{
+				g_elements[move] = g_elements[move + 1];
+			}
+			--g_element_number;
+			int new_index = LowerBound(element.object_, new_score);
+			if(new_index < g_element_number && CompareElement(g_elements[new_index].score_,
+			        g_elements[new_index].object_, new_score, element.object_) == 0)
+			{
+				// The object would be in the tree twice: restore the model.
+				new_score = element.score_;
+				new_index = index;
+			}
+			BPlusTreeUpdateScore(tree, element.object_, element.score_, new_score);
+			for(int move = g_element_number; move > new_index; --move)
+			{
+				g_elements[move] = g_elements[move - 1];
+			}
+			g_elements[new_index].score_ = new_score;
+			g_elements[new_index].object_ = element.object_;
+			++g_element_number;
+			assert(BPlusTreeGetRank(tree, element.object_, new_score) == new_index + 1);
+		}
+		max_height = tree->height_ > max_height ? tree->height_ : max_height;
+		if(round % 1000 == 0)
+		{
+			Check(tree);
+			CheckRanges(tree);
+		}
+	}
+	Check(tree);
+	CheckRanges(tree);
+	assert(max_height >= 3);
+	BPlusTreeFree(tree);
+	for(int index = 0; index < g_element_number; ++index)
+	{
+		assert(g_elements[index].object_->reference_count_ == 1);
+		DecreaseReferenceCount(g_elements[index].object_);
+	}
+	g_element_number = 0;
+}
+
+// The callback of the range deletes: check that the deleted element is the next one of the
+// model.
+void DeleteCallback(void *argument, NosqlObject *object, double score)
+{
+	int *index = argument;
+	assert(object == g_elements[*index].object_ && score == g_elements[*index].score_);
+	++*index;
+}
+
+// Remove count elements from index of the model.
+void RemoveElements(int index, int count)
+{
+	for(int move = index; move + count < g_element_number; ++move)
+	{
+		g_elements[move] = g_elements[move + count];
+	}
+	g_element_number -= count;
+}
+
+// Delete random ranges by score and by rank, some of them over many leaves, until the tree
+// is empty.
+void TestDeleteRanges()
+{
+	BPlusTree *tree = BPlusTreeCreate();
+	for(int index = 0; index < MAX_NUMBER; ++index)
+	{
+		// Unique objects with few distinct scores, inserted in order into the model.
+		char buffer[32];
+		int length = snprintf(buffer, sizeof(buffer), "%04d", index);
+		g_elements[index].score_ = index / 10;
+		g_elements[index].object_ = CreateStringObject(buffer, length);
+		BPlusTreeInsert(tree, g_elements[index].object_, g_elements[index].score_);
+	}
+	g_element_number = MAX_NUMBER;
+	while(g_element_number > 0)
+	{
+		int first = g_element_number, last = -1, deleted = 0;
+		if(rand() % 2)
+		{
+			SkipListRange range = {rand() % 330 - 15, 0, rand() % 2, rand() % 2};
+			range.max_ = range.min_ + rand() % 30;
+			if(rand() % 16 == 0)
+			{
+				range.max_ = 1.0 / 0.0; // inf
+			}
+			for(int index = 0; index < g_element_number; ++index)
+			{
+				if(SkipListAboveMin(g_elements[index].score_, &range) &&
+				        SkipListBelowMax(g_elements[index].score_, &range))
+				{
+					first = first < index ? first : index;
+					last = index;
+				}
+			}
+			deleted = first;
+			assert(BPlusTreeDeleteRangeByScore(tree, &range, DeleteCallback, &deleted) ==
+			       (last < 0 ? 0 : last - first + 1));
+		}
+		else
+		{
+			// Ranks start at 1 and the end may be past the last element.
+			int start = 1 + rand() % g_element_number, end = start + rand() % 150;
+			first = start - 1;
+			last = end > g_element_number ? g_element_number - 1 : end - 1;
+			deleted = first;
+			assert(BPlusTreeDeleteRangeByRank(tree, start, end, DeleteCallback, &deleted) ==
+			       last - first + 1);
+		}
+		if(last >= 0)
+		{
+			assert(deleted == last + 1);
+			RemoveElements(first, last - first + 1);
+		}
+		Check(tree);
+	}
+	assert(tree->height_ == 1);
+	assert(BPlusTreeDeleteRangeByRank(tree, 1, 10, NULL, NULL) == 0);
+	BPlusTreeFree(tree);
+}
+
+// Lexical ranges of the objects "a" to "z", which all have the score 0, with many more
+// elements after them so that they span a few leaves.
+void TestLexRanges()
+{
+	BPlusTree *tree = BPlusTreeCreate();
+	NosqlObject *objects[26];
+	for(int index = 0; index < 26; ++index)
+	{
+		char letter = CAST(char)('a' + index);
+		objects[index] = CreateStringObject(&letter, 1);
+		IncreaseReferenceCount(objects[index]);
+		BPlusTreeInsert(tree, objects[index], 0);
+	}
+	for(int index = 0; index < 100; ++index)
+	{
+		// "{" is after "z".
+		char buffer[32];
+		int length = snprintf(buffer, sizeof(buffer), "{%03d", index);
+		BPlusTreeInsert(tree, CreateStringObject(buffer, length), 0);
+	}
+	for(int round = 0; round < 1000; ++round)
+	{
+		// min and max from -1 for unbounded to 26, which is past "z".
+		int min = rand() % 28 - 1, max = rand() % 28 - 1;
+		int min_exclusive = rand() % 2, max_exclusive = rand() % 2;
+		NosqlObject *min_object = min < 0 ? NULL : min < 26 ? objects[min] :
+		                          CreateStringObject("zz", 2);
+		NosqlObject *max_object = max < 0 ? NULL : max < 26 ? objects[max] :
+		                          CreateStringObject("zz", 2);
+		SkipListLexRange range = {min_object, max_object, min_exclusive, max_exclusive};
+		int first = min < 0 ? 0 : min + min_exclusive;
+		int last = max < 0 ? 125 : (max > 25 ? 25 : max - max_exclusive);
+		int empty = first > 25 || last < 0 || first > last;
+		assert(empty || BPlusTreeIsInLexRange(tree, &range));
+		BPlusTreeIterator first_element = BPlusTreeFirstInLexRange(tree, &range);
+		BPlusTreeIterator last_element = BPlusTreeLastInLexRange(tree, &range);
+		assert(empty ? first_element.leaf_ == NULL :
+		       first_element.leaf_->object_[first_element.index_] == objects[first]);
+		assert(empty ? last_element.leaf_ == NULL : (last == 125 ?
+		        last_element.leaf_ == tree->last_ : last_element.leaf_->object_[last_element.index_] ==
+		        objects[last]));
+		for(int index = 0; index < 2; ++index)
+		{
+			NosqlObject *object = index == 0 ? min_object : max_object;
+			if(object != NULL && object->reference_count_ == 1)
+			{
+				DecreaseReferenceCount(object);
+			}
+		}
+	}
+	BPlusTreeFree(tree);
+	for(int index = 0; index < 26; ++index)
+	{
+		assert(objects[index]->reference_count_ == 1);
+		DecreaseReferenceCount(objects[index]);
+	}
+}
+
+// Check that the tree has the elements of the skip list in the same order.
+void CheckAgainst(BPlusTree *tree, SkipList *skip_list)
+{
+	assert(CheckNode(tree, tree->root_, 1, NULL, NULL, NULL, NULL) == skip_list->length_);
+	assert(tree->length_ == skip_list->length_);
+	BPlusTreeIterator iterator = {tree->first_, 0};
+	for(SkipListNode *node = skip_list->head_->level_[0].forward_; node != NULL;
+	        node = node->level_[0].forward_)
+	{
+		assert(iterator.leaf_->object_[iterator.index_] == node->object_);
+		assert(iterator.leaf_->score_[iterator.index_] == node->score_);
+		BPlusTreeNext(&iterator);
+	}
+	assert(iterator.leaf_ == NULL || tree->length_ == 0);
+}
+
+// Insert many random elements into both the tree and a skip list, and delete long random
+// ranges from both, so that inner nodes on several levels move children between them and
+// merge. The skip list is the model.
+void TestLargeTree()
+{
+	BPlusTree *tree = BPlusTreeCreate();
+	SkipList *skip_list = SkipListCreate();
+	int next_object = 0;
+	for(int round = 0; round < 300; ++round)
+	{
+		int number = round == 0 ? 100000 : rand() % 4000;
+		for(int index = 0; index < number; ++index)
+		{
+			char buffer[32];
+			int length = snprintf(buffer, sizeof(buffer), "%d", next_object++);
+			NosqlObject *object = CreateStringObject(buffer, length);
+			double score = rand() % 1000;
+			IncreaseReferenceCount(object);
+			BPlusTreeInsert(tree, object, score);
+			SkipListInsert(skip_list, object, score);
+		}
+		if(rand() % 2)
+		{
+			int64_t start = 1 + rand() % (skip_list->length_ + 1), end = start + rand() % 5000;
+			assert(BPlusTreeDeleteRangeByRank(tree, start, end, NULL, NULL) ==
+			       SkipListDeleteRangeByRank(skip_list, start, end, NULL, NULL));
+		}
+		else
+		{
+			SkipListRange range = {rand() % 1000, 0, rand() % 2, rand() % 2};
+			range.max_ = range.min_ + rand() % 40;
+			assert(BPlusTreeDeleteRangeByScore(tree, &range, NULL, NULL) ==
+			       SkipListDeleteRangeByScore(skip_list, &range, NULL, NULL));
+		}
+		if(round % 10 == 0)
+		{
+			CheckAgainst(tree, skip_list);
+		}
+	}
+	CheckAgainst(tree, skip_list);
+	assert(SkipListDeleteRangeByRank(skip_list, 1, skip_list->length_, NULL, NULL) ==
+	       BPlusTreeDeleteRangeByRank(tree, 1, tree->length_, NULL, NULL));
+	CheckAgainst(tree, skip_list);
+	SkipListFree(skip_list);
+	BPlusTreeFree(tree);
+}
+
+int main(void)
+{
+	TestRandomOperations();
+	TestLexRanges();
+	TestDeleteRanges();
+	TestLargeTree();
+	assert(UsedMemory() == 0);
+
+	printf("All passed! Come on!\n");
+	return 0;
+}
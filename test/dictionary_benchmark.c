@@ -0,0 +1,111 @@
+// Insert and lookup throughput and memory per key of the chained and the open addressing
+// hash table layouts. Keys are integers stored in the key pointer itself, so the used
+// memory is only the dictionary's own memory.
+#include <dictionary.h>
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h> // malloc(), free()
+#include <time.h> // clock()
+
+#include <memory.h>
+
+#define KEY(number) (CAST(void*)CAST(intptr_t)(number))
+
+uint64_t HashInteger(const void *key)
+{
+	// Finalizer of MurmurHash3, so that the slots are visited in random order.
+	uint64_t hash = CAST(uint64_t)CAST(intptr_t)key;
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdULL;
+	hash ^= hash >> 33;
+	hash *= 0xc4ceb9fe1a85ec53ULL;
+	hash ^= hash >> 33;
+	return hash;
+}
+
+// Fill keys with a random permutation of [0, key_number), seed must not be 0.
+void Shuffle(int *keys, int key_number, uint64_t seed)
+{
+	uint64_t state = seed; // xorshift64
+	for(int index = 0; index < key_number; ++index)
+	{
+		keys[index] = index;
+	}
+	for(int index = key_number - 1; index > 0; --index)
+	{
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		int other = CAST(int)(state % CAST(uint64_t)(index + 1));
+		int key = keys[index];
+		keys[index] = keys[other];
+		keys[other] = key;
+	}
+}
+
+double Seconds(clock_t start)
+{
+	return CAST(double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+void Benchmark(const char *name, int layout, int *keys, int *order, int key_number)
+{
+	HashTableType type = {HashInteger, NULL, NULL, NULL, NULL, NULL, layout, 0, NULL, NULL};
+	int64_t base = UsedMemory();
+	Dictionary *d = DictionaryCreate(&type, NULL);
+
+	clock_t start = clock();
+	for(int index = 0; index < key_number; ++index)
+	{
+		DictionaryAdd(d, KEY(keys[index]), NULL);
+	}
+	double insert_seconds = Seconds(start);
+	while(DictionaryRehash(d, 100)) // Finish rehashing to measure the steady state.
+	{
+	}
+	int64_t used_memory = UsedMemory() - base;
+
+	// Look up in an order unrelated to the insert order, otherwise the chained nodes,
+	// which are allocated in insert order, would be visited sequentially.
+	start = clock();
+	int found = 0;
+	for(int index = 0; index < key_number; ++index)
+	{
+		found += DictionaryFind(d, KEY(keys[order[index]])) != NULL;
+	}
+	double hit_seconds = Seconds(start);
+
+	start = clock();
+	for(int index = 0; index < key_number; ++index)
+	{
+		found += DictionaryFind(d, KEY(key_number + index)) != NULL;
+	}
+	double miss_seconds = Seconds(start);
+
+	printf("%-16s %9d keys: insert %6.2f Mops/s, hit %6.2f Mops/s, miss %6.2f Mops/s, "
+	       "%5.1f bytes/key%s\n", name, key_number,
+	       key_number / insert_seconds / 1e6, key_number / hit_seconds / 1e6,
+	       key_number / miss_seconds / 1e6, CAST(double)used_memory / key_number,
+	       found == key_number ? "" : " (WRONG)");
+	DictionaryRelease(d);
+}
+
+int main(void)
+{
+	int key_numbers[] = {1000000, 10000000};
+	for(int index = 0; index < 2; ++index)
+	{
+		// The keys are allocated by libc so that they're not counted in UsedMemory().
+		int *keys = malloc(CAST(size_t)key_numbers[index] * sizeof(int));
+		int *order = malloc(CAST(size_t)key_numbers[index] * sizeof(int));
+		Shuffle(keys, key_numbers[index], 88172645463325252ULL);
+		Shuffle(order, key_numbers[index], 2463534242ULL);
+		Benchmark("chained", DICTIONARY_LAYOUT_CHAINED, keys, order, key_numbers[index]);
+		Benchmark("open addressing", DICTIONARY_LAYOUT_OPEN_ADDRESSING,
+		          keys, order, key_numbers[index]);
+		free(keys);
+		free(order);
+	}
+	return 0;
+}
@@ -0,0 +1,99 @@
+// DictionaryFind() one by one against DictionaryFindBatch() for MGET-like batches of
+// random keys, in tables that are smaller and much larger than the last level cache.
+#include <dictionary.h>
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h> // malloc(), free()
+#include <time.h> // clock()
+
+#include <memory.h>
+
+#define KEY(number) (CAST(void*)CAST(intptr_t)(number))
+#define BATCH_SIZE 100
+#define LOOKUP_NUMBER 10000000
+#define ROUND_NUMBER 5
+
+uint64_t HashInteger(const void *key)
+{
+	// Finalizer of MurmurHash3, so that the slots are visited in random order.
+	uint64_t hash = CAST(uint64_t)CAST(intptr_t)key;
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdULL;
+	hash ^= hash >> 33;
+	hash *= 0xc4ceb9fe1a85ec53ULL;
+	hash ^= hash >> 33;
+	return hash;
+}
+
+double Seconds(clock_t start)
+{
+	return CAST(double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+void Benchmark(int layout, int key_number)
+{
+	HashTableType type = {HashInteger, NULL, NULL, NULL, NULL, NULL, layout, 0, NULL, NULL};
+	Dictionary *d = DictionaryCreate(&type, NULL);
+	for(int index = 0; index < key_number; ++index)
+	{
+		DictionaryAdd(d, KEY(index), NULL);
+	}
+	while(DictionaryRehash(d, 100))
+	{
+	}
+	// Random keys, 1 of 8 is missing.
+	const void **keys = malloc(LOOKUP_NUMBER * sizeof(void*));
+	uint64_t state = 88172645463325252ULL; // xorshift64
+	for(int index = 0; index < LOOKUP_NUMBER; ++index)
+	{
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		keys[index] = KEY(state % (CAST(uint64_t)key_number / 7 * 8));
+	}
+	HashTableNode *nodes[BATCH_SIZE];
+
+	// The machine may be shared, so take the best of several alternating rounds.
+	double single_seconds = 1e9, batch_seconds = 1e9;
+	int64_t found = 0, batch_found = 0;
+	for(int round = 0; round < ROUND_NUMBER; ++round)
+	{
+		clock_t start = clock();
+		found = 0;
+		for(int index = 0; index < LOOKUP_NUMBER; ++index)
+		{
+			found += DictionaryFind(d, keys[index]) != NULL;
+		}
+		double seconds = Seconds(start);
+		single_seconds = seconds < single_seconds ? seconds : single_seconds;
+
+		start = clock();
+		batch_found = 0;
+		for(int index = 0; index < LOOKUP_NUMBER; index += BATCH_SIZE)
+		{
+			batch_found += DictionaryFindBatch(d, keys + index, BATCH_SIZE, nodes);
+		}
+		seconds = Seconds(start);
+		batch_seconds = seconds < batch_seconds ? seconds : batch_seconds;
+	}
+
+	printf("%-15s %9d keys: DictionaryFind %6.2f Mops/s, DictionaryFindBatch(%d) %6.2f Mops/s, "
+	       "speedup %.2fx%s\n", layout == DICTIONARY_LAYOUT_CHAINED ? "chained" : "open addressing",
+	       key_number, LOOKUP_NUMBER / single_seconds / 1e6, BATCH_SIZE,
+	       LOOKUP_NUMBER / batch_seconds / 1e6, single_seconds / batch_seconds,
+	       found == batch_found ? "" : " (WRONG)");
+	free(keys);
+	DictionaryRelease(d);
+}
+
+int main(void)
+{
+	int key_numbers[] = {100000, 1000000, 10000000};
+	for(int index = 0; index < 3; ++index)
+	{
+		Benchmark(DICTIONARY_LAYOUT_CHAINED, key_numbers[index]);
+		Benchmark(DICTIONARY_LAYOUT_OPEN_ADDRESSING, key_numbers[index]);
+	}
+	return 0;
+}
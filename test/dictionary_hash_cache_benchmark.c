@@ -0,0 +1,117 @@
+// The trade-off of HashTableType.cache_hash_ for SDS keys hashed by SipHash: insert,
+// rehash and lookup throughput against the memory per key of the dictionary itself
+// (the keys are allocated before measuring).
+#include <dictionary.h>
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h> // memcmp()
+#include <time.h> // clock()
+
+#include <hash_function.h>
+#include <memory.h>
+#include <simple_dynamic_string.h>
+
+int CompareSDS(void *not_used, const void *key1, const void *key2)
+{
+	int64_t length = get_length(CAST(const String)key1);
+	return length == get_length(CAST(const String)key2) && memcmp(key1, key2, CAST(size_t)length) == 0;
+}
+
+double Seconds(clock_t start)
+{
+	return CAST(double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+// Keys of 24 bytes that share a long prefix, like most real keys.
+String *CreateKeys(int key_number, int first)
+{
+	String *keys = Malloc(CAST(int64_t)key_number * CAST(int64_t)sizeof(String));
+	char buffer[32];
+	for(int index = 0; index < key_number; ++index)
+	{
+		int length = snprintf(buffer, sizeof(buffer), "user:session:%011d", first + index);
+		keys[index] = SDSNewLength(buffer, length);
+	}
+	return keys;
+}
+
+void FreeKeys(String *keys, int key_number)
+{
+	for(int index = 0; index < key_number; ++index)
+	{
+		SDSFree(keys[index]);
+	}
+	Free(keys);
+}
+
+void Benchmark(int layout, int cache_hash, String *keys, String *missing_keys, int key_number)
+{
+	HashTableType type = {HashSDS, CompareSDS, NULL, NULL, NULL, NULL, layout, cache_hash, NULL, NULL};
+	int64_t base = UsedMemory();
+	Dictionary *d = DictionaryCreate(&type, NULL);
+
+	clock_t start = clock();
+	for(int index = 0; index < key_number; ++index)
+	{
+		DictionaryAdd(d, keys[index], NULL);
+	}
+	while(DictionaryRehash(d, 100))
+	{
+	}
+	double insert_seconds = Seconds(start);
+	int64_t used_memory = UsedMemory() - base;
+
+	// Rehash all keys to a table of 4 times the size.
+	start = clock();
+	DictionaryExpand(d, d->hash_table_[0].size_ * 4);
+	while(DictionaryRehash(d, 100))
+	{
+	}
+	double rehash_seconds = Seconds(start);
+
+	start = clock();
+	int found = 0;
+	for(int index = 0; index < key_number; ++index)
+	{
+		found += DictionaryFind(d, keys[(CAST(int64_t)index * 7919) % key_number]) != NULL;
+	}
+	double hit_seconds = Seconds(start);
+
+	start = clock();
+	for(int index = 0; index < key_number; ++index)
+	{
+		found += DictionaryFind(d, missing_keys[index]) != NULL;
+	}
+	double miss_seconds = Seconds(start);
+
+	printf("%-15s %-9s %8d keys: insert %5.2f Mops/s, rehash %6.1f ns/key, "
+	       "hit %5.2f Mops/s, miss %5.2f Mops/s, %5.1f bytes/key%s\n",
+	       layout == DICTIONARY_LAYOUT_CHAINED ? "chained" : "open addressing",
+	       cache_hash ? "cached" : "uncached", key_number,
+	       key_number / insert_seconds / 1e6, rehash_seconds * 1e9 / key_number,
+	       key_number / hit_seconds / 1e6, key_number / miss_seconds / 1e6,
+	       CAST(double)used_memory / key_number, found == key_number ? "" : " (WRONG)");
+	DictionaryRelease(d);
+}
+
+int main(void)
+{
+	int key_numbers[] = {1000000, 10000000};
+	for(int index = 0; index < 2; ++index)
+	{
+		// 7919 is a prime that doesn't divide the key numbers, so the hit loop visits
+		// every key once in an order unrelated to the insert order.
+		String *keys = CreateKeys(key_numbers[index], 0);
+		String *missing_keys = CreateKeys(key_numbers[index], key_numbers[index]);
+		for(int layout = DICTIONARY_LAYOUT_CHAINED; layout <= DICTIONARY_LAYOUT_OPEN_ADDRESSING;
+		        ++layout)
+		{
+			Benchmark(layout, 0, keys, missing_keys, key_numbers[index]);
+			Benchmark(layout, 1, keys, missing_keys, key_numbers[index]);
+		}
+		FreeKeys(keys, key_numbers[index]);
+		FreeKeys(missing_keys, key_numbers[index]);
+	}
+	return 0;
+}
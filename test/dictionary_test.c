@@ -1,13 +1,16 @@
 #include <dictionary.h>
 
 #include <stdio.h>
+#include <string.h> // memset()
 #include <assert.h>
 
+#include <hash_function.h>
 #include <memory.h>
+#include <simple_dynamic_string.h>
 
-int HashInt(const void *key)
+uint64_t HashInt(const void *key)
 {
-	return *(CAST(int*)key);
+	return CAST(uint64_t)*(CAST(const int*)key);
 }
 int CompareInt(void *not_used, const void *number1, const void *number2)
 {
@@ -24,6 +27,328 @@ void DestructorInt(void *not_used, void *number)
 	Free(number);
 }
 
+// Grow through several incremental rehashings and check every key is still reachable.
+void TestGrowAndDelete(Dictionary *d)
+{
+	for(int key = 1; key < 1000; ++key)
+	{
+		assert(DictionaryAdd(d, &key, &key) == DICTIONARY_SUCCESS);
+		assert(DictionaryAdd(d, &key, &key) == DICTIONARY_ERROR);
+	}
+	for(int key = 0; key < 1000; ++key)
+	{
+		assert(*(CAST(int*)DictionaryGetValue(d, &key)) == key);
+	}
+	for(int key = 0; key < 1000; key += 2)
+	{
+		assert(DictionaryDelete(d, &key) == DICTIONARY_SUCCESS);
+		assert(DictionaryFind(d, &key) == NULL);
+	}
+	assert(d->hash_table_[0].element_number_ + d->hash_table_[1].element_number_ == 500);
+	for(int key = 1; key < 1000; key += 2)
+	{
+		assert(*(CAST(int*)DictionaryGetValue(d, &key)) == key);
+	}
+}
+
+void MarkScanned(void *argument, const HashTableNode *node)
+{
+	++(CAST(int*)argument)[*(CAST(int*)node->key_)];
+}
+
+// Every key that stays in the dictionary during a scan must be scanned, though the hash
+// table grows, is rehashed, and shrinks between the calls.
+void TestScan(HashTableType *type)
+{
+	static int scanned[4000];
+	Dictionary *d = DictionaryCreate(type, NULL);
+	for(int key = 0; key < 1000; ++key)
+	{
+		DictionaryAdd(d, &key, &key);
+	}
+	memset(scanned, 0, sizeof(scanned));
+	uint64_t cursor = 0;
+	int call_number = 0;
+	do
+	{
+		cursor = DictionaryScan(d, cursor, MarkScanned, scanned);
+		int key = 1000 + call_number++;
+		if(key < 4000) // Grow while scanning.
+		{
+			DictionaryAdd(d, &key, &key);
+		}
+	}
+	while(cursor != 0);
+	for(int key = 0; key < 1000; ++key)
+	{
+		assert(scanned[key] >= 1);
+	}
+
+	for(int key = 1000; key < 4000; ++key)
+	{
+		DictionaryDelete(d, &key);
+	}
+	memset(scanned, 0, sizeof(scanned));
+	cursor = 0;
+	call_number = 0;
+	do
+	{
+		cursor = DictionaryScan(d, cursor, MarkScanned, scanned);
+		int key = 100 + call_number++;
+		if(key < 1000) // Shrink while scanning.
+		{
+			DictionaryDelete(d, &key);
+		}
+	}
+	while(cursor != 0);
+	for(int key = 0; key < 100; ++key)
+	{
+		assert(scanned[key] >= 1);
+	}
+	DictionaryRelease(d);
+}
+
+// Iterate a dictionary in the middle of rehashing: the unsafe iterator returns every
+// element once, and the safe iterator can delete them all.
+void TestIterator(HashTableType *type)
+{
+	static int iterated[1000];
+	Dictionary *d = DictionaryCreate(type, NULL);
+	for(int key = 0; key < 1000; ++key)
+	{
+		DictionaryAdd(d, &key, &key);
+	}
+	DictionaryRehashMilliseconds(d, 1000);
+	DictionaryExpand(d, 4096);
+	DictionaryRehash(d, 10);
+	assert(DictionaryIsRehashing(d));
+
+	uint64_t fingerprint = DictionaryFingerprint(d);
+	memset(iterated, 0, sizeof(iterated));
+	DictionaryIterator *iterator = DictionaryGetIterator(d);
+	HashTableNode *node = NULL;
+	while((node = DictionaryNext(iterator)) != NULL)
+	{
+		++iterated[*(CAST(int*)node->key_)];
+	}
+	DictionaryReleaseIterator(iterator);
+	for(int key = 0; key < 1000; ++key)
+	{
+		assert(iterated[key] == 1);
+	}
+	assert(DictionaryFingerprint(d) == fingerprint);
+
+	iterator = DictionaryGetSafeIterator(d);
+	int count = 0;
+	while((node = DictionaryNext(iterator)) != NULL)
+	{
+		assert(d->iterator_number_ == 1);
+		assert(DictionaryDelete(d, node->key_) == DICTIONARY_SUCCESS);
+		++count;
+	}
+	DictionaryReleaseIterator(iterator);
+	assert(count == 1000 && d->iterator_number_ == 0);
+	assert(d->hash_table_[0].element_number_ + d->hash_table_[1].element_number_ == 0);
+	assert(DictionaryFingerprint(d) != fingerprint);
+	DictionaryRelease(d);
+}
+
+// A safe iterator pauses rehashing, but adds during the iteration must still find room,
+// though the open addressing tables fill up, without moving the elements of a table that
+// the iterator is in the middle of: every element that was there before the iteration
+// started is returned exactly once.
+void TestSafeIteratorAdd(HashTableType *type)
+{
+	static int iterated[40000];
+	for(int in_second_table = 0; in_second_table <= 1; ++in_second_table)
+	{
+		Dictionary *d = DictionaryCreate(type, NULL);
+		int key = 0;
+		for(; key < 1000 || DictionaryIsRehashing(d) == 0; ++key)
+		{
+			DictionaryAdd(d, &key, &key);
+		}
+		int old_key_number = key;
+		memset(iterated, 0, sizeof(iterated));
+		DictionaryIterator *iterator = DictionaryGetSafeIterator(d);
+		HashTableNode *node = NULL;
+		do
+		{
+			assert((node = DictionaryNext(iterator)) != NULL);
+			++iterated[*(CAST(int*)node->key_)];
+		}
+		while(in_second_table && iterator->table_ == 0);
+		assert(d->second_iterator_number_ == in_second_table);
+		for(; key < 40000; ++key)
+		{
+			assert(DictionaryAdd(d, &key, &key) == DICTIONARY_SUCCESS);
+		}
+		while((node = DictionaryNext(iterator)) != NULL)
+		{
+			++iterated[*(CAST(int*)node->key_)];
+		}
+		DictionaryReleaseIterator(iterator);
+		assert(d->iterator_number_ == 0 && d->second_iterator_number_ == 0);
+		for(key = 0; key < 40000; ++key)
+		{
+			assert(key >= old_key_number ? iterated[key] <= 1 : iterated[key] == 1);
+			assert(*(CAST(int*)DictionaryGetValue(d, &key)) == key);
+		}
+		DictionaryRehashMilliseconds(d, 1000);
+		assert(DictionaryIsRehashing(d) == 0 && d->hash_table_[0].element_number_ == 40000);
+		DictionaryRelease(d);
+	}
+}
+
+// DictionaryFindBatch() finds the existing keys and only them, also in rehashing.
+void TestFindBatch(HashTableType *type)
+{
+	static int keys[100];
+	const void *key_pointers[100];
+	HashTableNode *nodes[100];
+	Dictionary *d = DictionaryCreate(type, NULL);
+	assert(DictionaryFindBatch(d, key_pointers, 0, nodes) == 0);
+	for(int key = 0; key < 500; ++key)
+	{
+		DictionaryAdd(d, &key, &key);
+	}
+	DictionaryRehashMilliseconds(d, 1000);
+	DictionaryExpand(d, 2048);
+	for(int index = 0; index < 100; ++index)
+	{
+		keys[index] = index * 7; // Keys >= 500 are missing.
+		key_pointers[index] = &keys[index];
+	}
+	assert(DictionaryFindBatch(d, key_pointers, 100, nodes) == 72);
+	for(int index = 0; index < 100; ++index)
+	{
+		assert((nodes[index] == NULL) == (keys[index] >= 500));
+		assert(keys[index] >= 500 || *(CAST(int*)nodes[index]->key_) == keys[index]);
+	}
+	DictionaryRelease(d);
+
+	// Several batches while a step or two would finish rehashing: the nodes found by the
+	// first batches must stay valid until the call returns.
+	static int more_keys[128];
+	const void *more_key_pointers[128];
+	HashTableNode *more_nodes[128];
+	d = DictionaryCreate(type, NULL);
+	for(int key = 0; key < 20; ++key)
+	{
+		DictionaryAdd(d, &key, &key);
+	}
+	DictionaryRehashMilliseconds(d, 1000);
+	assert(DictionaryExpand(d, 1024) == DICTIONARY_SUCCESS);
+	for(int index = 0; index < 128; ++index)
+	{
+		more_keys[index] = index; // Keys >= 20 are missing.
+		more_key_pointers[index] = &more_keys[index];
+	}
+	assert(DictionaryFindBatch(d, more_key_pointers, 128, more_nodes) == 20);
+	for(int index = 0; index < 20; ++index)
+	{
+		assert(*(CAST(int*)more_nodes[index]->key_) == index);
+	}
+	DictionaryRelease(d);
+}
+
+// Random elements are existing elements, and every element is sampled sooner or later,
+// also in rehashing.
+void TestRandomKeys(HashTableType *type)
+{
+	static int sampled[100];
+	HashTableNode *nodes[200];
+	Dictionary *d = DictionaryCreate(type, NULL);
+	assert(DictionaryGetRandomKey(d) == NULL && DictionaryGetSomeKeys(d, nodes, 10) == 0);
+	for(int key = 0; key < 100; ++key)
+	{
+		DictionaryAdd(d, &key, &key);
+	}
+	DictionaryRehashMilliseconds(d, 1000);
+	// The 100 keys are in 128 slots, so runs of empty slots are too short to make the sampling
+	// jump, and it walks all the slots well within its step budget.
+	assert(!DictionaryIsRehashing(d) && d->hash_table_[0].size_ == 128);
+	assert(DictionaryGetSomeKeys(d, nodes, 200) == 100);
+	DictionaryExpand(d, 1024);
+	assert(DictionaryIsRehashing(d));
+	memset(sampled, 0, sizeof(sampled));
+	for(int round = 0; round < 10000; ++round)
+	{
+		int key = *(CAST(int*)DictionaryGetRandomKey(d)->key_);
+		assert(key >= 0 && key < 100);
+		++sampled[key];
+	}
+	for(int key = 0; key < 100; ++key)
+	{
+		assert(sampled[key] > 0);
+	}
+
+	memset(sampled, 0, sizeof(sampled));
+	for(int round = 0; round < 1000; ++round)
+	{
+		int64_t number = DictionaryGetSomeKeys(d, nodes, 5);
+		assert(number <= 5);
+		for(int64_t index = 0; index < number; ++index)
+		{
+			int key = *(CAST(int*)nodes[index]->key_);
+			assert(key >= 0 && key < 100);
+			++sampled[key];
+		}
+	}
+	for(int key = 0; key < 100; ++key)
+	{
+		assert(sampled[key] > 0);
+	}
+	DictionaryRelease(d);
+}
+
+int CompareSDS(void *not_used, const void *key1, const void *key2)
+{
+	SDSView view = SDSViewOfSDS(CAST(const String)key1);
+	return SDSViewEqual(&view, CAST(const String)key2);
+}
+int CompareSDSView(void *not_used, const void *view, const void *key)
+{
+	return SDSViewEqual(view, CAST(const String)key);
+}
+void *ShareSDS(void *not_used, const void *key)
+{
+	return SDSShare(CAST(String)key);
+}
+void FreeSDS(void *not_used, void *key)
+{
+	SDSFree(key);
+}
+
+// Keys are found by views of a buffer without creating SDS strings, and shared keys are
+// added without copying.
+void TestFindView(int layout, int cache_hash)
+{
+	HashTableType type = {HashSDS, CompareSDS, ShareSDS, NULL, FreeSDS, NULL, layout, cache_hash,
+	                      HashSDSView, CompareSDSView
+	                     };
+	Dictionary *d = DictionaryCreate(&type, NULL);
+	char buffer[64];
+	for(int key = 0; key < 1000; ++key)
+	{
+		String shared = SDSNewShared(buffer, snprintf(buffer, sizeof(buffer), "key:%d", key));
+		assert(DictionaryAdd(d, shared, NULL) == DICTIONARY_SUCCESS);
+		assert(SDSReferenceCount(shared) == 2);
+		SDSFree(shared); // The dictionary holds the last reference.
+	}
+	const char *query = "GET key:123 key:999 key:1000 key:12";
+	SDSView views[4] = {{query + 4, 7}, {query + 12, 7}, {query + 20, 8}, {query + 29, 6}};
+	for(int index = 0; index < 4; ++index)
+	{
+		HashTableNode *node = DictionaryFindView(d, &views[index]);
+		assert((node != NULL) == (index != 2));
+		assert(node == NULL || SDSViewEqual(&views[index], node->key_));
+	}
+	SDSView prefix = {query + 4, 5}; // "key:1"
+	assert(DictionaryFindView(d, &prefix) != NULL && DictionaryGetValueView(d, &prefix) == NULL);
+	DictionaryRelease(d);
+}
+
 int main()
 {
 	HashTableType *type = Malloc(CAST(int)sizeof(HashTableType));
@@ -33,12 +358,148 @@ int main()
 	type->ValueDuplicate = DuplicateInt;
 	type->KeyDestructor = DestructorInt;
 	type->ValueDestructor = DestructorInt;
+	type->layout_ = DICTIONARY_LAYOUT_CHAINED;
+	type->cache_hash_ = 0;
+	type->ViewHashFunction = NULL;
+	type->ViewKeyCompare = NULL;
 
 	Dictionary *d = DictionaryCreate(type, NULL);
 	assert(d->hash_table_[0].slot_ == NULL && d->rehash_index_ == -1);
 	int arr = 0;
 	DictionaryAdd(d, &arr, &arr);
 	assert(d->hash_table_[0].size_ == 4 && d->hash_table_[0].element_number_ == 1);
+	TestGrowAndDelete(d);
+	DictionaryRelease(d);
+
+	type->layout_ = DICTIONARY_LAYOUT_OPEN_ADDRESSING;
+	d = DictionaryCreate(type, NULL);
+	DictionaryAdd(d, &arr, &arr);
+	assert(d->hash_table_[0].slot_ == NULL && d->hash_table_[0].entry_ != NULL &&
+	       d->hash_table_[0].size_ >= 16 && d->hash_table_[0].element_number_ == 1);
+	TestGrowAndDelete(d);
+	// Churn: deleted slots are reused or dropped by rebuilding, the table doesn't grow.
+	int64_t size = d->hash_table_[0].size_ + d->hash_table_[1].size_;
+	for(int round = 0; round < 100; ++round)
+	{
+		for(int key = 0; key < 1000; key += 2)
+		{
+			int churn_key = key + 1000 * (round + 1);
+			assert(DictionaryAdd(d, &churn_key, &churn_key) == DICTIONARY_SUCCESS);
+		}
+		for(int key = 0; key < 1000; key += 2)
+		{
+			int churn_key = key + 1000 * (round + 1);
+			assert(DictionaryDelete(d, &churn_key) == DICTIONARY_SUCCESS);
+		}
+	}
+	assert(d->hash_table_[0].size_ + d->hash_table_[1].size_ <= 2 * size);
+	for(int key = 1; key < 1000; key += 2)
+	{
+		assert(*(CAST(int*)DictionaryGetValue(d, &key)) == key);
+	}
+	DictionaryRelease(d);
+
+	// An idle dictionary finishes rehashing by DictionaryRehashMilliseconds(), unless
+	// there are safe iterators.
+	type->layout_ = DICTIONARY_LAYOUT_CHAINED;
+	d = DictionaryCreate(type, NULL);
+	for(int key = 0; key < 1000; ++key)
+	{
+		DictionaryAdd(d, &key, &key);
+	}
+	while(DictionaryRehash(d, 100))
+	{
+	}
+	int64_t finished_number = d->rehash_finished_number_;
+	assert(DictionaryExpand(d, 100000) == DICTIONARY_SUCCESS && DictionaryIsRehashing(d));
+	assert(d->rehash_start_time_ != 0 && DictionaryRehashingTime(d) >= 0);
+	d->iterator_number_ = 1;
+	assert(DictionaryRehashMilliseconds(d, 1000) == 0 && DictionaryIsRehashing(d));
+	d->iterator_number_ = 0;
+	// A step per slot that has keys: the identity hash puts every key in its own slot.
+	assert(DictionaryRehashMilliseconds(d, 1000) == 1000 && DictionaryIsRehashing(d) == 0);
+	assert(d->rehash_finished_number_ == finished_number + 1 && d->rehash_start_time_ == 0);
+	assert(DictionaryRehashingTime(d) == 0 && d->rehash_total_time_ >= 0);
+	assert(d->hash_table_[0].element_number_ == 1000);
+	DictionaryRelease(d);
+	// The last batch, which finishes rehashing in less than 100 steps, is counted exactly.
+	d = DictionaryCreate(type, NULL);
+	for(int key = 0; key < 10; ++key)
+	{
+		DictionaryAdd(d, &key, &key);
+	}
+	while(DictionaryRehash(d, 100))
+	{
+	}
+	assert(DictionaryExpand(d, 64) == DICTIONARY_SUCCESS);
+	assert(DictionaryRehashMilliseconds(d, 1000) == 10 && DictionaryIsRehashing(d) == 0);
+	assert(DictionaryRehashMilliseconds(d, 1000) == 0);
+	DictionaryRelease(d);
+
+	// Shrink after mass deletes, but not while resizing is disabled.
+	for(int layout = DICTIONARY_LAYOUT_CHAINED; layout <= DICTIONARY_LAYOUT_OPEN_ADDRESSING;
+	        ++layout)
+	{
+		type->layout_ = layout;
+		d = DictionaryCreate(type, NULL);
+		for(int key = 0; key < 10000; ++key)
+		{
+			DictionaryAdd(d, &key, &key);
+		}
+		DictionaryRehashMilliseconds(d, 1000);
+		int64_t full_size = d->hash_table_[0].size_;
+		DictionaryDisableResize();
+		for(int key = 0; key < 9500; ++key)
+		{
+			assert(DictionaryDelete(d, &key) == DICTIONARY_SUCCESS);
+		}
+		assert(d->hash_table_[0].size_ == full_size && DictionaryIsRehashing(d) == 0);
+		DictionaryEnableResize();
+		int key = 9500;
+		assert(DictionaryDelete(d, &key) == DICTIONARY_SUCCESS && DictionaryIsRehashing(d));
+		DictionaryRehashMilliseconds(d, 1000);
+		assert(d->hash_table_[0].size_ <= full_size / 8 && d->hash_table_[0].element_number_ == 499);
+		for(key = 9501; key < 10000; ++key)
+		{
+			assert(*(CAST(int*)DictionaryGetValue(d, &key)) == key);
+			assert(DictionaryDelete(d, &key) == DICTIONARY_SUCCESS);
+		}
+		DictionaryRehashMilliseconds(d, 1000);
+		assert(d->hash_table_[0].size_ <= DICTIONARY_HASH_TABLE_INITIAL_SIZE * 8);
+		DictionaryRelease(d);
+	}
+
+	type->cache_hash_ = 0;
+	type->layout_ = DICTIONARY_LAYOUT_CHAINED;
+	TestScan(type);
+	TestIterator(type);
+	TestSafeIteratorAdd(type);
+	TestFindBatch(type);
+	TestRandomKeys(type);
+	type->layout_ = DICTIONARY_LAYOUT_OPEN_ADDRESSING;
+	TestScan(type);
+	TestIterator(type);
+	TestSafeIteratorAdd(type);
+	TestFindBatch(type);
+	TestRandomKeys(type);
+
+	// Cached hash values: rehashing and lookups must use them consistently.
+	type->cache_hash_ = 1;
+	for(int layout = DICTIONARY_LAYOUT_CHAINED; layout <= DICTIONARY_LAYOUT_OPEN_ADDRESSING;
+	        ++layout)
+	{
+		type->layout_ = layout;
+		d = DictionaryCreate(type, NULL);
+		DictionaryAdd(d, &arr, &arr);
+		TestGrowAndDelete(d);
+		assert(layout == DICTIONARY_LAYOUT_CHAINED || d->hash_table_[0].hash_ != NULL);
+		DictionaryRelease(d);
+		TestScan(type);
+		TestFindView(layout, 0);
+		TestFindView(layout, 1);
+	}
+	Free(type);
+	assert(UsedMemory() == 0);
 
 	printf("All passed! Come on!\n");
 }
@@ -0,0 +1,76 @@
+#include <stdio.h> // printf()
+#include <string.h> // strlen()
+#include <assert.h>
+
+#include <hash_function.h>
+#include <simple_dynamic_string.h>
+
+// Count the bits that differ between two hash values.
+int DifferentBits(uint64_t hash1, uint64_t hash2)
+{
+	return __builtin_popcountll(hash1 ^ hash2);
+}
+
+int main(void)
+{
+	uint8_t seed[HASH_SEED_SIZE] = {0};
+	HashSetSeed(seed);
+	HashInitRandomSeed(); // The seed has been set, so it doesn't change.
+	assert(memcmp(HashGetSeed(), seed, HASH_SEED_SIZE) == 0);
+
+	const char *text = "The quick brown fox jumps over the lazy dog, 0123456789!";
+	int64_t length = CAST(int64_t)strlen(text);
+	uint64_t (*hashes[])(const void*, int64_t) = {HashSip, HashSipNoCase, HashFast, HashFastNoCase};
+	for(int hash = 0; hash < 4; ++hash)
+	{
+		for(int64_t prefix = 0; prefix <= length; ++prefix)
+		{
+			// Deterministic for the same seed.
+			assert(hashes[hash](text, prefix) == hashes[hash](text, prefix));
+			// Flipping any bit of the last byte changes about half of the hash bits.
+			if(prefix > 0)
+			{
+				char changed[64];
+				memcpy(changed, text, CAST(size_t)prefix);
+				changed[prefix - 1] ^= 0x10;
+				int bits = DifferentBits(hashes[hash](text, prefix), hashes[hash](changed, prefix));
+				assert(bits > 8 && bits < 56);
+			}
+			// A longer prefix doesn't collide with a shorter one.
+			if(prefix < length)
+			{
+				assert(hashes[hash](text, prefix) != hashes[hash](text, prefix + 1));
+			}
+		}
+	}
+
+	// Case insensitive variants only ignore the case of ASCII letters.
+	const char *lower = "hello, world! abcdefghijklmnopqrstuvwxyz [\\]^_`@{|}~\xc1\xe1";
+	const char *upper = "HELLO, WORLD! ABCDEFGHIJKLMNOPQRSTUVWXYZ [\\]^_`@{|}~\xc1\xe1";
+	for(int64_t prefix = 0; prefix <= CAST(int64_t)strlen(lower); ++prefix)
+	{
+		assert(HashSipNoCase(lower, prefix) == HashSipNoCase(upper, prefix));
+		assert(HashFastNoCase(lower, prefix) == HashFastNoCase(upper, prefix));
+		assert(HashSipNoCase(lower, prefix) == HashSip(lower, prefix));
+		assert(HashFastNoCase(lower, prefix) == HashFast(lower, prefix));
+	}
+	assert(HashSip("@", 1) != HashSipNoCase("`", 1) && HashFast("[", 1) != HashFastNoCase("{", 1));
+	assert(HashSip("\xc1", 1) != HashSipNoCase("\xe1", 1));
+
+	// SDS hash functions hash the content of the string.
+	String key = SDSNew("Key:1");
+	assert(HashSDS(key) == HashSip("Key:1", 5) && HashSDSNoCase(key) == HashSip("key:1", 5));
+	assert(HashSDSFast(key) == HashFast("Key:1", 5) &&
+	       HashSDSFastNoCase(key) == HashFast("key:1", 5));
+
+	// A different seed gives different hash values.
+	uint64_t sip = HashSDS(key), fast = HashSDSFast(key);
+	seed[0] = 1;
+	HashSetSeed(seed);
+	assert(DifferentBits(sip, HashSDS(key)) > 8 && DifferentBits(fast, HashSDSFast(key)) > 8);
+	SDSFree(key);
+
+	printf("All passed! Come on!\n");
+
+	return 0;
+}
@@ -0,0 +1,145 @@
+// Sets of integers as an intset against a Dictionary of SDS strings: memory per member and
+// membership throughput at the default conversion size, and the intersection and union
+// throughput of large intsets of each width at every SIMD level supported by the CPU. The
+// best of 3 runs is reported.
+#include <stdio.h> // printf()
+#include <stdint.h>
+#include <stdlib.h> // rand()
+#include <time.h> // clock()
+
+#include <int_set.h>
+#include <memory.h>
+#include <nosql.h>
+#include <set_object.h>
+#include <simple_dynamic_string.h>
+
+#define LOOKUP_NUMBER 10000000
+#define BENCHMARK_RUNS 3
+
+volatile int64_t sink = 0;
+
+double Seconds(clock_t start)
+{
+	return CAST(double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+// User IDs: random 7 digits numbers, half of the lookups miss.
+void BenchmarkMembership(int encoding)
+{
+	static char members[1024][SDS_INT64_STRING_SIZE];
+	int64_t lengths[1024];
+	int64_t base = UsedMemory();
+	NosqlObject *set = CreateSetObject();
+	for(int index = 0; index < 1024; ++index)
+	{
+		lengths[index] = SDSFormatInt64(members[index], 1000000 + rand() % 9000000);
+		if(index % 2 == 0 && SetTypeLength(set) < g_set_max_int_set_entries)
+		{
+			SetTypeAdd(set, members[index], lengths[index]);
+		}
+	}
+	if(encoding == NOSQL_ENCODING_HASH_TABLE)
+	{
+		SetTypeConvert(set, NOSQL_ENCODING_HASH_TABLE);
+	}
+	double bytes = CAST(double)(UsedMemory() - base) / CAST(double)SetTypeLength(set);
+	double best = 1e9;
+	for(int run = 0; run < BENCHMARK_RUNS; ++run)
+	{
+		clock_t start = clock();
+		for(int index = 0; index < LOOKUP_NUMBER; ++index)
+		{
+			sink += SetTypeIsMember(set, members[index & 1023], lengths[index & 1023]);
+		}
+		double seconds = Seconds(start);
+		best = seconds < best ? seconds : best;
+	}
+	printf("set of %lld members %-9s %5.1f bytes/member, is member %6.2f Mops/s\n",
+	       CAST(long long)SetTypeLength(set), ObjectEncodingName(encoding), bytes,
+	       LOOKUP_NUMBER / best / 1e6);
+	DecreaseReferenceCount(set);
+}
+
+// Two sets of values of the width in bytes, like the followers of two users, from length
+// slots of the range. If run is 1, the sets interleave: the i-th value of either set is one
+// of 2 in the i-th slot, and the second set takes the value of the first one half of the
+// time, so they share 3/4 of their values. Otherwise runs of run slots alternate between
+// the sets, and 1/8 of the values are in both.
+void BenchmarkSetOperations(int width, int64_t length, int run, int rounds)
+{
+	int64_t range = width == 2 ? 65536 : width == 4 ? 4000000000LL : 1LL << 50;
+	int64_t step = range / length / 2 * 2, base = -range / 2;
+	IntSet *set1 = IntSetNew(), *set2 = IntSetNew();
+	for(int64_t index = 0; index < length; ++index)
+	{
+		int64_t value1 = base + index * step + rand() % 2 * (step / 2);
+		int64_t value2 = base + index * step + rand() % 2 * (step / 2);
+		if(run == 1)
+		{
+			set1 = IntSetAdd(set1, value1, NULL);
+			set2 = IntSetAdd(set2, rand() % 2 ? value1 : value2, NULL);
+		}
+		else if(index / run % 2 == 0 || rand() % 8 == 0)
+		{
+			set1 = IntSetAdd(set1, value1, NULL);
+			set2 = index / run % 2 == 0 ? set2 : IntSetAdd(set2, value1, NULL);
+		}
+		else
+		{
+			set2 = IntSetAdd(set2, value1, NULL);
+		}
+	}
+	for(int level = SDS_SIMD_SCALAR; level <= SDS_SIMD_AVX2; ++level)
+	{
+		if(SDSSetSIMDLevel(level) != level)
+		{
+			continue;
+		}
+		double best_intersect = 1e9, best_union = 1e9;
+		for(int attempt = 0; attempt < BENCHMARK_RUNS; ++attempt)
+		{
+			clock_t start = clock();
+			for(int round = 0; round < rounds; ++round)
+			{
+				IntSet *set = IntSetIntersect(set1, set2);
+				sink += IntSetLength(set);
+				IntSetFree(set);
+			}
+			double seconds = Seconds(start);
+			best_intersect = seconds < best_intersect ? seconds : best_intersect;
+			start = clock();
+			for(int round = 0; round < rounds; ++round)
+			{
+				IntSet *set = IntSetUnion(set1, set2);
+				sink += IntSetLength(set);
+				IntSetFree(set);
+			}
+			seconds = Seconds(start);
+			best_union = seconds < best_union ? seconds : best_union;
+		}
+		double elements = CAST(double)(IntSetLength(set1) + IntSetLength(set2)) * rounds;
+		printf("int%-2d %-11s %s: intersect %7.1f M elements/s, union %7.1f M elements/s\n",
+		       width * 8, run == 1 ? "interleaved" : "runs", level == SDS_SIMD_SCALAR ? "scalar" :
+		       level == SDS_SIMD_SSE2 ? "SSE2  " : "AVX2  ", elements / best_intersect / 1e6,
+		       elements / best_union / 1e6);
+	}
+	SDSSetSIMDLevel(SDS_SIMD_AUTO);
+	IntSetFree(set1);
+	IntSetFree(set2);
+}
+
+int main(void)
+{
+	BenchmarkMembership(NOSQL_ENCODING_INT_SET);
+	BenchmarkMembership(NOSQL_ENCODING_HASH_TABLE);
+	int widths[] = {2, 4, 8};
+	for(int index = 0; index < 3; ++index)
+	{
+		// int16 sets hold at most 65536 values.
+		int64_t length = widths[index] == 2 ? 16384 : 100000;
+		int rounds = CAST(int)(20000000 / length);
+		BenchmarkSetOperations(widths[index], length, 1, rounds);
+		BenchmarkSetOperations(widths[index], length, 64, rounds);
+	}
+	return 0;
+}
@@ -0,0 +1,214 @@
+#include <stdio.h> // printf()
+#include <stdlib.h> // rand(), qsort()
+#include <assert.h>
+
+#include <int_set.h>
+#include <memory.h>
+#include <simple_dynamic_string.h>
+
+#define MAX_NUMBER 2000
+
+// Check that the set holds exactly the sorted values.
+void Check(const IntSet *set, const int64_t *values, int64_t number)
+{
+	assert(IntSetLength(set) == number);
+	assert(IntSetBytes(set) == CAST(int64_t)sizeof(IntSet) + number * set->encoding_);
+	int64_t value;
+	for(int64_t index = 0; index < number; ++index)
+	{
+		assert(IntSetGet(set, index, &value) && value == values[index]);
+		assert(IntSetFind(set, values[index]));
+	}
+	assert(!IntSetGet(set, number, &value) && !IntSetGet(set, -1, &value));
+}
+
+void TestEncodingUpgrade()
+{
+	IntSet *set = IntSetNew();
+	int success;
+	assert(set->encoding_ == INT_SET_ENCODING_INT16 && IntSetLength(set) == 0);
+	set = IntSetAdd(set, 5, &success);
+	assert(success && set->encoding_ == INT_SET_ENCODING_INT16);
+	set = IntSetAdd(set, 5, &success);
+	assert(!success);
+	set = IntSetAdd(set, -32768, NULL);
+	assert(set->encoding_ == INT_SET_ENCODING_INT16);
+	// A larger value is appended, a smaller one is prepended.
+	set = IntSetAdd(set, 65536, NULL);
+	assert(set->encoding_ == INT_SET_ENCODING_INT32);
+	set = IntSetAdd(set, INT64_MIN, NULL);
+	assert(set->encoding_ == INT_SET_ENCODING_INT64);
+	int64_t values[] = {INT64_MIN, -32768, 5, 65536};
+	Check(set, values, 4);
+	// Values that don't fit the encoding are never in the set.
+	IntSet *small = IntSetAdd(IntSetNew(), 1, NULL);
+	assert(!IntSetFind(small, 65537) && !IntSetFind(small, INT64_MAX));
+	small = IntSetRemove(small, 65537, &success);
+	assert(!success && IntSetLength(small) == 1);
+	small = IntSetRemove(small, 1, &success);
+	assert(success && IntSetLength(small) == 0 && !IntSetFind(small, 1));
+	IntSetFree(small);
+	IntSetFree(set);
+}
+
+int CompareInt64(const void *value1, const void *value2)
+{
+	int64_t a = *CAST(const int64_t*)value1, b = *CAST(const int64_t*)value2;
+	return (a > b) - (a < b);
+}
+
+// A random value of at most the width in bytes, mostly small so that sets overlap.
+int64_t RandomValue(int width)
+{
+	int64_t value = rand() % 3000 - 1500;
+	if(width >= 4 && rand() % 8 == 0)
+	{
+		value = CAST(int64_t)rand() * (rand() % 2 ? 1 : -1);
+	}
+	if(width == 8 && rand() % 8 == 0)
+	{
+		value = CAST(int64_t)(CAST(uint64_t)rand() << 33 ^ CAST(uint64_t)rand());
+	}
+	return value;
+}
+
+// Add and remove random values and compare with a sorted array.
+void TestRandomOperations()
+{
+	IntSet *set = IntSetNew();
+	int64_t values[MAX_NUMBER];
+	int64_t number = 0;
+	for(int round = 0; round < 20000; ++round)
+	{
+		int64_t value = RandomValue(1 << (rand() % 4));
+		int64_t position = 0;
+		while(position < number && values[position] < value)
+		{
+			++position;
+		}
+		int exists = position < number && values[position] == value, success;
+		if(rand() % 3 != 0 && number < MAX_NUMBER)
+		{
+			set = IntSetAdd(set, value, &success);
+			assert(success == !exists);
+			if(!exists)
+			{
+				for(int64_t index = number; index > position; --index)
+				{
+					values[index] = values[index - 1];
+				}
+				values[position] = value;
+				++number;
+			}
+		}
+		else
+		{
+			set = IntSetRemove(set, value, &success);
+			assert(success == exists);
+			if(exists)
+			{
+				for(int64_t index = position; index < number - 1; ++index)
+				{
+					values[index] = values[index + 1];
+				}
+				--number;
+			}
+		}
+		assert(IntSetLength(set) == number);
+		if(round % 500 == 0)
+		{
+			Check(set, values, number);
+		}
+	}
+	Check(set, values, number);
+	IntSetFree(set);
+}
+
+// Return a set of number random values of at most width bytes, stored sorted in values.
+IntSet *RandomSet(int64_t *values, int64_t number, int width)
+{
+	IntSet *set = IntSetNew();
+	for(int64_t index = 0; index < number; ++index)
+	{
+		set = IntSetAdd(set, RandomValue(width), NULL);
+	}
+	for(int64_t index = 0; index < IntSetLength(set); ++index)
+	{
+		IntSetGet(set, index, values + index);
+	}
+	return set;
+}
+
+// Check the intersection and the union of random sets of all widths and lengths around the
+// vector sizes against merges of their values.
+void TestIntersectUnion()
+{
+	static int64_t values1[MAX_NUMBER], values2[MAX_NUMBER], expected[2 * MAX_NUMBER];
+	int64_t lengths[] = {0, 1, 7, 8, 9, 16, 33, 100, 1000, MAX_NUMBER};
+	for(int round = 0; round < 300; ++round)
+	{
+		IntSet *set1 = RandomSet(values1, lengths[rand() % 10], 1 << (rand() % 4));
+		IntSet *set2 = RandomSet(values2, lengths[rand() % 10], 1 << (rand() % 4));
+		int64_t length1 = IntSetLength(set1), length2 = IntSetLength(set2);
+		int64_t number = 0, index1 = 0, index2 = 0;
+		while(index1 < length1 && index2 < length2)
+		{
+			if(values1[index1] < values2[index2])
+			{
+				++index1;
+			}
+			else if(values2[index2] < values1[index1])
+			{
+				++index2;
+			}
+			else
+			{
+				expected[number++] = values1[index1++];
+				++index2;
+			}
+		}
+		IntSet *intersection = IntSetIntersect(set1, set2);
+		Check(intersection, expected, number);
+		assert(intersection->encoding_ <= set1->encoding_ &&
+		       intersection->encoding_ <= set2->encoding_);
+		IntSetFree(intersection);
+
+		number = 0;
+		for(index1 = 0; index1 < length1; ++index1)
+		{
+			expected[number++] = values1[index1];
+		}
+		for(index2 = 0; index2 < length2; ++index2)
+		{
+			if(!IntSetFind(set1, values2[index2]))
+			{
+				expected[number++] = values2[index2];
+			}
+		}
+		qsort(expected, CAST(size_t)number, sizeof(int64_t), CompareInt64);
+		IntSet *union_set = IntSetUnion(set1, set2);
+		Check(union_set, expected, number);
+		IntSetFree(union_set);
+		IntSetFree(set1);
+		IntSetFree(set2);
+	}
+}
+
+int main(void)
+{
+	TestEncodingUpgrade();
+	TestRandomOperations();
+	// Every SIMD level supported by the CPU gives the same results.
+	for(int level = SDS_SIMD_SCALAR; level <= SDS_SIMD_AVX2; ++level)
+	{
+		if(SDSSetSIMDLevel(level) == level)
+		{
+			TestIntersectUnion();
+		}
+	}
+	SDSSetSIMDLevel(SDS_SIMD_AUTO);
+	assert(UsedMemory() == 0);
+
+	printf("All passed! Come on!\n");
+	return 0;
+}
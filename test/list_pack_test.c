@@ -0,0 +1,224 @@
+#include <stdio.h> // printf(), snprintf()
+#include <stdlib.h> // rand()
+#include <string.h> // memcmp(), memset()
+#include <assert.h>
+
+#include <list_pack.h>
+#include <memory.h>
+
+// Whether the entry at position is the string.
+int EntryEqual(const uint8_t *position, const char *string, int64_t length)
+{
+	ListPackEntry entry;
+	ListPackGet(position, &entry);
+	if(entry.string_ == NULL)
+	{
+		char buffer[32];
+		int integer_length = snprintf(buffer, sizeof(buffer), "%lld", CAST(long long)entry.integer_);
+		return integer_length == length && memcmp(buffer, string, CAST(size_t)length) == 0;
+	}
+	return entry.length_ == length && memcmp(entry.string_, string, CAST(size_t)length) == 0;
+}
+
+// Check the listpack both ways against the strings.
+void Check(uint8_t *list_pack, const char **strings, int64_t *lengths, int number)
+{
+	assert(ListPackLength(list_pack) == number);
+	uint8_t *position = ListPackFirst(list_pack);
+	for(int index = 0; index < number; ++index)
+	{
+		assert(position != NULL && EntryEqual(position, strings[index], lengths[index]));
+		assert(ListPackSeek(list_pack, index) == position);
+		assert(ListPackSeek(list_pack, index - number) == position);
+		position = ListPackNext(list_pack, position);
+	}
+	assert(position == NULL);
+	position = ListPackLast(list_pack);
+	for(int index = number - 1; index >= 0; --index)
+	{
+		assert(position != NULL && EntryEqual(position, strings[index], lengths[index]));
+		position = ListPackPrevious(list_pack, position);
+	}
+	assert(position == NULL);
+	assert(ListPackSeek(list_pack, number) == NULL && ListPackSeek(list_pack, -number - 1) == NULL);
+}
+
+void TestIntegers()
+{
+	int64_t values[] = {0, 1, 127, 128, -1, 4095, 4096, -4096, -4097, 32767, -32768, 32768,
+	                    8388607, -8388608, 8388608, 2147483647, -2147483647 - 1, 2147483648LL,
+	                    INT64_MAX, INT64_MIN};
+	int64_t sizes[] = {1, 1, 1, 2, 2, 2, 3, 2, 3, 3, 3, 4, 4, 4, 5, 5, 5, 9, 9, 9};
+	for(int index = 0; index < CAST(int)(sizeof(values) / sizeof(values[0])); ++index)
+	{
+		uint8_t *list_pack = ListPackNew();
+		char buffer[32];
+		int length = snprintf(buffer, sizeof(buffer), "%lld", CAST(long long)values[index]);
+		list_pack = ListPackAppend(list_pack, buffer, length);
+		// The header, the entry, its back length and the end byte.
+		assert(ListPackBytes(list_pack) == LIST_PACK_HEADER_SIZE + sizes[index] + 1 + 1);
+		ListPackEntry entry;
+		ListPackGet(ListPackFirst(list_pack), &entry);
+		assert(entry.string_ == NULL && entry.integer_ == values[index]);
+		list_pack = ListPackInsertInteger(list_pack, values[index], NULL, LIST_PACK_BEFORE, NULL);
+		ListPackGet(ListPackLast(list_pack), &entry);
+		assert(entry.string_ == NULL && entry.integer_ == values[index]);
+		ListPackFree(list_pack);
+	}
+	// Not the canonical form of an integer.
+	const char *strings[] = {"007", "+1", "-0", "1 ", "", "9223372036854775808"};
+	for(int index = 0; index < CAST(int)(sizeof(strings) / sizeof(strings[0])); ++index)
+	{
+		uint8_t *list_pack = ListPackAppend(ListPackNew(), strings[index],
+		                                    CAST(int64_t)strlen(strings[index]));
+		ListPackEntry entry;
+		ListPackGet(ListPackFirst(list_pack), &entry);
+		assert(entry.string_ != NULL && entry.length_ == CAST(int64_t)strlen(strings[index]));
+		ListPackFree(list_pack);
+	}
+}
+
+void TestStrings()
+{
+	// The string encodings and the back lengths of 1 to 3 bytes.
+	int64_t lengths[] = {0, 1, 63, 64, 125, 126, 127, 4095, 4096, 16380, 16400, 70000};
+	static char buffer[70000];
+	memset(buffer, 's', sizeof(buffer));
+	const char *strings[12];
+	uint8_t *list_pack = ListPackNew();
+	for(int index = 0; index < 12; ++index)
+	{
+		strings[index] = buffer;
+		list_pack = ListPackAppend(list_pack, buffer, lengths[index]);
+	}
+	Check(list_pack, strings, lengths, 12);
+	ListPackFree(list_pack);
+}
+
+// Random inserts, replaces and deletes against an array.
+void TestRandomOperations()
+{
+	enum {MAX_NUMBER = 300, MAX_LENGTH = 200};
+	static char values[MAX_NUMBER][MAX_LENGTH];
+	const char *strings[MAX_NUMBER];
+	int64_t lengths[MAX_NUMBER];
+	for(int index = 0; index < MAX_NUMBER; ++index)
+	{
+		strings[index] = values[index];
+	}
+	int number = 0;
+	uint8_t *list_pack = ListPackNew();
+	for(int round = 0; round < 20000; ++round)
+	{
+		int operation = rand() % 10, index = number == 0 ? 0 : rand() % number;
+		char string[MAX_LENGTH];
+		int64_t length = rand() % MAX_LENGTH;
+		for(int64_t position = 0; position < length; ++position)
+		{
+			string[position] = CAST(char)('a' + rand() % 26);
+		}
+		if(rand() % 3 == 0) // An integer.
+		{
+			length = snprintf(string, MAX_LENGTH, "%d", rand() - RAND_MAX / 2);
+		}
+		if(operation < 5 && number < MAX_NUMBER)
+		{
+			uint8_t *position = number == 0 ? NULL : ListPackSeek(list_pack, index), *new_position;
+			int after = number != 0 && rand() % 2;
+			list_pack = ListPackInsert(list_pack, string, length, position,
+			                           after ? LIST_PACK_AFTER : LIST_PACK_BEFORE, &new_position);
+			assert(EntryEqual(new_position, string, length));
+			index = number == 0 ? 0 : index + after;
+			memmove(values + index + 1, values + index, MAX_LENGTH * CAST(size_t)(number - index));
+			memmove(lengths + index + 1, lengths + index, sizeof(int64_t) * CAST(size_t)(number - index));
+			++number;
+		}
+		else if(operation < 6 && number > 0)
+		{
+			list_pack = ListPackInsert(list_pack, string, length, ListPackSeek(list_pack, index),
+			                           LIST_PACK_REPLACE, NULL);
+		}
+		else if(operation < 9 && number > 0)
+		{
+			uint8_t *next;
+			list_pack = ListPackDelete(list_pack, ListPackSeek(list_pack, index), &next);
+			assert(next == ListPackSeek(list_pack, index));
+			memmove(values + index, values + index + 1, MAX_LENGTH * CAST(size_t)(number - index - 1));
+			memmove(lengths + index, lengths + index + 1, sizeof(int64_t) * CAST(size_t)(number - index - 1));
+			--number;
+			continue;
+		}
+		else if(number > 0)
+		{
+			int count = rand() % 5;
+			list_pack = ListPackDeleteRange(list_pack, index, count);
+			count = count < number - index ? count : number - index;
+			memmove(values + index, values + index + count,
+			        MAX_LENGTH * CAST(size_t)(number - index - count));
+			memmove(lengths + index, lengths + index + count,
+			        sizeof(int64_t) * CAST(size_t)(number - index - count));
+			number -= count;
+			continue;
+		}
+		else
+		{
+			continue;
+		}
+		memcpy(values[index], string, CAST(size_t)length);
+		lengths[index] = length;
+		if(round % 97 == 0)
+		{
+			Check(list_pack, strings, lengths, number);
+		}
+	}
+	Check(list_pack, strings, lengths, number);
+	ListPackFree(list_pack);
+}
+
+// More entries than the header can count.
+void TestUnknownLength()
+{
+	uint8_t *list_pack = ListPackNew();
+	for(int index = 0; index < 70000; ++index)
+	{
+		list_pack = ListPackInsertInteger(list_pack, index, NULL, LIST_PACK_BEFORE, NULL);
+	}
+	assert(ListPackLength(list_pack) == 70000);
+	ListPackEntry entry;
+	ListPackGet(ListPackSeek(list_pack, 69999), &entry);
+	assert(entry.integer_ == 69999);
+	ListPackGet(ListPackSeek(list_pack, -70000), &entry);
+	assert(entry.integer_ == 0 && ListPackSeek(list_pack, 70000) == NULL);
+	list_pack = ListPackDeleteRange(list_pack, 0, 10000);
+	assert(ListPackLength(list_pack) == 60000);
+	ListPackGet(ListPackFirst(list_pack), &entry);
+	assert(entry.integer_ == 10000);
+	ListPackFree(list_pack);
+}
+
+int main(void)
+{
+	uint8_t *list_pack = ListPackNew();
+	assert(ListPackLength(list_pack) == 0 && ListPackBytes(list_pack) == LIST_PACK_HEADER_SIZE + 1);
+	assert(ListPackFirst(list_pack) == NULL && ListPackLast(list_pack) == NULL);
+	assert(ListPackSeek(list_pack, 0) == NULL && ListPackSeek(list_pack, -1) == NULL);
+	list_pack = ListPackAppend(list_pack, "b", 1);
+	list_pack = ListPackPrepend(list_pack, "a", 1);
+	list_pack = ListPackAppend(list_pack, "12", 2);
+	const char *strings[] = {"a", "b", "12"};
+	int64_t lengths[] = {1, 1, 2};
+	Check(list_pack, strings, lengths, 3);
+	// "a" and "b" take an encoding byte, a data byte and a back length byte; 12 is a 7 bits
+	// integer that takes an encoding byte and a back length byte.
+	assert(ListPackBytes(list_pack) == LIST_PACK_HEADER_SIZE + 3 + 3 + 2 + 1);
+	ListPackFree(list_pack);
+
+	TestIntegers();
+	TestStrings();
+	TestRandomOperations();
+	TestUnknownLength();
+	assert(UsedMemory() == 0);
+
+	printf("All passed! Come on!\n");
+	return 0;
+}
@@ -0,0 +1,71 @@
+#include <stdio.h> // printf()
+#include <stdlib.h> // rand()
+#include <string.h> // memcmp(), memset()
+#include <assert.h>
+
+#include <lzf.h>
+
+// Compress and decompress length bytes and return the compressed length.
+int RoundTrip(const char *data, int length)
+{
+	static char compressed[1 << 16], decompressed[1 << 16];
+	int64_t compressed_length = LZFCompress(data, length, compressed, sizeof(compressed));
+	assert(compressed_length > 0);
+	assert(LZFDecompress(compressed, compressed_length, decompressed, length) == length);
+	assert(memcmp(data, decompressed, CAST(size_t)length) == 0);
+	// The output buffer must be large enough.
+	assert(LZFDecompress(compressed, compressed_length, decompressed, length - 1) == 0);
+	return CAST(int)compressed_length;
+}
+
+int main(void)
+{
+	static char data[40000], compressed[40000];
+	// Empty input and too small output.
+	assert(LZFCompress(data, 0, compressed, sizeof(compressed)) == 0);
+	memset(data, 'a', 100);
+	assert(LZFCompress(data, 100, compressed, 3) == 0);
+
+	// Short inputs have no match.
+	assert(RoundTrip("a", 1) == 2);
+	assert(RoundTrip("abc", 3) == 4);
+
+	// Repeated bytes are long overlapping back references.
+	memset(data, 'x', sizeof(data));
+	assert(RoundTrip(data, sizeof(data)) < 500);
+
+	// Literal runs of exactly 32 bytes and more.
+	for(int index = 0; index < CAST(int)sizeof(data); ++index)
+	{
+		data[index] = CAST(char)rand();
+	}
+	for(int length = 1; length < 200; ++length)
+	{
+		assert(RoundTrip(data, length) == length + (length + 31) / 32);
+	}
+	// Random data doesn't compress, so the output limit is hit.
+	assert(LZFCompress(data, 10000, compressed, 10000) == 0);
+
+	// Text with matches at all distances, including farther than the 8KB window.
+	for(int index = 0; index < CAST(int)sizeof(data); ++index)
+	{
+		data[index] = CAST(char)("abcdefgh"[rand() % 8]);
+	}
+	RoundTrip(data, sizeof(data));
+	int length = 0;
+	for(int number = 0; length < CAST(int)sizeof(data) - 32; ++number)
+	{
+		length += snprintf(data + length, sizeof(data) - CAST(size_t)length, "item:%d,", number);
+	}
+	assert(RoundTrip(data, length) < length / 2);
+
+	// Corrupted input: a back reference before the start of the output.
+	uint8_t bad[] = {0x20, 0x05};
+	assert(LZFDecompress(bad, sizeof(bad), compressed, sizeof(compressed)) == 0);
+	// Truncated literal run.
+	uint8_t truncated[] = {0x05, 'a'};
+	assert(LZFDecompress(truncated, sizeof(truncated), compressed, sizeof(compressed)) == 0);
+
+	printf("All passed! Come on!\n");
+	return 0;
+}
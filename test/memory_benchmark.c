@@ -0,0 +1,70 @@
+// Dictionary insert/delete churn benchmark for the allocator.
+// `memory_benchmark` is linked with the slab allocator and `memory_benchmark_no_slab`
+// with the same memory.c compiled with -DMALLOC_NO_SLAB(plain libc malloc).
+#include <dictionary.h>
+
+#include <stdio.h>
+#include <assert.h>
+#include <time.h> // clock()
+
+#include <memory.h>
+
+#define KEY_NUMBER 1000000
+#define ROUND_NUMBER 5
+
+uint64_t HashInt(const void *key)
+{
+	// Knuth's multiplicative hash spreads sequential keys over the slots.
+	return CAST(uint64_t)(CAST(unsigned)*(CAST(const int*)key) * 2654435761u);
+}
+int CompareInt(void *not_used, const void *number1, const void *number2)
+{
+	return *(CAST(const int*)number1) == *(CAST(const int*)number2);
+}
+void *DuplicateInt(void *not_used, const void *number)
+{
+	int *ret = Malloc(CAST(int)sizeof(int));
+	*ret = *(CAST(const int*)number);
+	return ret;
+}
+void DestructorInt(void *not_used, void *number)
+{
+	Free(number);
+}
+
+int main(void)
+{
+	HashTableType type = {HashInt, CompareInt, DuplicateInt, DuplicateInt,
+	                      DestructorInt, DestructorInt, DICTIONARY_LAYOUT_CHAINED, 0, NULL, NULL
+	                     };
+	Dictionary *d = DictionaryCreate(&type, NULL);
+	clock_t start = clock();
+	for(int round = 0; round < ROUND_NUMBER; ++round)
+	{
+		// Insert all keys, then delete every other key and insert them back, so that
+		// the allocator sees both growth and free/reuse cycles.
+		for(int key = 0; key < KEY_NUMBER; ++key)
+		{
+			DictionaryAdd(d, &key, &key);
+		}
+		for(int key = 0; key < KEY_NUMBER; key += 2)
+		{
+			DictionaryDelete(d, &key);
+		}
+		for(int key = 0; key < KEY_NUMBER; key += 2)
+		{
+			DictionaryAdd(d, &key, &key);
+		}
+		for(int key = 0; key < KEY_NUMBER; ++key)
+		{
+			DictionaryDelete(d, &key);
+		}
+	}
+	double seconds = CAST(double)(clock() - start) / CLOCKS_PER_SEC;
+	DictionaryRelease(d);
+	assert(UsedMemory() == 0);
+	int operation_number = ROUND_NUMBER * KEY_NUMBER * 3;
+	printf("%d dictionary operations in %.3f s: %.0f operations/s\n",
+	       operation_number, seconds, operation_number / seconds);
+	return 0;
+}
@@ -0,0 +1,152 @@
+#include <stdio.h> // printf()
+#include <assert.h>
+#include <pthread.h>
+#include <string.h> // memset()
+
+#include <memory.h>
+
+#define THREAD_NUMBER 4
+#define BLOCK_NUMBER 10000
+#define CHURN_NUMBER 200000
+#define LIVE_NUMBER 100
+
+void *AllocateBlocks(void *blocks)
+{
+	for(int index = 0; index < BLOCK_NUMBER; ++index)
+	{
+		(CAST(void**)blocks)[index] = Malloc(16); // 16 + 8 bytes header: a 24 bytes block.
+	}
+	return NULL;
+}
+
+// Allocate and free blocks of all slab classes, filled with the thread's byte, and check that
+// no other thread wrote to them meanwhile.
+void *ChurnBlocks(void *argument)
+{
+	char byte = CAST(char)CAST(intptr_t)argument;
+	char *live[LIVE_NUMBER] = {NULL};
+	int64_t sizes[LIVE_NUMBER] = {0};
+	for(int index = 0; index < CHURN_NUMBER; ++index)
+	{
+		int slot = index % LIVE_NUMBER;
+		for(int64_t offset = 0; offset < sizes[slot]; ++offset)
+		{
+			assert(live[slot][offset] == byte);
+		}
+		Free(live[slot]);
+		sizes[slot] = 1 + (index * 7919) % 240;
+		live[slot] = Malloc(sizes[slot]);
+		memset(live[slot], byte, CAST(size_t)sizes[slot]);
+	}
+	for(int slot = 0; slot < LIVE_NUMBER; ++slot)
+	{
+		Free(live[slot]);
+	}
+	return NULL;
+}
+
+// The destructor of a key created after the allocator's, so that it runs after the thread's
+// counter and slab cache are gone: it frees memory and allocates again.
+static pthread_key_t g_late_key;
+void LateFree(void *ptr)
+{
+	Free(ptr);
+	Free(Malloc(100));
+}
+
+void *FreeAtExit(void *not_used)
+{
+	Free(Malloc(16)); // Register this thread's counter first.
+	pthread_setspecific(g_late_key, Malloc(16));
+	return NULL;
+}
+
+int main(void)
+{
+	int64_t base = UsedMemory();
+
+	void *ptr = Malloc(1);
+	assert(UsedMemory() - base == 16 && CAST(uintptr_t)ptr % 8 == 0);
+	ptr = Realloc(ptr, 100);
+	assert(UsedMemory() - base == 112);
+	ptr = Realloc(ptr, 1000); // Move from the slab to libc.
+	assert(UsedMemory() - base == 1008 && CAST(uintptr_t)ptr % 8 == 0);
+	Free(ptr);
+	assert(UsedMemory() == base);
+
+	ptr = Calloc(13);
+	for(int index = 0; index < 13; ++index)
+	{
+		assert((CAST(char*)ptr)[index] == 0);
+	}
+	Free(ptr);
+	assert(UsedMemory() == base);
+
+	// Usable size: the rest of the size class(or of the libc block) is kept and counted.
+	int64_t usable = 0;
+	ptr = MallocUsable(1, &usable);
+	assert(usable >= 1 && MallocUsableSize(ptr) == usable);
+	assert(UsedMemory() - base == (usable + 8 + 7) / 8 * 8);
+#ifndef MALLOC_NO_SLAB
+	assert(usable == 8 && UsedMemory() - base == 16); // The 16 bytes slab class.
+#endif
+	ptr = ReallocUsable(ptr, 100, &usable);
+	assert(usable >= 100 && MallocUsableSize(ptr) == usable);
+	assert(UsedMemory() - base == (usable + 8 + 7) / 8 * 8);
+#ifndef MALLOC_NO_SLAB
+	assert(usable == 104 && UsedMemory() - base == 112); // The 112 bytes slab class.
+#endif
+	ptr = ReallocUsable(ptr, 1000, &usable); // libc may also round up.
+	assert(usable >= 1000 && MallocUsableSize(ptr) == usable);
+	assert(UsedMemory() - base == (usable + 8 + 7) / 8 * 8);
+	Free(ptr);
+	ptr = Malloc(13);
+	assert(MallocUsableSize(ptr) == 13);
+	Free(ptr);
+	assert(UsedMemory() == base);
+
+	// Threads allocate, the main thread frees: the counters of the exited threads
+	// are folded into the total and the main thread's counter becomes negative.
+	MallocEnableThreadSafeness();
+	static void *blocks[THREAD_NUMBER][BLOCK_NUMBER];
+	pthread_t threads[THREAD_NUMBER];
+	for(int index = 0; index < THREAD_NUMBER; ++index)
+	{
+		pthread_create(&threads[index], NULL, AllocateBlocks, blocks[index]);
+	}
+	for(int index = 0; index < THREAD_NUMBER; ++index)
+	{
+		pthread_join(threads[index], NULL);
+	}
+	assert(UsedMemory() - base == THREAD_NUMBER * BLOCK_NUMBER * 24);
+	for(int thread = 0; thread < THREAD_NUMBER; ++thread)
+	{
+		for(int index = 0; index < BLOCK_NUMBER; ++index)
+		{
+			Free(blocks[thread][index]);
+		}
+	}
+	assert(UsedMemory() == base);
+
+	// Threads reuse each other's blocks through the shared free lists.
+	for(int index = 0; index < THREAD_NUMBER; ++index)
+	{
+		pthread_create(&threads[index], NULL, ChurnBlocks, CAST(void*)CAST(intptr_t)(index + 1));
+	}
+	for(int index = 0; index < THREAD_NUMBER; ++index)
+	{
+		pthread_join(threads[index], NULL);
+	}
+	assert(UsedMemory() == base);
+
+	// Malloc() and Free() still work and are counted in destructors that run after the
+	// thread's counter is folded.
+	pthread_key_create(&g_late_key, LateFree);
+	pthread_create(&threads[0], NULL, FreeAtExit, NULL);
+	pthread_join(threads[0], NULL);
+	assert(UsedMemory() == base);
+
+	printf("All passed! Come on!\n");
+
+	return 0;
+}
@@ -0,0 +1,243 @@
+// Small hashes, lists and sorted sets, which are most keys: memory per object and lookup
+// throughput of the listpack encoding against the general one(Dictionary, QuickList,
+// SortedSet). OBJECT_NUMBER objects of each size are created; the best of 3 runs of all
+// lookups is reported in millions of lookups per second. Then short string values: raw against
+// embedded strings, and integers.
+#include <stdio.h> // printf(), snprintf()
+#include <stdint.h>
+#include <time.h> // clock()
+
+#include <hash_object.h>
+#include <list_object.h>
+#include <memory.h>
+#include <nosql.h>
+#include <quick_list.h>
+#include <sorted_set_object.h>
+
+#define OBJECT_NUMBER 100000
+#define BENCHMARK_RUNS 3
+
+volatile int64_t sink = 0;
+NosqlObject *objects[OBJECT_NUMBER];
+
+double Seconds(clock_t start)
+{
+	return CAST(double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+// Hashes like user profiles: short fields and values, half of them integers.
+void BenchmarkHash(int field_number, int encoding)
+{
+	char field[32], value[32];
+	int64_t base = UsedMemory();
+	for(int index = 0; index < OBJECT_NUMBER; ++index)
+	{
+		objects[index] = CreateHashObject();
+		if(encoding == NOSQL_ENCODING_HASH_TABLE)
+		{
+			HashTypeConvert(objects[index], NOSQL_ENCODING_HASH_TABLE);
+		}
+		for(int number = 0; number < field_number; ++number)
+		{
+			int field_length = snprintf(field, sizeof(field), "attribute%d", number);
+			int value_length = number % 2 == 0 ? snprintf(value, sizeof(value), "%d", index + number) :
+			                   snprintf(value, sizeof(value), "value-%d", index);
+			HashTypeSet(objects[index], field, field_length, value, value_length);
+		}
+	}
+	double bytes = CAST(double)(UsedMemory() - base) / OBJECT_NUMBER;
+	double best = 1e9;
+	ListPackEntry entry;
+	for(int run = 0; run < BENCHMARK_RUNS; ++run)
+	{
+		clock_t start = clock();
+		for(int index = 0; index < OBJECT_NUMBER; ++index)
+		{
+			for(int number = 0; number < field_number; ++number)
+			{
+				int field_length = snprintf(field, sizeof(field), "attribute%d", number);
+				sink += HashTypeGet(objects[index], field, field_length, &entry);
+			}
+		}
+		double seconds = Seconds(start);
+		best = seconds < best ? seconds : best;
+	}
+	printf("hash %2d fields %-9s %7.1f bytes/object, get %5.2f Mops/s\n", field_number,
+	       ObjectEncodingName(encoding), bytes, CAST(double)OBJECT_NUMBER * field_number / best / 1e6);
+	for(int index = 0; index < OBJECT_NUMBER; ++index)
+	{
+		DecreaseReferenceCount(objects[index]);
+	}
+}
+
+// Lists like recent activity: short strings.
+void BenchmarkList(int entry_number, int encoding)
+{
+	char value[32];
+	int64_t base = UsedMemory();
+	for(int index = 0; index < OBJECT_NUMBER; ++index)
+	{
+		objects[index] = CreateListObject();
+		if(encoding == NOSQL_ENCODING_QUICK_LIST)
+		{
+			ListTypeConvert(objects[index], NOSQL_ENCODING_QUICK_LIST);
+		}
+		for(int number = 0; number < entry_number; ++number)
+		{
+			ListTypePush(objects[index], value, snprintf(value, sizeof(value), "event:%d", number),
+			             QUICK_LIST_TAIL);
+		}
+	}
+	double bytes = CAST(double)(UsedMemory() - base) / OBJECT_NUMBER;
+	double best = 1e9;
+	for(int run = 0; run < BENCHMARK_RUNS; ++run)
+	{
+		clock_t start = clock();
+		for(int index = 0; index < OBJECT_NUMBER; ++index)
+		{
+			for(int number = 0; number < entry_number; ++number)
+			{
+				String string = ListTypeIndex(objects[index], number);
+				sink += get_length(string);
+				SDSFree(string);
+			}
+		}
+		double seconds = Seconds(start);
+		best = seconds < best ? seconds : best;
+	}
+	printf("list %2d entries %-9s %7.1f bytes/object, index %5.2f Mops/s\n", entry_number,
+	       ObjectEncodingName(encoding), bytes, CAST(double)OBJECT_NUMBER * entry_number / best / 1e6);
+	for(int index = 0; index < OBJECT_NUMBER; ++index)
+	{
+		DecreaseReferenceCount(objects[index]);
+	}
+}
+
+// Sorted sets like small leaderboards: short members with integer scores.
+void BenchmarkSortedSet(int member_number, int encoding)
+{
+	char member[32];
+	int64_t base = UsedMemory();
+	for(int index = 0; index < OBJECT_NUMBER; ++index)
+	{
+		objects[index] = CreateSortedSetObject();
+		if(encoding == NOSQL_ENCODING_SKIP_LIST)
+		{
+			SortedSetTypeConvert(objects[index], NOSQL_ENCODING_SKIP_LIST);
+		}
+		for(int number = 0; number < member_number; ++number)
+		{
+			int length = snprintf(member, sizeof(member), "player:%d", number);
+			SortedSetTypeAdd(objects[index], member, length, (index + number * 37) % 1000);
+		}
+	}
+	double bytes = CAST(double)(UsedMemory() - base) / OBJECT_NUMBER;
+	double best = 1e9, score;
+	for(int run = 0; run < BENCHMARK_RUNS; ++run)
+	{
+		clock_t start = clock();
+		for(int index = 0; index < OBJECT_NUMBER; ++index)
+		{
+			for(int number = 0; number < member_number; ++number)
+			{
+				int length = snprintf(member, sizeof(member), "player:%d", number);
+				sink += SortedSetTypeScore(objects[index], member, length, &score);
+			}
+		}
+		double seconds = Seconds(start);
+		best = seconds < best ? seconds : best;
+	}
+	printf("zset %2d members %-9s %7.1f bytes/object, score %5.2f Mops/s\n", member_number,
+	       ObjectEncodingName(encoding), bytes, CAST(double)OBJECT_NUMBER * member_number / best / 1e6);
+	for(int index = 0; index < OBJECT_NUMBER; ++index)
+	{
+		DecreaseReferenceCount(objects[index]);
+	}
+}
+
+// Create a string object of the encoding: the integer, or length bytes of a session token.
+NosqlObject *CreateString(int64_t integer, int length, int encoding)
+{
+	const char *token = "session:0123456789abcdef0123456789abcdef";
+	return encoding == NOSQL_ENCODING_INT ? CreateStringObjectFromInt64(integer) :
+	       encoding == NOSQL_ENCODING_RAW ? CreateRawStringObject(token, length) :
+	       CreateEmbeddedStringObject(token, length);
+}
+
+// String values like counters and session tokens: create, read and free throughput. Integers
+// are the indexes modulo 10^length, which are shared objects below NOSQL_SHARED_INTEGERS unless
+// g_no_shared_integers is set.
+void BenchmarkString(int length, int encoding)
+{
+	char buffer[SDS_INT64_STRING_SIZE];
+	int modulus = 1;
+	for(int digit = 0; digit < length; ++digit)
+	{
+		modulus *= 10;
+	}
+	int64_t base = UsedMemory();
+	for(int index = 0; index < OBJECT_NUMBER; ++index)
+	{
+		objects[index] = CreateString(index % modulus, length, encoding);
+	}
+	double bytes = CAST(double)(UsedMemory() - base) / OBJECT_NUMBER;
+	for(int index = 0; index < OBJECT_NUMBER; ++index)
+	{
+		DecreaseReferenceCount(objects[index]);
+	}
+	double best = 1e9;
+	for(int run = 0; run < BENCHMARK_RUNS; ++run)
+	{
+		clock_t start = clock();
+		for(int index = 0; index < OBJECT_NUMBER; ++index)
+		{
+			objects[index] = CreateString(index % modulus, length, encoding);
+		}
+		for(int index = 0; index < OBJECT_NUMBER; ++index)
+		{
+			SDSView view = StringObjectView(objects[index], buffer);
+			sink += view.data_[view.length_ - 1];
+		}
+		for(int index = 0; index < OBJECT_NUMBER; ++index)
+		{
+			DecreaseReferenceCount(objects[index]);
+		}
+		double seconds = Seconds(start);
+		best = seconds < best ? seconds : best;
+	}
+	printf("string %2d bytes %-10s %5.1f bytes/object, create/read/free %6.2f Mops/s\n", length,
+	       encoding == NOSQL_ENCODING_INT && !g_no_shared_integers ? "int shared" :
+	       ObjectEncodingName(encoding), bytes,
+	       CAST(double)OBJECT_NUMBER / best / 1e6);
+}
+
+int main(void)
+{
+	int sizes[] = {4, 16, 64};
+	for(int index = 0; index < 3; ++index)
+	{
+		BenchmarkHash(sizes[index], NOSQL_ENCODING_LIST_PACK);
+		BenchmarkHash(sizes[index], NOSQL_ENCODING_HASH_TABLE);
+	}
+	for(int index = 0; index < 3; ++index)
+	{
+		BenchmarkList(sizes[index], NOSQL_ENCODING_LIST_PACK);
+		BenchmarkList(sizes[index], NOSQL_ENCODING_QUICK_LIST);
+	}
+	for(int index = 0; index < 3; ++index)
+	{
+		BenchmarkSortedSet(sizes[index], NOSQL_ENCODING_LIST_PACK);
+		BenchmarkSortedSet(sizes[index], NOSQL_ENCODING_SKIP_LIST);
+	}
+	int lengths[] = {8, 20, NOSQL_EMBEDDED_STRING_SIZE_LIMIT - 4};
+	for(int index = 0; index < 3; ++index)
+	{
+		BenchmarkString(lengths[index], NOSQL_ENCODING_RAW);
+		BenchmarkString(lengths[index], NOSQL_ENCODING_EMBEDDED_STRING);
+	}
+	g_no_shared_integers = 1;
+	BenchmarkString(4, NOSQL_ENCODING_INT);
+	g_no_shared_integers = 0;
+	BenchmarkString(4, NOSQL_ENCODING_INT);
+	return 0;
+}
@@ -0,0 +1,733 @@
+#include <inttypes.h> // PRId64
+#include <math.h> // INFINITY
+#include <stdio.h> // printf(), snprintf()
+#include <stdlib.h> // rand()
+#include <string.h> // memcmp(), memset()
+#include <assert.h>
+#include <pthread.h>
+
+#include <hash_object.h>
+#include <list_object.h>
+#include <memory.h>
+#include <nosql.h>
+#include <quick_list.h>
+#include <set_object.h>
+#include <sorted_set_object.h>
+
+// Whether the value is the string.
+int ValueEqual(const ListPackEntry *value, const char *string)
+{
+	String value_string = ListPackEntryToSDS(value);
+	int equal = get_length(value_string) == CAST(int64_t)strlen(string) &&
+	            memcmp(value_string, string, strlen(string)) == 0;
+	SDSFree(value_string);
+	return equal;
+}
+
+// Whether the SDS string is the C string, and free it.
+int SDSEqualFree(String string, const char *expected)
+{
+	int equal = string != NULL && get_length(string) == CAST(int64_t)strlen(expected) &&
+	            memcmp(string, expected, strlen(expected)) == 0;
+	SDSFree(string);
+	return equal;
+}
+
+// Check that fields 0 to number - 1 have their field times 3 as values.
+void CheckHash(NosqlObject *hash, int number)
+{
+	char field[32], expected[32];
+	ListPackEntry value;
+	for(int index = 0; index < number; ++index)
+	{
+		int length = snprintf(field, sizeof(field), "field:%d", index);
+		snprintf(expected, sizeof(expected), "%d", index * 3);
+		assert(HashTypeGet(hash, field, length, &value) && ValueEqual(&value, expected));
+	}
+	assert(!HashTypeExists(hash, "field:-1", 8));
+}
+
+void TestHash(int encoding)
+{
+	NosqlObject *hash = CreateHashObject();
+	assert(hash->type_ == NOSQL_HASH && hash->encoding_ == NOSQL_ENCODING_LIST_PACK);
+	if(encoding == NOSQL_ENCODING_HASH_TABLE)
+	{
+		HashTypeConvert(hash, NOSQL_ENCODING_HASH_TABLE);
+	}
+	char field[32], value[32];
+	ListPackEntry entry;
+	assert(!HashTypeGet(hash, "a", 1, &entry) && !HashTypeDelete(hash, "a", 1));
+	for(int index = 0; index < 100; ++index)
+	{
+		int field_length = snprintf(field, sizeof(field), "field:%d", index);
+		int value_length = snprintf(value, sizeof(value), "v%d", index);
+		assert(HashTypeSet(hash, field, field_length, value, value_length) == 1);
+		value_length = snprintf(value, sizeof(value), "%d", index * 3);
+		assert(HashTypeSet(hash, field, field_length, value, value_length) == 0);
+	}
+	assert(HashTypeLength(hash) == 100);
+	CheckHash(hash, 100);
+	assert(hash->encoding_ == CAST(unsigned)encoding);
+	// Delete the second half.
+	for(int index = 50; index < 100; ++index)
+	{
+		int length = snprintf(field, sizeof(field), "field:%d", index);
+		assert(HashTypeDelete(hash, field, length) && !HashTypeDelete(hash, field, length));
+	}
+	assert(HashTypeLength(hash) == 50);
+	CheckHash(hash, 50);
+	// Integer fields are stored as integers in a listpack, but are still strings.
+	assert(HashTypeSet(hash, "12", 2, "", 0) && HashTypeGet(hash, "12", 2, &entry));
+	assert(ValueEqual(&entry, "") && !HashTypeExists(hash, "012", 3));
+	DecreaseReferenceCount(hash);
+}
+
+void TestHashConversion()
+{
+	// Too many fields.
+	NosqlObject *hash = CreateHashObject();
+	char field[32], value[32];
+	for(int index = 0; index < g_hash_max_list_pack_entries; ++index)
+	{
+		int field_length = snprintf(field, sizeof(field), "field:%d", index);
+		int value_length = snprintf(value, sizeof(value), "%d", index * 3);
+		HashTypeSet(hash, field, field_length, value, value_length);
+	}
+	assert(hash->encoding_ == NOSQL_ENCODING_LIST_PACK);
+	HashTypeSet(hash, "field:128", 9, "384", 3);
+	assert(hash->encoding_ == NOSQL_ENCODING_HASH_TABLE);
+	assert(HashTypeLength(hash) == 129);
+	CheckHash(hash, 129);
+	DecreaseReferenceCount(hash);
+
+	// Too long a value or field.
+	static char long_value[65];
+	memset(long_value, 'x', sizeof(long_value));
+	for(int long_field = 0; long_field <= 1; ++long_field)
+	{
+		hash = CreateHashObject();
+		HashTypeSet(hash, "field:0", 7, "0", 1);
+		HashTypeSet(hash, long_value, 64, long_value, 64);
+		assert(hash->encoding_ == NOSQL_ENCODING_LIST_PACK);
+		if(long_field)
+		{
+			HashTypeSet(hash, long_value, 65, "1", 1);
+		}
+		else
+		{
+			HashTypeSet(hash, "field:1", 7, long_value, 65);
+		}
+		assert(hash->encoding_ == NOSQL_ENCODING_HASH_TABLE && HashTypeLength(hash) == 3);
+		CheckHash(hash, 1);
+		ListPackEntry entry;
+		assert(HashTypeGet(hash, long_value, 64, &entry) && entry.length_ == 64);
+		DecreaseReferenceCount(hash);
+	}
+}
+
+void TestList()
+{
+	NosqlObject *list = CreateListObject();
+	assert(list->type_ == NOSQL_LIST && list->encoding_ == NOSQL_ENCODING_LIST_PACK);
+	assert(ListTypePop(list, QUICK_LIST_HEAD) == NULL && ListTypeIndex(list, 0) == NULL);
+	ListTypePush(list, "b", 1, QUICK_LIST_TAIL);
+	ListTypePush(list, "a", 1, QUICK_LIST_HEAD);
+	ListTypePush(list, "42", 2, QUICK_LIST_TAIL);
+	assert(ListTypeLength(list) == 3);
+	assert(SDSEqualFree(ListTypeIndex(list, -1), "42") && SDSEqualFree(ListTypeIndex(list, 1), "b"));
+	assert(SDSEqualFree(ListTypePop(list, QUICK_LIST_TAIL), "42"));
+	assert(SDSEqualFree(ListTypePop(list, QUICK_LIST_HEAD), "a"));
+	assert(ListTypeLength(list) == 1);
+
+	// Converted when there are too many entries, which are kept in order.
+	char value[32];
+	for(int index = 1; index < g_list_max_list_pack_entries; ++index)
+	{
+		ListTypePush(list, value, snprintf(value, sizeof(value), "%d", index), QUICK_LIST_TAIL);
+	}
+	assert(list->encoding_ == NOSQL_ENCODING_LIST_PACK);
+	ListTypePush(list, "last", 4, QUICK_LIST_TAIL);
+	assert(list->encoding_ == NOSQL_ENCODING_QUICK_LIST);
+	assert(ListTypeLength(list) == g_list_max_list_pack_entries + 1);
+	assert(SDSEqualFree(ListTypeIndex(list, 0), "b") && SDSEqualFree(ListTypeIndex(list, 1), "1"));
+	assert(SDSEqualFree(ListTypePop(list, QUICK_LIST_TAIL), "last"));
+	assert(SDSEqualFree(ListTypePop(list, QUICK_LIST_TAIL), "127"));
+	DecreaseReferenceCount(list);
+
+	// Converted when a value is too long.
+	list = CreateListObject();
+	static char long_value[65];
+	memset(long_value, 'x', sizeof(long_value));
+	ListTypePush(list, "a", 1, QUICK_LIST_HEAD);
+	ListTypePush(list, long_value, 64, QUICK_LIST_HEAD);
+	assert(list->encoding_ == NOSQL_ENCODING_LIST_PACK);
+	ListTypePush(list, long_value, 65, QUICK_LIST_HEAD);
+	assert(list->encoding_ == NOSQL_ENCODING_QUICK_LIST && ListTypeLength(list) == 3);
+	assert(SDSEqualFree(ListTypeIndex(list, 2), "a"));
+	DecreaseReferenceCount(list);
+}
+
+// Add the members i * step for i in [first, last).
+void AddIntegers(NosqlObject *set, int first, int last, int step)
+{
+	char member[32];
+	for(int index = first; index < last; ++index)
+	{
+		SetTypeAdd(set, member, snprintf(member, sizeof(member), "%d", index * step));
+	}
+}
+
+void TestSet()
+{
+	NosqlObject *set = CreateSetObject();
+	assert(set->type_ == NOSQL_SET && set->encoding_ == NOSQL_ENCODING_INT_SET);
+	assert(SetTypeAdd(set, "5", 1) && !SetTypeAdd(set, "5", 1) && SetTypeAdd(set, "-7", 2));
+	assert(SetTypeIsMember(set, "5", 1) && !SetTypeIsMember(set, "6", 1));
+	// Only the canonical form of an integer is a member.
+	assert(!SetTypeIsMember(set, "05", 2) && !SetTypeIsMember(set, "x", 1));
+	assert(!SetTypeRemove(set, "05", 2) && SetTypeRemove(set, "5", 1) && !SetTypeRemove(set, "5", 1));
+	assert(SetTypeLength(set) == 1 && set->encoding_ == NOSQL_ENCODING_INT_SET);
+
+	// Converted by a member that isn't an integer.
+	assert(SetTypeAdd(set, "05", 2));
+	assert(set->encoding_ == NOSQL_ENCODING_HASH_TABLE && SetTypeLength(set) == 2);
+	assert(SetTypeIsMember(set, "-7", 2) && SetTypeIsMember(set, "05", 2));
+	assert(!SetTypeIsMember(set, "5", 1) && SetTypeRemove(set, "-7", 2));
+	assert(!SetTypeIsMember(set, "-7", 2) && SetTypeLength(set) == 1);
+	DecreaseReferenceCount(set);
+
+	// Converted when there are too many members.
+	set = CreateSetObject();
+	AddIntegers(set, 0, CAST(int)g_set_max_int_set_entries, 1);
+	assert(set->encoding_ == NOSQL_ENCODING_INT_SET);
+	AddIntegers(set, 0, CAST(int)g_set_max_int_set_entries + 1, 1);
+	assert(set->encoding_ == NOSQL_ENCODING_HASH_TABLE);
+	assert(SetTypeLength(set) == g_set_max_int_set_entries + 1 && SetTypeIsMember(set, "512", 3));
+	DecreaseReferenceCount(set);
+}
+
+// Check the intersection and the union of the even numbers below 800 and the multiples of 3
+// below 900 in all encodings.
+void TestSetOperations()
+{
+	for(int encoding = 0; encoding < 4; ++encoding)
+	{
+		NosqlObject *set1 = CreateSetObject(), *set2 = CreateSetObject();
+		AddIntegers(set1, 0, 400, 2);
+		AddIntegers(set2, 0, 300, 3);
+		if(encoding & 1)
+		{
+			SetTypeConvert(set1, NOSQL_ENCODING_HASH_TABLE);
+		}
+		if(encoding & 2)
+		{
+			SetTypeConvert(set2, NOSQL_ENCODING_HASH_TABLE);
+		}
+		NosqlObject *intersection = SetTypeIntersect(set1, set2);
+		NosqlObject *union_set = SetTypeUnion(set1, set2);
+		assert(intersection->encoding_ == NOSQL_ENCODING_INT_SET);
+		// 400 + 300 - 134 members are too many for an intset.
+		assert(union_set->encoding_ == NOSQL_ENCODING_HASH_TABLE);
+		assert(SetTypeLength(intersection) == 134 && SetTypeLength(union_set) == 566);
+		char member[32];
+		for(int index = 0; index < 900; ++index)
+		{
+			int length = snprintf(member, sizeof(member), "%d", index);
+			int in1 = index % 2 == 0 && index < 800, in2 = index % 3 == 0;
+			assert(SetTypeIsMember(intersection, member, length) == (in1 && in2));
+			assert(SetTypeIsMember(union_set, member, length) == (in1 || in2));
+		}
+		DecreaseReferenceCount(intersection);
+		DecreaseReferenceCount(union_set);
+		DecreaseReferenceCount(set1);
+		DecreaseReferenceCount(set2);
+	}
+}
+
+// The members and scores passed to RangeCallback().
+char g_range_members[256][32];
+double g_range_scores[256];
+int g_range_number = 0;
+
+void RangeCallback(void *argument, const char *member, int64_t length, double score)
+{
+	assert(length < 32 && g_range_number < 256);
+	memcpy(g_range_members[g_range_number], member, CAST(size_t)length);
+	g_range_members[g_range_number][length] = '\0';
+	g_range_scores[g_range_number++] = score;
+}
+
+// Check the scores, ranks and order of the sorted set against scores[i], the score of the
+// member "i", or NaN if "i" isn't in the set. Members "0" to "9" are integers in listpacks.
+void CheckSortedSet(NosqlObject *zset, const double *scores, int number)
+{
+	char member[32];
+	int64_t length = 0;
+	for(int index = 0; index < number; ++index)
+	{
+		length += scores[index] == scores[index];
+	}
+	assert(SortedSetTypeLength(zset) == length);
+	g_range_number = 0;
+	assert(SortedSetTypeRange(zset, 0, -1, 0, RangeCallback, NULL) == length);
+	for(int rank = 0; rank < length; ++rank)
+	{
+		int index = atoi(g_range_members[rank]);
+		assert(g_range_scores[rank] == scores[index]);
+		double score;
+		int member_length = snprintf(member, sizeof(member), "%d", index);
+		assert(SortedSetTypeScore(zset, member, member_length, &score) && score == scores[index]);
+		assert(SortedSetTypeRank(zset, member, member_length) == rank);
+		if(rank > 0)
+		{
+			// Ordered by score, then by the bytes of the member.
+			assert(g_range_scores[rank - 1] < g_range_scores[rank] ||
+			       (g_range_scores[rank - 1] == g_range_scores[rank] &&
+			        strcmp(g_range_members[rank - 1], g_range_members[rank]) < 0));
+		}
+	}
+}
+
+void TestSortedSet(int encoding)
+{
+	double scores[100];
+	char member[32];
+	NosqlObject *zset = CreateSortedSetObject();
+	assert(zset->type_ == NOSQL_ZSET && zset->encoding_ == NOSQL_ENCODING_LIST_PACK);
+	if(encoding == NOSQL_ENCODING_SKIP_LIST)
+	{
+		SortedSetTypeConvert(zset, NOSQL_ENCODING_SKIP_LIST);
+	}
+	for(int index = 0; index < 100; ++index)
+	{
+		scores[index] = 0.0 / 0.0; // NaN: not in the set.
+	}
+	// 0.1 and 2^63 don't fit an integer entry in the listpack, -0 must not become one.
+	double special_scores[] = {-INFINITY, INFINITY, 0.5, -2.25, 1e300, 3, 0.1, -0.0,
+	                           9223372036854775808.0};
+	for(int round = 0; round < 3000; ++round)
+	{
+		int index = rand() % 100;
+		int length = snprintf(member, sizeof(member), "%d", index);
+		double score = rand() % 4 == 0 ? special_scores[rand() % 9] : rand() % 10;
+		int exists = scores[index] == scores[index];
+		switch(rand() % 3)
+		{
+		case 0:
+			assert(SortedSetTypeAdd(zset, member, length, score) == !exists);
+			scores[index] = score;
+			break;
+		case 1:
+		{
+			double new_score = 0, expected = (exists ? scores[index] : 0) + score;
+			if(expected != expected)
+			{
+				// inf + -inf: nothing changes.
+				assert(!SortedSetTypeIncrementBy(zset, member, length, score, &new_score));
+				break;
+			}
+			assert(SortedSetTypeIncrementBy(zset, member, length, score, &new_score));
+			assert(new_score == expected);
+			scores[index] = new_score;
+			break;
+		}
+		default:
+			assert(SortedSetTypeRemove(zset, member, length) == exists);
+			scores[index] = 0.0 / 0.0;
+			assert(SortedSetTypeRank(zset, member, length) == -1);
+		}
+		if(round % 100 == 0)
+		{
+			CheckSortedSet(zset, scores, 100);
+		}
+	}
+	CheckSortedSet(zset, scores, 100);
+	assert(zset->encoding_ == CAST(unsigned)encoding);
+
+	// Ranges are clamped and negative ranks count from the last member.
+	int64_t length = SortedSetTypeLength(zset);
+	g_range_number = 0;
+	assert(SortedSetTypeRange(zset, -2, 1000, 0, RangeCallback, NULL) == (length < 2 ? length : 2));
+	assert(SortedSetTypeRange(zset, 5, 4, 0, RangeCallback, NULL) == 0);
+	assert(SortedSetTypeRange(zset, length, -1, 0, RangeCallback, NULL) == 0);
+	assert(SortedSetTypeRange(zset, -1000, 0, 0, RangeCallback, NULL) == (length > 0));
+	DecreaseReferenceCount(zset);
+}
+
+void TestSortedSetConversion()
+{
+	// Converted when there are too many members, keeping the scores and the order.
+	char member[32];
+	double scores[200];
+	NosqlObject *zset = CreateSortedSetObject();
+	for(int index = 0; index < 200; ++index)
+	{
+		scores[index] = 0.0 / 0.0;
+	}
+	for(int index = 0; index < g_zset_max_list_pack_entries; ++index)
+	{
+		int length = snprintf(member, sizeof(member), "%d", index);
+		scores[index] = index % 7 * 0.5 - 1;
+		assert(SortedSetTypeAdd(zset, member, length, scores[index]));
+	}
+	assert(zset->encoding_ == NOSQL_ENCODING_LIST_PACK);
+	CheckSortedSet(zset, scores, 200);
+	int length = snprintf(member, sizeof(member), "%d", 199);
+	scores[199] = -1;
+	assert(SortedSetTypeAdd(zset, member, length, -1));
+	assert(zset->encoding_ == NOSQL_ENCODING_SKIP_LIST);
+	CheckSortedSet(zset, scores, 200);
+	DecreaseReferenceCount(zset);
+
+	// Converted by a long member.
+	char long_member[100];
+	memset(long_member, 'x', sizeof(long_member));
+	zset = CreateSortedSetObject();
+	assert(SortedSetTypeAdd(zset, "a", 1, 2) && SortedSetTypeAdd(zset, long_member, 64, 1));
+	assert(zset->encoding_ == NOSQL_ENCODING_LIST_PACK);
+	assert(SortedSetTypeAdd(zset, long_member, 65, 1));
+	assert(zset->encoding_ == NOSQL_ENCODING_SKIP_LIST);
+	assert(SortedSetTypeRank(zset, long_member, 64) == 0);
+	assert(SortedSetTypeRank(zset, long_member, 65) == 1 && SortedSetTypeRank(zset, "a", 1) == 2);
+	assert(SortedSetTypeRemove(zset, long_member, 64) && SortedSetTypeLength(zset) == 2);
+	DecreaseReferenceCount(zset);
+}
+
+// Check the range by score, or by lexical order if range is NULL, with the reverse flag, the
+// offset and the count, against the members of the whole sorted set in g_range_*.
+void CheckRangeBy(NosqlObject *zset, const SkipListRange *range, const SkipListLexRange *lex_range,
+                  int reverse, int64_t offset, int64_t count)
+{
+	int all_number = g_range_number;
+	char expected[256][32];
+	int expected_number = 0;
+	int64_t skipped = 0;
+	for(int index = 0; index < all_number; ++index)
+	{
+		int rank = reverse ? all_number - 1 - index : index;
+		NosqlObject *member = CreateStringObject(g_range_members[rank],
+		                      CAST(int64_t)strlen(g_range_members[rank]));
+		int in_range = range != NULL ? SkipListAboveMin(g_range_scores[rank], range) &&
+		               SkipListBelowMax(g_range_scores[rank], range) :
+		               SkipListLexAboveMin(member, lex_range) && SkipListLexBelowMax(member, lex_range);
+		DecreaseReferenceCount(member);
+		if(in_range && skipped < offset)
+		{
+			++skipped;
+		}
+		else if(in_range && expected_number != count)
+		{
+			strcpy(expected[expected_number++], g_range_members[rank]);
+		}
+	}
+	g_range_number = all_number;
+	int64_t number = range != NULL ?
+	                 SortedSetTypeRangeByScore(zset, range, reverse, offset, count, RangeCallback, NULL) :
+	                 SortedSetTypeRangeByLex(zset, lex_range, reverse, offset, count, RangeCallback, NULL);
+	assert(number == expected_number && g_range_number == all_number + expected_number);
+	for(int index = 0; index < expected_number; ++index)
+	{
+		assert(strcmp(g_range_members[all_number + index], expected[index]) == 0);
+	}
+	g_range_number = all_number;
+}
+
+void TestSortedSetRanges(int encoding)
+{
+	char member[32];
+	NosqlObject *zset = CreateSortedSetObject();
+	if(encoding == NOSQL_ENCODING_SKIP_LIST)
+	{
+		SortedSetTypeConvert(zset, NOSQL_ENCODING_SKIP_LIST);
+	}
+	for(int index = 0; index < 100; ++index)
+	{
+		int length = snprintf(member, sizeof(member), "%d", index);
+		SortedSetTypeAdd(zset, member, length, index % 3 == 0 ? index / 4 : -index / 4);
+	}
+	SortedSetTypeAdd(zset, "-inf", 4, -INFINITY);
+	SortedSetTypeAdd(zset, "inf", 3, INFINITY);
+	// Keep the member of every rank in g_range_* for the checks.
+	g_range_number = 0;
+	int64_t length = SortedSetTypeRange(zset, 0, -1, 0, RangeCallback, NULL);
+
+	// Ranks, in reverse: 0 is the last member.
+	for(int round = 0; round < 200; ++round)
+	{
+		int64_t start = rand() % 230 - 115, stop = rand() % 230 - 115;
+		int reverse = rand() % 2;
+		int64_t first = start < 0 ? start + length : start, last = stop < 0 ? stop + length : stop;
+		first = first < 0 ? 0 : first;
+		last = last >= length ? length - 1 : last;
+		int64_t number = SortedSetTypeRange(zset, start, stop, reverse, RangeCallback, NULL);
+		assert(number == (first > last ? 0 : last - first + 1));
+		for(int64_t index = 0; index < number; ++index)
+		{
+			int64_t rank = reverse ? length - 1 - first - index : first + index;
+			assert(strcmp(g_range_members[length + index], g_range_members[rank]) == 0);
+		}
+		g_range_number = CAST(int)length;
+	}
+
+	// Scores, with infinite and exclusive bounds, offsets and counts.
+	double bounds[] = {-INFINITY, INFINITY, -30, -5, 0, 0.5, 3, 24};
+	for(int round = 0; round < 500; ++round)
+	{
+		SkipListRange range = {bounds[rand() % 8], bounds[rand() % 8], rand() % 2, rand() % 2};
+		CheckRangeBy(zset, &range, NULL, rand() % 2, rand() % 4 == 0 ? rand() % 20 : 0,
+		             rand() % 2 ? -1 : rand() % 20);
+	}
+	DecreaseReferenceCount(zset);
+
+	// Lexical order, which needs equal scores.
+	zset = CreateSortedSetObject();
+	if(encoding == NOSQL_ENCODING_SKIP_LIST)
+	{
+		SortedSetTypeConvert(zset, NOSQL_ENCODING_SKIP_LIST);
+	}
+	for(int index = 0; index < 100; ++index)
+	{
+		SortedSetTypeAdd(zset, member, snprintf(member, sizeof(member), "%d", index * 7), 1);
+	}
+	g_range_number = 0;
+	SortedSetTypeRange(zset, 0, -1, 0, RangeCallback, NULL);
+	for(int round = 0; round < 500; ++round)
+	{
+		// The bounds are integer encoded, and compare as their decimal forms.
+		char min[32], max[32];
+		NosqlObject *min_object = TryObjectEncoding(CreateStringObject(min,
+		                          snprintf(min, sizeof(min), "%d", rand() % 700)));
+		NosqlObject *max_object = TryObjectEncoding(CreateStringObject(max,
+		                          snprintf(max, sizeof(max), "%d", rand() % 700)));
+		assert(min_object->encoding_ == NOSQL_ENCODING_INT);
+		SkipListLexRange range = {rand() % 4 == 0 ? NULL : min_object,
+		                          rand() % 4 == 0 ? NULL : max_object, rand() % 2, rand() % 2
+		                         };
+		CheckRangeBy(zset, NULL, &range, rand() % 2, rand() % 4 == 0 ? rand() % 20 : 0,
+		             rand() % 2 ? -1 : rand() % 20);
+		DecreaseReferenceCount(min_object);
+		DecreaseReferenceCount(max_object);
+	}
+	DecreaseReferenceCount(zset);
+}
+
+void TestSortedSetDeleteRanges(int encoding)
+{
+	char member[32];
+	NosqlObject *zset = CreateSortedSetObject();
+	if(encoding == NOSQL_ENCODING_SKIP_LIST)
+	{
+		SortedSetTypeConvert(zset, NOSQL_ENCODING_SKIP_LIST);
+	}
+	for(int index = 0; index < 100; ++index)
+	{
+		SortedSetTypeAdd(zset, member, snprintf(member, sizeof(member), "%d", index), index / 2);
+	}
+	// Scores 10 to 19 are members 20 to 39.
+	SkipListRange range = {10, 20, 0, 1};
+	assert(SortedSetTypeDeleteRangeByScore(zset, &range) == 20);
+	assert(SortedSetTypeDeleteRangeByScore(zset, &range) == 0);
+	assert(SortedSetTypeLength(zset) == 80 && SortedSetTypeRank(zset, "40", 2) == 20);
+	assert(!SortedSetTypeScore(zset, "39", 2, &range.min_));
+	SkipListRange all = {-INFINITY, INFINITY, 0, 0};
+	// Ranks are counted as in SortedSetTypeRange(): the last 5 and then the first 10.
+	assert(SortedSetTypeDeleteRangeByRank(zset, -5, -1) == 5);
+	assert(SortedSetTypeDeleteRangeByRank(zset, -1000, 9) == 10);
+	assert(SortedSetTypeDeleteRangeByRank(zset, 100, 200) == 0);
+	assert(SortedSetTypeLength(zset) == 65 && SortedSetTypeRank(zset, "10", 2) == 0);
+	assert(!SortedSetTypeScore(zset, "95", 2, &range.min_) && SortedSetTypeRank(zset, "94", 2) == 64);
+	// Removed members can be added again.
+	assert(SortedSetTypeAdd(zset, "95", 2, 0) && SortedSetTypeRank(zset, "95", 2) == 0);
+	assert(SortedSetTypeDeleteRangeByScore(zset, &all) == 66 && SortedSetTypeLength(zset) == 0);
+	assert(zset->encoding_ == CAST(unsigned)encoding);
+	DecreaseReferenceCount(zset);
+}
+
+void TestReferenceCount()
+{
+	NosqlObject *string = CreateStringObject("value", 5);
+	assert(string->type_ == NOSQL_STRING && string->encoding_ == NOSQL_ENCODING_EMBEDDED_STRING);
+	assert(string->reference_count_ == 1 && get_length(CAST(String)string->ptr_) == 5);
+	IncreaseReferenceCount(string);
+	DecreaseReferenceCount(string);
+	assert(string->reference_count_ == 1);
+	DecreaseReferenceCount(string);
+	assert(strcmp(ObjectEncodingName(NOSQL_ENCODING_LIST_PACK), "listpack") == 0);
+	assert(strcmp(ObjectEncodingName(NOSQL_ENCODING_HASH_TABLE), "hashtable") == 0);
+	assert(strcmp(ObjectEncodingName(NOSQL_ENCODING_INT_SET), "intset") == 0);
+	assert(strcmp(ObjectEncodingName(NOSQL_ENCODING_SKIP_LIST), "skiplist") == 0);
+	assert(strcmp(ObjectEncodingName(NOSQL_ENCODING_INT), "int") == 0);
+	assert(strcmp(ObjectEncodingName(NOSQL_ENCODING_EMBEDDED_STRING), "embstr") == 0);
+}
+
+// Return whether the string object holds the string.
+int StringObjectIs(const NosqlObject *object, const char *string)
+{
+	char buffer[SDS_INT64_STRING_SIZE];
+	SDSView view = StringObjectView(object, buffer);
+	return view.length_ == CAST(int64_t)strlen(string) &&
+	       memcmp(view.data_, string, strlen(string)) == 0;
+}
+
+void TestStringEncodings()
+{
+	char string[64];
+	memset(string, 'a', sizeof(string));
+	// Embedded up to the limit, raw beyond it, with the same content.
+	NosqlObject *embedded = CreateStringObject(string, NOSQL_EMBEDDED_STRING_SIZE_LIMIT);
+	NosqlObject *raw = CreateStringObject(string, NOSQL_EMBEDDED_STRING_SIZE_LIMIT + 1);
+	assert(embedded->encoding_ == NOSQL_ENCODING_EMBEDDED_STRING);
+	assert(raw->encoding_ == NOSQL_ENCODING_RAW);
+	assert(CAST(char*)embedded->ptr_ > CAST(char*)embedded &&
+	       CAST(char*)embedded->ptr_ < CAST(char*)(embedded + 1) + 4);
+	assert(get_length(CAST(String)embedded->ptr_) == NOSQL_EMBEDDED_STRING_SIZE_LIMIT);
+	assert(memcmp(embedded->ptr_, string, NOSQL_EMBEDDED_STRING_SIZE_LIMIT) == 0);
+	assert(CompareStringObjects(embedded, raw) < 0 && CompareStringObjects(raw, embedded) > 0);
+	// A long string stays raw, a short one is embedded.
+	raw = TryObjectEncoding(raw);
+	assert(raw->encoding_ == NOSQL_ENCODING_RAW);
+	NosqlObject *object = TryObjectEncoding(CreateRawStringObject("short", 5));
+	assert(object->encoding_ == NOSQL_ENCODING_EMBEDDED_STRING && StringObjectIs(object, "short"));
+	DecreaseReferenceCount(object);
+	DecreaseReferenceCount(embedded);
+	DecreaseReferenceCount(raw);
+
+	// Integers are in ptr_ and read back in their decimal forms.
+	int64_t values[] = {0, -1, 7, 10000, INT64_MAX, INT64_MIN};
+	for(int index = 0; index < 6; ++index)
+	{
+		int length = snprintf(string, sizeof(string), "%" PRId64, values[index]);
+		object = CreateStringObjectFromInt64(values[index]);
+		assert(object->encoding_ == NOSQL_ENCODING_INT && StringObjectIs(object, string));
+		assert(CAST(intptr_t)object->ptr_ == values[index]);
+		// Raw and embedded strings of integers are converted.
+		NosqlObject *converted = TryObjectEncoding(CreateRawStringObject(string, length));
+		assert(converted->encoding_ == NOSQL_ENCODING_INT);
+		assert(CompareStringObjects(object, converted) == 0);
+		DecreaseReferenceCount(converted);
+		converted = TryObjectEncoding(CreateStringObject(string, length));
+		assert(converted->encoding_ == NOSQL_ENCODING_INT);
+		assert(CompareStringObjects(converted, object) == 0);
+		DecreaseReferenceCount(converted);
+		DecreaseReferenceCount(object);
+	}
+	// Only canonical integers are converted, so that the string reads back the same.
+	const char *not_integers[] = {"007", "+1", " 1", "1.0", "-0", "", "9223372036854775808"};
+	for(int index = 0; index < 7; ++index)
+	{
+		object = TryObjectEncoding(CreateStringObject(not_integers[index],
+		                           CAST(int64_t)strlen(not_integers[index])));
+		assert(object->encoding_ == NOSQL_ENCODING_EMBEDDED_STRING);
+		DecreaseReferenceCount(object);
+	}
+	// Shared objects keep their encoding.
+	object = CreateStringObject("12", 2);
+	IncreaseReferenceCount(object);
+	assert(TryObjectEncoding(object) == object);
+	assert(object->encoding_ == NOSQL_ENCODING_EMBEDDED_STRING);
+	DecreaseReferenceCount(object);
+	DecreaseReferenceCount(object);
+
+	// Integers compare as strings: "10" < "9" < "a".
+	NosqlObject *ten = CreateStringObjectFromInt64(10), *nine = CreateStringObjectFromInt64(9);
+	NosqlObject *letter = CreateStringObject("a", 1), *nine_string = CreateStringObject("9", 1);
+	assert(CompareStringObjects(ten, nine) < 0 && CompareStringObjects(nine, ten) > 0);
+	assert(CompareStringObjects(nine, letter) < 0 && CompareStringObjects(letter, ten) > 0);
+	assert(CompareStringObjects(nine, nine_string) == 0);
+	assert(CompareStringObjects(nine_string, ten) > 0);
+	DecreaseReferenceCount(ten);
+	DecreaseReferenceCount(nine);
+	DecreaseReferenceCount(letter);
+	DecreaseReferenceCount(nine_string);
+}
+
+void TestSharedIntegers()
+{
+	int64_t memory = UsedMemory();
+	NosqlObject *zero = CreateStringObjectFromInt64(0), *last = CreateStringObjectFromInt64(9999);
+	assert(zero == CreateStringObjectFromInt64(0) && last == CreateStringObjectFromInt64(9999));
+	assert(zero->reference_count_ == NOSQL_SHARED_REFERENCE_COUNT && StringObjectIs(last, "9999"));
+	assert(UsedMemory() == memory);
+	// Reference counting leaves them as is.
+	IncreaseReferenceCount(zero);
+	DecreaseReferenceCount(zero);
+	DecreaseReferenceCount(zero);
+	assert(zero->reference_count_ == NOSQL_SHARED_REFERENCE_COUNT && StringObjectIs(zero, "0"));
+	// Raw and embedded strings are replaced by them.
+	assert(TryObjectEncoding(CreateRawStringObject("9999", 4)) == last);
+	assert(TryObjectEncoding(CreateStringObject("0", 1)) == zero && UsedMemory() == memory);
+	// Out of range integers aren't shared.
+	NosqlObject *negative = CreateStringObjectFromInt64(-1);
+	NosqlObject *large = CreateStringObjectFromInt64(10000);
+	assert(negative->reference_count_ == 1 && large->reference_count_ == 1);
+	DecreaseReferenceCount(negative);
+	DecreaseReferenceCount(large);
+	// Nor any integer when every key needs its own LRU.
+	g_no_shared_integers = 1;
+	NosqlObject *object = CreateStringObjectFromInt64(0);
+	assert(object != zero && object->reference_count_ == 1 && StringObjectIs(object, "0"));
+	DecreaseReferenceCount(object);
+	object = TryObjectEncoding(CreateRawStringObject("9999", 4));
+	assert(object != last && object->encoding_ == NOSQL_ENCODING_INT);
+	assert(object->reference_count_ == 1);
+	DecreaseReferenceCount(object);
+	g_no_shared_integers = 0;
+	assert(UsedMemory() == memory);
+}
+
+void *CreateSharedIntegers(void *objects)
+{
+	for(int64_t value = 0; value < NOSQL_SHARED_INTEGERS; ++value)
+	{
+		(CAST(NosqlObject**)objects)[value] = CreateStringObjectFromInt64(value);
+	}
+	return NULL;
+}
+
+// Threads that create the first shared integers at the same time get the same, complete
+// objects. Must run before any other test creates a shared integer.
+void TestSharedIntegersThreads()
+{
+	static NosqlObject *objects[2][NOSQL_SHARED_INTEGERS];
+	pthread_t threads[2];
+	for(int index = 0; index < 2; ++index)
+	{
+		pthread_create(&threads[index], NULL, CreateSharedIntegers, objects[index]);
+	}
+	for(int index = 0; index < 2; ++index)
+	{
+		pthread_join(threads[index], NULL);
+	}
+	for(int64_t value = 0; value < NOSQL_SHARED_INTEGERS; ++value)
+	{
+		assert(objects[0][value] == objects[1][value]);
+		assert(objects[0][value]->reference_count_ == NOSQL_SHARED_REFERENCE_COUNT);
+		assert(CAST(int64_t)CAST(intptr_t)objects[0][value]->ptr_ == value);
+	}
+}
+
+int main(void)
+{
+	TestSharedIntegersThreads();
+	TestHash(NOSQL_ENCODING_LIST_PACK);
+	TestHash(NOSQL_ENCODING_HASH_TABLE);
+	TestHashConversion();
+	TestList();
+	TestSet();
+	TestSetOperations();
+	TestSortedSet(NOSQL_ENCODING_LIST_PACK);
+	TestSortedSet(NOSQL_ENCODING_SKIP_LIST);
+	TestSortedSetConversion();
+	TestSortedSetRanges(NOSQL_ENCODING_LIST_PACK);
+	TestSortedSetRanges(NOSQL_ENCODING_SKIP_LIST);
+	TestSortedSetDeleteRanges(NOSQL_ENCODING_LIST_PACK);
+	TestSortedSetDeleteRanges(NOSQL_ENCODING_SKIP_LIST);
+	TestReferenceCount();
+	TestStringEncodings();
+	TestSharedIntegers();
+	assert(UsedMemory() == 0);
+
+	printf("All passed! Come on!\n");
+	return 0;
+}
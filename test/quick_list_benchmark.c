@@ -0,0 +1,133 @@
+// Lists of ENTRY_NUMBER short values, like queues of ids and log lines: the memory per entry
+// and the throughput of push, iterate and pop for the List of SDS strings against quicklists
+// of 8KB nodes, uncompressed and with all but the end nodes compressed. The best of 3 runs
+// is reported in millions of operations per second.
+#include <stdio.h> // printf(), snprintf()
+#include <stdint.h>
+#include <time.h> // clock()
+
+#include <double_linked_list.h>
+#include <memory.h>
+#include <quick_list.h>
+#include <simple_dynamic_string.h>
+
+#define ENTRY_NUMBER 1000000
+#define BENCHMARK_RUNS 3
+
+volatile int64_t sink = 0;
+char values[ENTRY_NUMBER][32];
+int lengths[ENTRY_NUMBER];
+
+typedef struct Result
+{
+	double bytes_; // Memory per entry.
+	double push_, iterate_, pop_; // Seconds.
+} Result;
+
+double Seconds(clock_t start)
+{
+	return CAST(double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+void *FreeSDS(void *value)
+{
+	SDSFree(value);
+	return NULL;
+}
+
+void RunList(Result *result)
+{
+	int64_t base = UsedMemory();
+	clock_t start = clock();
+	List *list = ListCreate();
+	ListSetFreeMethod(list, FreeSDS);
+	for(int index = 0; index < ENTRY_NUMBER; ++index)
+	{
+		ListAddTailNode(list, SDSNewLength(values[index], lengths[index]));
+	}
+	result->push_ = Seconds(start);
+	result->bytes_ = CAST(double)(UsedMemory() - base) / ENTRY_NUMBER;
+
+	start = clock();
+	ListIterator *iterator = ListGetIterator(list, FROM_HEAD_TO_TAIL);
+	ListNode *node;
+	while((node = ListNextIterateNode(iterator)) != NULL)
+	{
+		sink += get_length(CAST(String)ListNodeValue(node));
+	}
+	ListFreeIterator(iterator);
+	result->iterate_ = Seconds(start);
+
+	start = clock();
+	while(ListLength(list) != 0)
+	{
+		node = ListHeadNode(list);
+		sink += get_length(CAST(String)ListNodeValue(node));
+		ListDeleteNode(list, node);
+	}
+	ListFree(list);
+	result->pop_ = Seconds(start);
+}
+
+void RunQuickList(Result *result, int compress_depth)
+{
+	int64_t base = UsedMemory();
+	clock_t start = clock();
+	QuickList *list = QuickListCreate(QUICK_LIST_DEFAULT_FILL, compress_depth);
+	for(int index = 0; index < ENTRY_NUMBER; ++index)
+	{
+		QuickListPushTail(list, values[index], lengths[index]);
+	}
+	result->push_ = Seconds(start);
+	result->bytes_ = CAST(double)(UsedMemory() - base) / ENTRY_NUMBER;
+
+	start = clock();
+	QuickListIterator *iterator = QuickListGetIterator(list, QUICK_LIST_HEAD);
+	QuickListEntry entry;
+	while(QuickListNext(iterator, &entry))
+	{
+		sink += entry.value_.string_ != NULL ? entry.value_.length_ : entry.value_.integer_;
+	}
+	QuickListFreeIterator(iterator);
+	result->iterate_ = Seconds(start);
+
+	start = clock();
+	String value;
+	while((value = QuickListPop(list, QUICK_LIST_HEAD)) != NULL)
+	{
+		sink += get_length(value);
+		SDSFree(value);
+	}
+	QuickListFree(list);
+	result->pop_ = Seconds(start);
+}
+
+void Benchmark(const char *name, int compress_depth)
+{
+	Result best = {0, 1e9, 1e9, 1e9}, result;
+	for(int run = 0; run < BENCHMARK_RUNS; ++run)
+	{
+		compress_depth < 0 ? RunList(&result) : RunQuickList(&result, compress_depth);
+		best.bytes_ = result.bytes_;
+		best.push_ = result.push_ < best.push_ ? result.push_ : best.push_;
+		best.iterate_ = result.iterate_ < best.iterate_ ? result.iterate_ : best.iterate_;
+		best.pop_ = result.pop_ < best.pop_ ? result.pop_ : best.pop_;
+	}
+	printf("%-24s %6.1f bytes/entry, push %6.2f Mops/s, iterate %7.2f Mops/s, pop %6.2f Mops/s\n",
+	       name, best.bytes_, ENTRY_NUMBER / best.push_ / 1e6, ENTRY_NUMBER / best.iterate_ / 1e6,
+	       ENTRY_NUMBER / best.pop_ / 1e6);
+}
+
+int main(void)
+{
+	// Half ids that are stored as integers, half log lines.
+	for(int index = 0; index < ENTRY_NUMBER; ++index)
+	{
+		lengths[index] = index % 2 == 0 ? snprintf(values[index], 32, "%d", 1000000 + index) :
+		                 snprintf(values[index], 32, "GET /item/%d 200", index % 5000);
+	}
+	Benchmark("List", -1);
+	Benchmark("quicklist", 0);
+	Benchmark("quicklist compressed", 1);
+	return 0;
+}
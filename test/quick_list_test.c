@@ -0,0 +1,321 @@
+#include <stdio.h> // printf(), snprintf()
+#include <stdlib.h> // rand()
+#include <string.h> // memcmp(), memmove()
+#include <assert.h>
+
+#include <lzf.h>
+#include <memory.h>
+#include <quick_list.h>
+
+#define MAX_NUMBER 3000
+
+// The expected content of the quicklist.
+String g_model[MAX_NUMBER];
+int g_number = 0;
+
+int EntryEqual(const ListPackEntry *value, const String string)
+{
+	if(value->string_ == NULL)
+	{
+		int64_t integer;
+		return SDSToLongLongStrict(string, &integer) && integer == value->integer_;
+	}
+	return value->length_ == get_length(string) &&
+	       memcmp(value->string_, string, CAST(size_t)value->length_) == 0;
+}
+
+// Check the counts and the sizes of all nodes, and that exactly the nodes that are farther
+// than compress_depth_ from both ends are compressed, unless LZF can't shrink them.
+void CheckNodes(QuickList *list)
+{
+	int64_t count = 0, node_number = 0;
+	static uint8_t buffer[1 << 20];
+	for(QuickListNode *node = list->head_; node != NULL; node = node->next_, ++node_number)
+	{
+		assert(node->count_ > 0 && (node->next_ == NULL || node->next_->previous_ == node));
+		assert(node->size_ <= list->fill_ || node->count_ == 1);
+		uint8_t *list_pack = node->entry_;
+		if(node->compressed_)
+		{
+			QuickListLZF *lzf = CAST(QuickListLZF*)node->entry_;
+			assert(LZFDecompress(lzf->data_, lzf->size_, buffer, sizeof(buffer)) == node->size_);
+			list_pack = buffer;
+		}
+		assert(ListPackBytes(list_pack) == node->size_ && ListPackLength(list_pack) == node->count_);
+		int64_t from_tail = QuickListNodeNumber(list) - 1 - node_number;
+		int in_depth = node_number < list->compress_depth_ || from_tail < list->compress_depth_;
+		assert(!node->recompress_);
+		if(list->compress_depth_ == 0 || in_depth)
+		{
+			assert(!node->compressed_);
+		}
+		else
+		{
+			assert(node->compressed_ || node->incompressible_ ||
+			       node->size_ < QUICK_LIST_MIN_COMPRESS_BYTES);
+		}
+		count += node->count_;
+	}
+	assert(count == QuickListLength(list) && node_number == QuickListNodeNumber(list));
+}
+
+// Check the quicklist against the model both ways.
+void Check(QuickList *list)
+{
+	CheckNodes(list);
+	assert(QuickListLength(list) == g_number);
+	QuickListIterator *iterator = QuickListGetIterator(list, QUICK_LIST_HEAD);
+	QuickListEntry entry;
+	for(int index = 0; index < g_number; ++index)
+	{
+		assert(QuickListNext(iterator, &entry) && EntryEqual(&entry.value_, g_model[index]));
+	}
+	assert(!QuickListNext(iterator, &entry));
+	QuickListFreeIterator(iterator);
+	iterator = QuickListGetIterator(list, QUICK_LIST_TAIL);
+	for(int index = g_number - 1; index >= 0; --index)
+	{
+		assert(QuickListNext(iterator, &entry) && EntryEqual(&entry.value_, g_model[index]));
+	}
+	assert(!QuickListNext(iterator, &entry));
+	QuickListFreeIterator(iterator);
+	CheckNodes(list);
+}
+
+String RandomString()
+{
+	char buffer[600];
+	int length;
+	switch(rand() % 4)
+	{
+	case 0:
+		length = snprintf(buffer, sizeof(buffer), "%d", rand() % 100000 - 50000);
+		break;
+	case 1: // Compressible.
+		length = snprintf(buffer, sizeof(buffer), "item:%08d:payload:payload:payload", rand() % 1000);
+		break;
+	case 2: // Incompressible.
+		length = rand() % 40;
+		for(int index = 0; index < length; ++index)
+		{
+			buffer[index] = CAST(char)rand();
+		}
+		break;
+	default: // Sometimes larger than a node.
+		length = rand() % 600;
+		memset(buffer, 'a' + rand() % 26, CAST(size_t)length);
+		break;
+	}
+	return SDSNewLength(buffer, length);
+}
+
+void ModelInsert(int index, String string)
+{
+	memmove(g_model + index + 1, g_model + index, sizeof(String) * CAST(size_t)(g_number - index));
+	g_model[index] = string;
+	++g_number;
+}
+
+void ModelDelete(int index, int count)
+{
+	for(int current = index; current < index + count; ++current)
+	{
+		SDSFree(g_model[current]);
+	}
+	memmove(g_model + index, g_model + index + count,
+	        sizeof(String) * CAST(size_t)(g_number - index - count));
+	g_number -= count;
+}
+
+typedef struct RangeState
+{
+	int next_; // The model index of the next entry.
+	int number_;
+} RangeState;
+
+void CheckRangeEntry(void *argument, const QuickListEntry *entry)
+{
+	RangeState *state = argument;
+	assert(EntryEqual(&entry->value_, g_model[state->next_++]));
+	++state->number_;
+}
+
+void TestRandomOperations(int64_t fill, int compress_depth)
+{
+	QuickList *list = QuickListCreate(fill, compress_depth);
+	for(int round = 0; round < 30000; ++round)
+	{
+		int operation = rand() % 20, index = g_number == 0 ? 0 : rand() % g_number;
+		if(operation < 8 && g_number < MAX_NUMBER) // Push.
+		{
+			String string = RandomString();
+			int where = rand() % 2;
+			QuickListPush(list, string, get_length(string), where);
+			ModelInsert(where == QUICK_LIST_HEAD ? 0 : g_number, string);
+		}
+		else if(operation < 10) // Pop.
+		{
+			int where = rand() % 2;
+			String string = QuickListPop(list, where);
+			if(g_number == 0)
+			{
+				assert(string == NULL);
+				continue;
+			}
+			int model_index = where == QUICK_LIST_HEAD ? 0 : g_number - 1;
+			ListPackEntry value = {string, get_length(string), 0};
+			assert(EntryEqual(&value, g_model[model_index]));
+			SDSFree(string);
+			ModelDelete(model_index, 1);
+		}
+		else if(operation < 12) // Index.
+		{
+			String string = QuickListIndex(list, rand() % 2 ? index : index - g_number);
+			if(g_number == 0)
+			{
+				assert(string == NULL);
+				continue;
+			}
+			ListPackEntry value = {string, get_length(string), 0};
+			assert(EntryEqual(&value, g_model[index]));
+			SDSFree(string);
+			assert(QuickListIndex(list, g_number) == NULL && QuickListIndex(list, -g_number - 1) == NULL);
+		}
+		else if(operation < 15 && g_number < MAX_NUMBER) // Insert.
+		{
+			String string = RandomString();
+			int after = rand() % 2;
+			int inserted = QuickListInsert(list, index, string, get_length(string), after);
+			assert(inserted == (g_number != 0));
+			if(inserted)
+			{
+				ModelInsert(index + after, string);
+			}
+			else
+			{
+				SDSFree(string);
+			}
+		}
+		else if(operation < 16 && g_number > 0) // Replace.
+		{
+			String string = RandomString();
+			assert(QuickListReplaceAtIndex(list, index - g_number, string, get_length(string)));
+			SDSFree(g_model[index]);
+			g_model[index] = string;
+		}
+		else if(operation < 17) // Delete a range.
+		{
+			int count = rand() % 50;
+			int64_t deleted = QuickListDeleteRange(list, index, count);
+			count = g_number == 0 ? 0 : count < g_number - index ? count : g_number - index;
+			assert(deleted == count);
+			ModelDelete(index, count);
+		}
+		else if(operation < 18) // Range.
+		{
+			int stop = index + rand() % 100;
+			RangeState state = {index, 0};
+			int64_t number = QuickListRange(list, index - g_number, stop, CheckRangeEntry, &state);
+			stop = stop < g_number ? stop : g_number - 1;
+			assert(number == (g_number == 0 ? 0 : stop - index + 1) && state.number_ == number);
+		}
+		else if(operation < 19 && g_number > 0) // Delete the integers while iterating.
+		{
+			int direction = rand() % 2, count = 0;
+			int model_index = index;
+			QuickListIterator *iterator = QuickListGetIteratorAtIndex(list, direction, model_index);
+			assert(QuickListGetIteratorAtIndex(list, direction, g_number) == NULL);
+			QuickListEntry entry;
+			while(count++ < 200 && QuickListNext(iterator, &entry))
+			{
+				assert(EntryEqual(&entry.value_, g_model[model_index]));
+				if(entry.value_.string_ == NULL)
+				{
+					QuickListDeleteEntry(iterator, &entry);
+					ModelDelete(model_index, 1);
+					model_index -= direction == QUICK_LIST_HEAD ? 0 : 1;
+				}
+				else
+				{
+					model_index += direction == QUICK_LIST_HEAD ? 1 : -1;
+				}
+			}
+			QuickListFreeIterator(iterator);
+		}
+		if(round % 499 == 0)
+		{
+			Check(list);
+		}
+	}
+	Check(list);
+	QuickListFree(list);
+	ModelDelete(0, g_number);
+}
+
+void TestBasic()
+{
+	QuickList *list = QuickListCreate(0, 0);
+	assert(list->fill_ == QUICK_LIST_DEFAULT_FILL && QuickListLength(list) == 0);
+	assert(QuickListPop(list, QUICK_LIST_HEAD) == NULL && QuickListIndex(list, 0) == NULL);
+	assert(!QuickListInsert(list, 0, "a", 1, 0) && !QuickListReplaceAtIndex(list, 0, "a", 1));
+	QuickListPushTail(list, "b", 1);
+	QuickListPushHead(list, "a", 1);
+	QuickListPushTail(list, "100", 3);
+	assert(QuickListLength(list) == 3 && QuickListNodeNumber(list) == 1);
+	String string = QuickListIndex(list, -1);
+	assert(get_length(string) == 3 && memcmp(string, "100", 3) == 0);
+	SDSFree(string);
+	assert(QuickListInsert(list, 1, "x", 1, 1));
+	string = QuickListPop(list, QUICK_LIST_HEAD);
+	assert(get_length(string) == 1 && string[0] == 'a');
+	SDSFree(string);
+	string = QuickListIndex(list, 1);
+	assert(get_length(string) == 1 && string[0] == 'x');
+	SDSFree(string);
+	assert(QuickListDeleteRange(list, -2, 10) == 2 && QuickListLength(list) == 1);
+	QuickListFree(list);
+
+	// A long list with the interior compressed.
+	list = QuickListCreate(512, 1);
+	char buffer[64];
+	for(int index = 0; index < 10000; ++index)
+	{
+		int length = snprintf(buffer, sizeof(buffer), "value:%d:value:value", index);
+		QuickListPushTail(list, buffer, length);
+	}
+	int compressed = 0;
+	for(QuickListNode *node = list->head_; node != NULL; node = node->next_)
+	{
+		compressed += node->compressed_;
+	}
+	assert(compressed == QuickListNodeNumber(list) - 2);
+	string = QuickListIndex(list, 5000);
+	assert(memcmp(string, "value:5000:value:value", 22) == 0);
+	SDSFree(string);
+	for(int index = 9999; index >= 0; --index)
+	{
+		string = QuickListPop(list, QUICK_LIST_TAIL);
+		int length = snprintf(buffer, sizeof(buffer), "value:%d:value:value", index);
+		assert(get_length(string) == length && memcmp(string, buffer, CAST(size_t)length) == 0);
+		SDSFree(string);
+	}
+	assert(QuickListLength(list) == 0 && QuickListNodeNumber(list) == 0 && list->head_ == NULL);
+	QuickListFree(list);
+}
+
+int main(void)
+{
+	TestBasic();
+	int64_t fills[] = {64, 256, 8192};
+	for(int fill = 0; fill < 3; ++fill)
+	{
+		for(int depth = 0; depth <= 2; ++depth)
+		{
+			TestRandomOperations(fills[fill], depth);
+		}
+	}
+	assert(UsedMemory() == 0);
+
+	printf("All passed! Come on!\n");
+	return 0;
+}
@@ -0,0 +1,35 @@
+// Memory used by a million short SDS strings, which are typical keys, and the part of it
+// that is overhead: the SDS header, the null byte, the Malloc prefix and the rounding of
+// the allocator.
+#include <stdio.h> // printf(), snprintf()
+#include <stdint.h>
+
+#include <memory.h>
+#include <simple_dynamic_string.h>
+
+#define STRING_NUMBER 1000000
+
+int main(void)
+{
+	int lengths[] = {8, 16, 24, 31, 48, 200, 300};
+	char buffer[512];
+	for(int index = 0; index < CAST(int)(sizeof(lengths) / sizeof(lengths[0])); ++index)
+	{
+		String *strings = Malloc(STRING_NUMBER * CAST(int64_t)sizeof(String));
+		int64_t base = UsedMemory();
+		for(int number = 0; number < STRING_NUMBER; ++number)
+		{
+			snprintf(buffer, sizeof(buffer), "%0*d", lengths[index], number);
+			strings[number] = SDSNewLength(buffer, lengths[index]);
+		}
+		double bytes = CAST(double)(UsedMemory() - base) / STRING_NUMBER;
+		printf("%3d bytes strings: %5.1f MB per million, %5.1f bytes overhead per string(%4.1f%%)\n",
+		       lengths[index], bytes, bytes - lengths[index], (bytes - lengths[index]) / bytes * 100);
+		for(int number = 0; number < STRING_NUMBER; ++number)
+		{
+			SDSFree(strings[number]);
+		}
+		Free(strings);
+	}
+	return 0;
+}
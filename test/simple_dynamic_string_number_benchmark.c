@@ -0,0 +1,109 @@
+// Number to string conversions of SDS against stdio: formatting counters and doubles,
+// parsing counters, and formatting a reply with SDSCatFmt(). The best of 3 runs of
+// NUMBER_COUNT conversions is reported in millions of conversions per second.
+#include <stdio.h> // printf(), snprintf()
+#include <stdint.h>
+#include <stdlib.h> // rand(), strtoll()
+#include <string.h> // strlen()
+#include <time.h> // clock()
+
+#include <memory.h>
+#include <simple_dynamic_string.h>
+
+#define NUMBER_COUNT 1000000
+#define BENCHMARK_RUNS 3
+
+volatile int64_t sink = 0;
+int64_t integers[NUMBER_COUNT];
+double doubles[NUMBER_COUNT];
+String strings[NUMBER_COUNT];
+
+enum
+{
+	CASE_FROM_LONG_LONG, CASE_SNPRINTF_LONG_LONG, CASE_FROM_DOUBLE, CASE_SNPRINTF_DOUBLE,
+	CASE_TO_LONG_LONG, CASE_STRTOLL, CASE_CAT_FMT, CASE_SNPRINTF_FORMAT, CASE_NUMBER
+};
+
+const char *case_names[CASE_NUMBER] =
+{
+	"SDSFromLongLong()", "snprintf(\"%lld\")", "SDSFromDouble()", "snprintf(\"%.17g\")",
+	"SDSToLongLongStrict()", "strtoll()", "SDSCatFmt()", "snprintf() + SDSAppend()"
+};
+
+void Run(int benchmark_case, int64_t index)
+{
+	char buffer[64];
+	String string = NULL;
+	char *end = NULL;
+	int64_t value = 0;
+	switch(benchmark_case)
+	{
+	case CASE_FROM_LONG_LONG:
+		string = SDSFromLongLong(integers[index]);
+		break;
+	case CASE_SNPRINTF_LONG_LONG:
+		string = SDSNewLength(buffer, snprintf(buffer, sizeof(buffer), "%lld",
+		                                       CAST(long long)integers[index]));
+		break;
+	case CASE_FROM_DOUBLE:
+		string = SDSFromDouble(doubles[index]);
+		break;
+	case CASE_SNPRINTF_DOUBLE:
+		string = SDSNewLength(buffer, snprintf(buffer, sizeof(buffer), "%.17g", doubles[index]));
+		break;
+	case CASE_TO_LONG_LONG:
+		sink += SDSToLongLongStrict(strings[index], &value) ? value : 0;
+		break;
+	case CASE_STRTOLL:
+		value = strtoll(strings[index], &end, 10);
+		sink += *end == '\0' ? value : 0;
+		break;
+	case CASE_CAT_FMT:
+		string = SDSCatFmt(SDSNewEmpty(), "counter:%I hits %i", integers[index], 42);
+		break;
+	default:
+		snprintf(buffer, sizeof(buffer), "counter:%lld hits %d", CAST(long long)integers[index], 42);
+		string = SDSAppend(SDSNewEmpty(), buffer);
+		break;
+	}
+	if(string != NULL)
+	{
+		sink += get_length(string);
+		SDSFree(string);
+	}
+}
+
+int main(void)
+{
+	// Counters are mostly small, with some large ones.
+	srand(1);
+	for(int64_t index = 0; index < NUMBER_COUNT; ++index)
+	{
+		int64_t large = (CAST(int64_t)rand() << 31) ^ rand();
+		integers[index] = index % 4 == 0 ? large : rand() % 100000;
+		doubles[index] = index % 2 == 0 ? CAST(double)(rand() % 100000) / 100 :
+		                 CAST(double)rand() / RAND_MAX * 1e6;
+		strings[index] = SDSFromLongLong(integers[index]);
+	}
+	for(int benchmark_case = 0; benchmark_case < CASE_NUMBER; ++benchmark_case)
+	{
+		double best = 0;
+		for(int run = 0; run < BENCHMARK_RUNS; ++run)
+		{
+			clock_t start = clock();
+			for(int64_t index = 0; index < NUMBER_COUNT; ++index)
+			{
+				Run(benchmark_case, index);
+			}
+			double seconds = CAST(double)(clock() - start) / CLOCKS_PER_SEC;
+			double rate = NUMBER_COUNT / (seconds > 0 ? seconds : 1e-9) / 1e6;
+			best = rate > best ? rate : best;
+		}
+		printf("%-26s %6.2f Mops/s\n", case_names[benchmark_case], best);
+	}
+	for(int64_t index = 0; index < NUMBER_COUNT; ++index)
+	{
+		SDSFree(strings[index]);
+	}
+	return 0;
+}
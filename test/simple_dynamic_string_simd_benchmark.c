@@ -0,0 +1,135 @@
+// Throughput of the string operations with scanning kernels, for every SIMD level
+// supported by the CPU and strings from 8 bytes to 1MB. Every measurement processes
+// about 64MB and the best of 3 runs is reported, in GB/s of the string length.
+#include <stdio.h> // printf()
+#include <stdint.h>
+#include <string.h> // memset()
+#include <time.h> // clock()
+
+#include <memory.h>
+#include <simple_dynamic_string.h>
+
+#define BENCHMARK_BYTES (64 * 1024 * 1024)
+#define BENCHMARK_RUNS 3
+
+enum
+{
+	OPERATION_TRIM, // Trim a string whose both halves are spaces and tabs, then restore it.
+	OPERATION_CASE, // SDSToLower() and SDSToUpper() in turn.
+	OPERATION_MAP, // SDSMapChars() with 3 bytes and back.
+	OPERATION_COMPARE, // SDSCompareNoCase() of the lower and upper case strings.
+	OPERATION_FIND, // SDSFind() of a needle that doesn't occur.
+	OPERATION_SPLIT, // SDSSplitLength() into tokens of 63 bytes.
+	OPERATION_NUMBER
+};
+
+const char *operation_names[OPERATION_NUMBER] =
+{
+	"trim", "to lower/upper", "map chars", "compare no case", "find", "split"
+};
+
+volatile int64_t sink = 0;
+
+void Run(int operation, String *string, String lower, String upper, String padded,
+         int64_t length)
+{
+	int64_t count = 0;
+	String *tokens = NULL;
+	switch(operation)
+	{
+	case OPERATION_TRIM:
+		*string = SDSCopyLength(*string, padded, CAST(int)length);
+		*string = SDSTrim(*string, " \t");
+		sink += get_length(*string);
+		break;
+	case OPERATION_CASE:
+		SDSToLower(*string);
+		SDSToUpper(*string);
+		break;
+	case OPERATION_MAP:
+		*string = SDSMapChars(*string, "abc", "xyz", 3);
+		*string = SDSMapChars(*string, "xyz", "abc", 3);
+		break;
+	case OPERATION_COMPARE:
+		sink += SDSCompareNoCase(lower, upper);
+		break;
+	case OPERATION_FIND:
+		sink += SDSFind(lower, "needle", 6);
+		break;
+	default:
+		tokens = SDSSplitLength(padded, length, ",", 1, &count);
+		SDSFreeSplitResult(tokens, count);
+		sink += count;
+		break;
+	}
+}
+
+double Benchmark(int operation, int64_t length)
+{
+	String lower = SDSNewLength(NULL, length), upper = SDSNewLength(NULL, length);
+	String padded = SDSNewLength(NULL, length), string = NULL;
+	for(int64_t index = 0; index < length; ++index)
+	{
+		lower[index] = CAST(char)('a' + index % 26);
+		upper[index] = CAST(char)('A' + index % 26);
+		if(operation == OPERATION_SPLIT)
+		{
+			padded[index] = index % 64 == 63 ? ',' : lower[index];
+		}
+		else
+		{
+			padded[index] = (index < length / 2 || index >= length - length / 2) ?
+			                " \t"[index % 2] : 'x';
+		}
+	}
+	string = SDSDuplicate(lower);
+	int64_t iterations = BENCHMARK_BYTES / length;
+	double best = 0;
+	for(int run = 0; run < BENCHMARK_RUNS; ++run)
+	{
+		clock_t start = clock();
+		for(int64_t iteration = 0; iteration < iterations; ++iteration)
+		{
+			Run(operation, &string, lower, upper, padded, length);
+		}
+		double seconds = CAST(double)(clock() - start) / CLOCKS_PER_SEC;
+		double throughput = CAST(double)(iterations * length) / (seconds > 0 ? seconds : 1e-9) / 1e9;
+		best = throughput > best ? throughput : best;
+	}
+	SDSFree(lower);
+	SDSFree(upper);
+	SDSFree(padded);
+	SDSFree(string);
+	return best;
+}
+
+int main(void)
+{
+	int64_t lengths[] = {8, 64, 512, 4096, 65536, 1048576};
+	const char *level_names[] = {"scalar", "sse2", "avx2"};
+	int length_number = CAST(int)(sizeof(lengths) / sizeof(lengths[0]));
+	printf("%-16s %-6s", "GB/s", "level");
+	for(int index = 0; index < length_number; ++index)
+	{
+		printf(" %9lld B", CAST(long long)lengths[index]);
+	}
+	printf("\n");
+	for(int operation = 0; operation < OPERATION_NUMBER; ++operation)
+	{
+		for(int level = SDS_SIMD_SCALAR; level <= SDS_SIMD_AVX2; ++level)
+		{
+			if(SDSSetSIMDLevel(level) != level)
+			{
+				continue;
+			}
+			printf("%-16s %-6s", operation_names[operation], level_names[level]);
+			for(int index = 0; index < length_number; ++index)
+			{
+				printf(" %11.2f", Benchmark(operation, lengths[index]));
+				fflush(stdout);
+			}
+			printf("\n");
+		}
+	}
+	return 0;
+}
@@ -1,9 +1,205 @@
 #include <stdio.h> // printf()
+#include <stdlib.h> // rand()
 #include <string.h> // strlen(), memcmp()
 #include <assert.h>
 
+#include <memory.h>
 #include <simple_dynamic_string.h>
 
+// The free space of an SDS string is the rest of its allocation after the header of
+// header_size bytes, the string and the null, so it depends on the allocator's size classes:
+// it's slab_free with the slab allocator, otherwise whatever libc rounded the size up to.
+#ifdef MALLOC_NO_SLAB
+#define SLAB_FREE(string, header_size, slab_free) \
+(SDSAllocatedSize(string) - (header_size) - get_length(string) - 1)
+#else
+#define SLAB_FREE(string, header_size, slab_free) (slab_free)
+#endif
+
+char Lower(char c)
+{
+	return CAST(char)(c >= 'A' && c <= 'Z' ? c + 32 : c);
+}
+
+int64_t NaiveFind(const char *haystack, int64_t haystack_length, const char *needle,
+                  int64_t needle_length)
+{
+	for(int64_t index = 0; index + needle_length <= haystack_length; ++index)
+	{
+		if(memcmp(haystack + index, needle, CAST(size_t)needle_length) == 0)
+		{
+			return index;
+		}
+	}
+	return -1;
+}
+
+int NaiveCompareNoCase(const char *string1, int64_t length1, const char *string2,
+                       int64_t length2)
+{
+	for(int64_t index = 0; index < length1 && index < length2; ++index)
+	{
+		unsigned char c1 = CAST(unsigned char)Lower(string1[index]);
+		unsigned char c2 = CAST(unsigned char)Lower(string2[index]);
+		if(c1 != c2)
+		{
+			return c1 < c2 ? -1 : 1;
+		}
+	}
+	return (length1 > length2) - (length1 < length2);
+}
+
+// Check the kernels of the SIMD level against naive implementations, with lengths around
+// the vector widths and small alphabets that give many partial matches.
+void TestSIMDKernels(int level)
+{
+	const char alphabet[] = "aAbBzZ@[` \t-\xc1";
+	char text[300], other[300];
+	srand(CAST(unsigned)level);
+	for(int round = 0; round < 3000; ++round)
+	{
+		int64_t length = rand() % (round < 2000 ? 80 : 300);
+		for(int64_t index = 0; index < length; ++index)
+		{
+			text[index] = alphabet[rand() % (CAST(int)sizeof(alphabet) - 1)];
+		}
+		String string = SDSNewLength(text, length);
+
+		// Trim by a small set, and by a set too large for the SIMD kernels.
+		const char *set = round % 3 == 0 ? " \t" : (round % 3 == 1 ? "aA \t-" :
+		                  "abcdefghijklmnopqrstuvwxyz \t");
+		int64_t start = 0, end = length;
+		while(start < end && strchr(set, text[start]) != NULL)
+		{
+			++start;
+		}
+		while(end > start && strchr(set, text[end - 1]) != NULL)
+		{
+			--end;
+		}
+		String trimmed = SDSTrim(SDSDuplicate(string), set);
+		assert(get_length(trimmed) == end - start && trimmed[end - start] == '\0');
+		assert(memcmp(trimmed, text + start, CAST(size_t)(end - start)) == 0);
+		SDSFree(trimmed);
+
+		// Case conversion only changes ASCII letters.
+		String lower = SDSDuplicate(string), upper = SDSDuplicate(string);
+		SDSToLower(lower);
+		SDSToUpper(upper);
+		for(int64_t index = 0; index < length; ++index)
+		{
+			assert(lower[index] == Lower(text[index]));
+			assert(upper[index] == (text[index] >= 'a' && text[index] <= 'z' ?
+			                        text[index] - 32 : text[index]));
+		}
+		assert(SDSCompareNoCase(lower, upper) == 0 && SDSCompareNoCase(string, upper) == 0);
+
+		// Compare with a copy that differs at a random position, or is shorter.
+		memcpy(other, text, CAST(size_t)length);
+		int64_t other_length = length;
+		if(length > 0 && rand() % 4 != 0)
+		{
+			other[rand() % length] = alphabet[rand() % (CAST(int)sizeof(alphabet) - 1)];
+		}
+		else if(length > 0)
+		{
+			other_length = rand() % length;
+		}
+		String other_string = SDSNewLength(other, other_length);
+		assert(SDSCompareNoCase(string, other_string) ==
+		       NaiveCompareNoCase(text, length, other, other_length));
+		assert(SDSCompareNoCase(other_string, string) ==
+		       NaiveCompareNoCase(other, other_length, text, length));
+
+		// Search needles cut from the text, or random ones.
+		for(int needle_length = 0; needle_length < 6; ++needle_length)
+		{
+			char needle[8];
+			int64_t offset = length > needle_length ? rand() % (length - needle_length) : 0;
+			for(int index = 0; index < needle_length; ++index)
+			{
+				needle[index] = rand() % 2 && length > needle_length ? text[offset + index] :
+				                alphabet[rand() % (CAST(int)sizeof(alphabet) - 1)];
+			}
+			assert(SDSFind(string, needle, needle_length) ==
+			       NaiveFind(text, length, needle, needle_length));
+		}
+
+		// Map with duplicated bytes in from: the first one wins.
+		String mapped = SDSMapChars(SDSDuplicate(string), "aAa-\xc1", "A1x+\xe1", 5);
+		for(int64_t index = 0; index < length; ++index)
+		{
+			const char *position = memchr("aAa-\xc1", text[index], 5);
+			assert(mapped[index] == (position == NULL ? text[index] :
+			                         "A1x+\xe1"[position - "aAa-\xc1"]));
+		}
+		SDSFree(mapped);
+
+		// Split and join gives back the text.
+		int64_t count = 0;
+		String *tokens = SDSSplitLength(text, length, "a-", 2, &count);
+		assert(tokens != NULL && (count > 0) == (length > 0));
+		String joined = SDSNewEmpty();
+		for(int64_t index = 0; index < count; ++index)
+		{
+			assert(NaiveFind(tokens[index], get_length(tokens[index]), "a-", 2) == -1);
+			joined = SDSAppendSDS(joined, tokens[index]);
+			joined = index + 1 < count ? SDSAppendLength(joined, "a-", 2) : joined;
+		}
+		assert(get_length(joined) == length && memcmp(joined, text, CAST(size_t)length) == 0);
+		SDSFreeSplitResult(tokens, count);
+		SDSFree(joined);
+		SDSFree(string);
+		SDSFree(lower);
+		SDSFree(upper);
+		SDSFree(other_string);
+	}
+}
+
+// Check the integer formatting against snprintf() and that it parses back.
+void CheckInt64(int64_t value)
+{
+	char expected[32], buffer[SDS_INT64_STRING_SIZE];
+	int length = snprintf(expected, sizeof(expected), "%lld", CAST(long long)value);
+	assert(SDSFormatInt64(buffer, value) == length && strcmp(buffer, expected) == 0);
+	int64_t parsed = 0;
+	assert(SDSParseInt64(buffer, length, &parsed) == 1 && parsed == value);
+}
+
+// Check the double formatting reads back as the same double, and return 1 if a shorter
+// "%.*g" also reads back as the same double.
+int CheckDouble(double value)
+{
+	char buffer[SDS_DOUBLE_STRING_SIZE], expected[32];
+	int length = SDSFormatDouble(buffer, value);
+	assert(length == CAST(int)strlen(buffer) && length < SDS_DOUBLE_STRING_SIZE);
+	assert(strtod(buffer, NULL) == value);
+	// The significant digits: without the sign, the point, the exponent, and the leading
+	// and trailing zeros.
+	char digits[32];
+	int digit_number = 0;
+	for(const char *c = buffer; *c != '\0' && *c != 'e'; ++c)
+	{
+		if(*c >= '0' && *c <= '9' && (*c != '0' || digit_number > 0))
+		{
+			digits[digit_number++] = *c;
+		}
+	}
+	while(digit_number > 0 && digits[digit_number - 1] == '0')
+	{
+		--digit_number;
+	}
+	for(int precision = 1; precision < 17; ++precision)
+	{
+		snprintf(expected, sizeof(expected), "%.*g", precision, value);
+		if(strtod(expected, NULL) == value)
+		{
+			return precision < digit_number;
+		}
+	}
+	return 0;
+}
+
 int main(void)
 {
 	String s1, s2;
@@ -40,40 +236,253 @@ int main(void)
 	s2 = SDSDuplicate(s1);
 	assert(get_length(s2) == 6 && get_free(s2) == 0 && memcmp(s2, "number\0", 7) == 0);
 
+	// Short strings have type 5 header that has no free space.
 	SDSClear(s2);
-	assert(get_length(s2) == 0 && get_free(s2) == 6 && memcmp(s2, "\0umber\0", 7) == 0);
+	assert(get_length(s2) == 0 && get_free(s2) == 0 && memcmp(s2, "\0umber\0", 7) == 0);
 
+	// Appending allocates twice the needed length, and the rest of the allocator's
+	// size class is free space too: 3 + 18 + 1 bytes are rounded up to 24 + 1 + 3.
 	s1 = SDSAppendLength(s1, "one", 3);
-	assert(get_length(s1) == 9 && get_free(s1) == 9 && memcmp(s1, "numberone\0", 10) == 0);
+	assert(get_length(s1) == 9 && get_free(s1) == SLAB_FREE(s1, 3, 11) && memcmp(s1, "numberone\0", 10) == 0);
 
 	SDSFree(s2);
 	s2 = SDSNew("gaoxiang");
 	s1 = SDSAppendSDS(s1, s2);
-	assert(get_length(s1) == 17 && get_free(s1) == 1 && memcmp(s1, "numberonegaoxiang\0", 18) == 0);
+	assert(get_length(s1) == 17 && get_free(s1) == SLAB_FREE(s1, 3, 3) && memcmp(s1, "numberonegaoxiang\0", 18) == 0);
 
 	s1 = SDSAppend(s1, "!!!");
-	assert(get_length(s1) == 20 && get_free(s1) == 20 && memcmp(s1, "numberonegaoxiang!!!\0", 21) == 0);
+	assert(get_length(s1) == 20 && get_free(s1) == SLAB_FREE(s1, 3, 0) && memcmp(s1, "numberonegaoxiang!!!\0", 21) == 0);
 
 	s1 = SDSCopyLength(s1, "xiang", 6);
-	assert(get_length(s1) == 6 && get_free(s1) == 34 && memcmp(s1, "xiang\0\0negaoxiang!!!\0", 21) == 0);
+	assert(get_length(s1) == 6 && get_free(s1) == SLAB_FREE(s1, 3, 14) && memcmp(s1, "xiang\0\0negaoxiang!!!\0", 21) == 0);
 
 	s1 = SDSCopy(s1, "gao");
-	assert(get_length(s1) == 3 && get_free(s1) == 37 && memcmp(s1, "gao\0g\0\0negaoxiang!!!\0", 21) == 0);
+	assert(get_length(s1) == 3 && get_free(s1) == SLAB_FREE(s1, 3, 17) && memcmp(s1, "gao\0g\0\0negaoxiang!!!\0", 21) == 0);
 
 	s1 = SDSGrowWithNull(s1, 10);
-	assert(get_length(s1) == 10 && get_free(s1) == 30 && memcmp(s1, "gao\0\0\0\0\0\0\0\0oxiang!!!\0", 21) == 0);
+	assert(get_length(s1) == 10 && get_free(s1) == SLAB_FREE(s1, 3, 10) && memcmp(s1, "gao\0\0\0\0\0\0\0\0oxiang!!!\0", 21) == 0);
 
 	SDSRange(s1, 5, 9);
-	assert(get_length(s1) == 5 && get_free(s1) == 35 && memcmp(s1, "\0\0\0\0\0\0\0\0\0\0\0oxiang!!!\0", 21) == 0);
+	assert(get_length(s1) == 5 && get_free(s1) == SLAB_FREE(s1, 3, 15) && memcmp(s1, "\0\0\0\0\0\0\0\0\0\0\0oxiang!!!\0", 21) == 0);
 
 	s1 = SDSCopy(s1, "I am gao xiang. To be number one!");
-	assert(get_length(s1) == 33 && get_free(s1) == 7 && memcmp(s1, "I am gao xiang. To be number one!\0", 34) == 0);
+	assert(get_length(s1) == 33 && get_free(s1) == SLAB_FREE(s1, 3, 35) && memcmp(s1, "I am gao xiang. To be number one!\0", 34) == 0);
 
 	s1 = SDSTrim(s1, "Iabcde !");
-	assert(get_length(s1) == 28 && get_free(s1) == 12 && memcmp(s1, "m gao xiang. To be number on\0one!\0", 34) == 0);
+	assert(get_length(s1) == 28 && get_free(s1) == SLAB_FREE(s1, 3, 40) && memcmp(s1, "m gao xiang. To be number on\0one!\0", 34) == 0);
 
 	int value = SDSCompare(s1, s2);
 	assert(value > 0);
+	SDSFree(s1);
+	SDSFree(s2);
+
+	// The smallest header type that holds the capacity is chosen, and the type changes
+	// as the string grows.
+	char buffer[70000];
+	memset(buffer, 'x', sizeof(buffer));
+	s1 = SDSNewLength(buffer, 31);
+	assert((s1[-1] & SDS_TYPE_MASK) == SDS_TYPE_5 && get_length(s1) == 31);
+	s1 = SDSAppendLength(s1, "y", 1);
+	assert((s1[-1] & SDS_TYPE_MASK) == SDS_TYPE_8 && get_length(s1) == 32 && get_free(s1) == SLAB_FREE(s1, 3, 36));
+	assert(memcmp(s1, buffer, 31) == 0 && memcmp(s1 + 31, "y\0", 2) == 0);
+	SDSFree(s1);
+	s1 = SDSNewEmpty();
+	assert((s1[-1] & SDS_TYPE_MASK) == SDS_TYPE_8);
+	s1 = SDSAppendLength(s1, buffer, 100);
+	assert((s1[-1] & SDS_TYPE_MASK) == SDS_TYPE_8 && get_length(s1) == 100 && get_free(s1) == SLAB_FREE(s1, 3, 104));
+	s1 = SDSAppendLength(s1, buffer, 200);
+	assert((s1[-1] & SDS_TYPE_MASK) == SDS_TYPE_16 && get_length(s1) == 300 && get_free(s1) >= 300);
+	s1 = SDSGrowWithNull(s1, 70000);
+	assert((s1[-1] & SDS_TYPE_MASK) == SDS_TYPE_32 && get_length(s1) == 70000);
+	assert(memcmp(s1, buffer, 300) == 0 && s1[300] == '\0' && s1[70000] == '\0');
+	SDSRange(s1, 1, 2);
+	assert(get_length(s1) == 2 && get_free(s1) >= 139998 && memcmp(s1, "xx\0", 3) == 0);
+	SDSFree(s1);
+	s1 = SDSNewLength(buffer, 255);
+	assert((s1[-1] & SDS_TYPE_MASK) == SDS_TYPE_8 && get_length(s1) == 255);
+	SDSFree(s1);
+	s1 = SDSNewLength(NULL, 256);
+	assert((s1[-1] & SDS_TYPE_MASK) == SDS_TYPE_16 && get_length(s1) == 256 && s1[255] == '\0');
+	SDSFree(s1);
+
+	// Non-greedy growth only adds the allocator's rounding, and the free space can be
+	// removed, which may also make the header smaller.
+	s1 = SDSNew("gao");
+	s1 = SDSMakeRoomForNonGreedy(s1, 1000);
+	assert((s1[-1] & SDS_TYPE_MASK) == SDS_TYPE_16 && get_length(s1) == 3);
+	assert(get_free(s1) >= 997 && get_free(s1) < 1100);
+	assert(SDSAllocatedSize(s1) == 5 + get_length(s1) + get_free(s1) + 1);
+	assert(SDSMakeRoomForNonGreedy(s1, 997) == s1);
+	s1 = SDSRemoveFreeSpace(s1);
+	assert((s1[-1] & SDS_TYPE_MASK) == SDS_TYPE_5 && get_length(s1) == 3 && get_free(s1) == 0);
+	assert(memcmp(s1, "gao\0", 4) == 0 && SDSAllocatedSize(s1) == 1 + 3 + 1);
+	s1 = SDSAppendLength(s1, buffer, 300);
+	s1 = SDSRemoveFreeSpace(s1);
+	assert((s1[-1] & SDS_TYPE_MASK) == SDS_TYPE_16 && get_length(s1) == 303 && get_free(s1) == 0);
+	assert(memcmp(s1, "gaoxxx", 6) == 0 && s1[303] == '\0');
+	SDSFree(s1);
+
+	// Splitting: adjacent separators give empty tokens, an empty separator is an error.
+	int64_t count = 0;
+	String *tokens = SDSSplitLength("foo_-_bar_-__-_", 15, "_-_", 3, &count);
+	assert(count == 4 && strcmp(tokens[0], "foo") == 0 && strcmp(tokens[1], "bar") == 0);
+	assert(get_length(tokens[2]) == 0 && get_length(tokens[3]) == 0);
+	SDSFreeSplitResult(tokens, count);
+	tokens = SDSSplitLength("", 0, ",", 1, &count);
+	assert(tokens != NULL && count == 0);
+	SDSFreeSplitResult(tokens, count);
+	assert(SDSSplitLength("a,b", 3, "", 0, &count) == NULL && count == 0);
+
+	s1 = SDSNew("Hello, World! 0123456789 Hello, World!");
+	assert(SDSFind(s1, "World", 5) == 7 && SDSFind(s1, "world", 5) == -1);
+	assert(SDSFind(s1, "", 0) == 0 && SDSFind(s1, "!", 1) == 12);
+	s2 = SDSNew("HELLO, WORLD! 0123456789 hello, world!");
+	assert(SDSCompare(s1, s2) > 0 && SDSCompareNoCase(s1, s2) == 0);
+	SDSToLower(s1);
+	assert(strcmp(s1, "hello, world! 0123456789 hello, world!") == 0);
+	SDSToUpper(s1);
+	assert(strcmp(s1, "HELLO, WORLD! 0123456789 HELLO, WORLD!") == 0);
+	s1 = SDSMapChars(s1, "HO", "ho", 2);
+	assert(strcmp(s1, "hELLo, WoRLD! 0123456789 hELLo, WoRLD!") == 0);
+	SDSFree(s1);
+	SDSFree(s2);
+
+	// Integers are formatted like "%lld" and parsed back, only in their canonical form.
+	int64_t numbers[] = {0, 1, -1, 9, 10, 99, 100, -100, 12345, 4294967295LL, 4294967296LL,
+	                     INT64_MAX, INT64_MIN, INT64_MAX - 1, INT64_MIN + 1
+	                    };
+	for(int index = 0; index < CAST(int)(sizeof(numbers) / sizeof(numbers[0])); ++index)
+	{
+		CheckInt64(numbers[index]);
+	}
+	for(int64_t power = 1; power <= INT64_MAX / 10; power *= 10)
+	{
+		CheckInt64(power - 1);
+		CheckInt64(power);
+		CheckInt64(-power - 1);
+	}
+	srand(1);
+	for(int round = 0; round < 100000; ++round)
+	{
+		uint64_t bits = (CAST(uint64_t)rand() << 42) ^ (CAST(uint64_t)rand() << 21) ^
+		                CAST(uint64_t)rand();
+		CheckInt64(CAST(int64_t)(bits >> (rand() % 64)) * (round % 2 ? 1 : -1));
+	}
+	const char *invalid[] = {"", "-", "+1", " 1", "1 ", "01", "-0", "-01", "1a", "0x1",
+	                         "9223372036854775808", "-9223372036854775809",
+	                         "18446744073709551616", "99999999999999999999"
+	                        };
+	for(int index = 0; index < CAST(int)(sizeof(invalid) / sizeof(invalid[0])); ++index)
+	{
+		int64_t parsed = 0;
+		assert(SDSParseInt64(invalid[index], CAST(int64_t)strlen(invalid[index]), &parsed) == 0);
+	}
+	s1 = SDSFromLongLong(-9223372036854775807LL - 1);
+	int64_t parsed = 0;
+	assert(strcmp(s1, "-9223372036854775808") == 0 && get_length(s1) == 20);
+	assert(SDSToLongLongStrict(s1, &parsed) == 1 && parsed == INT64_MIN);
+	SDSFree(s1);
+
+	// Doubles are formatted with the shortest digits in the notation of "%.17g".
+	double doubles[] = {0.1, 100, 1e20, 1.5e-7, 0.0001, 1e-5, 1e16, 1e17, 123.456, -2.5,
+	                    5e-324, 1.7976931348623157e308, 2.2250738585072014e-308, 0.3, 2.0 / 3
+	                   };
+	const char *expected[] = {"0.1", "100", "1e+20", "1.5e-07", "0.0001", "1e-05",
+	                          "10000000000000000", "1e+17", "123.456", "-2.5", "5e-324",
+	                          "1.7976931348623157e+308", "2.2250738585072014e-308", "0.3",
+	                          "0.6666666666666666"
+	                         };
+	for(int index = 0; index < CAST(int)(sizeof(doubles) / sizeof(doubles[0])); ++index)
+	{
+		s1 = SDSFromDouble(doubles[index]);
+		assert(strcmp(s1, expected[index]) == 0);
+		SDSFree(s1);
+	}
+	char number[SDS_DOUBLE_STRING_SIZE];
+	assert(SDSFormatDouble(number, -0.0) == 2 && strcmp(number, "-0") == 0);
+	assert(SDSFormatDouble(number, 1.0 / 0.0) == 3 && strcmp(number, "inf") == 0);
+	assert(SDSFormatDouble(number, -1.0 / 0.0) == 4 && strcmp(number, "-inf") == 0);
+	assert(SDSFormatDouble(number, 0.0 / 0.0) == 3 && strcmp(number, "nan") == 0);
+	// Random bit patterns cover all exponents. Grisu2 is shortest for all but about 0.1%.
+	int longer = 0;
+	for(int round = 0; round < 100000; ++round)
+	{
+		uint64_t bits = (CAST(uint64_t)rand() << 42) ^ (CAST(uint64_t)rand() << 21) ^
+		                CAST(uint64_t)rand();
+		double value;
+		memcpy(&value, &bits, sizeof(value));
+		if(value == value && value - value == 0) // Finite.
+		{
+			longer += CheckDouble(value);
+		}
+		longer += CheckDouble(CAST(double)rand() / 1000);
+	}
+	assert(longer < 200);
+
+	s2 = SDSNew("value");
+	s1 = SDSCatFmt(SDSNew("log:"), "%s=%S %i %I %u %U %g%% %x%", "key", s2, -7, INT64_MIN,
+	               4000000000U, UINT64_MAX, 0.25);
+	assert(strcmp(s1, "log:key=value -7 -9223372036854775808 4000000000 "
+	              "18446744073709551615 0.25% %x%") == 0);
+	SDSFree(s1);
+	SDSFree(s2);
+
+	// Views compare like SDS strings without owning the bytes.
+	s1 = SDSNew("key:1");
+	SDSView view = {"key:12", 5}, long_view = {"key:12", 6}, whole = SDSViewOfSDS(s1);
+	assert(SDSViewEqual(&view, s1) && !SDSViewEqual(&long_view, s1) && whole.length_ == 5);
+	assert(SDSViewCompare(&view, &whole) == 0 && SDSViewCompare(&view, &long_view) < 0);
+	assert(SDSViewCompare(&long_view, &view) > 0);
+	SDSFree(s1);
+
+	// Shared strings are reference counted and freed with the last reference; sharing an
+	// ordinary string copies it.
+	s1 = SDSNewShared(buffer, 1000);
+	assert(SDSIsShared(s1) && SDSReferenceCount(s1) == 1 && get_length(s1) == 1000);
+	assert(get_free(s1) == 0 && s1[1000] == '\0' && memcmp(s1, buffer, 1000) == 0);
+	assert(SDSAllocatedSize(s1) >= 8 + 5 + 1000 + 1);
+	s2 = SDSShare(s1);
+	assert(s2 == s1 && SDSReferenceCount(s1) == 2);
+	SDSFree(s2);
+	assert(SDSReferenceCount(s1) == 1);
+	s2 = SDSShare(s1);
+	s2 = SDSUnshare(s2); // Drops a reference and copies.
+	assert(s2 != s1 && !SDSIsShared(s2) && SDSReferenceCount(s1) == 1);
+	assert(get_length(s2) == 1000 && memcmp(s2, s1, 1001) == 0);
+	s2 = SDSAppend(s2, "!");
+	assert(get_length(s2) == 1001 && get_length(s1) == 1000);
+	SDSFree(s1);
+	s1 = SDSShare(s2);
+	assert(s1 != s2 && !SDSIsShared(s1) && SDSUnshare(s1) == s1);
+	SDSFree(s1);
+	SDSFree(s2);
+	s1 = SDSNewShared("", 0);
+	assert(SDSIsShared(s1) && get_length(s1) == 0 && SDSShare(s1) == s1);
+	SDSFree(s1);
+	SDSFree(s1);
+
+	// Embedded strings live in the memory of the caller with the smallest header.
+	char *memory = Malloc(64);
+	s1 = SDSNewEmbedded(memory, "embedded", 8);
+	assert(SDSEmbeddedSize(8) == 1 + 8 + 1 && s1 == memory + 1 && strcmp(s1, "embedded") == 0);
+	assert(get_length(s1) == 8 && get_free(s1) == 0 && !SDSIsShared(s1));
+	s1 = SDSNewEmbedded(memory, buffer, 44);
+	assert(SDSEmbeddedSize(44) == 3 + 44 + 1 && s1 == memory + 3 && get_length(s1) == 44);
+	assert(memcmp(s1, buffer, 44) == 0 && s1[44] == '\0');
+	s1 = SDSNewEmbedded(memory, NULL, 0);
+	assert(SDSEmbeddedSize(0) == 2 && get_length(s1) == 0 && s1[0] == '\0');
+	Free(memory);
+
+	// Every SIMD level supported by the CPU gives the same results.
+	for(int level = SDS_SIMD_SCALAR; level <= SDS_SIMD_AVX2; ++level)
+	{
+		if(SDSSetSIMDLevel(level) == level)
+		{
+			TestSIMDKernels(level);
+		}
+	}
+	assert(SDSSetSIMDLevel(SDS_SIMD_AUTO) >= SDS_SIMD_SCALAR);
+	assert(UsedMemory() == 0);
 
 	printf("All passed! Come on!\n");
 
@@ -0,0 +1,118 @@
+// A skip list of 1M members with random scores, like a leaderboard: insert, score update,
+// rank, element by rank and first/last in a score range throughput. The best of 3 runs is
+// reported.
+#include <stdio.h> // printf()
+#include <stdint.h>
+#include <stdlib.h> // rand()
+#include <time.h> // clock()
+
+#include <memory.h>
+#include <nosql.h>
+#include <simple_dynamic_string.h>
+#include <skip_list.h>
+
+#define MEMBER_NUMBER 1000000
+#define QUERY_NUMBER 1000000
+#define BENCHMARK_RUNS 3
+
+volatile int64_t sink = 0;
+
+NosqlObject *g_members[MEMBER_NUMBER];
+double g_scores[MEMBER_NUMBER];
+
+double Seconds(clock_t start)
+{
+	return CAST(double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+// Return a random score with a few ties, like points.
+double RandomScore()
+{
+	return rand() % (MEMBER_NUMBER * 4);
+}
+
+void PrintResult(const char *operation, int64_t number, double seconds)
+{
+	printf("skip list of %d members %-19s %6.2f Mops/s\n", MEMBER_NUMBER, operation,
+	       CAST(double)number / seconds / 1e6);
+}
+
+int main(void)
+{
+	char buffer[SDS_INT64_STRING_SIZE + 5] = "user:";
+	for(int index = 0; index < MEMBER_NUMBER; ++index)
+	{
+		int length = CAST(int)SDSFormatInt64(buffer + 5, index) + 5;
+		g_members[index] = CreateStringObject(buffer, length);
+	}
+	SkipList *skip_list = NULL;
+	double best_insert = 1e9, best_update = 1e9, best_rank = 1e9, best_element = 1e9,
+	       best_range = 1e9;
+	for(int run = 0; run < BENCHMARK_RUNS; ++run)
+	{
+		if(skip_list != NULL)
+		{
+			SkipListFree(skip_list);
+		}
+		skip_list = SkipListCreate();
+		srand(1);
+		clock_t start = clock();
+		for(int index = 0; index < MEMBER_NUMBER; ++index)
+		{
+			// The skip list takes over a reference, and the benchmark keeps its own.
+			IncreaseReferenceCount(g_members[index]);
+			g_scores[index] = RandomScore();
+			SkipListInsert(skip_list, g_members[index], g_scores[index]);
+		}
+		double seconds = Seconds(start);
+		best_insert = seconds < best_insert ? seconds : best_insert;
+		// Small increments mostly keep the order, which is updated in place.
+		start = clock();
+		for(int query = 0; query < QUERY_NUMBER; ++query)
+		{
+			int index = rand() % MEMBER_NUMBER;
+			double new_score = g_scores[index] + (query % 2 ? 1 : RandomScore() - g_scores[index]);
+			SkipListUpdateScore(skip_list, g_members[index], g_scores[index], new_score);
+			g_scores[index] = new_score;
+		}
+		seconds = Seconds(start);
+		best_update = seconds < best_update ? seconds : best_update;
+		start = clock();
+		for(int query = 0; query < QUERY_NUMBER; ++query)
+		{
+			int index = rand() % MEMBER_NUMBER;
+			sink += SkipListGetRank(skip_list, g_members[index], g_scores[index]);
+		}
+		seconds = Seconds(start);
+		best_rank = seconds < best_rank ? seconds : best_rank;
+		start = clock();
+		for(int query = 0; query < QUERY_NUMBER; ++query)
+		{
+			sink += SkipListGetElementByRank(skip_list, 1 + rand() % MEMBER_NUMBER)->object_->type_;
+		}
+		seconds = Seconds(start);
+		best_element = seconds < best_element ? seconds : best_element;
+		start = clock();
+		for(int query = 0; query < QUERY_NUMBER; ++query)
+		{
+			double min = RandomScore();
+			SkipListRange range = {min, min + 100, 0, 1};
+			SkipListNode *first = SkipListFirstInRange(skip_list, &range);
+			SkipListNode *last = SkipListLastInRange(skip_list, &range);
+			sink += (first != NULL) + (last != NULL);
+		}
+		seconds = Seconds(start);
+		best_range = seconds < best_range ? seconds : best_range;
+	}
+	PrintResult("insert", MEMBER_NUMBER, best_insert);
+	PrintResult("update score", QUERY_NUMBER, best_update);
+	PrintResult("get rank", QUERY_NUMBER, best_rank);
+	PrintResult("get element by rank", QUERY_NUMBER, best_element);
+	PrintResult("first/last in range", QUERY_NUMBER, best_range);
+	SkipListFree(skip_list);
+	for(int index = 0; index < MEMBER_NUMBER; ++index)
+	{
+		DecreaseReferenceCount(g_members[index]);
+	}
+	return 0;
+}
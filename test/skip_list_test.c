@@ -0,0 +1,296 @@
+#include <stdio.h> // printf(), snprintf()
+#include <stdlib.h> // rand()
+#include <assert.h>
+
+#include <memory.h>
+#include <nosql.h>
+#include <simple_dynamic_string.h>
+#include <skip_list.h>
+
+#define MAX_NUMBER 1000
+
+#include "sorted_model.h" // The model of the skip list: its elements in order.
+
+// Check the links, the spans, the ranks and the backward pointers against the model.
+void Check(SkipList *skip_list)
+{
+	assert(skip_list->length_ == g_element_number);
+	SkipListNode *node = skip_list->head_->level_[0].forward_;
+	for(int index = 0; index < g_element_number; ++index, node = node->level_[0].forward_)
+	{
+		assert(node != NULL && node->object_ == g_elements[index].object_);
+		assert(node->score_ == g_elements[index].score_);
+		assert(node->backward_ == (index == 0 ? NULL : SkipListGetElementByRank(skip_list, index)));
+		assert(SkipListGetRank(skip_list, node->object_, node->score_) == index + 1);
+		assert(SkipListGetElementByRank(skip_list, index + 1) == node);
+	}
+	assert(node == NULL && skip_list->tail_ == (g_element_number == 0 ? NULL :
+	        SkipListGetElementByRank(skip_list, g_element_number)));
+	assert(SkipListGetElementByRank(skip_list, 0) == NULL);
+	assert(SkipListGetElementByRank(skip_list, g_element_number + 1) == NULL);
+	// The spans of every level add up to the ranks of the nodes.
+	for(int level = 0; level < skip_list->level_; ++level)
+	{
+		int64_t rank = 0;
+		for(node = skip_list->head_; node->level_[level].forward_ != NULL;
+		        node = node->level_[level].forward_)
+		{
+			rank += node->level_[level].span_;
+			assert(SkipListGetElementByRank(skip_list, rank) == node->level_[level].forward_);
+		}
+	}
+	assert(skip_list->level_ == 1 || skip_list->head_->level_[skip_list->level_ - 1].forward_);
+}
+
+// Check the first and last nodes in random score ranges against the model.
+void CheckRanges(SkipList *skip_list)
+{
+	for(int round = 0; round < 100; ++round)
+	{
+		SkipListRange range = {rand() % 24 - 2, rand() % 24 - 2, rand() % 2, rand() % 2};
+		int first = -1, last = -1;
+		for(int index = 0; index < g_element_number; ++index)
+		{
+			double score = g_elements[index].score_;
+			if((range.min_exclusive_ ? score > range.min_ : score >= range.min_) &&
+			        (range.max_exclusive_ ? score < range.max_ : score <= range.max_))
+			{
+				first = first < 0 ? index : first;
+				last = index;
+			}
+		}
+		SkipListNode *first_node = SkipListFirstInRange(skip_list, &range);
+		SkipListNode *last_node = SkipListLastInRange(skip_list, &range);
+		assert(first < 0 || SkipListIsInRange(skip_list, &range));
+		assert(first_node == (first < 0 ? NULL : SkipListGetElementByRank(skip_list, first + 1)));
+		assert(last_node == (last < 0 ? NULL : SkipListGetElementByRank(skip_list, last + 1)));
+	}
+}
+
+// Insert, delete and update random elements with few distinct scores, so that many of them
+// are ordered by their objects.
+void TestRandomOperations()
+{
+	SkipList *skip_list = SkipListCreate();
+	Check(skip_list);
+	for(int round = 0; round < 20000; ++round)
+	{
+		int operation = rand() % 3;
+		if(operation == 0 && g_element_number < MAX_NUMBER)
+		{
+			NosqlObject *object = RandomObject();
+			double score = rand() % 20;
+			int index = LowerBound(object, score);
+			if(index < g_element_number && CompareElement(g_elements[index].score_,
+			        g_elements[index].object_, score, object) == 0)
+			{
+				DecreaseReferenceCount(object); // Already in the skip list.
+				continue;
+			}
+			SkipListNode *node = SkipListInsert(skip_list, object, score);
+			assert(node->object_ == object && node->score_ == score);
+			for(int move = g_element_number; move > index; --move)
+			{
+				g_elements[move] = g_elements[move - 1];
+			}
+			g_elements[index].score_ = score;
+			g_elements[index].object_ = object;
+			++g_element_number;
+		}
+		else if(operation == 1 && g_element_number > 0)
+		{
+			int index = rand() % g_element_number;
+			SkipListNode *node = NULL;
+			int keep = rand() % 2;
+			NosqlObject *object = g_elements[index].object_;
+			assert(SkipListDelete(skip_list, object, g_elements[index].score_ + 0.125, NULL) == 0);
+			assert(SkipListDelete(skip_list, object, g_elements[index].score_, keep ? &node : NULL));
+			if(keep)
+			{
+				assert(node->object_ == object);
+				SkipListFreeNode(node);
+			}
+			for(int move = index; move < g_element_number - 1; ++move)
+			{
+				g_elements[move] = g_elements[move + 1];
+			}
+			--g_element_number;
+		}
+		else if(operation == 2 && g_element_number > 0)
+		{
+			// Small changes mostly keep the order, which is updated in place. All scores are multiples
+			// of 0.25, so the delete of score + 0.125 above always misses.
+			int index = rand() % g_element_number;
+			Element element = g_elements[index];
+			double new_score = element.score_ + (rand() % 2 ? (rand() % 5 - 2) * 0.25 :
+			                                     rand() % 20 - element.score_);
+			for(int move = index; move < g_element_number - 1; ++move)
+			{
+				g_elements[move] = g_elements[move + 1];
+			}
+			--g_element_number;
+			int new_index = LowerBound(element.object_, new_score);
+			if(new_index < g_element_number && CompareElement(g_elements[new_index].score_,
+			        g_elements[new_index].object_, new_score, element.object_) == 0)
+			{
+				// The object would be in the skip list twice: restore the model.
+				new_score = element.score_;
+				new_index = index;
+			}
+			SkipListNode *node = SkipListUpdateScore(skip_list, element.object_, element.score_,
+			                     new_score);
+			assert(node->object_ == element.object_ && node->score_ == new_score);
+			for(int move = g_element_number; move > new_index; --move)
+			{
+				g_elements[move] = g_elements[move - 1];
+			}
+			g_elements[new_index].score_ = new_score;
+			g_elements[new_index].object_ = element.object_;
+			++g_element_number;
+		}
+		if(round % 1000 == 0)
+		{
+			Check(skip_list);
+			CheckRanges(skip_list);
+		}
+	}
+	Check(skip_list);
+	CheckRanges(skip_list);
+	SkipListFree(skip_list);
+	g_element_number = 0;
+}
+
+// The callback of the range deletes: check that the deleted node is the next one of the model.
+void DeleteCallback(void *argument, SkipListNode *node)
+{
+	int *index = argument;
+	assert(node->object_ == g_elements[*index].object_ && node->score_ == g_elements[*index].score_);
+	++*index;
+}
+
+// Remove count elements from index of the model.
+void RemoveElements(int index, int count)
+{
+	for(int move = index; move + count < g_element_number; ++move)
+	{
+		g_elements[move] = g_elements[move + count];
+	}
+	g_element_number -= count;
+}
+
+// Delete random ranges by score and by rank until the skip list is empty.
+void TestDeleteRanges()
+{
+	SkipList *skip_list = SkipListCreate();
+	for(int index = 0; index < MAX_NUMBER; ++index)
+	{
+		// Unique objects with few distinct scores, inserted in order into the model.
+		char buffer[32];
+		int length = snprintf(buffer, sizeof(buffer), "%04d", index);
+		g_elements[index].score_ = index / 10;
+		g_elements[index].object_ = CreateStringObject(buffer, length);
+		SkipListInsert(skip_list, g_elements[index].object_, g_elements[index].score_);
+	}
+	g_element_number = MAX_NUMBER;
+	while(g_element_number > 0)
+	{
+		int first = g_element_number, last = -1, deleted = 0;
+		if(rand() % 2)
+		{
+			SkipListRange range = {rand() % 110 - 5, rand() % 110 - 5, rand() % 2, rand() % 2};
+			range.max_ = range.min_ + rand() % 10;
+			if(rand() % 8 == 0)
+			{
+				range.max_ = 1.0 / 0.0; // inf
+			}
+			for(int index = 0; index < g_element_number; ++index)
+			{
+				if(SkipListAboveMin(g_elements[index].score_, &range) &&
+				        SkipListBelowMax(g_elements[index].score_, &range))
+				{
+					first = first < index ? first : index;
+					last = index;
+				}
+			}
+			deleted = first;
+			assert(SkipListDeleteRangeByScore(skip_list, &range, DeleteCallback, &deleted) ==
+			       (last < 0 ? 0 : last - first + 1));
+		}
+		else
+		{
+			// Ranks start at 1 and the end may be past the last node.
+			int start = 1 + rand() % g_element_number, end = start + rand() % 50;
+			first = start - 1;
+			last = end > g_element_number ? g_element_number - 1 : end - 1;
+			deleted = first;
+			assert(SkipListDeleteRangeByRank(skip_list, start, end, DeleteCallback, &deleted) ==
+			       last - first + 1);
+		}
+		if(last >= 0)
+		{
+			assert(deleted == last + 1);
+			RemoveElements(first, last - first + 1);
+		}
+		Check(skip_list);
+	}
+	assert(SkipListDeleteRangeByRank(skip_list, 1, 10, NULL, NULL) == 0);
+	SkipListFree(skip_list);
+}
+
+// Lexical ranges of the objects "a" to "z", which all have the score 0.
+void TestLexRanges()
+{
+	SkipList *skip_list = SkipListCreate();
+	NosqlObject *objects[26];
+	for(int index = 0; index < 26; ++index)
+	{
+		char letter = CAST(char)('a' + index);
+		objects[index] = CreateStringObject(&letter, 1);
+		IncreaseReferenceCount(objects[index]);
+		SkipListInsert(skip_list, objects[index], 0);
+	}
+	for(int round = 0; round < 1000; ++round)
+	{
+		// min and max from -1 for unbounded to 26, which is past "z".
+		int min = rand() % 28 - 1, max = rand() % 28 - 1;
+		int min_exclusive = rand() % 2, max_exclusive = rand() % 2;
+		NosqlObject *min_object = min < 0 ? NULL : min < 26 ? objects[min] :
+		                          CreateStringObject("zz", 2);
+		NosqlObject *max_object = max < 0 ? NULL : max < 26 ? objects[max] :
+		                          CreateStringObject("zz", 2);
+		SkipListLexRange range = {min_object, max_object, min_exclusive, max_exclusive};
+		int first = min < 0 ? 0 : min + min_exclusive;
+		int last = max < 0 ? 25 : (max > 25 ? 25 : max - max_exclusive);
+		int empty = first > 25 || last < 0 || first > last;
+		assert(empty || SkipListIsInLexRange(skip_list, &range));
+		SkipListNode *first_node = SkipListFirstInLexRange(skip_list, &range);
+		SkipListNode *last_node = SkipListLastInLexRange(skip_list, &range);
+		assert(empty ? first_node == NULL : first_node->object_ == objects[first]);
+		assert(empty ? last_node == NULL : last_node->object_ == objects[last]);
+		for(int index = 0; index < 2; ++index)
+		{
+			NosqlObject *object = index == 0 ? min_object : max_object;
+			if(object != NULL && object->reference_count_ == 1)
+			{
+				DecreaseReferenceCount(object);
+			}
+		}
+	}
+	SkipListFree(skip_list);
+	for(int index = 0; index < 26; ++index)
+	{
+		assert(objects[index]->reference_count_ == 1);
+		DecreaseReferenceCount(objects[index]);
+	}
+}
+
+int main(void)
+{
+	TestRandomOperations();
+	TestLexRanges();
+	TestDeleteRanges();
+	assert(UsedMemory() == 0);
+
+	printf("All passed! Come on!\n");
+	return 0;
+}
@@ -0,0 +1,51 @@
+// The reference model of the sorted set tests: the elements of the tested structure in
+// order, kept in an array by the test. Define MAX_NUMBER, the capacity of the model,
+// before including it.
+#ifndef NOSQL_TEST_SORTED_MODEL_H_
+#define NOSQL_TEST_SORTED_MODEL_H_
+
+#include <stdio.h> // snprintf()
+#include <stdlib.h> // rand()
+
+#include <nosql.h>
+
+typedef struct Element
+{
+	double score_;
+	NosqlObject *object_;
+} Element;
+
+Element g_elements[MAX_NUMBER];
+int g_element_number = 0;
+
+int CompareElement(double score1, const NosqlObject *object1, double score2,
+                   const NosqlObject *object2)
+{
+	if(score1 != score2)
+	{
+		return score1 < score2 ? -1 : 1;
+	}
+	return CompareStringObjects(object1, object2);
+}
+
+// Return the index of the first element that isn't before (object, score).
+int LowerBound(const NosqlObject *object, double score)
+{
+	int index = 0;
+	while(index < g_element_number &&
+	        CompareElement(g_elements[index].score_, g_elements[index].object_, score, object) < 0)
+	{
+		++index;
+	}
+	return index;
+}
+
+NosqlObject *RandomObject()
+{
+	char buffer[32];
+	// Few distinct lengths and first bytes, so that some objects are prefixes of others.
+	int length = snprintf(buffer, sizeof(buffer), "%c%d", 'a' + rand() % 3, rand() % 1000);
+	return CreateStringObject(buffer, length);
+}
+
+#endif // NOSQL_TEST_SORTED_MODEL_H_
@@ -0,0 +1,279 @@
+// A sorted set of 1M members against its skip list alone: ZADD, ZSCORE, ZINCRBY and ZRANGE
+// of 10 members throughput. The skip list alone can only find the score of a member by
+// scanning all nodes, and needs the current score to update one. Then leaderboard range
+// queries, and range deletes in one pass against one delete per member. The best of 3 runs
+// is reported.
+#include <stdio.h> // printf()
+#include <stdint.h>
+#include <stdlib.h> // rand()
+#include <string.h> // memcpy()
+#include <time.h> // clock()
+
+#include <memory.h>
+#include <nosql.h>
+#include <simple_dynamic_string.h>
+#include <skip_list.h>
+#include <sorted_set_object.h>
+
+#define MEMBER_NUMBER 1000000
+#define QUERY_NUMBER 1000000
+#define SCAN_NUMBER 100 // Skip list alone score lookups, which are O(N).
+#define RANGE_LENGTH 10
+#define DELETE_RANGE_NUMBER 2000
+#define BENCHMARK_RUNS 3
+
+volatile int64_t sink = 0;
+
+char g_members[MEMBER_NUMBER][SDS_INT64_STRING_SIZE + 5];
+int g_lengths[MEMBER_NUMBER];
+double g_scores[MEMBER_NUMBER];
+
+double Seconds(clock_t start)
+{
+	return CAST(double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+void RangeCallback(void *argument, const char *member, int64_t length, double score)
+{
+	sink += length;
+}
+
+// Return the score of the member by walking the level 0 of the skip list, or 0 if not found.
+double SkipListScanScore(SkipList *skip_list, const char *member, int64_t length)
+{
+	SDSView view = {member, length};
+	for(SkipListNode *node = skip_list->head_->level_[0].forward_; node != NULL;
+	        node = node->level_[0].forward_)
+	{
+		if(SDSViewEqual(&view, node->object_->ptr_))
+		{
+			return node->score_;
+		}
+	}
+	return 0;
+}
+
+void PrintResult(const char *structure, const char *operation, int64_t number, double seconds)
+{
+	printf("%-10s of %d members %-33s %11.0f ops/s\n", structure, MEMBER_NUMBER, operation,
+	       CAST(double)number / seconds);
+}
+
+void BenchmarkSortedSet()
+{
+	double best_add = 1e9, best_score = 1e9, best_increment = 1e9, best_range = 1e9, score;
+	NosqlObject *zset = NULL;
+	for(int run = 0; run < BENCHMARK_RUNS; ++run)
+	{
+		if(zset != NULL)
+		{
+			DecreaseReferenceCount(zset);
+		}
+		zset = CreateSortedSetObject();
+		SortedSetTypeConvert(zset, NOSQL_ENCODING_SKIP_LIST);
+		clock_t start = clock();
+		for(int index = 0; index < MEMBER_NUMBER; ++index)
+		{
+			SortedSetTypeAdd(zset, g_members[index], g_lengths[index], g_scores[index]);
+		}
+		double seconds = Seconds(start);
+		best_add = seconds < best_add ? seconds : best_add;
+		srand(2);
+		start = clock();
+		for(int query = 0; query < QUERY_NUMBER; ++query)
+		{
+			int index = rand() % MEMBER_NUMBER;
+			sink += SortedSetTypeScore(zset, g_members[index], g_lengths[index], &score);
+		}
+		seconds = Seconds(start);
+		best_score = seconds < best_score ? seconds : best_score;
+		start = clock();
+		for(int query = 0; query < QUERY_NUMBER; ++query)
+		{
+			int index = rand() % MEMBER_NUMBER;
+			sink += SortedSetTypeIncrementBy(zset, g_members[index], g_lengths[index], 1, &score);
+		}
+		seconds = Seconds(start);
+		best_increment = seconds < best_increment ? seconds : best_increment;
+		start = clock();
+		for(int query = 0; query < QUERY_NUMBER; ++query)
+		{
+			int64_t rank = rand() % MEMBER_NUMBER;
+			sink += SortedSetTypeRange(zset, rank, rank + RANGE_LENGTH - 1, 0, RangeCallback, NULL);
+		}
+		seconds = Seconds(start);
+		best_range = seconds < best_range ? seconds : best_range;
+	}
+	PrintResult("zset", "ZADD", MEMBER_NUMBER, best_add);
+	PrintResult("zset", "ZSCORE", QUERY_NUMBER, best_score);
+	PrintResult("zset", "ZINCRBY", QUERY_NUMBER, best_increment);
+	PrintResult("zset", "ZRANGE", QUERY_NUMBER, best_range);
+	DecreaseReferenceCount(zset);
+}
+
+void BenchmarkSkipList()
+{
+	double best_add = 1e9, best_score = 1e9, best_increment = 1e9, best_range = 1e9;
+	SkipList *skip_list = NULL;
+	for(int run = 0; run < BENCHMARK_RUNS; ++run)
+	{
+		if(skip_list != NULL)
+		{
+			SkipListFree(skip_list);
+		}
+		skip_list = SkipListCreate();
+		clock_t start = clock();
+		for(int index = 0; index < MEMBER_NUMBER; ++index)
+		{
+			// Without the dictionary nothing checks whether the member exists.
+			SkipListInsert(skip_list, CreateStringObject(g_members[index], g_lengths[index]),
+			               g_scores[index]);
+		}
+		double seconds = Seconds(start);
+		best_add = seconds < best_add ? seconds : best_add;
+		srand(2);
+		start = clock();
+		for(int query = 0; query < SCAN_NUMBER; ++query)
+		{
+			int index = rand() % MEMBER_NUMBER;
+			sink += CAST(int64_t)SkipListScanScore(skip_list, g_members[index], g_lengths[index]);
+		}
+		seconds = Seconds(start);
+		best_score = seconds < best_score ? seconds : best_score;
+		// The lower bound of ZINCRBY with the current scores known in advance.
+		start = clock();
+		for(int query = 0; query < QUERY_NUMBER; ++query)
+		{
+			int index = rand() % MEMBER_NUMBER;
+			SkipListNode *node = SkipListGetElementByRank(skip_list, index + 1);
+			SkipListUpdateScore(skip_list, node->object_, node->score_, node->score_ + 1);
+		}
+		seconds = Seconds(start);
+		best_increment = seconds < best_increment ? seconds : best_increment;
+		start = clock();
+		for(int query = 0; query < QUERY_NUMBER; ++query)
+		{
+			SkipListNode *node = SkipListGetElementByRank(skip_list, 1 + rand() % MEMBER_NUMBER);
+			for(int number = 0; number < RANGE_LENGTH && node != NULL; ++number)
+			{
+				sink += get_length(CAST(String)node->object_->ptr_);
+				node = node->level_[0].forward_;
+			}
+		}
+		seconds = Seconds(start);
+		best_range = seconds < best_range ? seconds : best_range;
+	}
+	PrintResult("skip list", "ZADD", MEMBER_NUMBER, best_add);
+	PrintResult("skip list", "ZSCORE", SCAN_NUMBER, best_score);
+	PrintResult("skip list", "ZINCRBY", QUERY_NUMBER, best_increment);
+	PrintResult("skip list", "ZRANGE", QUERY_NUMBER, best_range);
+	SkipListFree(skip_list);
+}
+
+// Top 10, the first members from a score on, and pages deep in the set.
+void BenchmarkRangeQueries()
+{
+	NosqlObject *zset = CreateSortedSetObject();
+	SortedSetTypeConvert(zset, NOSQL_ENCODING_SKIP_LIST);
+	for(int index = 0; index < MEMBER_NUMBER; ++index)
+	{
+		SortedSetTypeAdd(zset, g_members[index], g_lengths[index], g_scores[index]);
+	}
+	double best_top = 1e9, best_score = 1e9, best_page = 1e9;
+	for(int run = 0; run < BENCHMARK_RUNS; ++run)
+	{
+		clock_t start = clock();
+		for(int query = 0; query < QUERY_NUMBER; ++query)
+		{
+			sink += SortedSetTypeRange(zset, 0, RANGE_LENGTH - 1, 1, RangeCallback, NULL);
+		}
+		double seconds = Seconds(start);
+		best_top = seconds < best_top ? seconds : best_top;
+		start = clock();
+		for(int query = 0; query < QUERY_NUMBER; ++query)
+		{
+			SkipListRange range = {rand() % (MEMBER_NUMBER * 4), 1.0 / 0.0, 0, 0};
+			sink += SortedSetTypeRangeByScore(zset, &range, 0, 0, RANGE_LENGTH, RangeCallback, NULL);
+		}
+		seconds = Seconds(start);
+		best_score = seconds < best_score ? seconds : best_score;
+		// The offset is skipped by rank, not walked.
+		start = clock();
+		for(int query = 0; query < QUERY_NUMBER; ++query)
+		{
+			SkipListRange range = {-1.0 / 0.0, 1.0 / 0.0, 0, 0};
+			sink += SortedSetTypeRangeByScore(zset, &range, 1, rand() % (MEMBER_NUMBER / 2),
+			                                  RANGE_LENGTH, RangeCallback, NULL);
+		}
+		seconds = Seconds(start);
+		best_page = seconds < best_page ? seconds : best_page;
+	}
+	PrintResult("zset", "ZREVRANGE 0 9", QUERY_NUMBER, best_top);
+	PrintResult("zset", "ZRANGEBYSCORE LIMIT 0 10", QUERY_NUMBER, best_score);
+	PrintResult("zset", "ZREVRANGEBYSCORE LIMIT 0-500k 10", QUERY_NUMBER, best_page);
+	DecreaseReferenceCount(zset);
+}
+
+// Delete DELETE_RANGE_NUMBER random score ranges of about 100 members each from the skip list,
+// in one pass per range or by one search per member, and return the number of deleted members.
+int64_t DeleteRanges(SkipList *skip_list, int one_pass)
+{
+	int64_t deleted = 0;
+	for(int number = 0; number < DELETE_RANGE_NUMBER; ++number)
+	{
+		double min = rand() % (MEMBER_NUMBER * 4);
+		SkipListRange range = {min, min + 400, 0, 1};
+		if(one_pass)
+		{
+			deleted += SkipListDeleteRangeByScore(skip_list, &range, NULL, NULL);
+			continue;
+		}
+		SkipListNode *node;
+		while((node = SkipListFirstInRange(skip_list, &range)) != NULL)
+		{
+			deleted += SkipListDelete(skip_list, node->object_, node->score_, NULL);
+		}
+	}
+	return deleted;
+}
+
+void BenchmarkDeleteRanges()
+{
+	double best[2] = {1e9, 1e9};
+	int64_t deleted[2] = {0, 0};
+	for(int run = 0; run < BENCHMARK_RUNS; ++run)
+	{
+		for(int one_pass = 0; one_pass < 2; ++one_pass)
+		{
+			SkipList *skip_list = SkipListCreate();
+			for(int index = 0; index < MEMBER_NUMBER; ++index)
+			{
+				SkipListInsert(skip_list, CreateStringObject(g_members[index], g_lengths[index]),
+				               g_scores[index]);
+			}
+			srand(3);
+			clock_t start = clock();
+			deleted[one_pass] = DeleteRanges(skip_list, one_pass);
+			double seconds = Seconds(start);
+			best[one_pass] = seconds < best[one_pass] ? seconds : best[one_pass];
+			SkipListFree(skip_list);
+		}
+	}
+	PrintResult("skip list", "delete ranges, per member", deleted[0], best[0]);
+	PrintResult("skip list", "delete ranges, one pass", deleted[1], best[1]);
+}
+
+int main(void)
+{
+	for(int index = 0; index < MEMBER_NUMBER; ++index)
+	{
+		memcpy(g_members[index], "user:", 5);
+		g_lengths[index] = SDSFormatInt64(g_members[index] + 5, index) + 5;
+		g_scores[index] = rand() % (MEMBER_NUMBER * 4);
+	}
+	BenchmarkSortedSet();
+	BenchmarkSkipList();
+	BenchmarkRangeQueries();
+	BenchmarkDeleteRanges();
+	return 0;
+}